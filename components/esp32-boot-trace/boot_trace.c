@@ -0,0 +1,185 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <esp_attr.h>
+#include <esp_event.h>
+#include <esp_wifi.h>
+#include <esp_netif.h>
+#include <esp_log.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <esp_app_desc.h>
+#include <freertos/FreeRTOS.h>
+#include "boot_trace.h"
+
+static const char *TAG = "BOOT_TRACE";
+
+#ifdef CONFIG_BOOT_TRACE_ENABLE
+
+#define TRACE_MAGIC 0x42545243
+#define NAME_LEN 24
+
+typedef struct {
+        char name[NAME_LEN];
+        uint32_t time_us;
+} trace_entry_t;
+
+typedef struct {
+        uint32_t magic;
+        uint32_t boot;
+        uint32_t reset_reason;
+        uint32_t count;
+        trace_entry_t entries[CONFIG_BOOT_TRACE_MAX_ENTRIES];
+} trace_timeline_t;
+
+// Both live in RTC slow memory and are not cleared by a software or watchdog reset
+static RTC_NOINIT_ATTR trace_timeline_t current;
+static RTC_NOINIT_ATTR trace_timeline_t previous;
+
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static bool complete = false;
+
+static void record(const char *phase) {
+        uint32_t now = (uint32_t)esp_timer_get_time();
+
+        portENTER_CRITICAL(&lock);
+        if (!complete && current.count < CONFIG_BOOT_TRACE_MAX_ENTRIES) {
+                trace_entry_t *entry = &current.entries[current.count++];
+                strncpy(entry->name, phase, NAME_LEN - 1);
+                entry->name[NAME_LEN - 1] = '\0';
+                entry->time_us = now;
+        }
+        portEXIT_CRITICAL(&lock);
+}
+
+static void event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data) {
+        if (event_base == WIFI_EVENT) {
+                switch (event_id) {
+                case WIFI_EVENT_STA_START:
+                        record("sta_start");
+                        break;
+                case WIFI_EVENT_STA_CONNECTED:
+                        record("sta_connected");
+                        break;
+                case WIFI_EVENT_STA_DISCONNECTED:
+                        record("sta_disconnected");
+                        break;
+                default:
+                        break;
+                }
+        } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+                record("got_ip");
+        }
+}
+
+static void dump(const trace_timeline_t *timeline) {
+        if (timeline->magic != TRACE_MAGIC || timeline->count > CONFIG_BOOT_TRACE_MAX_ENTRIES) {
+                ESP_LOGW(TAG, "No timeline recorded");
+                return;
+        }
+        const esp_app_desc_t *app = esp_app_get_description();
+        ESP_LOGI(TAG, "Boot %lu (reset reason %lu), %lu phases",
+                 (unsigned long)timeline->boot, (unsigned long)timeline->reset_reason,
+                 (unsigned long)timeline->count);
+        for (uint32_t i = 0; i < timeline->count; i++) {
+                const trace_entry_t *entry = &timeline->entries[i];
+                ESP_LOGI(TAG, "%s,%s,%lu,%.*s,%lu", app->project_name, app->version,
+                         (unsigned long)timeline->boot, NAME_LEN, entry->name,
+                         (unsigned long)entry->time_us);
+        }
+}
+
+void boot_trace_init(void) {
+        esp_reset_reason_t reason = esp_reset_reason();
+        uint32_t boot = 1;
+
+        if (current.magic == TRACE_MAGIC && reason != ESP_RST_POWERON) {
+                previous = current;
+                boot = current.boot + 1;
+        } else {
+                memset(&previous, 0, sizeof(previous));
+        }
+        memset(&current, 0, sizeof(current));
+        current.magic = TRACE_MAGIC;
+        current.boot = boot;
+        current.reset_reason = reason;
+        complete = false;
+        record("app_main");
+
+#ifdef CONFIG_BOOT_TRACE_DUMP_PREVIOUS
+        if (reason == ESP_RST_PANIC || reason == ESP_RST_INT_WDT || reason == ESP_RST_TASK_WDT ||
+            reason == ESP_RST_WDT || reason == ESP_RST_BROWNOUT) {
+                ESP_LOGW(TAG, "Previous boot ended with reset reason %d", reason);
+                dump(&previous);
+        }
+#endif
+
+        esp_err_t err = esp_event_loop_create_default();
+        if (err == ESP_OK || err == ESP_ERR_INVALID_STATE) {
+                esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL);
+                esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, NULL);
+        }
+}
+
+void boot_trace_mark(const char *phase) {
+        record(phase);
+}
+
+void boot_trace_complete(const char *phase) {
+        if (complete) {
+                return;
+        }
+        record(phase);
+        complete = true;
+
+        esp_event_handler_unregister(WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler);
+        esp_event_handler_unregister(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler);
+
+#ifdef CONFIG_BOOT_TRACE_DUMP_ON_COMPLETE
+        dump(&current);
+#endif
+}
+
+void boot_trace_dump(boot_trace_timeline_t which) {
+        dump(which == BOOT_TRACE_PREVIOUS ? &previous : &current);
+}
+
+#else
+
+void boot_trace_init(void) {
+}
+
+void boot_trace_mark(const char *phase) {
+}
+
+void boot_trace_complete(const char *phase) {
+}
+
+void boot_trace_dump(boot_trace_timeline_t which) {
+        ESP_LOGW(TAG, "Boot trace is disabled in menuconfig");
+}
+
+#endif
@@ -0,0 +1,50 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+        BOOT_TRACE_CURRENT = 0,
+        BOOT_TRACE_PREVIOUS,    // the boot before the last reset
+} boot_trace_timeline_t;
+
+// Start a new timeline; call first thing in app_main().
+// Also timestamps every Wi-Fi and IP event until the boot is complete.
+void boot_trace_init(void);
+
+// Timestamp the end of a boot phase. Names are truncated to 23 characters.
+void boot_trace_mark(const char *phase);
+
+// Timestamp the final phase and stop recording. Only the first call has an effect.
+void boot_trace_complete(const char *phase);
+
+// Print a timeline to the log, one "BOOT_TRACE: project,version,boot,phase,time_us" line per phase
+void boot_trace_dump(boot_trace_timeline_t which);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,232 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <stdlib.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <gpio_edge.h>
+#include "button_gesture.h"
+
+static const char *TAG = "BUTTON_GESTURE";
+
+#define NO_DEADLINE INT64_MAX
+
+struct button_gesture {
+        button_gesture_config_t config;
+        esp_timer_handle_t timer;
+
+        // Written by the edge callback, guarded by `lock`
+        portMUX_TYPE lock;
+        int64_t edge_us;                    // first edge of the current bounce burst
+        int64_t last_edge_us;
+        bool edge_level;                    // pressed level after the last edge
+        bool edge_pending;
+
+        // Only touched from the timer callback
+        bool pressed;
+        bool long_sent;
+        uint8_t clicks;
+        int64_t press_us;
+        int64_t release_us;
+        int64_t repeat_us;
+};
+
+static bool is_pressed(const button_gesture_config_t *config, int level) {
+        return level == (config->active_low ? 0 : 1);
+}
+
+static void emit(struct button_gesture *button, button_gesture_event_t event) {
+        if (button->config.callback) {
+                button->config.callback(event, button->config.context);
+        }
+}
+
+// Fire every decision deadline that passed before `now`
+static void run_deadlines(struct button_gesture *button, int64_t now) {
+        const button_gesture_config_t *config = &button->config;
+
+        if (button->pressed && !button->long_sent &&
+            now >= button->press_us + (int64_t)config->long_press_ms * 1000) {
+                button->long_sent = true;
+                button->clicks = 0;
+                button->repeat_us = button->press_us + (int64_t)(config->long_press_ms + config->hold_repeat_ms) * 1000;
+                emit(button, BUTTON_GESTURE_LONG_PRESS);
+        }
+        while (button->pressed && button->long_sent && config->hold_repeat_ms && now >= button->repeat_us) {
+                button->repeat_us += (int64_t)config->hold_repeat_ms * 1000;
+                emit(button, BUTTON_GESTURE_HOLD_REPEAT);
+        }
+        if (!button->pressed && button->clicks == 1 &&
+            now >= button->release_us + (int64_t)config->double_press_ms * 1000) {
+                button->clicks = 0;
+                emit(button, BUTTON_GESTURE_SINGLE_PRESS);
+        }
+}
+
+static void apply_edge(struct button_gesture *button, bool pressed, int64_t time_us) {
+        run_deadlines(button, time_us);
+        button->pressed = pressed;
+
+        if (pressed) {
+                button->press_us = time_us;
+                button->long_sent = false;
+                return;
+        }
+        if (button->long_sent) {
+                // The long press already consumed this gesture; a press held since boot has no press_us
+                if (button->press_us) {
+                        emit(button, BUTTON_GESTURE_LONG_RELEASE);
+                }
+                return;
+        }
+        button->clicks++;
+        if (button->clicks == 2 || button->config.double_press_ms == 0) {
+                emit(button, button->clicks == 2 ? BUTTON_GESTURE_DOUBLE_PRESS : BUTTON_GESTURE_SINGLE_PRESS);
+                button->clicks = 0;
+        } else {
+                button->release_us = time_us;
+        }
+}
+
+static int64_t next_deadline(const struct button_gesture *button) {
+        const button_gesture_config_t *config = &button->config;
+
+        if (button->pressed && !button->long_sent) {
+                return button->press_us + (int64_t)config->long_press_ms * 1000;
+        }
+        if (button->pressed && config->hold_repeat_ms) {
+                return button->repeat_us;
+        }
+        if (!button->pressed && button->clicks == 1) {
+                return button->release_us + (int64_t)config->double_press_ms * 1000;
+        }
+        return NO_DEADLINE;
+}
+
+// Arm the timer `delay_us` from now; called with `lock` held so edges and deadlines never race
+static void arm(struct button_gesture *button, int64_t delay_us) {
+        esp_timer_stop(button->timer);
+        esp_timer_start_once(button->timer, delay_us > 0 ? delay_us : 0);
+}
+
+static void timer_cb(void *arg) {
+        struct button_gesture *button = arg;
+        int64_t now = esp_timer_get_time();
+
+        portENTER_CRITICAL(&button->lock);
+        bool edge_pending = button->edge_pending;
+        int64_t edge_us = button->edge_us;
+        int64_t settle_us = button->last_edge_us + (int64_t)button->config.debounce_ms * 1000;
+        bool pressed = button->edge_level;
+        if (edge_pending && now < settle_us) {
+                // Still bouncing
+                arm(button, settle_us - now);
+                portEXIT_CRITICAL(&button->lock);
+                return;
+        }
+        button->edge_pending = false;
+        portEXIT_CRITICAL(&button->lock);
+
+        if (edge_pending && pressed != button->pressed) {
+                apply_edge(button, pressed, edge_us);
+        }
+        run_deadlines(button, now);
+
+        // Sleep until the next decision; nothing is armed while the button is idle
+        int64_t deadline = next_deadline(button);
+        portENTER_CRITICAL(&button->lock);
+        if (deadline != NO_DEADLINE && !button->edge_pending) {
+                arm(button, deadline - now);
+        }
+        portEXIT_CRITICAL(&button->lock);
+}
+
+// Edges arrive with the level and timestamp captured in the interrupt
+static void edge_cb(const gpio_edge_event_t *event, void *context) {
+        struct button_gesture *button = context;
+        int64_t settle_us = event->time_us + (int64_t)button->config.debounce_ms * 1000;
+
+        portENTER_CRITICAL(&button->lock);
+        if (!button->edge_pending) {
+                button->edge_us = event->time_us;
+                button->edge_pending = true;
+        }
+        button->last_edge_us = event->time_us;
+        button->edge_level = is_pressed(&button->config, event->level);
+        arm(button, settle_us - esp_timer_get_time());
+        portEXIT_CRITICAL(&button->lock);
+}
+
+esp_err_t button_gesture_create(const button_gesture_config_t *config, button_gesture_handle_t *handle) {
+        if (!config || !handle || !GPIO_IS_VALID_GPIO(config->gpio)) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        struct button_gesture *button = calloc(1, sizeof(*button));
+        if (!button) {
+                return ESP_ERR_NO_MEM;
+        }
+        button->config = *config;
+        portMUX_INITIALIZE(&button->lock);
+
+        const esp_timer_create_args_t timer_args = {
+                .callback = timer_cb,
+                .arg = button,
+                .name = "button_gesture",
+        };
+        esp_err_t err = esp_timer_create(&timer_args, &button->timer);
+        if (err != ESP_OK) {
+                free(button);
+                return err;
+        }
+
+        err = gpio_edge_add(config->gpio, config->active_low ? GPIO_PULLUP_ONLY : GPIO_PULLDOWN_ONLY,
+                            edge_cb, button);
+        if (err == ESP_OK) {
+                // A button held during boot is ignored until it is released: it has no press time to
+                // measure holds from, so it never repeats and releases without LONG_RELEASE
+                button->pressed = is_pressed(config, gpio_get_level(config->gpio));
+                button->long_sent = button->pressed;
+                button->repeat_us = NO_DEADLINE;
+        }
+        if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Button on GPIO %d: %s", config->gpio, esp_err_to_name(err));
+                esp_timer_delete(button->timer);
+                free(button);
+                return err;
+        }
+
+        *handle = button;
+        return ESP_OK;
+}
+
+esp_err_t button_gesture_delete(button_gesture_handle_t button) {
+        if (!button) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        gpio_edge_remove(button->config.gpio);
+        esp_timer_stop(button->timer);
+        esp_timer_delete(button->timer);
+        free(button);
+        return ESP_OK;
+}
@@ -0,0 +1,79 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <driver/gpio.h>
+#include <sdkconfig.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+        BUTTON_GESTURE_SINGLE_PRESS = 0,
+        BUTTON_GESTURE_DOUBLE_PRESS,
+        BUTTON_GESTURE_LONG_PRESS,
+        BUTTON_GESTURE_HOLD_REPEAT,
+        BUTTON_GESTURE_LONG_RELEASE,    // released after a long press
+} button_gesture_event_t;
+
+// Runs in the esp_timer task; keep it short and do not block
+typedef void (*button_gesture_cb_t)(button_gesture_event_t event, void *context);
+
+typedef struct {
+        gpio_num_t gpio;
+        bool active_low;            // pressed reads 0; enables the internal pull-up
+        uint32_t debounce_ms;
+        uint32_t double_press_ms;   // 0 reports single presses on release
+        uint32_t long_press_ms;
+        uint32_t hold_repeat_ms;    // 0 disables hold repeat
+        button_gesture_cb_t callback;
+        void *context;
+} button_gesture_config_t;
+
+#define BUTTON_GESTURE_CONFIG_DEFAULT(pin, cb, ctx) {                  \
+                .gpio = (pin),                                         \
+                .active_low = true,                                    \
+                .debounce_ms = CONFIG_BUTTON_GESTURE_DEBOUNCE_MS,      \
+                .double_press_ms = CONFIG_BUTTON_GESTURE_DOUBLE_PRESS_MS, \
+                .long_press_ms = CONFIG_BUTTON_GESTURE_LONG_PRESS_MS,  \
+                .hold_repeat_ms = CONFIG_BUTTON_GESTURE_HOLD_REPEAT_MS, \
+                .callback = (cb),                                      \
+                .context = (ctx),                                      \
+}
+
+typedef struct button_gesture *button_gesture_handle_t;
+
+// Configure the GPIO and start recognising gestures; edges come from esp32-gpio-edge
+esp_err_t button_gesture_create(const button_gesture_config_t *config, button_gesture_handle_t *handle);
+
+// Detach the interrupt, stop the timer and free the button
+esp_err_t button_gesture_delete(button_gesture_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
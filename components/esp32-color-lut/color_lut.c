@@ -0,0 +1,183 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include "color_lut.h"
+
+#define RATIO_ONE 8192                          // 1.0 in the ratio table
+#define HSI_FULL (3 * 100 * RATIO_ONE)          // channel weight that maps to 255
+
+// cos(h) / cos(60° - h) for h = 0..119 degrees, scaled by RATIO_ONE. This is the only
+// transcendental part of the HSI model; each 120° sector reuses it with the channels rotated.
+static const int16_t hsi_ratio[120] = {
+         16384,  15903,  15450,  15021,  14614,  14228,  13861,  13511,  13177,  12857,
+         12551,  12257,  11975,  11704,  11443,  11190,  10947,  10712,  10484,  10263,
+         10049,   9841,   9639,   9442,   9250,   9064,   8881,   8703,   8529,   8359,
+          8192,   8029,   7868,   7711,   7556,   7404,   7255,   7107,   6962,   6819,
+          6678,   6539,   6401,   6265,   6130,   5997,   5865,   5734,   5604,   5475,
+          5347,   5220,   5093,   4967,   4842,   4717,   4592,   4468,   4344,   4220,
+          4096,   3972,   3848,   3724,   3600,   3475,   3350,   3225,   3099,   2972,
+          2845,   2717,   2588,   2458,   2327,   2195,   2062,   1927,   1791,   1653,
+          1514,   1373,   1230,   1085,    937,    788,    636,    481,    324,    163,
+             0,   -167,   -337,   -511,   -689,   -872,  -1058,  -1250,  -1447,  -1649,
+         -1857,  -2071,  -2292,  -2520,  -2755,  -2998,  -3251,  -3512,  -3783,  -4065,
+         -4359,  -4665,  -4985,  -5319,  -5669,  -6036,  -6422,  -6829,  -7258,  -7711,
+};
+
+static void clamp(uint16_t *hue, uint8_t *saturation, uint8_t *brightness) {
+        *hue %= 360;
+        if (*saturation > 100) {
+                *saturation = 100;
+        }
+        if (*brightness > 100) {
+                *brightness = 100;
+        }
+}
+
+// Channel weight (0..HSI_FULL) times brightness (0..100) to 0..255, rounded. Every step
+// stays below 2^31, so no 64-bit arithmetic is needed.
+static uint8_t hsi_scale(int32_t weight, uint8_t brightness) {
+        if (weight <= 0) {
+                return 0;
+        }
+        uint32_t value = (uint32_t)weight * brightness / 100 * 255;
+        return (value + HSI_FULL / 2) / HSI_FULL;
+}
+
+// hsi_scale to 0..65535; the product with the full scale needs 64 bits
+static uint16_t hsi_scale16(int32_t weight, uint8_t brightness) {
+        if (weight <= 0) {
+                return 0;
+        }
+        uint32_t value = (uint32_t)weight * brightness / 100;
+        return ((uint64_t)value * 65535 + HSI_FULL / 2) / HSI_FULL;
+}
+
+// Percent of percent to 0..255, rounded
+static uint8_t percent_scale(uint32_t a, uint32_t b) {
+        return (a * b * 255 + 5000) / 10000;
+}
+
+// Rotate the three sector channels back into red, green and blue
+static void assign_sector(int sector, uint8_t first, uint8_t second, uint8_t third, color_rgbw_t *color) {
+        switch (sector) {
+        case 0:
+                color->red = first;
+                color->green = second;
+                color->blue = third;
+                break;
+        case 1:
+                color->green = first;
+                color->blue = second;
+                color->red = third;
+                break;
+        default:
+                color->blue = first;
+                color->red = second;
+                color->green = third;
+                break;
+        }
+}
+
+void color_lut_hsi_to_rgb(uint16_t hue, uint8_t saturation, uint8_t brightness, color_rgbw_t *color) {
+        clamp(&hue, &saturation, &brightness);
+        int32_t ratio = hsi_ratio[hue % 120];
+
+        // I / 3 * (1 + S * ratio), I / 3 * (1 + S * (1 - ratio)) and I / 3 * (1 - S)
+        uint8_t first = hsi_scale(100 * RATIO_ONE + saturation * ratio, brightness);
+        uint8_t second = hsi_scale(100 * RATIO_ONE + saturation * (RATIO_ONE - ratio), brightness);
+        uint8_t third = hsi_scale((100 - saturation) * RATIO_ONE, brightness);
+
+        assign_sector(hue / 120, first, second, third, color);
+        color->white = 0;
+}
+
+void color_lut_hsi_to_rgb16(uint16_t hue, uint8_t saturation, uint8_t brightness, color_rgbw16_t *color) {
+        clamp(&hue, &saturation, &brightness);
+        int32_t ratio = hsi_ratio[hue % 120];
+        int sector = hue / 120;
+
+        // The weights of color_lut_hsi_to_rgb, indexed red, green, blue and rotated by sector
+        int32_t weights[3];
+        weights[sector] = 100 * RATIO_ONE + saturation * ratio;
+        weights[(sector + 1) % 3] = 100 * RATIO_ONE + saturation * (RATIO_ONE - ratio);
+        weights[(sector + 2) % 3] = (100 - saturation) * RATIO_ONE;
+
+        color->red = hsi_scale16(weights[0], brightness);
+        color->green = hsi_scale16(weights[1], brightness);
+        color->blue = hsi_scale16(weights[2], brightness);
+        color->white = 0;
+}
+
+void color_lut_hsi_to_rgbw(uint16_t hue, uint8_t saturation, uint8_t brightness, color_rgbw_t *color) {
+        clamp(&hue, &saturation, &brightness);
+        int32_t ratio = hsi_ratio[hue % 120];
+
+        // S * I / 3 * (1 + ratio), S * I / 3 * (2 - ratio) and (1 - S) * I on white
+        uint8_t first = hsi_scale(saturation * (RATIO_ONE + ratio), brightness);
+        uint8_t second = hsi_scale(saturation * (2 * RATIO_ONE - ratio), brightness);
+
+        assign_sector(hue / 120, first, second, 0, color);
+        color->white = percent_scale(100 - saturation, brightness);
+}
+
+void color_lut_hsv_to_rgb(uint16_t hue, uint8_t saturation, uint8_t brightness, color_rgbw_t *color) {
+        clamp(&hue, &saturation, &brightness);
+        uint32_t offset = hue % 60;
+
+        // Brightest, falling, rising and darkest channel of the 60° sector, in percent * 6000
+        uint32_t max = brightness * 6000;
+        uint32_t min = brightness * (100 - saturation) * 60;
+        uint32_t falling = brightness * (6000 - saturation * offset);
+        uint32_t rising = brightness * (6000 - saturation * (60 - offset));
+
+        uint8_t v = (max * 255 / 100 + 3000) / 6000;
+        uint8_t p = (min * 255 / 100 + 3000) / 6000;
+        uint8_t q = (falling * 255 / 100 + 3000) / 6000;
+        uint8_t t = (rising * 255 / 100 + 3000) / 6000;
+
+        switch (hue / 60) {
+        case 0: color->red = v; color->green = t; color->blue = p; break;
+        case 1: color->red = q; color->green = v; color->blue = p; break;
+        case 2: color->red = p; color->green = v; color->blue = t; break;
+        case 3: color->red = p; color->green = q; color->blue = v; break;
+        case 4: color->red = t; color->green = p; color->blue = v; break;
+        default: color->red = v; color->green = p; color->blue = q; break;
+        }
+        color->white = 0;
+}
+
+void color_lut_hsv_to_rgbw(uint16_t hue, uint8_t saturation, uint8_t brightness, color_rgbw_t *color) {
+        color_lut_hsv_to_rgb(hue, saturation, brightness, color);
+
+        uint8_t white = color->red;
+        if (color->green < white) {
+                white = color->green;
+        }
+        if (color->blue < white) {
+                white = color->blue;
+        }
+        color->red -= white;
+        color->green -= white;
+        color->blue -= white;
+        color->white = white;
+}
@@ -0,0 +1,68 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+        uint8_t red;
+        uint8_t green;
+        uint8_t blue;
+        uint8_t white;
+} color_rgbw_t;
+
+typedef struct {
+        uint16_t red;
+        uint16_t green;
+        uint16_t blue;
+        uint16_t white;
+} color_rgbw16_t;
+
+// All conversions take HomeKit units: hue in degrees (wrapped to 0-359), saturation and
+// brightness in percent (clamped to 100). They use integer arithmetic and a constant table
+// only, so the same input gives the same output on every target.
+
+// HSI with the intensity shared over the three channels; white is always 0
+void color_lut_hsi_to_rgb(uint16_t hue, uint8_t saturation, uint8_t brightness, color_rgbw_t *color);
+
+// color_lut_hsi_to_rgb with 0-65535 channels, for outputs that put each channel through a
+// lightness curve and would lose the dim end to 8-bit steps first
+void color_lut_hsi_to_rgb16(uint16_t hue, uint8_t saturation, uint8_t brightness, color_rgbw16_t *color);
+
+// HSI where the unsaturated part goes to the white channel
+void color_lut_hsi_to_rgbw(uint16_t hue, uint8_t saturation, uint8_t brightness, color_rgbw_t *color);
+
+// HSV (HSB) with the brightest channel at the brightness; white is always 0
+void color_lut_hsv_to_rgb(uint16_t hue, uint8_t saturation, uint8_t brightness, color_rgbw_t *color);
+
+// HSV (HSB) with the common part of red, green and blue moved to the white channel
+void color_lut_hsv_to_rgbw(uint16_t hue, uint8_t saturation, uint8_t brightness, color_rgbw_t *color);
+
+#ifdef __cplusplus
+}
+#endif
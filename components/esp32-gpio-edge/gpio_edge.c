@@ -0,0 +1,176 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <stdlib.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_attr.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "gpio_edge.h"
+
+static const char *TAG = "GPIO_EDGE";
+
+typedef struct {
+        gpio_edge_cb_t callback;
+        void *context;
+        uint32_t overflows;
+} gpio_edge_input_t;
+
+static gpio_edge_input_t inputs[GPIO_NUM_MAX];
+
+// Single producer, single consumer: all pin handlers run from the one GPIO interrupt
+// of the ISR service, and only the dispatch task consumes.
+static gpio_edge_event_t *ring = NULL;
+static uint32_t ring_mask;
+static uint32_t ring_head = 0;  // written by the ISR
+static uint32_t ring_tail = 0;  // written by the dispatch task
+
+static TaskHandle_t dispatch_task = NULL;
+static gpio_edge_stats_t stats;
+
+static void IRAM_ATTR gpio_isr(void *arg) {
+        gpio_num_t gpio = (gpio_num_t)(intptr_t)arg;
+        int64_t now = esp_timer_get_time();
+        uint8_t level = gpio_get_level(gpio);
+
+        uint32_t head = ring_head;
+        uint32_t depth = head - __atomic_load_n(&ring_tail, __ATOMIC_ACQUIRE);
+        if (depth > ring_mask) {
+                stats.overflows++;
+                inputs[gpio].overflows++;
+                return;
+        }
+        ring[head & ring_mask] = (gpio_edge_event_t) {
+                .gpio = gpio,
+                .level = level,
+                .time_us = now,
+        };
+        __atomic_store_n(&ring_head, head + 1, __ATOMIC_RELEASE);
+
+        stats.captured++;
+        if (depth + 1 > stats.high_water) {
+                stats.high_water = depth + 1;
+        }
+
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(dispatch_task, &woken);
+        portYIELD_FROM_ISR(woken);
+}
+
+static void dispatch(void *args) {
+        uint32_t tail = ring_tail;
+
+        for (;;) {
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+                while (tail != __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE)) {
+                        gpio_edge_event_t event = ring[tail & ring_mask];
+                        __atomic_store_n(&ring_tail, ++tail, __ATOMIC_RELEASE);
+
+                        gpio_edge_input_t *input = &inputs[event.gpio];
+                        if (input->callback) {
+                                input->callback(&event, input->context);
+                                stats.dispatched++;
+                        }
+                }
+        }
+}
+
+static esp_err_t service_init(void) {
+        if (dispatch_task) {
+                return ESP_OK;
+        }
+
+        uint32_t size = 1;
+        while (size < CONFIG_GPIO_EDGE_RING_SIZE) {
+                size <<= 1;
+        }
+        ring = calloc(size, sizeof(gpio_edge_event_t));
+        if (!ring) {
+                return ESP_ERR_NO_MEM;
+        }
+        ring_mask = size - 1;
+
+        if (xTaskCreate(dispatch, "gpio_edge", CONFIG_GPIO_EDGE_TASK_STACK_SIZE, NULL,
+                        CONFIG_GPIO_EDGE_TASK_PRIORITY, &dispatch_task) != pdPASS) {
+                free(ring);
+                ring = NULL;
+                return ESP_ERR_NO_MEM;
+        }
+
+        esp_err_t err = gpio_install_isr_service(0);
+        return err == ESP_ERR_INVALID_STATE ? ESP_OK : err;
+}
+
+esp_err_t gpio_edge_add(gpio_num_t gpio, gpio_pull_mode_t pull, gpio_edge_cb_t callback, void *context) {
+        if (!GPIO_IS_VALID_GPIO(gpio) || !callback) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        esp_err_t err = service_init();
+        if (err != ESP_OK) {
+                return err;
+        }
+
+        gpio_config_t io_conf = {
+                .pin_bit_mask = 1ULL << gpio,
+                .mode = GPIO_MODE_INPUT,
+                .pull_up_en = (pull == GPIO_PULLUP_ONLY || pull == GPIO_PULLUP_PULLDOWN),
+                .pull_down_en = (pull == GPIO_PULLDOWN_ONLY || pull == GPIO_PULLUP_PULLDOWN),
+                .intr_type = GPIO_INTR_ANYEDGE,
+        };
+        err = gpio_config(&io_conf);
+        if (err != ESP_OK) {
+                return err;
+        }
+
+        inputs[gpio].callback = callback;
+        inputs[gpio].context = context;
+        inputs[gpio].overflows = 0;
+
+        err = gpio_isr_handler_add(gpio, gpio_isr, (void *)(intptr_t)gpio);
+        if (err != ESP_OK) {
+                ESP_LOGE(TAG, "GPIO %d: %s", gpio, esp_err_to_name(err));
+                inputs[gpio].callback = NULL;
+        }
+        return err;
+}
+
+esp_err_t gpio_edge_remove(gpio_num_t gpio) {
+        if (!GPIO_IS_VALID_GPIO(gpio)) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        esp_err_t err = gpio_isr_handler_remove(gpio);
+        gpio_set_intr_type(gpio, GPIO_INTR_DISABLE);
+        // Edges already in the ring are dropped by the dispatch task
+        inputs[gpio].callback = NULL;
+        return err;
+}
+
+void gpio_edge_get_stats(gpio_edge_stats_t *out) {
+        *out = stats;
+}
+
+uint32_t gpio_edge_get_overflows(gpio_num_t gpio) {
+        return GPIO_IS_VALID_GPIO(gpio) ? inputs[gpio].overflows : 0;
+}
@@ -0,0 +1,66 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stdint.h>
+#include <esp_err.h>
+#include <driver/gpio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One level change, captured inside the interrupt
+typedef struct {
+        gpio_num_t gpio;
+        uint8_t level;          // level right after the edge
+        int64_t time_us;        // esp_timer_get_time() at the edge
+} gpio_edge_event_t;
+
+// Runs in the edge dispatch task, in capture order
+typedef void (*gpio_edge_cb_t)(const gpio_edge_event_t *event, void *context);
+
+typedef struct {
+        uint32_t captured;      // edges written to the ring
+        uint32_t dispatched;    // edges handed to a callback
+        uint32_t overflows;     // edges dropped because the ring was full
+        uint32_t high_water;    // deepest the ring has been
+} gpio_edge_stats_t;
+
+// Configure `gpio` as an input with the given pull and deliver every edge to `callback`.
+// The first call starts the dispatch task and installs the GPIO ISR service if needed.
+esp_err_t gpio_edge_add(gpio_num_t gpio, gpio_pull_mode_t pull, gpio_edge_cb_t callback, void *context);
+
+// Stop capturing edges on `gpio`
+esp_err_t gpio_edge_remove(gpio_num_t gpio);
+
+// Copy the service wide counters
+void gpio_edge_get_stats(gpio_edge_stats_t *stats);
+
+// Edges dropped on one input because the ring was full
+uint32_t gpio_edge_get_overflows(gpio_num_t gpio);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,115 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <driver/gpio.h>
+#include <driver/ledc.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Output level for one step of a pattern; 0 is off, 255 is fully on
+typedef struct {
+        uint8_t level;
+        uint16_t duration_ms;
+} indicator_step_t;
+
+typedef struct {
+        const indicator_step_t *steps;
+        uint8_t step_count;
+        uint8_t repeat;             // times the steps are played, at least once
+} indicator_pattern_t;
+
+// The HomeKit identify blink: two short flashes and a pause, three times
+extern const indicator_pattern_t indicator_pattern_identify;
+
+typedef enum {
+        INDICATOR_OUTPUT_GPIO = 0,
+        INDICATOR_OUTPUT_LEDC,
+        INDICATOR_OUTPUT_CUSTOM,    // addressable strips and anything the application drives itself
+} indicator_output_type_t;
+
+// Both run in the esp_timer task; keep them short and do not block
+typedef void (*indicator_write_cb_t)(uint8_t level, void *context);
+typedef void (*indicator_restore_cb_t)(void *context);
+
+typedef struct {
+        indicator_output_type_t type;
+        gpio_num_t gpio;                    // INDICATOR_OUTPUT_GPIO
+        bool active_low;
+        ledc_mode_t ledc_mode;              // INDICATOR_OUTPUT_LEDC
+        ledc_channel_t ledc_channel;
+        uint32_t ledc_duty_max;             // duty written for level 255
+        indicator_write_cb_t write;         // INDICATOR_OUTPUT_CUSTOM
+        // Put the application's own output state back when a pattern ends. Required for custom
+        // outputs; GPIO and LEDC outputs fall back to the level they had when the pattern started.
+        indicator_restore_cb_t restore;
+        void *context;
+} indicator_config_t;
+
+#define INDICATOR_CONFIG_GPIO(pin, restore_cb, ctx) {                  \
+                .type = INDICATOR_OUTPUT_GPIO,                         \
+                .gpio = (pin),                                         \
+                .restore = (restore_cb),                               \
+                .context = (ctx),                                      \
+}
+
+#define INDICATOR_CONFIG_LEDC(mode, channel, duty_max, restore_cb, ctx) { \
+                .type = INDICATOR_OUTPUT_LEDC,                         \
+                .ledc_mode = (mode),                                   \
+                .ledc_channel = (channel),                             \
+                .ledc_duty_max = (duty_max),                           \
+                .restore = (restore_cb),                               \
+                .context = (ctx),                                      \
+}
+
+#define INDICATOR_CONFIG_CUSTOM(write_cb, restore_cb, ctx) {           \
+                .type = INDICATOR_OUTPUT_CUSTOM,                       \
+                .write = (write_cb),                                   \
+                .restore = (restore_cb),                               \
+                .context = (ctx),                                      \
+}
+
+typedef struct indicator *indicator_handle_t;
+
+// Create an idle indicator; the output is not touched until a pattern plays.
+// GPIO outputs are switched to input/output so their level can be read back.
+esp_err_t indicator_create(const indicator_config_t *config, indicator_handle_t *handle);
+
+// Start `pattern` and return immediately. Returns ESP_ERR_INVALID_STATE while another pattern
+// is still playing. The pattern must stay valid until it ends.
+esp_err_t indicator_play(indicator_handle_t handle, const indicator_pattern_t *pattern);
+
+bool indicator_is_playing(indicator_handle_t handle);
+
+// Stop the timer and free the indicator; a pattern in progress is cut short without restoring
+esp_err_t indicator_delete(indicator_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
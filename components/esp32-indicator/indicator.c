@@ -0,0 +1,207 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <stdlib.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include "indicator.h"
+
+static const char *TAG = "INDICATOR";
+
+static const indicator_step_t identify_steps[] = {
+        { 255, 100 },
+        { 0, 100 },
+        { 255, 100 },
+        { 0, 350 },
+};
+
+const indicator_pattern_t indicator_pattern_identify = {
+        .steps = identify_steps,
+        .step_count = sizeof(identify_steps) / sizeof(identify_steps[0]),
+        .repeat = 3,
+};
+
+struct indicator {
+        indicator_config_t config;
+        esp_timer_handle_t timer;
+
+        // Guards `pattern`; set by indicator_play(), cleared by the timer once the output is restored
+        portMUX_TYPE lock;
+        const indicator_pattern_t *pattern;
+
+        // Only touched by the caller that started the pattern and then by the timer callback
+        uint8_t step;
+        uint8_t round;
+        uint32_t saved;                     // GPIO level or LEDC duty before the pattern
+};
+
+static void output_write(struct indicator *indicator, uint8_t level) {
+        const indicator_config_t *config = &indicator->config;
+
+        switch (config->type) {
+        case INDICATOR_OUTPUT_GPIO:
+                gpio_set_level(config->gpio, (level != 0) != config->active_low);
+                break;
+        case INDICATOR_OUTPUT_LEDC:
+                ledc_set_duty(config->ledc_mode, config->ledc_channel,
+                              (uint32_t)((uint64_t)config->ledc_duty_max * level / 255));
+                ledc_update_duty(config->ledc_mode, config->ledc_channel);
+                break;
+        case INDICATOR_OUTPUT_CUSTOM:
+                config->write(level, config->context);
+                break;
+        }
+}
+
+static void output_save(struct indicator *indicator) {
+        const indicator_config_t *config = &indicator->config;
+
+        if (config->type == INDICATOR_OUTPUT_GPIO) {
+                indicator->saved = gpio_get_level(config->gpio);
+        } else if (config->type == INDICATOR_OUTPUT_LEDC) {
+                indicator->saved = ledc_get_duty(config->ledc_mode, config->ledc_channel);
+        }
+}
+
+static void output_restore(struct indicator *indicator) {
+        const indicator_config_t *config = &indicator->config;
+
+        if (config->restore) {
+                config->restore(config->context);
+        } else if (config->type == INDICATOR_OUTPUT_GPIO) {
+                gpio_set_level(config->gpio, indicator->saved);
+        } else if (config->type == INDICATOR_OUTPUT_LEDC) {
+                ledc_set_duty(config->ledc_mode, config->ledc_channel, indicator->saved);
+                ledc_update_duty(config->ledc_mode, config->ledc_channel);
+        }
+}
+
+static void play_step(struct indicator *indicator) {
+        const indicator_step_t *step = &indicator->pattern->steps[indicator->step];
+
+        output_write(indicator, step->level);
+        esp_timer_start_once(indicator->timer, (uint64_t)step->duration_ms * 1000);
+}
+
+static void timer_cb(void *arg) {
+        struct indicator *indicator = arg;
+        const indicator_pattern_t *pattern = indicator->pattern;
+
+        if (++indicator->step < pattern->step_count) {
+                play_step(indicator);
+                return;
+        }
+        indicator->step = 0;
+        if (++indicator->round < pattern->repeat) {
+                play_step(indicator);
+                return;
+        }
+
+        output_restore(indicator);
+        portENTER_CRITICAL(&indicator->lock);
+        indicator->pattern = NULL;
+        portEXIT_CRITICAL(&indicator->lock);
+}
+
+esp_err_t indicator_create(const indicator_config_t *config, indicator_handle_t *handle) {
+        if (!config || !handle) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        if (config->type == INDICATOR_OUTPUT_GPIO && !GPIO_IS_VALID_OUTPUT_GPIO(config->gpio)) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        if (config->type == INDICATOR_OUTPUT_CUSTOM && (!config->write || !config->restore)) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        struct indicator *indicator = calloc(1, sizeof(*indicator));
+        if (!indicator) {
+                return ESP_ERR_NO_MEM;
+        }
+        indicator->config = *config;
+        portMUX_INITIALIZE(&indicator->lock);
+
+        const esp_timer_create_args_t timer_args = {
+                .callback = timer_cb,
+                .arg = indicator,
+                .name = "indicator",
+        };
+        esp_err_t err = esp_timer_create(&timer_args, &indicator->timer);
+        if (err == ESP_OK && config->type == INDICATOR_OUTPUT_GPIO) {
+                // Keeps the output as it is and enables the input buffer for gpio_get_level()
+                err = gpio_set_direction(config->gpio, GPIO_MODE_INPUT_OUTPUT);
+        }
+        if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Create indicator: %s", esp_err_to_name(err));
+                if (indicator->timer) {
+                        esp_timer_delete(indicator->timer);
+                }
+                free(indicator);
+                return err;
+        }
+
+        *handle = indicator;
+        return ESP_OK;
+}
+
+esp_err_t indicator_play(indicator_handle_t indicator, const indicator_pattern_t *pattern) {
+        if (!indicator || !pattern || !pattern->steps || !pattern->step_count) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        portENTER_CRITICAL(&indicator->lock);
+        bool busy = indicator->pattern != NULL;
+        if (!busy) {
+                indicator->pattern = pattern;
+        }
+        portEXIT_CRITICAL(&indicator->lock);
+        if (busy) {
+                ESP_LOGW(TAG, "Pattern already playing");
+                return ESP_ERR_INVALID_STATE;
+        }
+
+        indicator->step = 0;
+        indicator->round = 0;
+        output_save(indicator);
+        play_step(indicator);
+        return ESP_OK;
+}
+
+bool indicator_is_playing(indicator_handle_t indicator) {
+        if (!indicator) {
+                return false;
+        }
+        portENTER_CRITICAL(&indicator->lock);
+        bool playing = indicator->pattern != NULL;
+        portEXIT_CRITICAL(&indicator->lock);
+        return playing;
+}
+
+esp_err_t indicator_delete(indicator_handle_t indicator) {
+        if (!indicator) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        esp_timer_stop(indicator->timer);
+        esp_timer_delete(indicator->timer);
+        free(indicator);
+        return ESP_OK;
+}
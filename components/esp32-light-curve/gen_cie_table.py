@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+#
+# Copyright 2025 Achim Pieters | StudioPieters®
+#
+# Generate the CIE 1931 lightness table used by the esp32-light-curve component.
+#
+# The table maps perceived lightness L* (0-100, spread over 0-65535) to relative
+# luminance Y (0-65535) in SEGMENTS equal steps: entry i is the luminance at input
+# i * 65535 / SEGMENTS. light_curve.c interpolates between entries with the same
+# mapping, and lookup() below does exactly what it does. The build fails unless the
+# lookup is monotonic over every input, no input step moves the output by more than
+# MAX_STEP, and no input is further than MAX_ERROR from the exact curve, so a change
+# here can't reintroduce visible jumps at the low end.
+#
+#   gen_cie_table.py OUTPUT_HEADER
+#
+# for more information visit https://www.studiopieters.nl
+
+import sys
+
+SEGMENTS = 256
+FULL = 65535
+MAX_STEP = 3  # output counts per input count; the curve's steepest slope is about 2.6
+MAX_ERROR = 2  # output counts between the interpolated and the exact curve
+
+
+def luminance(lightness):
+    """CIE 1931: relative luminance 0-1 for lightness L* 0-100."""
+    if lightness <= 8:
+        return lightness / 903.3
+    return ((lightness + 16) / 116) ** 3
+
+
+def lookup(table, lightness):
+    """light_curve_cie() in integer math: lightness 0-65535 to luminance 0-65535."""
+    segment, offset = divmod(lightness * SEGMENTS, FULL)
+    if segment == SEGMENTS:
+        return table[SEGMENTS]
+    low, high = table[segment], table[segment + 1]
+    return low + ((high - low) * offset + FULL // 2) // FULL
+
+
+def main():
+    table = [round(luminance(100 * i / SEGMENTS) * FULL) for i in range(SEGMENTS + 1)]
+
+    previous = lookup(table, 0)
+    for lightness in range(FULL + 1):
+        value = lookup(table, lightness)
+        if value < previous:
+            sys.exit('CIE curve is not monotonic at input %d' % lightness)
+        if value - previous > MAX_STEP:
+            sys.exit('CIE curve step at input %d is %d, above %d' % (lightness, value - previous, MAX_STEP))
+        error = abs(value - luminance(100 * lightness / FULL) * FULL)
+        if error > MAX_ERROR:
+            sys.exit('CIE curve is %.1f off at input %d, above %d' % (error, lightness, MAX_ERROR))
+        previous = value
+
+    with open(sys.argv[1], 'w') as header:
+        header.write('// Generated by gen_cie_table.py, do not edit\n\n')
+        header.write('#define CIE_TABLE_SEGMENTS %d\n\n' % SEGMENTS)
+        header.write('static const uint16_t cie_table[CIE_TABLE_SEGMENTS + 1] = {\n')
+        for i in range(0, len(table), 8):
+            header.write('        ' + ', '.join('%5d' % value for value in table[i:i + 8]) + ',\n')
+        header.write('};\n')
+
+
+if __name__ == '__main__':
+    main()
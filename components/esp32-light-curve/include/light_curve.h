@@ -0,0 +1,55 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LIGHT_CURVE_MAX 65535
+
+// Perceived lightness (0-65535, even steps look even) to relative luminance (0-65535),
+// following CIE 1931. The table behind it is generated at build time.
+uint16_t light_curve_cie(uint16_t lightness);
+
+// Luminance (0-65535) to a PWM duty for a timer whose full duty is `duty_max`, with
+// `fraction_bits` bits below the LSB left for temporal dithering (see light_fade)
+uint32_t light_curve_duty(uint16_t luminance, uint32_t duty_max, uint8_t fraction_bits);
+
+// HomeKit percent (0-100) to lightness (0-65535)
+static inline uint16_t light_curve_percent(float percent) {
+        if (percent <= 0) {
+                return 0;
+        }
+        if (percent >= 100) {
+                return LIGHT_CURVE_MAX;
+        }
+        return (uint16_t)(percent * LIGHT_CURVE_MAX / 100 + 0.5f);
+}
+
+#ifdef __cplusplus
+}
+#endif
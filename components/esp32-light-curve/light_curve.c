@@ -0,0 +1,46 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include "light_curve.h"
+#include "cie_table.h"
+
+uint16_t light_curve_cie(uint16_t lightness) {
+        // Entry i is the luminance at lightness i * LIGHT_CURVE_MAX / CIE_TABLE_SEGMENTS, as
+        // gen_cie_table.py samples it, so the last entry is the full input
+        uint32_t position = (uint32_t)lightness * CIE_TABLE_SEGMENTS;
+        uint32_t segment = position / LIGHT_CURVE_MAX;
+        uint32_t offset = position % LIGHT_CURVE_MAX;
+
+        if (segment == CIE_TABLE_SEGMENTS) {
+                return cie_table[CIE_TABLE_SEGMENTS];
+        }
+        // Linear interpolation between the two table entries
+        uint32_t low = cie_table[segment];
+        uint32_t high = cie_table[segment + 1];
+        return low + ((high - low) * offset + LIGHT_CURVE_MAX / 2) / LIGHT_CURVE_MAX;
+}
+
+uint32_t light_curve_duty(uint16_t luminance, uint32_t duty_max, uint8_t fraction_bits) {
+        uint64_t scaled = (uint64_t)luminance * duty_max << fraction_bits;
+        return (scaled + LIGHT_CURVE_MAX / 2) / LIGHT_CURVE_MAX;
+}
@@ -0,0 +1,65 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stdint.h>
+#include <esp_err.h>
+#include <driver/ledc.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LIGHT_FADE_MAX_CHANNELS 4
+
+// A group of LEDC channels that fade together, e.g. the red, green and blue of one light.
+// The timer and channels are configured by the caller.
+typedef struct {
+        ledc_mode_t speed_mode;
+        ledc_channel_t channels[LIGHT_FADE_MAX_CHANNELS];
+        uint8_t channel_count;
+        uint32_t duty_max;
+        uint32_t full_scale_ms;     // fade time from 0 to duty_max; smaller steps are proportionally faster
+        uint8_t fraction_bits;      // duties carry this many bits below the LSB (0-8); see Kconfig for dithering
+        const char *name;           // tags the duty trace; NULL for "fade"
+} light_fade_config_t;
+
+typedef struct light_fade *light_fade_handle_t;
+
+esp_err_t light_fade_create(const light_fade_config_t *config, light_fade_handle_t *handle);
+
+// Fade every channel to its duty in `duties` with the LEDC hardware. With fraction_bits set, a
+// channel that ends up between two low duty steps is then dithered between them (see Kconfig).
+// All channels take the time of the largest step, so a colour change moves in a straight line. A
+// fade still running is cancelled and the new one starts from the duty the output had reached.
+esp_err_t light_fade_to(light_fade_handle_t fade, const uint32_t *duties);
+
+// Jump to `duties`, cancelling a running fade
+esp_err_t light_fade_set(light_fade_handle_t fade, const uint32_t *duties);
+
+void light_fade_delete(light_fade_handle_t fade);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,421 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include "light_fade.h"
+
+static const char *TAG = "LIGHT_FADE";
+
+#if CONFIG_LIGHT_FADE_DITHER_HZ
+#define DITHER_PERIOD_US (1000000 / CONFIG_LIGHT_FADE_DITHER_HZ)
+#else
+#define DITHER_PERIOD_US 0      // unused: without a rate no handle creates the dither timers
+#endif
+
+#define TRACE_QUEUE_LENGTH 8
+#define TRACE_TASK_STACK_SIZE 3072
+
+typedef struct {
+        uint32_t time_us;
+        uint32_t time_ms;                   // 0 for a jump
+        uint32_t from[LIGHT_FADE_MAX_CHANNELS];
+        uint32_t to[LIGHT_FADE_MAX_CHANNELS];
+} trace_entry_t;
+
+struct light_fade {
+        light_fade_config_t config;
+        SemaphoreHandle_t lock;
+
+        // Dithering: targets with fraction_bits below the LSB, started once the fade has ended
+        esp_timer_handle_t settle_timer;
+        esp_timer_handle_t dither_timer;
+        int64_t fade_end_us;
+        uint32_t targets[LIGHT_FADE_MAX_CHANNELS];
+        uint32_t accumulators[LIGHT_FADE_MAX_CHANNELS];
+        uint32_t written[LIGHT_FADE_MAX_CHANNELS];
+
+#if CONFIG_LIGHT_FADE_TRACE_DEPTH
+        // Fades fill one buffer while the trace task prints the other; with both full, fades
+        // are only counted until the printed one is free again
+        trace_entry_t trace[2][CONFIG_LIGHT_FADE_TRACE_DEPTH];
+        uint8_t trace_active;
+        uint32_t trace_count;
+        bool trace_printing;
+        uint32_t trace_dropped;
+#endif
+};
+
+static bool fade_installed = false;
+
+static esp_err_t write_duty(struct light_fade *fade, int index, uint32_t duty) {
+        const light_fade_config_t *config = &fade->config;
+
+        esp_err_t err = ledc_set_duty(config->speed_mode, config->channels[index], duty);
+        if (err == ESP_OK) {
+                err = ledc_update_duty(config->speed_mode, config->channels[index]);
+        }
+        fade->written[index] = duty;
+        return err;
+}
+
+static uint32_t whole(const struct light_fade *fade, uint32_t duty) {
+        return duty >> fade->config.fraction_bits;
+}
+
+static uint32_t fraction(const struct light_fade *fade, uint32_t duty) {
+        return duty & ((1 << fade->config.fraction_bits) - 1);
+}
+
+// Duty a channel rests at when it is not dithered: the target rounded to the nearest step
+static uint32_t rounded(const struct light_fade *fade, uint32_t duty) {
+        if (!fade->config.fraction_bits) {
+                return duty;
+        }
+        return (duty + (1 << (fade->config.fraction_bits - 1))) >> fade->config.fraction_bits;
+}
+
+static bool needs_dither(const struct light_fade *fade, uint32_t duty) {
+        return CONFIG_LIGHT_FADE_DITHER_HZ && fraction(fade, duty) && whole(fade, duty) < CONFIG_LIGHT_FADE_DITHER_BELOW;
+}
+
+#if CONFIG_LIGHT_FADE_TRACE_DEPTH
+// Printed at the lowest priority, so a dump never delays a fade or the caller
+static QueueHandle_t trace_queue;
+
+// Called with `lock` held; returns true when the active buffer filled up and was handed over
+static bool trace_swap(struct light_fade *fade) {
+        if (fade->trace_count < CONFIG_LIGHT_FADE_TRACE_DEPTH || fade->trace_printing) {
+                return false;
+        }
+        fade->trace_printing = true;
+        fade->trace_active ^= 1;
+        fade->trace_count = 0;
+        return true;
+}
+
+// Called with `lock` held; returns true when trace_post() has a buffer to print
+static bool trace_add(struct light_fade *fade, const trace_entry_t *entry) {
+        if (fade->trace_count == CONFIG_LIGHT_FADE_TRACE_DEPTH) {
+                fade->trace_dropped++;
+                return false;
+        }
+        fade->trace[fade->trace_active][fade->trace_count++] = *entry;
+        return trace_swap(fade);
+}
+
+static void trace_post(struct light_fade *fade, bool full) {
+        if (full && xQueueSend(trace_queue, &fade, 0) != pdTRUE) {
+                // Lose the buffer rather than block the caller
+                xSemaphoreTake(fade->lock, portMAX_DELAY);
+                fade->trace_dropped += CONFIG_LIGHT_FADE_TRACE_DEPTH;
+                fade->trace_printing = false;
+                xSemaphoreGive(fade->lock);
+        }
+}
+
+// One "LIGHT_FADE: trace,name,time_us,time_ms,from,to[,from,to...]" line per fade or jump, and
+// "LIGHT_FADE: trace_dropped,name,count" for those that found both buffers full
+static void trace_task(void *arg) {
+        struct light_fade *fade;
+
+        for (;;) {
+                xQueueReceive(trace_queue, &fade, portMAX_DELAY);
+                const char *name = fade->config.name ? fade->config.name : "fade";
+                // trace_active only moves once trace_printing is cleared
+                const trace_entry_t *entries = fade->trace[fade->trace_active ^ 1];
+
+                for (int i = 0; i < CONFIG_LIGHT_FADE_TRACE_DEPTH; i++) {
+                        const trace_entry_t *entry = &entries[i];
+                        char duties[LIGHT_FADE_MAX_CHANNELS * 24] = "";
+                        size_t used = 0;
+                        for (int ch = 0; ch < fade->config.channel_count; ch++) {
+                                used += snprintf(duties + used, sizeof(duties) - used, ",%lu,%lu",
+                                                 (unsigned long)entry->from[ch], (unsigned long)entry->to[ch]);
+                        }
+                        ESP_LOGI(TAG, "trace,%s,%lu,%lu%s", name, (unsigned long)entry->time_us,
+                                 (unsigned long)entry->time_ms, duties);
+                }
+
+                xSemaphoreTake(fade->lock, portMAX_DELAY);
+                uint32_t dropped = fade->trace_dropped;
+                fade->trace_dropped = 0;
+                fade->trace_printing = false;
+                bool full = trace_swap(fade);
+                xSemaphoreGive(fade->lock);
+                if (dropped) {
+                        ESP_LOGI(TAG, "trace_dropped,%s,%lu", name, (unsigned long)dropped);
+                }
+                trace_post(fade, full);
+        }
+}
+
+static esp_err_t trace_init(void) {
+        if (trace_queue) {
+                return ESP_OK;
+        }
+        trace_queue = xQueueCreate(TRACE_QUEUE_LENGTH, sizeof(struct light_fade *));
+        if (!trace_queue) {
+                return ESP_ERR_NO_MEM;
+        }
+        if (xTaskCreate(trace_task, "fade_trace", TRACE_TASK_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1, NULL) != pdPASS) {
+                vQueueDelete(trace_queue);
+                trace_queue = NULL;
+                return ESP_ERR_NO_MEM;
+        }
+        return ESP_OK;
+}
+
+// The trace task may still be printing from the fade
+static void trace_wait(struct light_fade *fade) {
+        for (;;) {
+                xSemaphoreTake(fade->lock, portMAX_DELAY);
+                bool printing = fade->trace_printing;
+                xSemaphoreGive(fade->lock);
+                if (!printing) {
+                        return;
+                }
+                vTaskDelay(1);
+        }
+}
+#else
+static bool trace_add(struct light_fade *fade, const trace_entry_t *entry) {
+        return false;
+}
+
+static void trace_post(struct light_fade *fade, bool full) {
+}
+
+static esp_err_t trace_init(void) {
+        return ESP_OK;
+}
+
+static void trace_wait(struct light_fade *fade) {
+}
+#endif
+
+// Stop a running hardware fade or dither; the duty stays where it got to
+static void cancel(struct light_fade *fade) {
+        if (fade->settle_timer) {
+                esp_timer_stop(fade->settle_timer);
+                esp_timer_stop(fade->dither_timer);
+        }
+        for (int i = 0; i < fade->config.channel_count; i++) {
+                ledc_fade_stop(fade->config.speed_mode, fade->config.channels[i]);
+        }
+}
+
+// First-order sigma-delta: each channel spends fraction / 2^fraction_bits of the ticks one step up
+static void dither_cb(void *arg) {
+        struct light_fade *fade = arg;
+        uint32_t one = 1 << fade->config.fraction_bits;
+
+        xSemaphoreTake(fade->lock, portMAX_DELAY);
+        for (int i = 0; i < fade->config.channel_count; i++) {
+                uint32_t target = fade->targets[i];
+                if (!needs_dither(fade, target)) {
+                        continue;
+                }
+                uint32_t duty = whole(fade, target);
+                fade->accumulators[i] += fraction(fade, target);
+                if (fade->accumulators[i] >= one) {
+                        fade->accumulators[i] -= one;
+                        duty++;
+                }
+                if (duty != fade->written[i]) {
+                        write_duty(fade, i, duty);
+                }
+        }
+        xSemaphoreGive(fade->lock);
+}
+
+static void settle_cb(void *arg) {
+        struct light_fade *fade = arg;
+
+        xSemaphoreTake(fade->lock, portMAX_DELAY);
+        // A newer fade armed its own settle timer
+        if (esp_timer_get_time() >= fade->fade_end_us) {
+                esp_timer_start_periodic(fade->dither_timer, DITHER_PERIOD_US);
+        }
+        xSemaphoreGive(fade->lock);
+}
+
+// Called with `lock` held once the channels are on their way to `targets`
+static void schedule_dither(struct light_fade *fade, uint32_t time_ms) {
+        bool dither = false;
+
+        for (int i = 0; i < fade->config.channel_count; i++) {
+                dither |= needs_dither(fade, fade->targets[i]);
+        }
+        fade->fade_end_us = esp_timer_get_time() + (int64_t)time_ms * 1000;
+        if (dither && fade->settle_timer) {
+                esp_timer_start_once(fade->settle_timer, (uint64_t)time_ms * 1000);
+        }
+}
+
+esp_err_t light_fade_create(const light_fade_config_t *config, light_fade_handle_t *handle) {
+        if (!config || !handle || !config->channel_count || config->channel_count > LIGHT_FADE_MAX_CHANNELS ||
+            !config->duty_max || config->fraction_bits > 8) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        if (!fade_installed) {
+                esp_err_t err = ledc_fade_func_install(0);
+                if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+                        ESP_LOGE(TAG, "Fade service: %s", esp_err_to_name(err));
+                        return err;
+                }
+                fade_installed = true;
+        }
+        esp_err_t err = trace_init();
+        if (err != ESP_OK) {
+                return err;
+        }
+
+        struct light_fade *fade = calloc(1, sizeof(*fade));
+        if (!fade) {
+                return ESP_ERR_NO_MEM;
+        }
+        fade->config = *config;
+        fade->lock = xSemaphoreCreateMutex();
+        if (!fade->lock) {
+                free(fade);
+                return ESP_ERR_NO_MEM;
+        }
+
+        if (config->fraction_bits && CONFIG_LIGHT_FADE_DITHER_HZ) {
+                const esp_timer_create_args_t settle_args = {
+                        .callback = settle_cb,
+                        .arg = fade,
+                        .name = "light_fade_settle",
+                };
+                const esp_timer_create_args_t dither_args = {
+                        .callback = dither_cb,
+                        .arg = fade,
+                        .name = "light_fade_dither",
+                };
+                err = esp_timer_create(&settle_args, &fade->settle_timer);
+                if (err == ESP_OK) {
+                        err = esp_timer_create(&dither_args, &fade->dither_timer);
+                        if (err != ESP_OK) {
+                                esp_timer_delete(fade->settle_timer);
+                        }
+                }
+                if (err != ESP_OK) {
+                        vSemaphoreDelete(fade->lock);
+                        free(fade);
+                        return err;
+                }
+        }
+
+        *handle = fade;
+        return ESP_OK;
+}
+
+esp_err_t light_fade_to(light_fade_handle_t fade, const uint32_t *duties) {
+        const light_fade_config_t *config = &fade->config;
+        uint32_t step_max = 0;
+        esp_err_t err = ESP_OK;
+        trace_entry_t entry = { .time_us = esp_timer_get_time() };
+        bool trace_full = false;
+
+        xSemaphoreTake(fade->lock, portMAX_DELAY);
+        cancel(fade);
+        for (int i = 0; i < config->channel_count; i++) {
+                uint32_t current = ledc_get_duty(config->speed_mode, config->channels[i]);
+                uint32_t target = rounded(fade, duties[i]);
+                entry.from[i] = current;
+                entry.to[i] = target;
+                uint32_t step = current > target ? current - target : target - current;
+                if (step > step_max) {
+                        step_max = step;
+                }
+        }
+
+        // The hardware sleeps between fades; nothing runs once the target is reached
+        uint32_t time_ms = (uint64_t)config->full_scale_ms * step_max / config->duty_max;
+        for (int i = 0; i < config->channel_count && err == ESP_OK; i++) {
+                uint32_t target = rounded(fade, duties[i]);
+                fade->targets[i] = duties[i];
+                if (time_ms) {
+                        err = ledc_set_fade_with_time(config->speed_mode, config->channels[i], target, time_ms);
+                        if (err == ESP_OK) {
+                                err = ledc_fade_start(config->speed_mode, config->channels[i], LEDC_FADE_NO_WAIT);
+                        }
+                        fade->written[i] = target;
+                } else {
+                        err = write_duty(fade, i, target);
+                }
+        }
+        if (err == ESP_OK) {
+                schedule_dither(fade, time_ms);
+                entry.time_ms = time_ms;
+                trace_full = trace_add(fade, &entry);
+        }
+        xSemaphoreGive(fade->lock);
+        trace_post(fade, trace_full);
+        return err;
+}
+
+esp_err_t light_fade_set(light_fade_handle_t fade, const uint32_t *duties) {
+        const light_fade_config_t *config = &fade->config;
+        esp_err_t err = ESP_OK;
+        trace_entry_t entry = { .time_us = esp_timer_get_time() };
+        bool trace_full = false;
+
+        xSemaphoreTake(fade->lock, portMAX_DELAY);
+        cancel(fade);
+        for (int i = 0; i < config->channel_count && err == ESP_OK; i++) {
+                fade->targets[i] = duties[i];
+                entry.from[i] = ledc_get_duty(config->speed_mode, config->channels[i]);
+                entry.to[i] = rounded(fade, duties[i]);
+                err = write_duty(fade, i, entry.to[i]);
+        }
+        if (err == ESP_OK) {
+                schedule_dither(fade, 0);
+                trace_full = trace_add(fade, &entry);
+        }
+        xSemaphoreGive(fade->lock);
+        trace_post(fade, trace_full);
+        return err;
+}
+
+void light_fade_delete(light_fade_handle_t fade) {
+        if (!fade) {
+                return;
+        }
+        cancel(fade);
+        trace_wait(fade);
+        if (fade->settle_timer) {
+                esp_timer_delete(fade->settle_timer);
+                esp_timer_delete(fade->dither_timer);
+        }
+        vSemaphoreDelete(fade->lock);
+        free(fade);
+}
@@ -0,0 +1,64 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stdint.h>
+#include <esp_err.h>
+#include <homekit/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+        uint32_t min_interval_ms;   // at most one notification per interval; 0 disables the limit
+        uint32_t max_interval_ms;   // send even an unchanged value once this long has passed; 0 never
+        float deadband;             // smallest change worth a notification; 0 sends any change
+} notify_limits_t;
+
+typedef struct {
+        uint32_t updates;           // values handed to the scheduler
+        uint32_t sent;              // notifications sent, including immediate ones
+        uint32_t immediate;         // notifications sent by notify_scheduler_update_now()
+        uint32_t coalesced;         // pending values replaced by a newer one before the flush
+        uint32_t suppressed;        // values dropped because they were inside the deadband
+} notify_stats_t;
+
+// Schedule notifications for `characteristic`. The first call starts the flush timer.
+esp_err_t notify_scheduler_add(homekit_characteristic_t *characteristic, const notify_limits_t *limits);
+
+// Store `value` in the characteristic right away and notify at the next tick if the limits allow.
+// Several updates before the tick send only the latest value.
+esp_err_t notify_scheduler_update(homekit_characteristic_t *characteristic, homekit_value_t value);
+
+// Store and notify immediately, ignoring interval and deadband. Use for edge events such as
+// motion onset that must never wait for the tick.
+esp_err_t notify_scheduler_update_now(homekit_characteristic_t *characteristic, homekit_value_t value);
+
+// Copy the counters of one characteristic, or the totals when `characteristic` is NULL
+esp_err_t notify_scheduler_get_stats(const homekit_characteristic_t *characteristic, notify_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
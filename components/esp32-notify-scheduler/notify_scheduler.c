@@ -0,0 +1,225 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <math.h>
+#include <stdlib.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <homekit/homekit.h>
+#include "notify_scheduler.h"
+
+static const char *TAG = "NOTIFY_SCHEDULER";
+
+typedef struct {
+        homekit_characteristic_t *characteristic;
+        notify_limits_t limits;
+        homekit_value_t pending_value;
+        homekit_value_t sent_value;
+        int64_t sent_us;
+        bool pending;
+        bool sent_once;
+        notify_stats_t stats;
+} notify_entry_t;
+
+static notify_entry_t entries[CONFIG_NOTIFY_SCHEDULER_MAX_CHARACTERISTICS];
+static int entry_count = 0;
+static notify_stats_t totals;
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static esp_timer_handle_t flush_timer = NULL;
+
+static notify_entry_t *find_entry(const homekit_characteristic_t *characteristic) {
+        for (int i = 0; i < entry_count; i++) {
+                if (entries[i].characteristic == characteristic) {
+                        return &entries[i];
+                }
+        }
+        return NULL;
+}
+
+// Whether `value` moved far enough from the last notified value to be worth sending
+static bool outside_deadband(const notify_entry_t *entry, homekit_value_t value) {
+        homekit_value_t sent = entry->sent_value;
+
+        switch (value.format) {
+        case homekit_format_bool:
+                return value.bool_value != sent.bool_value;
+        case homekit_format_float:
+                return fabsf(value.float_value - sent.float_value) >= entry->limits.deadband &&
+                       value.float_value != sent.float_value;
+        case homekit_format_uint8:
+        case homekit_format_uint16:
+        case homekit_format_uint32:
+        case homekit_format_int:
+                return abs(value.int_value - sent.int_value) >= entry->limits.deadband &&
+                       value.int_value != sent.int_value;
+        default:
+                // Strings, TLV and data are always sent
+                return true;
+        }
+}
+
+static void flush_cb(void *arg) {
+        homekit_characteristic_t *to_send[CONFIG_NOTIFY_SCHEDULER_MAX_CHARACTERISTICS];
+        homekit_value_t values[CONFIG_NOTIFY_SCHEDULER_MAX_CHARACTERISTICS];
+        int send_count = 0;
+        int64_t now = esp_timer_get_time();
+
+        portENTER_CRITICAL(&lock);
+        for (int i = 0; i < entry_count; i++) {
+                notify_entry_t *entry = &entries[i];
+                if (!entry->pending) {
+                        continue;
+                }
+                int64_t since_sent = now - entry->sent_us;
+                if (entry->sent_once && since_sent < (int64_t)entry->limits.min_interval_ms * 1000) {
+                        // Stays pending until the interval has passed
+                        continue;
+                }
+                entry->pending = false;
+                bool heartbeat = entry->limits.max_interval_ms &&
+                                 since_sent >= (int64_t)entry->limits.max_interval_ms * 1000;
+                if (entry->sent_once && !heartbeat && !outside_deadband(entry, entry->pending_value)) {
+                        entry->stats.suppressed++;
+                        totals.suppressed++;
+                        continue;
+                }
+                entry->sent_value = entry->pending_value;
+                entry->sent_us = now;
+                entry->sent_once = true;
+                entry->stats.sent++;
+                totals.sent++;
+                to_send[send_count] = entry->characteristic;
+                values[send_count] = entry->pending_value;
+                send_count++;
+        }
+        portEXIT_CRITICAL(&lock);
+
+        for (int i = 0; i < send_count; i++) {
+                homekit_characteristic_notify(to_send[i], values[i]);
+        }
+}
+
+esp_err_t notify_scheduler_add(homekit_characteristic_t *characteristic, const notify_limits_t *limits) {
+        if (!characteristic || !limits) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        if (!flush_timer) {
+                const esp_timer_create_args_t timer_args = {
+                        .callback = flush_cb,
+                        .name = "notify_flush",
+                };
+                esp_err_t err = esp_timer_create(&timer_args, &flush_timer);
+                if (err == ESP_OK) {
+                        err = esp_timer_start_periodic(flush_timer, CONFIG_NOTIFY_SCHEDULER_TICK_MS * 1000);
+                }
+                if (err != ESP_OK) {
+                        ESP_LOGE(TAG, "Flush timer: %s", esp_err_to_name(err));
+                        return err;
+                }
+        }
+
+        portENTER_CRITICAL(&lock);
+        notify_entry_t *entry = find_entry(characteristic);
+        if (!entry && entry_count < CONFIG_NOTIFY_SCHEDULER_MAX_CHARACTERISTICS) {
+                entry = &entries[entry_count++];
+                *entry = (notify_entry_t) {
+                        .characteristic = characteristic,
+                };
+        }
+        if (entry) {
+                entry->limits = *limits;
+        }
+        portEXIT_CRITICAL(&lock);
+
+        if (!entry) {
+                ESP_LOGE(TAG, "No room for more characteristics");
+                return ESP_ERR_NO_MEM;
+        }
+        return ESP_OK;
+}
+
+esp_err_t notify_scheduler_update(homekit_characteristic_t *characteristic, homekit_value_t value) {
+        portENTER_CRITICAL(&lock);
+        notify_entry_t *entry = find_entry(characteristic);
+        if (entry) {
+                characteristic->value = value;
+                if (entry->pending) {
+                        entry->stats.coalesced++;
+                        totals.coalesced++;
+                }
+                entry->pending_value = value;
+                entry->pending = true;
+                entry->stats.updates++;
+                totals.updates++;
+        }
+        portEXIT_CRITICAL(&lock);
+
+        return entry ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t notify_scheduler_update_now(homekit_characteristic_t *characteristic, homekit_value_t value) {
+        portENTER_CRITICAL(&lock);
+        notify_entry_t *entry = find_entry(characteristic);
+        if (entry) {
+                characteristic->value = value;
+                entry->pending = false;
+                entry->sent_value = value;
+                entry->sent_us = esp_timer_get_time();
+                entry->sent_once = true;
+                entry->stats.updates++;
+                entry->stats.sent++;
+                entry->stats.immediate++;
+                totals.updates++;
+                totals.sent++;
+                totals.immediate++;
+        }
+        portEXIT_CRITICAL(&lock);
+
+        if (!entry) {
+                return ESP_ERR_NOT_FOUND;
+        }
+        homekit_characteristic_notify(characteristic, value);
+        return ESP_OK;
+}
+
+esp_err_t notify_scheduler_get_stats(const homekit_characteristic_t *characteristic, notify_stats_t *stats) {
+        if (!stats) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        esp_err_t err = ESP_OK;
+
+        portENTER_CRITICAL(&lock);
+        if (!characteristic) {
+                *stats = totals;
+        } else {
+                notify_entry_t *entry = find_entry(characteristic);
+                if (entry) {
+                        *stats = entry->stats;
+                } else {
+                        err = ESP_ERR_NOT_FOUND;
+                }
+        }
+        portEXIT_CRITICAL(&lock);
+        return err;
+}
@@ -0,0 +1,76 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stdint.h>
+#include <esp_err.h>
+#include <driver/ledc.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PWM_POOL_MAX_CHANNELS 4
+
+typedef enum {
+        PWM_POOL_MODE_ANY = 0,      // high speed where the chip has it, then low speed
+        PWM_POOL_MODE_HIGH_SPEED,
+        PWM_POOL_MODE_LOW_SPEED,
+} pwm_pool_mode_t;
+
+// Outputs of one accessory. They always end up on one speed mode and one timer, so they can
+// be handed to light_fade as a group.
+typedef struct {
+        const char *owner;                  // shown in the diagnostics
+        int gpios[PWM_POOL_MAX_CHANNELS];
+        uint8_t gpio_count;
+        uint32_t freq_hz;
+        ledc_timer_bit_t duty_resolution;
+        pwm_pool_mode_t mode;
+} pwm_pool_config_t;
+
+typedef struct {
+        ledc_mode_t speed_mode;
+        ledc_timer_t timer;
+        ledc_channel_t channels[PWM_POOL_MAX_CHANNELS];   // in the order of the GPIOs
+        uint8_t channel_count;
+        uint32_t duty_max;
+} pwm_pool_group_t;
+
+// Claim a channel for every GPIO and configure it with duty 0. Channels with the same frequency
+// and resolution share a timer. When the LEDC runs out of channels or timers, or a GPIO is
+// already taken, the claim fails with ESP_ERR_NOT_FOUND or ESP_ERR_INVALID_STATE and the
+// current allocation is logged.
+esp_err_t pwm_pool_claim(const pwm_pool_config_t *config, pwm_pool_group_t *group);
+
+// Stop the channels and give them back; the timer is paused once its last channel is released
+// and resumed when a later claim reuses it
+void pwm_pool_release(const pwm_pool_group_t *group);
+
+// Log every timer and channel in use, with its owner
+void pwm_pool_log_usage(void);
+
+#ifdef __cplusplus
+}
+#endif
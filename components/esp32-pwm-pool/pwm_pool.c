@@ -0,0 +1,277 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <soc/soc_caps.h>
+#include "pwm_pool.h"
+
+static const char *TAG = "PWM_POOL";
+
+typedef struct {
+        uint32_t freq_hz;
+        ledc_timer_bit_t duty_resolution;
+        uint8_t users;                      // channels on this timer; free at 0
+} pool_timer_t;
+
+typedef struct {
+        const char *owner;                  // NULL while the channel is free
+        int gpio;
+} pool_channel_t;
+
+static pool_timer_t timers[LEDC_SPEED_MODE_MAX][LEDC_TIMER_MAX];
+static pool_channel_t channels[LEDC_SPEED_MODE_MAX][LEDC_CHANNEL_MAX];
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *mode_name(ledc_mode_t mode) {
+#if SOC_LEDC_SUPPORT_HS_MODE
+        if (mode == LEDC_HIGH_SPEED_MODE) {
+                return "high speed";
+        }
+#endif
+        return "low speed";
+}
+
+// Speed modes to try, in order of preference
+static int candidate_modes(pwm_pool_mode_t mode, ledc_mode_t *modes) {
+        int count = 0;
+
+#if SOC_LEDC_SUPPORT_HS_MODE
+        if (mode != PWM_POOL_MODE_LOW_SPEED) {
+                modes[count++] = LEDC_HIGH_SPEED_MODE;
+        }
+#endif
+        if (mode != PWM_POOL_MODE_HIGH_SPEED) {
+                modes[count++] = LEDC_LOW_SPEED_MODE;
+        }
+        return count;
+}
+
+static bool gpio_claimed(int gpio) {
+        for (int mode = 0; mode < LEDC_SPEED_MODE_MAX; mode++) {
+                for (int channel = 0; channel < LEDC_CHANNEL_MAX; channel++) {
+                        if (channels[mode][channel].owner && channels[mode][channel].gpio == gpio) {
+                                return true;
+                        }
+                }
+        }
+        return false;
+}
+
+// A timer already running at the same frequency and resolution, or else a free one
+static int find_timer(ledc_mode_t mode, uint32_t freq_hz, ledc_timer_bit_t duty_resolution) {
+        int free_timer = -1;
+
+        for (int timer = 0; timer < LEDC_TIMER_MAX; timer++) {
+                const pool_timer_t *candidate = &timers[mode][timer];
+                if (!candidate->users) {
+                        if (free_timer < 0) {
+                                free_timer = timer;
+                        }
+                } else if (candidate->freq_hz == freq_hz && candidate->duty_resolution == duty_resolution) {
+                        return timer;
+                }
+        }
+        return free_timer;
+}
+
+// Called with `lock` held; books a timer and the channels in `mode` if they are all available
+static bool reserve(const pwm_pool_config_t *config, const char *owner, ledc_mode_t mode,
+                    pwm_pool_group_t *group, bool *new_timer) {
+        int timer = find_timer(mode, config->freq_hz, config->duty_resolution);
+        if (timer < 0) {
+                return false;
+        }
+
+        int found = 0;
+        for (int channel = 0; channel < LEDC_CHANNEL_MAX && found < config->gpio_count; channel++) {
+                if (!channels[mode][channel].owner) {
+                        group->channels[found++] = channel;
+                }
+        }
+        if (found < config->gpio_count) {
+                return false;
+        }
+
+        for (int i = 0; i < config->gpio_count; i++) {
+                channels[mode][group->channels[i]] = (pool_channel_t) {
+                        .owner = owner,
+                        .gpio = config->gpios[i],
+                };
+        }
+        *new_timer = !timers[mode][timer].users;
+        timers[mode][timer].freq_hz = config->freq_hz;
+        timers[mode][timer].duty_resolution = config->duty_resolution;
+        timers[mode][timer].users += config->gpio_count;
+
+        group->speed_mode = mode;
+        group->timer = timer;
+        group->channel_count = config->gpio_count;
+        group->duty_max = (1 << config->duty_resolution) - 1;
+        return true;
+}
+
+esp_err_t pwm_pool_claim(const pwm_pool_config_t *config, pwm_pool_group_t *group) {
+        if (!config || !group || !config->gpio_count || config->gpio_count > PWM_POOL_MAX_CHANNELS ||
+            !config->freq_hz || !config->duty_resolution) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        for (int i = 0; i < config->gpio_count; i++) {
+                for (int j = 0; j < i; j++) {
+                        if (config->gpios[i] == config->gpios[j]) {
+                                return ESP_ERR_INVALID_ARG;
+                        }
+                }
+        }
+
+        const char *owner = config->owner ? config->owner : "unnamed";
+        ledc_mode_t modes[LEDC_SPEED_MODE_MAX];
+        int mode_count = candidate_modes(config->mode, modes);
+        if (!mode_count) {
+                ESP_LOGE(TAG, "%s: this chip has no high speed LEDC channels", owner);
+                return ESP_ERR_NOT_SUPPORTED;
+        }
+
+        int claimed_gpio = -1;
+        bool reserved = false;
+        bool new_timer = false;
+
+        memset(group, 0, sizeof(*group));
+        portENTER_CRITICAL(&lock);
+        for (int i = 0; i < config->gpio_count && claimed_gpio < 0; i++) {
+                if (gpio_claimed(config->gpios[i])) {
+                        claimed_gpio = config->gpios[i];
+                }
+        }
+        for (int i = 0; i < mode_count && claimed_gpio < 0 && !reserved; i++) {
+                reserved = reserve(config, owner, modes[i], group, &new_timer);
+        }
+        portEXIT_CRITICAL(&lock);
+
+        if (claimed_gpio >= 0) {
+                ESP_LOGE(TAG, "%s: GPIO %d is already driven by a PWM channel", owner, claimed_gpio);
+                pwm_pool_log_usage();
+                return ESP_ERR_INVALID_STATE;
+        }
+        if (!reserved) {
+                ESP_LOGE(TAG, "%s: no room for %d channels at %" PRIu32 " Hz, %d bit; "
+                         "every timer runs another frequency or the channels are used up",
+                         owner, config->gpio_count, config->freq_hz, config->duty_resolution);
+                pwm_pool_log_usage();
+                return ESP_ERR_NOT_FOUND;
+        }
+
+        esp_err_t err = ESP_OK;
+        if (new_timer) {
+                const ledc_timer_config_t timer_config = {
+                        .speed_mode = group->speed_mode,
+                        .timer_num = group->timer,
+                        .duty_resolution = config->duty_resolution,
+                        .freq_hz = config->freq_hz,
+                        .clk_cfg = LEDC_AUTO_CLK,
+                };
+                err = ledc_timer_config(&timer_config);
+                if (err == ESP_OK) {
+                        // The timer may have been paused when its last group was released
+                        err = ledc_timer_resume(group->speed_mode, group->timer);
+                }
+        }
+        for (int i = 0; i < group->channel_count && err == ESP_OK; i++) {
+                const ledc_channel_config_t channel_config = {
+                        .gpio_num = config->gpios[i],
+                        .speed_mode = group->speed_mode,
+                        .channel = group->channels[i],
+                        .intr_type = LEDC_INTR_DISABLE,
+                        .timer_sel = group->timer,
+                        .duty = 0,
+                        .hpoint = 0,
+                };
+                err = ledc_channel_config(&channel_config);
+        }
+        if (err != ESP_OK) {
+                ESP_LOGE(TAG, "%s: LEDC configuration: %s", owner, esp_err_to_name(err));
+                pwm_pool_release(group);
+                return err;
+        }
+
+        ESP_LOGI(TAG, "%s: %d channels on %s timer %d at %" PRIu32 " Hz", owner, group->channel_count,
+                 mode_name(group->speed_mode), group->timer, config->freq_hz);
+        return ESP_OK;
+}
+
+void pwm_pool_release(const pwm_pool_group_t *group) {
+        bool timer_free = false;
+
+        if (!group || !group->channel_count) {
+                return;
+        }
+        for (int i = 0; i < group->channel_count; i++) {
+                ledc_stop(group->speed_mode, group->channels[i], 0);
+        }
+
+        portENTER_CRITICAL(&lock);
+        for (int i = 0; i < group->channel_count; i++) {
+                channels[group->speed_mode][group->channels[i]] = (pool_channel_t) { 0 };
+        }
+        pool_timer_t *timer = &timers[group->speed_mode][group->timer];
+        timer->users -= group->channel_count < timer->users ? group->channel_count : timer->users;
+        timer_free = !timer->users;
+        portEXIT_CRITICAL(&lock);
+
+        if (timer_free) {
+                ledc_timer_pause(group->speed_mode, group->timer);
+        }
+}
+
+void pwm_pool_log_usage(void) {
+        pool_timer_t timer_copy[LEDC_SPEED_MODE_MAX][LEDC_TIMER_MAX];
+        pool_channel_t channel_copy[LEDC_SPEED_MODE_MAX][LEDC_CHANNEL_MAX];
+
+        // Log from a copy; logging inside the critical section would stall the other core
+        portENTER_CRITICAL(&lock);
+        memcpy(timer_copy, timers, sizeof(timers));
+        memcpy(channel_copy, channels, sizeof(channels));
+        portEXIT_CRITICAL(&lock);
+
+        for (int mode = 0; mode < LEDC_SPEED_MODE_MAX; mode++) {
+                for (int timer = 0; timer < LEDC_TIMER_MAX; timer++) {
+                        const pool_timer_t *entry = &timer_copy[mode][timer];
+                        if (entry->users) {
+                                ESP_LOGI(TAG, "%s timer %d: %" PRIu32 " Hz, %d bit, %d channels", mode_name(mode),
+                                         timer, entry->freq_hz, entry->duty_resolution, entry->users);
+                        } else {
+                                ESP_LOGI(TAG, "%s timer %d: free", mode_name(mode), timer);
+                        }
+                }
+                for (int channel = 0; channel < LEDC_CHANNEL_MAX; channel++) {
+                        const pool_channel_t *entry = &channel_copy[mode][channel];
+                        if (entry->owner) {
+                                ESP_LOGI(TAG, "%s channel %d: GPIO %d, %s", mode_name(mode), channel,
+                                         entry->gpio, entry->owner);
+                        }
+                }
+        }
+}
@@ -0,0 +1,62 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stdint.h>
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*render_scheduler_cb_t)(void *context);
+
+// Setters change their state and call render_scheduler_request(); the callback then runs once
+// on the esp_timer task, `interval_ms` after the first request of a burst. Renders are at least
+// one interval apart and every request is rendered within `interval_ms`.
+typedef struct {
+        uint32_t interval_ms;
+        render_scheduler_cb_t callback;
+        void *context;
+} render_scheduler_config_t;
+
+typedef struct {
+        uint32_t requests;
+        uint32_t renders;
+        uint32_t latency_max_us;    // longest time from a request to the render that covered it
+} render_scheduler_stats_t;
+
+typedef struct render_scheduler *render_scheduler_handle_t;
+
+esp_err_t render_scheduler_create(const render_scheduler_config_t *config, render_scheduler_handle_t *handle);
+
+void render_scheduler_request(render_scheduler_handle_t scheduler);
+
+void render_scheduler_get_stats(render_scheduler_handle_t scheduler, render_scheduler_stats_t *stats);
+
+void render_scheduler_delete(render_scheduler_handle_t scheduler);
+
+#ifdef __cplusplus
+}
+#endif
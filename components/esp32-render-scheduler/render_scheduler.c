@@ -0,0 +1,111 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include "render_scheduler.h"
+
+struct render_scheduler {
+        render_scheduler_config_t config;
+        esp_timer_handle_t timer;
+        portMUX_TYPE lock;
+        bool pending;
+        int64_t first_request_us;   // oldest request not rendered yet
+        render_scheduler_stats_t stats;
+};
+
+static void timer_cb(void *arg) {
+        struct render_scheduler *scheduler = arg;
+        int64_t now = esp_timer_get_time();
+
+        // Requests from here on schedule the next render
+        portENTER_CRITICAL(&scheduler->lock);
+        scheduler->pending = false;
+        scheduler->stats.renders++;
+        if (now - scheduler->first_request_us > scheduler->stats.latency_max_us) {
+                scheduler->stats.latency_max_us = now - scheduler->first_request_us;
+        }
+        portEXIT_CRITICAL(&scheduler->lock);
+
+        scheduler->config.callback(scheduler->config.context);
+}
+
+esp_err_t render_scheduler_create(const render_scheduler_config_t *config, render_scheduler_handle_t *handle) {
+        if (!config || !handle || !config->callback) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        struct render_scheduler *scheduler = calloc(1, sizeof(*scheduler));
+        if (!scheduler) {
+                return ESP_ERR_NO_MEM;
+        }
+        scheduler->config = *config;
+        portMUX_INITIALIZE(&scheduler->lock);
+
+        const esp_timer_create_args_t timer_args = {
+                .callback = timer_cb,
+                .arg = scheduler,
+                .name = "render_scheduler",
+        };
+        esp_err_t err = esp_timer_create(&timer_args, &scheduler->timer);
+        if (err != ESP_OK) {
+                free(scheduler);
+                return err;
+        }
+
+        *handle = scheduler;
+        return ESP_OK;
+}
+
+void render_scheduler_request(render_scheduler_handle_t scheduler) {
+        int64_t interval_us = (int64_t)scheduler->config.interval_ms * 1000;
+        int64_t now = esp_timer_get_time();
+
+        portENTER_CRITICAL(&scheduler->lock);
+        scheduler->stats.requests++;
+        if (!scheduler->pending) {
+                // The rest of the burst arrives while the timer runs. A render is always a full
+                // interval after a request that came in after the previous render, so renders
+                // are at least one interval apart as well.
+                scheduler->pending = true;
+                scheduler->first_request_us = now;
+                esp_timer_start_once(scheduler->timer, interval_us);
+        }
+        portEXIT_CRITICAL(&scheduler->lock);
+}
+
+void render_scheduler_get_stats(render_scheduler_handle_t scheduler, render_scheduler_stats_t *stats) {
+        portENTER_CRITICAL(&scheduler->lock);
+        *stats = scheduler->stats;
+        portEXIT_CRITICAL(&scheduler->lock);
+}
+
+void render_scheduler_delete(render_scheduler_handle_t scheduler) {
+        if (!scheduler) {
+                return;
+        }
+        esp_timer_stop(scheduler->timer);
+        esp_timer_delete(scheduler->timer);
+        free(scheduler);
+}
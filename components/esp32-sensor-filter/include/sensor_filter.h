@@ -0,0 +1,66 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SENSOR_FILTER_MEDIAN_MAX 7
+
+// A reading is published when it leaves any of the enabled deadbands around the last published
+// value, or when the heartbeat is due. With every deadband at 0 any change is published.
+typedef struct {
+        float abs_deadband;         // in sensor units, e.g. 0.5 for °C
+        float rel_deadband;         // fraction of the last published value, e.g. 0.05 for 5 %
+        float log_deadband;         // change of log10(value + 1), for values spanning decades such as lux
+        uint32_t heartbeat_ms;      // publish an unchanged value after this long; 0 disables
+        uint8_t median_window;      // median of the last N readings rejects single spikes; 0 or 1 disables
+} sensor_filter_config_t;
+
+typedef struct {
+        uint32_t readings;          // values passed to sensor_filter_update()
+        uint32_t published;         // readings that should be notified
+        uint32_t heartbeats;        // of which published only because the heartbeat was due
+} sensor_filter_stats_t;
+
+typedef struct sensor_filter *sensor_filter_handle_t;
+
+esp_err_t sensor_filter_create(const sensor_filter_config_t *config, sensor_filter_handle_t *handle);
+
+// Feed one raw reading. `value` receives the spike-filtered reading, which is what the
+// characteristic should hold. Returns true when that value should also be notified.
+bool sensor_filter_update(sensor_filter_handle_t filter, float reading, float *value);
+
+void sensor_filter_get_stats(sensor_filter_handle_t filter, sensor_filter_stats_t *stats);
+
+void sensor_filter_delete(sensor_filter_handle_t filter);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,129 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <math.h>
+#include <stdlib.h>
+#include <esp_timer.h>
+#include "sensor_filter.h"
+
+struct sensor_filter {
+        sensor_filter_config_t config;
+        float window[SENSOR_FILTER_MEDIAN_MAX];
+        uint8_t window_count;
+        uint8_t window_next;
+        bool has_published;
+        float published;
+        int64_t published_us;
+        sensor_filter_stats_t stats;
+};
+
+// Median of the readings in the window; the window is at most SENSOR_FILTER_MEDIAN_MAX long
+static float median(const struct sensor_filter *filter) {
+        float sorted[SENSOR_FILTER_MEDIAN_MAX];
+        int count = filter->window_count;
+
+        for (int i = 0; i < count; i++) {
+                float value = filter->window[i];
+                int j = i;
+                while (j > 0 && sorted[j - 1] > value) {
+                        sorted[j] = sorted[j - 1];
+                        j--;
+                }
+                sorted[j] = value;
+        }
+        if (count % 2) {
+                return sorted[count / 2];
+        }
+        return (sorted[count / 2 - 1] + sorted[count / 2]) / 2;
+}
+
+static bool outside_deadband(const struct sensor_filter *filter, float value) {
+        const sensor_filter_config_t *config = &filter->config;
+        float delta = fabsf(value - filter->published);
+
+        if (!config->abs_deadband && !config->rel_deadband && !config->log_deadband) {
+                return delta > 0;
+        }
+        if (config->abs_deadband && delta >= config->abs_deadband) {
+                return true;
+        }
+        if (config->rel_deadband && delta >= config->rel_deadband * fabsf(filter->published)) {
+                return true;
+        }
+        if (config->log_deadband &&
+            fabsf(log10f(fabsf(value) + 1) - log10f(fabsf(filter->published) + 1)) >= config->log_deadband) {
+                return true;
+        }
+        return false;
+}
+
+esp_err_t sensor_filter_create(const sensor_filter_config_t *config, sensor_filter_handle_t *handle) {
+        if (!config || !handle || config->median_window > SENSOR_FILTER_MEDIAN_MAX) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        struct sensor_filter *filter = calloc(1, sizeof(*filter));
+        if (!filter) {
+                return ESP_ERR_NO_MEM;
+        }
+        filter->config = *config;
+        if (filter->config.median_window == 0) {
+                filter->config.median_window = 1;
+        }
+
+        *handle = filter;
+        return ESP_OK;
+}
+
+bool sensor_filter_update(sensor_filter_handle_t filter, float reading, float *value) {
+        filter->window[filter->window_next] = reading;
+        filter->window_next = (filter->window_next + 1) % filter->config.median_window;
+        if (filter->window_count < filter->config.median_window) {
+                filter->window_count++;
+        }
+        float filtered = median(filter);
+        *value = filtered;
+        filter->stats.readings++;
+
+        int64_t now = esp_timer_get_time();
+        bool publish = !filter->has_published || outside_deadband(filter, filtered);
+        if (!publish && filter->config.heartbeat_ms &&
+            now - filter->published_us >= (int64_t)filter->config.heartbeat_ms * 1000) {
+                publish = true;
+                filter->stats.heartbeats++;
+        }
+        if (publish) {
+                filter->has_published = true;
+                filter->published = filtered;
+                filter->published_us = now;
+                filter->stats.published++;
+        }
+        return publish;
+}
+
+void sensor_filter_get_stats(sensor_filter_handle_t filter, sensor_filter_stats_t *stats) {
+        *stats = filter->stats;
+}
+
+void sensor_filter_delete(sensor_filter_handle_t filter) {
+        free(filter);
+}
@@ -0,0 +1,62 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Guards a plain struct that is written rarely and read often. Writers bump the sequence to
+// odd, change the fields and bump it back to even; readers copy the struct and retry when the
+// sequence moved, so they never block and never see a mix of old and new fields.
+typedef struct {
+        uint32_t sequence;
+        portMUX_TYPE writer;        // serialises writers and keeps them from being preempted mid-write
+} seqlock_t;
+
+#define SEQLOCK_INIT { .sequence = 0, .writer = portMUX_INITIALIZER_UNLOCKED }
+
+// Keep the write section to plain field stores; interrupts are off on this core until the end
+void seqlock_write_begin(seqlock_t *lock);
+void seqlock_write_end(seqlock_t *lock);
+
+uint32_t seqlock_read_begin(const seqlock_t *lock);
+bool seqlock_read_retry(const seqlock_t *lock, uint32_t sequence);
+
+// Copy `src` to `dst` as one consistent snapshot
+#define SEQLOCK_READ(lock, dst, src) do {                         \
+                uint32_t __sequence;                            \
+                do {                                            \
+                        __sequence = seqlock_read_begin(lock);  \
+                        (dst) = (src);                          \
+                } while (seqlock_read_retry(lock, __sequence)); \
+} while (0)
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,53 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include "seqlock.h"
+
+void seqlock_write_begin(seqlock_t *lock) {
+        portENTER_CRITICAL(&lock->writer);
+        __atomic_store_n(&lock->sequence, lock->sequence + 1, __ATOMIC_RELAXED);
+        // The odd sequence is visible before any field changes
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void seqlock_write_end(seqlock_t *lock) {
+        // Every field change is visible before the even sequence
+        __atomic_store_n(&lock->sequence, lock->sequence + 1, __ATOMIC_RELEASE);
+        portEXIT_CRITICAL(&lock->writer);
+}
+
+uint32_t seqlock_read_begin(const seqlock_t *lock) {
+        uint32_t sequence;
+
+        // An odd sequence means a writer on the other core is between begin and end; that
+        // window is a handful of stores with interrupts off, so spinning is bounded
+        while ((sequence = __atomic_load_n(&lock->sequence, __ATOMIC_ACQUIRE)) & 1) {
+        }
+        return sequence;
+}
+
+bool seqlock_read_retry(const seqlock_t *lock, uint32_t sequence) {
+        // The copy is complete before the sequence is checked again
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        return __atomic_load_n(&lock->sequence, __ATOMIC_RELAXED) != sequence;
+}
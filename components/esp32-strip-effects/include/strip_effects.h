@@ -0,0 +1,87 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <strip_render.h>
+#include <color_lut.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+        STRIP_EFFECT_NONE = 0,      // no animation; the caller renders a static colour
+        STRIP_EFFECT_RAINBOW,       // hue wheel spread over the strip, rotating
+        STRIP_EFFECT_CHASE,         // groups of the primary colour running along the strip
+        STRIP_EFFECT_TWINKLE,       // random pixels flash in the primary colour and fade out
+        STRIP_EFFECT_FIRE,          // heat simulation rising from the start of the strip
+        STRIP_EFFECT_BREATHING,     // the primary colour slowly fading in and out
+        STRIP_EFFECT_GRADIENT,      // primary at the start blending into secondary at the end
+        STRIP_EFFECT_COUNT,
+} strip_effect_t;
+
+typedef struct {
+        strip_render_handle_t render;   // frames are drawn into this frame buffer
+        uint32_t length;                // pixels, at most the render length
+        uint32_t frame_rate;            // frames per second
+} strip_effects_config_t;
+
+typedef struct {
+        strip_effect_t effect;
+        color_rgbw_t primary;
+        color_rgbw_t secondary;
+        uint8_t brightness;             // percent, for effects that make their own colours
+} strip_effect_params_t;
+
+typedef struct {
+        uint32_t frames;
+        uint32_t overruns;              // frames that took longer to compute than the frame period
+        uint32_t compute_us;            // compute and hand-off time of the last frame
+        uint32_t compute_max_us;
+} strip_effects_stats_t;
+
+typedef struct strip_effects *strip_effects_handle_t;
+
+esp_err_t strip_effects_create(const strip_effects_config_t *config, strip_effects_handle_t *handle);
+
+// Run an effect, or change the colours of the running one without restarting its animation.
+// STRIP_EFFECT_NONE stops the engine. Frames are rendered from an esp_timer callback, so
+// callers drawing from other esp_timer callbacks never interleave with a frame.
+esp_err_t strip_effects_start(strip_effects_handle_t effects, const strip_effect_params_t *params);
+
+// Stop rendering; the strip keeps the last frame until the caller draws over it
+void strip_effects_stop(strip_effects_handle_t effects);
+
+bool strip_effects_running(strip_effects_handle_t effects);
+
+void strip_effects_get_stats(strip_effects_handle_t effects, strip_effects_stats_t *stats);
+
+void strip_effects_delete(strip_effects_handle_t effects);
+
+#ifdef __cplusplus
+}
+#endif
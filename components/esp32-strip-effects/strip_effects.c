@@ -0,0 +1,330 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include "strip_effects.h"
+
+static const char *TAG = "STRIP_EFFECTS";
+
+#define RAINBOW_PERIOD_MS   5000    // one turn of the hue wheel
+#define CHASE_SPACING       8       // pixels from one group to the next
+#define CHASE_SPEED         20      // pixels per second
+#define TWINKLE_RATE        2       // seconds between flashes of one pixel, on average
+#define FIRE_COOLING        55      // higher makes shorter flames
+#define FIRE_SPARKING       120     // chance out of 255 of a new spark each frame
+#define BREATHING_PERIOD_MS 4000
+
+struct strip_effects {
+        strip_effects_config_t config;
+        esp_timer_handle_t timer;
+        uint32_t period_us;
+
+        // Written by the caller, copied by each frame
+        portMUX_TYPE lock;
+        strip_effect_params_t params;
+        strip_effects_stats_t stats;
+
+        // Only touched by the frame callback
+        strip_effect_t rendered;    // effect the state below belongs to
+        uint32_t frame;
+        uint32_t random;
+        uint8_t *cells;             // twinkle level or fire heat per pixel
+        color_rgbw_t *colors;       // the frame, handed to the render layer in one call
+};
+
+// xorshift32: cheap, and the same sequence on every run so frames are reproducible
+static uint32_t next_random(struct strip_effects *effects) {
+        uint32_t x = effects->random;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        return effects->random = x;
+}
+
+static uint8_t scale8(uint8_t value, uint8_t level) {
+        return (uint16_t)value * (level + 1) >> 8;
+}
+
+static color_rgbw_t scale_color(const color_rgbw_t *color, uint8_t level) {
+        return (color_rgbw_t) {
+                .red = scale8(color->red, level),
+                .green = scale8(color->green, level),
+                .blue = scale8(color->blue, level),
+                .white = scale8(color->white, level),
+        };
+}
+
+static uint8_t blend8(uint8_t from, uint8_t to, uint8_t amount) {
+        return from + ((int)to - from) * amount / 255;
+}
+
+static void render_rainbow(struct strip_effects *effects, const strip_effect_params_t *params, uint32_t time_ms) {
+        uint32_t length = effects->config.length;
+        uint32_t shift = (time_ms % RAINBOW_PERIOD_MS) * 65536 / RAINBOW_PERIOD_MS;
+
+        for (uint32_t i = 0; i < length; i++) {
+                uint32_t position = (i * 65536 / length + shift) & 0xFFFF;
+                color_lut_hsv_to_rgb(position * 360 >> 16, 100, params->brightness, &effects->colors[i]);
+        }
+}
+
+static void render_chase(struct strip_effects *effects, const strip_effect_params_t *params, uint32_t time_ms) {
+        uint32_t offset = (uint64_t)time_ms * CHASE_SPEED / 1000 % CHASE_SPACING;
+
+        for (uint32_t i = 0; i < effects->config.length; i++) {
+                // Head at full strength with a two pixel tail behind it
+                uint32_t distance = (offset + CHASE_SPACING - i % CHASE_SPACING) % CHASE_SPACING;
+                uint8_t level = distance < 3 ? 255 >> (distance * 2) : 0;
+                effects->colors[i] = scale_color(&params->primary, level);
+        }
+}
+
+static void render_twinkle(struct strip_effects *effects, const strip_effect_params_t *params) {
+        uint32_t chance = 0xFFFFFFFFu / (TWINKLE_RATE * effects->config.frame_rate);
+
+        for (uint32_t i = 0; i < effects->config.length; i++) {
+                uint8_t level = effects->cells[i];
+                level -= (level >> 3) + (level ? 1 : 0);
+                if (next_random(effects) < chance) {
+                        level = 255;
+                }
+                effects->cells[i] = level;
+                effects->colors[i] = scale_color(&params->primary, level);
+        }
+}
+
+// Black through red and yellow to white as the heat rises
+static color_rgbw_t heat_color(uint8_t heat) {
+        uint8_t scaled = heat * 191 / 255;
+        uint8_t ramp = (scaled & 0x3F) << 2;
+
+        if (scaled >= 0x80) {
+                return (color_rgbw_t) { .red = 255, .green = 255, .blue = ramp };
+        }
+        if (scaled >= 0x40) {
+                return (color_rgbw_t) { .red = 255, .green = ramp };
+        }
+        return (color_rgbw_t) { .red = ramp };
+}
+
+static void render_fire(struct strip_effects *effects, const strip_effect_params_t *params) {
+        uint32_t length = effects->config.length;
+        uint8_t *heat = effects->cells;
+        uint8_t level = params->brightness * 255 / 100;
+
+        // Every cell cools, heat drifts away from the base and new sparks ignite near it
+        for (uint32_t i = 0; i < length; i++) {
+                uint32_t cooling = next_random(effects) % (FIRE_COOLING * 10 / length + 2);
+                heat[i] = heat[i] > cooling ? heat[i] - cooling : 0;
+        }
+        for (uint32_t i = length - 1; i >= 2; i--) {
+                heat[i] = (heat[i - 1] + 2 * heat[i - 2]) / 3;
+        }
+        if (next_random(effects) % 255 < FIRE_SPARKING) {
+                uint32_t spark = next_random(effects) % (length < 7 ? length : 7);
+                uint32_t value = heat[spark] + 160 + next_random(effects) % 96;
+                heat[spark] = value > 255 ? 255 : value;
+        }
+
+        for (uint32_t i = 0; i < length; i++) {
+                color_rgbw_t color = heat_color(heat[i]);
+                effects->colors[i] = scale_color(&color, level);
+        }
+}
+
+static void render_breathing(struct strip_effects *effects, const strip_effect_params_t *params, uint32_t time_ms) {
+        uint32_t phase = time_ms % BREATHING_PERIOD_MS;
+        uint32_t half = BREATHING_PERIOD_MS / 2;
+        uint32_t triangle = (phase < half ? phase : BREATHING_PERIOD_MS - phase) * 255 / half;
+
+        // Squaring the ramp lingers near dark, which reads as an even breath
+        color_rgbw_t color = scale_color(&params->primary, triangle * triangle / 255);
+        strip_render_fill(effects->config.render, &color);
+}
+
+static void render_gradient(struct strip_effects *effects, const strip_effect_params_t *params) {
+        uint32_t last = effects->config.length > 1 ? effects->config.length - 1 : 1;
+
+        // Unchanged pixels cost nothing in the frame buffer, so the static gradient is redrawn freely
+        for (uint32_t i = 0; i < effects->config.length; i++) {
+                uint8_t amount = i * 255 / last;
+                effects->colors[i] = (color_rgbw_t) {
+                        .red = blend8(params->primary.red, params->secondary.red, amount),
+                        .green = blend8(params->primary.green, params->secondary.green, amount),
+                        .blue = blend8(params->primary.blue, params->secondary.blue, amount),
+                        .white = blend8(params->primary.white, params->secondary.white, amount),
+                };
+        }
+}
+
+static void frame_cb(void *arg) {
+        struct strip_effects *effects = arg;
+        int64_t start = esp_timer_get_time();
+
+        portENTER_CRITICAL(&effects->lock);
+        strip_effect_params_t params = effects->params;
+        portEXIT_CRITICAL(&effects->lock);
+
+        if (params.effect != effects->rendered) {
+                effects->rendered = params.effect;
+                effects->frame = 0;
+                effects->random = 0x2545F491;
+                memset(effects->cells, 0, effects->config.length);
+        }
+        uint32_t time_ms = (uint64_t)effects->frame * 1000 / effects->config.frame_rate;
+        effects->frame++;
+
+        switch (params.effect) {
+        case STRIP_EFFECT_RAINBOW:
+                render_rainbow(effects, &params, time_ms);
+                break;
+        case STRIP_EFFECT_CHASE:
+                render_chase(effects, &params, time_ms);
+                break;
+        case STRIP_EFFECT_TWINKLE:
+                render_twinkle(effects, &params);
+                break;
+        case STRIP_EFFECT_FIRE:
+                render_fire(effects, &params);
+                break;
+        case STRIP_EFFECT_BREATHING:
+                render_breathing(effects, &params, time_ms);
+                break;
+        case STRIP_EFFECT_GRADIENT:
+                render_gradient(effects, &params);
+                break;
+        default:
+                return;
+        }
+        // Breathing fills the strip itself; every other effect drew into `colors`, which goes
+        // over under one lock of the render layer instead of one per pixel
+        if (params.effect != STRIP_EFFECT_BREATHING) {
+                strip_render_set_pixels(effects->config.render, 0, effects->config.length, effects->colors);
+        }
+        esp_err_t err = strip_render_show(effects->config.render);
+        if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Frame: %s", esp_err_to_name(err));
+        }
+
+        uint32_t compute_us = esp_timer_get_time() - start;
+        portENTER_CRITICAL(&effects->lock);
+        effects->stats.frames++;
+        effects->stats.compute_us = compute_us;
+        if (compute_us > effects->stats.compute_max_us) {
+                effects->stats.compute_max_us = compute_us;
+        }
+        if (compute_us > effects->period_us) {
+                effects->stats.overruns++;
+        }
+        portEXIT_CRITICAL(&effects->lock);
+}
+
+esp_err_t strip_effects_create(const strip_effects_config_t *config, strip_effects_handle_t *handle) {
+        if (!config || !handle || !config->render || !config->length || !config->frame_rate) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        struct strip_effects *effects = calloc(1, sizeof(*effects));
+        if (!effects) {
+                return ESP_ERR_NO_MEM;
+        }
+        effects->cells = calloc(config->length, 1);
+        effects->colors = calloc(config->length, sizeof(color_rgbw_t));
+        if (!effects->cells || !effects->colors) {
+                free(effects->cells);
+                free(effects->colors);
+                free(effects);
+                return ESP_ERR_NO_MEM;
+        }
+        effects->config = *config;
+        effects->period_us = 1000000 / config->frame_rate;
+        portMUX_INITIALIZE(&effects->lock);
+
+        const esp_timer_create_args_t timer_args = {
+                .callback = frame_cb,
+                .arg = effects,
+                .name = "strip_effects",
+                // Frames missed while the timer task was held up are dropped, not replayed back
+                // to back, so the effect keeps its pace after a stall
+                .skip_unhandled_events = true,
+        };
+        esp_err_t err = esp_timer_create(&timer_args, &effects->timer);
+        if (err != ESP_OK) {
+                free(effects->cells);
+                free(effects->colors);
+                free(effects);
+                return err;
+        }
+
+        *handle = effects;
+        return ESP_OK;
+}
+
+esp_err_t strip_effects_start(strip_effects_handle_t effects, const strip_effect_params_t *params) {
+        if (!params || params->effect >= STRIP_EFFECT_COUNT) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        if (params->effect == STRIP_EFFECT_NONE) {
+                strip_effects_stop(effects);
+                return ESP_OK;
+        }
+
+        portENTER_CRITICAL(&effects->lock);
+        effects->params = *params;
+        portEXIT_CRITICAL(&effects->lock);
+
+        if (esp_timer_is_active(effects->timer)) {
+                return ESP_OK;
+        }
+        // A restarted effect begins from its first frame
+        effects->rendered = STRIP_EFFECT_NONE;
+        return esp_timer_start_periodic(effects->timer, effects->period_us);
+}
+
+void strip_effects_stop(strip_effects_handle_t effects) {
+        esp_timer_stop(effects->timer);
+}
+
+bool strip_effects_running(strip_effects_handle_t effects) {
+        return esp_timer_is_active(effects->timer);
+}
+
+void strip_effects_get_stats(strip_effects_handle_t effects, strip_effects_stats_t *stats) {
+        portENTER_CRITICAL(&effects->lock);
+        *stats = effects->stats;
+        portEXIT_CRITICAL(&effects->lock);
+}
+
+void strip_effects_delete(strip_effects_handle_t effects) {
+        if (!effects) {
+                return;
+        }
+        esp_timer_stop(effects->timer);
+        esp_timer_delete(effects->timer);
+        free(effects->cells);
+        free(effects->colors);
+        free(effects);
+}
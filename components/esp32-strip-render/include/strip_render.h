@@ -0,0 +1,88 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <led_strip.h>
+#include <color_lut.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+        led_strip_handle_t strip;   // created by the caller; the render layer only writes to it
+        uint32_t length;            // pixels, at most the strip's max_leds
+        bool rgbw;                  // four bytes per pixel and led_strip_set_pixel_rgbw()
+        bool async;                 // transmit from a second buffer on a task; strip_render_show() returns at once
+        uint32_t max_current_ma;    // supply budget; frames estimated above it are dimmed as a whole, 0 for no limit
+        const char *name;           // tags the refresh trace; NULL for "strip"
+} strip_render_config_t;
+
+typedef struct {
+        uint32_t frames;            // strip_render_show() calls
+        uint32_t refreshes;         // frames that were sent to the strip
+        uint32_t pixels_written;    // pixels copied into the driver
+        uint32_t dropped;           // async frames replaced by a newer one before they were sent
+        uint32_t errors;            // async transmits that failed
+        uint32_t transmit_us;       // duration of the last transmit
+        uint32_t transmit_max_us;
+        uint32_t interval_us;       // time between the starts of the last two transmits
+        uint32_t wire_us;           // what a full refresh takes on the wire at 800 kbit/s, reset included
+        uint32_t current_ma;        // estimated current of the last frame sent, after limiting
+        uint32_t limited;           // frames sent dimmed to stay inside max_current_ma
+} strip_render_stats_t;
+
+typedef struct strip_render *strip_render_handle_t;
+
+esp_err_t strip_render_create(const strip_render_config_t *config, strip_render_handle_t *handle);
+
+// Set every pixel to one colour. Filling with the colour the strip already shows is free.
+void strip_render_fill(strip_render_handle_t render, const color_rgbw_t *color);
+
+// Set `count` pixels from `start` to one colour; pixels that already have it are not marked dirty
+void strip_render_fill_range(strip_render_handle_t render, uint32_t start, uint32_t count, const color_rgbw_t *color);
+
+void strip_render_set_pixel(strip_render_handle_t render, uint32_t index, const color_rgbw_t *color);
+
+// Set `count` pixels from `start` to `colors`, one colour each, under a single lock; for effects
+// that redraw the whole strip every frame
+void strip_render_set_pixels(strip_render_handle_t render, uint32_t start, uint32_t count, const color_rgbw_t *colors);
+
+// Send the pixels changed since the last call and refresh the strip. Returns ESP_OK without
+// touching the strip when nothing changed. With a current budget, a frame over it is scaled down
+// at once and brought back over a few frames; in sync mode that takes further calls. In async
+// mode the frame is handed to the transmit task and the call returns immediately; errors are then
+// only counted and logged.
+esp_err_t strip_render_show(strip_render_handle_t render);
+
+void strip_render_get_stats(strip_render_handle_t render, strip_render_stats_t *stats);
+
+void strip_render_delete(strip_render_handle_t render);
+
+#ifdef __cplusplus
+}
+#endif
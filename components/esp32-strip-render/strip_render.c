@@ -0,0 +1,633 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include "strip_render.h"
+
+static const char *TAG = "STRIP_RENDER";
+
+#define LIMIT_FULL_SCALE 256
+#define LIMIT_RELEASE_MS 20     // resend interval while an async limit recovers without new frames
+#define WIRE_US_PER_BYTE 10     // eight bits of 1.25 us
+#define WIRE_RESET_US 280
+#define TRACE_QUEUE_LENGTH 8
+#define TRACE_TASK_STACK_SIZE 3072
+
+typedef struct {
+        uint32_t time_us;
+        uint32_t transmit_us;
+        uint32_t first;
+        uint32_t last;
+        uint32_t current_ma;
+        uint32_t hash;
+        uint16_t scale;
+} trace_entry_t;
+
+struct strip_render {
+        strip_render_config_t config;
+        SemaphoreHandle_t lock;
+        uint8_t pixel_size;
+        uint8_t *frame;             // packed red, green, blue[, white] per pixel, composed by callers
+
+        // Pixels [dirty_first, dirty_last] differ from what the driver holds
+        bool dirty;
+        uint32_t dirty_first;
+        uint32_t dirty_last;
+
+        // Set while every pixel in `frame` has the same colour
+        bool uniform;
+
+        // Async mode: the transmit task copies the dirty range of `frame` into `transmit`
+        // and sends it, so callers compose the next frame while the strip is being written
+        uint8_t *transmit;
+        TaskHandle_t task;
+        TaskHandle_t deleting;
+        bool pending;
+        bool stop;
+        int64_t last_start_us;
+
+        // Power limiter, only touched by whoever writes the strip: brightness scale of the
+        // frame (of LIMIT_FULL_SCALE), the scale it heads for, and the scale the driver holds
+        uint16_t scale;
+        uint16_t scale_target;
+        uint16_t sent_scale;
+
+        strip_render_stats_t stats;
+
+#if CONFIG_STRIP_RENDER_TRACE_DEPTH
+        // Refreshes fill one buffer while the trace task prints the other; with both full,
+        // refreshes are only counted until the printed one is free again
+        trace_entry_t trace[2][CONFIG_STRIP_RENDER_TRACE_DEPTH];
+        uint8_t trace_active;
+        uint32_t trace_count;
+        bool trace_printing;
+        uint32_t trace_dropped;
+#endif
+};
+
+static void pack(const struct strip_render *render, const color_rgbw_t *color, uint8_t *pixel) {
+        pixel[0] = color->red;
+        pixel[1] = color->green;
+        pixel[2] = color->blue;
+        if (render->config.rgbw) {
+                pixel[3] = color->white;
+        }
+}
+
+static void mark_dirty(struct strip_render *render, uint32_t first, uint32_t last) {
+        if (!render->dirty) {
+                render->dirty = true;
+                render->dirty_first = first;
+                render->dirty_last = last;
+                return;
+        }
+        if (first < render->dirty_first) {
+                render->dirty_first = first;
+        }
+        if (last > render->dirty_last) {
+                render->dirty_last = last;
+        }
+}
+
+// Sum of every channel byte of `size` bytes, four bytes per step in two 16-bit lanes
+static uint32_t channel_sum(const uint8_t *pixels, size_t size) {
+        uint32_t total = 0;
+        size_t words = size / 4;
+        const uint8_t *cursor = pixels;
+
+        while (words) {
+                // A lane takes at most 510 per word, so 128 words fit before it could overflow
+                size_t chunk = words < 128 ? words : 128;
+                uint32_t lanes = 0;
+                for (size_t i = 0; i < chunk; i++, cursor += 4) {
+                        uint32_t word;
+                        memcpy(&word, cursor, sizeof(word));
+                        lanes += (word & 0x00FF00FF) + ((word >> 8) & 0x00FF00FF);
+                }
+                total += (lanes & 0xFFFF) + (lanes >> 16);
+                words -= chunk;
+        }
+        for (size_t i = size & ~(size_t)3; i < size; i++) {
+                total += pixels[i];
+        }
+        return total;
+}
+
+// Estimate the current of `pixels` and pick the scale that keeps the strip inside the budget.
+// Returns the current drawn at that scale in mA.
+static uint32_t limit(struct strip_render *render, const uint8_t *pixels) {
+        uint32_t budget_ma = render->config.max_current_ma;
+        uint32_t idle_ma = render->config.length * CONFIG_STRIP_RENDER_PIXEL_IDLE_MA;
+        uint32_t sum = channel_sum(pixels, render->config.length * render->pixel_size);
+        uint32_t drive_ma = (uint64_t)sum * CONFIG_STRIP_RENDER_CHANNEL_MA / 255;
+
+        uint32_t target = LIMIT_FULL_SCALE;
+        if (budget_ma && idle_ma + drive_ma > budget_ma) {
+                target = budget_ma > idle_ma ? (uint64_t)(budget_ma - idle_ma) * LIMIT_FULL_SCALE / drive_ma : 0;
+        }
+        render->scale_target = target;
+        if (target < render->scale) {
+                // Cut at once, the supply does not wait
+                render->scale = target;
+        } else {
+                // Recover over a few frames so a scene hovering at the budget does not pump
+                render->scale += (target - render->scale + 3) / 4;
+        }
+        return idle_ma + (uint64_t)drive_ma * render->scale / LIMIT_FULL_SCALE;
+}
+
+// Copy pixels [first, last] of `pixels` into the driver at `scale` and refresh the strip
+static esp_err_t write_strip(struct strip_render *render, const uint8_t *pixels, uint32_t first, uint32_t last,
+                             uint16_t scale) {
+        led_strip_handle_t strip = render->config.strip;
+        esp_err_t err = ESP_OK;
+
+        for (uint32_t i = first; i <= last && err == ESP_OK; i++) {
+                const uint8_t *source = pixels + i * render->pixel_size;
+                uint8_t pixel[4];
+                for (int c = 0; c < render->pixel_size; c++) {
+                        pixel[c] = source[c] * scale / LIMIT_FULL_SCALE;
+                }
+                if (render->config.rgbw) {
+                        err = led_strip_set_pixel_rgbw(strip, i, pixel[0], pixel[1], pixel[2], pixel[3]);
+                } else {
+                        err = led_strip_set_pixel(strip, i, pixel[0], pixel[1], pixel[2]);
+                }
+        }
+        return err == ESP_OK ? led_strip_refresh(strip) : err;
+}
+
+// Limit and send pixels [first, last]; the whole strip goes out when the scale moved
+static esp_err_t send(struct strip_render *render, const uint8_t *pixels, uint32_t *first, uint32_t *last,
+                      uint32_t *current_ma) {
+        *current_ma = limit(render, pixels);
+        if (render->scale != render->sent_scale) {
+                *first = 0;
+                *last = render->config.length - 1;
+        }
+        esp_err_t err = write_strip(render, pixels, *first, *last, render->scale);
+        if (err == ESP_OK) {
+                render->sent_scale = render->scale;
+        }
+        return err;
+}
+
+#if CONFIG_STRIP_RENDER_TRACE_DEPTH
+// FNV-1a over the frame as composed, so two captures of the same scene compare frame by frame
+static uint32_t trace_hash(const struct strip_render *render, const uint8_t *pixels) {
+        uint32_t hash = 2166136261u;
+        size_t size = render->config.length * render->pixel_size;
+
+        for (size_t i = 0; i < size; i++) {
+                hash = (hash ^ pixels[i]) * 16777619u;
+        }
+        return hash;
+}
+
+// Printed at the lowest priority, so a dump never delays a refresh or skews its timing
+static QueueHandle_t trace_queue;
+
+// Called with `lock` held; returns true when the active buffer filled up and was handed over
+static bool trace_swap(struct strip_render *render) {
+        if (render->trace_count < CONFIG_STRIP_RENDER_TRACE_DEPTH || render->trace_printing) {
+                return false;
+        }
+        render->trace_printing = true;
+        render->trace_active ^= 1;
+        render->trace_count = 0;
+        return true;
+}
+
+// Called with `lock` held; returns true when trace_post() has a buffer to print
+static bool trace_add(struct strip_render *render, const trace_entry_t *entry) {
+        if (render->trace_count == CONFIG_STRIP_RENDER_TRACE_DEPTH) {
+                render->trace_dropped++;
+                return false;
+        }
+        render->trace[render->trace_active][render->trace_count++] = *entry;
+        return trace_swap(render);
+}
+
+static void trace_post(struct strip_render *render, bool full) {
+        if (full && xQueueSend(trace_queue, &render, 0) != pdTRUE) {
+                // Never happens with fewer strips than queue slots; lose the buffer rather than block
+                xSemaphoreTake(render->lock, portMAX_DELAY);
+                render->trace_dropped += CONFIG_STRIP_RENDER_TRACE_DEPTH;
+                render->trace_printing = false;
+                xSemaphoreGive(render->lock);
+        }
+}
+
+// One "STRIP_RENDER: trace,name,time_us,transmit_us,first,last,scale,current_ma,hash" line per
+// refresh, and "STRIP_RENDER: trace_dropped,name,count" for refreshes that found both buffers full
+static void trace_task(void *arg) {
+        struct strip_render *render;
+
+        for (;;) {
+                xQueueReceive(trace_queue, &render, portMAX_DELAY);
+                const char *name = render->config.name ? render->config.name : "strip";
+                // trace_active only moves once trace_printing is cleared
+                const trace_entry_t *entries = render->trace[render->trace_active ^ 1];
+
+                for (int i = 0; i < CONFIG_STRIP_RENDER_TRACE_DEPTH; i++) {
+                        const trace_entry_t *entry = &entries[i];
+                        ESP_LOGI(TAG, "trace,%s,%lu,%lu,%lu,%lu,%u,%lu,%08lx", name, (unsigned long)entry->time_us,
+                                 (unsigned long)entry->transmit_us, (unsigned long)entry->first,
+                                 (unsigned long)entry->last, entry->scale, (unsigned long)entry->current_ma,
+                                 (unsigned long)entry->hash);
+                }
+
+                xSemaphoreTake(render->lock, portMAX_DELAY);
+                uint32_t dropped = render->trace_dropped;
+                render->trace_dropped = 0;
+                render->trace_printing = false;
+                bool full = trace_swap(render);
+                xSemaphoreGive(render->lock);
+                if (dropped) {
+                        ESP_LOGI(TAG, "trace_dropped,%s,%lu", name, (unsigned long)dropped);
+                }
+                trace_post(render, full);
+        }
+}
+
+static esp_err_t trace_init(void) {
+        if (trace_queue) {
+                return ESP_OK;
+        }
+        trace_queue = xQueueCreate(TRACE_QUEUE_LENGTH, sizeof(struct strip_render *));
+        if (!trace_queue) {
+                return ESP_ERR_NO_MEM;
+        }
+        if (xTaskCreate(trace_task, "strip_trace", TRACE_TASK_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1, NULL) != pdPASS) {
+                vQueueDelete(trace_queue);
+                trace_queue = NULL;
+                return ESP_ERR_NO_MEM;
+        }
+        return ESP_OK;
+}
+
+// The trace task may still be printing from the render
+static void trace_wait(struct strip_render *render) {
+        for (;;) {
+                xSemaphoreTake(render->lock, portMAX_DELAY);
+                bool printing = render->trace_printing;
+                xSemaphoreGive(render->lock);
+                if (!printing) {
+                        return;
+                }
+                vTaskDelay(1);
+        }
+}
+#else
+static uint32_t trace_hash(const struct strip_render *render, const uint8_t *pixels) {
+        return 0;
+}
+
+static bool trace_add(struct strip_render *render, const trace_entry_t *entry) {
+        return false;
+}
+
+static void trace_post(struct strip_render *render, bool full) {
+}
+
+static esp_err_t trace_init(void) {
+        return ESP_OK;
+}
+
+static void trace_wait(struct strip_render *render) {
+}
+#endif
+
+// Called with `lock` held once pixels [first, last] went out. Returns true when a full trace
+// buffer is ready for trace_post() once the lock is released.
+static bool record_transmit(struct strip_render *render, int64_t start_us, int64_t end_us,
+                            uint32_t first, uint32_t last, uint32_t current_ma, uint32_t hash) {
+        strip_render_stats_t *stats = &render->stats;
+        uint32_t pixels = last - first + 1;
+
+        stats->refreshes++;
+        stats->current_ma = current_ma;
+        if (render->scale < LIMIT_FULL_SCALE) {
+                stats->limited++;
+        }
+        stats->pixels_written += pixels;
+        stats->transmit_us = end_us - start_us;
+        if (stats->transmit_us > stats->transmit_max_us) {
+                stats->transmit_max_us = stats->transmit_us;
+        }
+        if (render->last_start_us) {
+                stats->interval_us = start_us - render->last_start_us;
+        }
+        render->last_start_us = start_us;
+
+        const trace_entry_t entry = {
+                .time_us = start_us,
+                .transmit_us = stats->transmit_us,
+                .first = first,
+                .last = last,
+                .current_ma = current_ma,
+                .hash = hash,
+                .scale = render->scale,
+        };
+        return trace_add(render, &entry);
+}
+
+static void transmit_task(void *arg) {
+        struct strip_render *render = arg;
+        size_t pixel_size = render->pixel_size;
+
+        for (;;) {
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+                xSemaphoreTake(render->lock, portMAX_DELAY);
+                if (render->stop) {
+                        xSemaphoreGive(render->lock);
+                        break;
+                }
+                if (!render->pending) {
+                        xSemaphoreGive(render->lock);
+                        continue;
+                }
+                uint32_t first = render->dirty_first;
+                uint32_t last = render->dirty_last;
+                memcpy(render->transmit + first * pixel_size, render->frame + first * pixel_size,
+                       (last - first + 1) * pixel_size);
+                render->dirty = false;
+                render->pending = false;
+                xSemaphoreGive(render->lock);
+
+                uint32_t current_ma;
+                int64_t start_us = esp_timer_get_time();
+                esp_err_t err = send(render, render->transmit, &first, &last, &current_ma);
+                int64_t end_us = esp_timer_get_time();
+                uint32_t hash = trace_hash(render, render->transmit);
+                bool trace_full = false;
+
+                xSemaphoreTake(render->lock, portMAX_DELAY);
+                if (err == ESP_OK) {
+                        trace_full = record_transmit(render, start_us, end_us, first, last, current_ma, hash);
+                } else {
+                        // Send the range again with the next frame
+                        render->stats.errors++;
+                        mark_dirty(render, first, last);
+                }
+                xSemaphoreGive(render->lock);
+                if (err != ESP_OK) {
+                        ESP_LOGE(TAG, "Transmit failed: %s", esp_err_to_name(err));
+                }
+                trace_post(render, trace_full);
+
+                if (render->scale < render->scale_target) {
+                        // The limit is still releasing; resend the frame even when callers are idle
+                        vTaskDelay(pdMS_TO_TICKS(LIMIT_RELEASE_MS));
+                        xSemaphoreTake(render->lock, portMAX_DELAY);
+                        if (!render->pending) {
+                                mark_dirty(render, 0, 0);
+                                render->pending = true;
+                        }
+                        xSemaphoreGive(render->lock);
+                        xTaskNotifyGive(render->task);
+                }
+        }
+
+        xTaskNotifyGive(render->deleting);
+        vTaskDelete(NULL);
+}
+
+esp_err_t strip_render_create(const strip_render_config_t *config, strip_render_handle_t *handle) {
+        if (!config || !handle || !config->strip || !config->length) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        esp_err_t err = trace_init();
+        if (err != ESP_OK) {
+                return err;
+        }
+        struct strip_render *render = calloc(1, sizeof(*render));
+        if (!render) {
+                return ESP_ERR_NO_MEM;
+        }
+        render->config = *config;
+        render->pixel_size = config->rgbw ? 4 : 3;
+        render->frame = calloc(config->length, render->pixel_size);
+        if (config->async) {
+                render->transmit = calloc(config->length, render->pixel_size);
+        }
+        render->lock = xSemaphoreCreateMutex();
+        if (!render->frame || (config->async && !render->transmit) || !render->lock ||
+            (config->async && xTaskCreate(transmit_task, "strip_render", CONFIG_STRIP_RENDER_TASK_STACK_SIZE,
+                                          render, CONFIG_STRIP_RENDER_TASK_PRIORITY, &render->task) != pdPASS)) {
+                if (render->lock) {
+                        vSemaphoreDelete(render->lock);
+                }
+                free(render->transmit);
+                free(render->frame);
+                free(render);
+                return ESP_ERR_NO_MEM;
+        }
+
+        // The driver starts out black, like the zeroed frame
+        render->uniform = true;
+        render->scale = render->scale_target = render->sent_scale = LIMIT_FULL_SCALE;
+        render->stats.wire_us = config->length * render->pixel_size * WIRE_US_PER_BYTE + WIRE_RESET_US;
+        *handle = render;
+        return ESP_OK;
+}
+
+void strip_render_fill(strip_render_handle_t render, const color_rgbw_t *color) {
+        uint8_t pixel[4];
+        size_t pixel_size = render->pixel_size;
+        size_t frame_size = render->config.length * pixel_size;
+
+        pack(render, color, pixel);
+
+        xSemaphoreTake(render->lock, portMAX_DELAY);
+        if (render->uniform && memcmp(render->frame, pixel, pixel_size) == 0) {
+                xSemaphoreGive(render->lock);
+                return;
+        }
+
+        // Convert once, then double the filled part with each copy
+        memcpy(render->frame, pixel, pixel_size);
+        for (size_t filled = pixel_size; filled < frame_size; filled *= 2) {
+                memcpy(render->frame + filled, render->frame, filled < frame_size - filled ? filled : frame_size - filled);
+        }
+        render->uniform = true;
+        mark_dirty(render, 0, render->config.length - 1);
+        xSemaphoreGive(render->lock);
+}
+
+void strip_render_fill_range(strip_render_handle_t render, uint32_t start, uint32_t count, const color_rgbw_t *color) {
+        uint8_t pixel[4];
+        size_t pixel_size = render->pixel_size;
+
+        if (start >= render->config.length) {
+                return;
+        }
+        if (count > render->config.length - start) {
+                count = render->config.length - start;
+        }
+        pack(render, color, pixel);
+
+        xSemaphoreTake(render->lock, portMAX_DELAY);
+        // Only the span that actually changes is rewritten and marked dirty
+        uint32_t first = start;
+        uint32_t last = start + count;
+        while (first < last && memcmp(render->frame + first * pixel_size, pixel, pixel_size) == 0) {
+                first++;
+        }
+        while (last > first && memcmp(render->frame + (last - 1) * pixel_size, pixel, pixel_size) == 0) {
+                last--;
+        }
+        if (first < last) {
+                uint8_t *target = render->frame + first * pixel_size;
+                size_t span = (last - first) * pixel_size;
+                memcpy(target, pixel, pixel_size);
+                for (size_t filled = pixel_size; filled < span; filled *= 2) {
+                        memcpy(target + filled, target, filled < span - filled ? filled : span - filled);
+                }
+                render->uniform = false;
+                mark_dirty(render, first, last - 1);
+        }
+        xSemaphoreGive(render->lock);
+}
+
+void strip_render_set_pixel(strip_render_handle_t render, uint32_t index, const color_rgbw_t *color) {
+        uint8_t pixel[4];
+
+        if (index >= render->config.length) {
+                return;
+        }
+        pack(render, color, pixel);
+
+        xSemaphoreTake(render->lock, portMAX_DELAY);
+        uint8_t *target = render->frame + index * render->pixel_size;
+        if (memcmp(target, pixel, render->pixel_size) != 0) {
+                memcpy(target, pixel, render->pixel_size);
+                render->uniform = false;
+                mark_dirty(render, index, index);
+        }
+        xSemaphoreGive(render->lock);
+}
+
+void strip_render_set_pixels(strip_render_handle_t render, uint32_t start, uint32_t count, const color_rgbw_t *colors) {
+        size_t pixel_size = render->pixel_size;
+        uint32_t first = UINT32_MAX;
+        uint32_t last = 0;
+
+        if (start >= render->config.length) {
+                return;
+        }
+        if (count > render->config.length - start) {
+                count = render->config.length - start;
+        }
+
+        xSemaphoreTake(render->lock, portMAX_DELAY);
+        // The dirty range only covers the pixels that changed
+        for (uint32_t i = 0; i < count; i++) {
+                uint8_t pixel[4];
+                uint8_t *target = render->frame + (start + i) * pixel_size;
+                pack(render, &colors[i], pixel);
+                if (memcmp(target, pixel, pixel_size) != 0) {
+                        memcpy(target, pixel, pixel_size);
+                        if (first == UINT32_MAX) {
+                                first = start + i;
+                        }
+                        last = start + i;
+                }
+        }
+        if (first != UINT32_MAX) {
+                render->uniform = false;
+                mark_dirty(render, first, last);
+        }
+        xSemaphoreGive(render->lock);
+}
+
+esp_err_t strip_render_show(strip_render_handle_t render) {
+        xSemaphoreTake(render->lock, portMAX_DELAY);
+        render->stats.frames++;
+        // A synchronous limiter that is still releasing sends the unchanged frame again
+        bool releasing = !render->config.async && render->scale < render->scale_target;
+        if (!render->dirty && !releasing) {
+                xSemaphoreGive(render->lock);
+                return ESP_OK;
+        }
+
+        if (render->config.async) {
+                // A frame still waiting for the task is superseded; its changes go out with this one
+                if (render->pending) {
+                        render->stats.dropped++;
+                }
+                render->pending = true;
+                xSemaphoreGive(render->lock);
+                xTaskNotifyGive(render->task);
+                return ESP_OK;
+        }
+
+        uint32_t first = render->dirty ? render->dirty_first : 0;
+        uint32_t last = render->dirty ? render->dirty_last : 0;
+        uint32_t current_ma;
+        bool trace_full = false;
+        int64_t start_us = esp_timer_get_time();
+        esp_err_t err = send(render, render->frame, &first, &last, &current_ma);
+        if (err == ESP_OK) {
+                render->dirty = false;
+                trace_full = record_transmit(render, start_us, esp_timer_get_time(), first, last, current_ma,
+                                             trace_hash(render, render->frame));
+        }
+        xSemaphoreGive(render->lock);
+        trace_post(render, trace_full);
+        return err;
+}
+
+void strip_render_get_stats(strip_render_handle_t render, strip_render_stats_t *stats) {
+        xSemaphoreTake(render->lock, portMAX_DELAY);
+        *stats = render->stats;
+        xSemaphoreGive(render->lock);
+}
+
+void strip_render_delete(strip_render_handle_t render) {
+        if (!render) {
+                return;
+        }
+        if (render->task) {
+                // Let a running transmit finish before the buffers go away
+                xSemaphoreTake(render->lock, portMAX_DELAY);
+                render->stop = true;
+                render->deleting = xTaskGetCurrentTaskHandle();
+                xSemaphoreGive(render->lock);
+                xTaskNotifyGive(render->task);
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+        trace_wait(render);
+        vSemaphoreDelete(render->lock);
+        free(render->transmit);
+        free(render->frame);
+        free(render);
+}
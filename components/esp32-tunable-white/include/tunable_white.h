@@ -0,0 +1,80 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <light_fade.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Channel shares at one colour temperature. Both are fractions of full duty (0-65535) that
+// together give the same light output at every point of the table.
+typedef struct {
+        uint16_t mired;
+        uint16_t warm;
+        uint16_t cold;
+} tunable_white_point_t;
+
+typedef struct {
+        light_fade_handle_t fade;           // two channels: warm first, then cold
+        uint32_t duty_max;
+        uint8_t fraction_bits;
+        const tunable_white_point_t *table; // sorted by mired; NULL for the built-in table
+        size_t table_size;
+        uint32_t transition_ms;             // time of a change made with tunable_white_set()
+} tunable_white_config_t;
+
+typedef struct tunable_white *tunable_white_handle_t;
+
+// Mixing table for a 2700 K / 6500 K strip whose cold channel gives 15 % more light per duty,
+// computed along the Planckian locus. Strips with other LEDs should pass their own measurements.
+extern const tunable_white_point_t tunable_white_default_table[];
+extern const size_t tunable_white_default_table_size;
+
+esp_err_t tunable_white_create(const tunable_white_config_t *config, tunable_white_handle_t *handle);
+
+// Move to `mired` and `brightness` (percent, 0 for off) over the configured transition time
+void tunable_white_set(tunable_white_handle_t white, uint16_t mired, float brightness);
+
+// Move to `brightness` only; the colour temperature carries on
+void tunable_white_set_brightness(tunable_white_handle_t white, float brightness);
+
+// Stop writing the outputs, so something else can drive them for a while (an identify blink).
+// Changes still arrive and keep their timing; tunable_white_resume() outputs where they are.
+void tunable_white_pause(tunable_white_handle_t white);
+
+void tunable_white_resume(tunable_white_handle_t white);
+
+// Colour temperature the light is heading to
+uint16_t tunable_white_get_mired(tunable_white_handle_t white);
+
+void tunable_white_delete(tunable_white_handle_t white);
+
+#ifdef __cplusplus
+}
+#endif
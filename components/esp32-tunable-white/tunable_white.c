@@ -0,0 +1,275 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <light_curve.h>
+#include "tunable_white.h"
+
+static const char *TAG = "TUNABLE_WHITE";
+
+#define TICK_MS 20  // output update rate while a transition runs
+
+const tunable_white_point_t tunable_white_default_table[] = {
+        { .mired = 154, .warm = 0,     .cold = 56987 },
+        { .mired = 170, .warm = 6173,  .cold = 51619 },
+        { .mired = 190, .warm = 13297, .cold = 45424 },
+        { .mired = 210, .warm = 19982, .cold = 39612 },
+        { .mired = 230, .warm = 26312, .cold = 34107 },
+        { .mired = 250, .warm = 32361, .cold = 28847 },
+        { .mired = 275, .warm = 39622, .cold = 22533 },
+        { .mired = 300, .warm = 46641, .cold = 16429 },
+        { .mired = 330, .warm = 54853, .cold = 9289 },
+        { .mired = 370, .warm = 65535, .cold = 0 },
+};
+const size_t tunable_white_default_table_size = sizeof(tunable_white_default_table) / sizeof(tunable_white_default_table[0]);
+
+// Transition between two targets, starting at `start_us`
+typedef struct {
+        float from_mired;
+        float from_brightness;
+        float to_mired;
+        float to_brightness;
+        int64_t start_us;
+} transition_t;
+
+struct tunable_white {
+        tunable_white_config_t config;
+        esp_timer_handle_t timer;
+
+        // Guards the fields below. Only copies and flags change under it; the interpolation,
+        // the mixing and the timer calls all run outside.
+        portMUX_TYPE lock;
+        transition_t transition;
+        uint32_t generation;        // bumped with every new transition
+        bool ticking;               // a tick is armed or running and arms the next one itself
+        bool paused;
+};
+
+static float lerp(float from, float to, float amount) {
+        return from + (to - from) * amount;
+}
+
+// Colour temperature and brightness at `now`; returns true once nothing moves anymore
+static bool evaluate(const transition_t *transition, uint32_t transition_ms, int64_t now, float *mired,
+                     float *brightness) {
+        int64_t transition_us = (int64_t)transition_ms * 1000;
+        float amount = transition_us > 0 && now - transition->start_us < transition_us ?
+                       (float)(now - transition->start_us) / transition_us : 1;
+
+        *brightness = lerp(transition->from_brightness, transition->to_brightness, amount);
+        *mired = lerp(transition->from_mired, transition->to_mired, amount);
+        return amount >= 1;
+}
+
+// Warm and cold shares at `mired`, interpolated between the two nearest table points
+static void mix(const tunable_white_config_t *config, float mired, float *warm, float *cold) {
+        const tunable_white_point_t *table = config->table;
+        size_t last = config->table_size - 1;
+
+        if (mired <= table[0].mired) {
+                *warm = table[0].warm;
+                *cold = table[0].cold;
+                return;
+        }
+        if (mired >= table[last].mired) {
+                *warm = table[last].warm;
+                *cold = table[last].cold;
+                return;
+        }
+        size_t i = 1;
+        while (table[i].mired < mired) {
+                i++;
+        }
+        float amount = (mired - table[i - 1].mired) / (table[i].mired - table[i - 1].mired);
+        *warm = lerp(table[i - 1].warm, table[i].warm, amount);
+        *cold = lerp(table[i - 1].cold, table[i].cold, amount);
+}
+
+// Write the outputs for `now` and arm the next tick until the transition has ended. A new
+// transition that arrives meanwhile finds `ticking` set and leaves the timer to this tick.
+static void tick_cb(void *arg) {
+        struct tunable_white *white = arg;
+        float mired, brightness, warm, cold;
+
+        portENTER_CRITICAL(&white->lock);
+        transition_t transition = white->transition;
+        uint32_t generation = white->generation;
+        bool paused = white->paused;
+        if (paused) {
+                white->ticking = false;
+        }
+        portEXIT_CRITICAL(&white->lock);
+        if (paused) {
+                return;
+        }
+
+        bool finished = evaluate(&transition, white->config.transition_ms, esp_timer_get_time(), &mired, &brightness);
+        // Lightness follows the CIE curve; the table splits that luminance over the two channels
+        mix(&white->config, mired, &warm, &cold);
+        uint32_t luminance = light_curve_cie(light_curve_percent(brightness));
+        const uint32_t duties[2] = {
+                light_curve_duty(luminance * warm / LIGHT_CURVE_MAX, white->config.duty_max, white->config.fraction_bits),
+                light_curve_duty(luminance * cold / LIGHT_CURVE_MAX, white->config.duty_max, white->config.fraction_bits),
+        };
+        esp_err_t err = light_fade_set(white->config.fade, duties);
+        if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Output: %s", esp_err_to_name(err));
+        }
+
+        portENTER_CRITICAL(&white->lock);
+        // Keep going while the transition runs, was replaced meanwhile, or a pause came in
+        bool again = !finished || white->generation != generation || white->paused;
+        white->ticking = again;
+        portEXIT_CRITICAL(&white->lock);
+        if (again) {
+                esp_timer_start_once(white->timer, TICK_MS * 1000);
+        }
+}
+
+// Called after `ticking` was found clear and set under the lock, so no tick is armed
+static void start_ticks(struct tunable_white *white) {
+        esp_err_t err = esp_timer_start_once(white->timer, 0);
+        if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Tick: %s", esp_err_to_name(err));
+        }
+}
+
+esp_err_t tunable_white_create(const tunable_white_config_t *config, tunable_white_handle_t *handle) {
+        if (!config || !handle || !config->fade || (config->table && config->table_size < 2)) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        struct tunable_white *white = calloc(1, sizeof(*white));
+        if (!white) {
+                return ESP_ERR_NO_MEM;
+        }
+        white->config = *config;
+        if (!config->table) {
+                white->config.table = tunable_white_default_table;
+                white->config.table_size = tunable_white_default_table_size;
+        }
+        portMUX_INITIALIZE(&white->lock);
+
+        // Start dark in the middle of the range
+        const tunable_white_config_t *active = &white->config;
+        white->transition.from_mired = white->transition.to_mired =
+                (active->table[0].mired + active->table[active->table_size - 1].mired) / 2;
+
+        const esp_timer_create_args_t timer_args = {
+                .callback = tick_cb,
+                .arg = white,
+                .name = "tunable_white",
+        };
+        esp_err_t err = esp_timer_create(&timer_args, &white->timer);
+        if (err != ESP_OK) {
+                free(white);
+                return err;
+        }
+
+        *handle = white;
+        return ESP_OK;
+}
+
+// Start a transition from where the light is now. The new transition is worked out from a copy
+// of the current one; if another change got in first it is worked out again from that one.
+static void retarget(struct tunable_white *white, bool set_mired, uint16_t mired, float brightness) {
+        bool start = false;
+
+        for (bool swapped = false; !swapped;) {
+                portENTER_CRITICAL(&white->lock);
+                transition_t next = white->transition;
+                uint32_t generation = white->generation;
+                portEXIT_CRITICAL(&white->lock);
+
+                float now_mired, now_brightness;
+                int64_t now = esp_timer_get_time();
+                evaluate(&next, white->config.transition_ms, now, &now_mired, &now_brightness);
+                next.from_mired = now_mired;
+                next.from_brightness = now_brightness;
+                if (set_mired) {
+                        next.to_mired = mired;
+                }
+                next.to_brightness = brightness;
+                next.start_us = now;
+
+                portENTER_CRITICAL(&white->lock);
+                if (white->generation == generation) {
+                        white->transition = next;
+                        white->generation++;
+                        start = !white->ticking && !white->paused;
+                        white->ticking |= start;
+                        swapped = true;
+                }
+                portEXIT_CRITICAL(&white->lock);
+        }
+        if (start) {
+                start_ticks(white);
+        }
+}
+
+void tunable_white_set(tunable_white_handle_t white, uint16_t mired, float brightness) {
+        retarget(white, true, mired, brightness);
+}
+
+void tunable_white_set_brightness(tunable_white_handle_t white, float brightness) {
+        retarget(white, false, 0, brightness);
+}
+
+void tunable_white_pause(tunable_white_handle_t white) {
+        // A tick still armed sees the flag and stops without writing
+        portENTER_CRITICAL(&white->lock);
+        white->paused = true;
+        portEXIT_CRITICAL(&white->lock);
+}
+
+void tunable_white_resume(tunable_white_handle_t white) {
+        portENTER_CRITICAL(&white->lock);
+        white->paused = false;
+        bool start = !white->ticking;
+        white->ticking = true;
+        portEXIT_CRITICAL(&white->lock);
+
+        // One tick puts the outputs back where the transition is, and more follow while it runs
+        if (start) {
+                start_ticks(white);
+        }
+}
+
+uint16_t tunable_white_get_mired(tunable_white_handle_t white) {
+        portENTER_CRITICAL(&white->lock);
+        float mired = white->transition.to_mired;
+        portEXIT_CRITICAL(&white->lock);
+        return (uint16_t)(mired + 0.5f);
+}
+
+void tunable_white_delete(tunable_white_handle_t white) {
+        if (!white) {
+                return;
+        }
+        esp_timer_stop(white->timer);
+        esp_timer_delete(white->timer);
+        free(white);
+}
@@ -0,0 +1,91 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Called once, the first time the station obtains an IP address
+typedef void (*wifi_connect_ready_cb_t)(void);
+
+// Boot-relative timestamps (esp_timer_get_time(), in microseconds) of each connection phase
+typedef struct {
+        int64_t init_us;        // wifi_connect_init() entered
+        int64_t start_us;       // WIFI_EVENT_STA_START
+        int64_t connected_us;   // WIFI_EVENT_STA_CONNECTED
+        int64_t got_ip_us;      // IP_EVENT_STA_GOT_IP
+        bool fast_connect;      // associated using the cached BSSID and channel
+} wifi_connect_timings_t;
+
+// Why the last connection attempt failed or the connection dropped
+typedef enum {
+        WIFI_CONNECT_FAILURE_NO_AP = 0,  // access point not found or no longer answering
+        WIFI_CONNECT_FAILURE_AUTH,       // wrong password or handshake failure
+        WIFI_CONNECT_FAILURE_ASSOC,      // association refused by the access point
+        WIFI_CONNECT_FAILURE_LINK_LOST,  // connection dropped after it was established
+        WIFI_CONNECT_FAILURE_DRIVER,     // esp_wifi call failed
+        WIFI_CONNECT_FAILURE_OTHER,
+        WIFI_CONNECT_FAILURE_MAX
+} wifi_connect_failure_t;
+
+// Connection supervisor counters, cumulative since boot unless noted
+typedef struct {
+        uint32_t disconnects;                       // WIFI_EVENT_STA_DISCONNECTED events
+        uint32_t retries;                           // reconnect attempts started by the supervisor
+        uint32_t reinits;                           // Wi-Fi driver reinitialisations
+        uint32_t restarts;                          // supervisor restarts since power-on
+        uint32_t errors;                            // non Wi-Fi errors passed to wifi_connect_handle_error()
+        uint32_t failures[WIFI_CONNECT_FAILURE_MAX];
+        uint32_t consecutive_failures;              // since the last successful connection
+        uint32_t backoff_ms;                        // delay before the pending attempt
+        uint8_t last_reason;                        // wifi_err_reason_t of the last disconnect
+        bool connected;
+} wifi_connect_stats_t;
+
+// Bring up the default station interface and connect to the given network.
+// Creates the default event loop if it does not exist yet.
+esp_err_t wifi_connect_init(const char *ssid, const char *password, wifi_connect_ready_cb_t on_ready);
+
+// Copy the phase timings of the current connection attempt
+void wifi_connect_get_timings(wifi_connect_timings_t *timings);
+
+// Copy the connection supervisor counters
+void wifi_connect_get_stats(wifi_connect_stats_t *stats);
+
+// Route an error to the connection supervisor. Wi-Fi errors schedule a reconnect through the
+// same backoff and escalation as a dropped connection; other errors are logged and counted.
+// Never restarts the device by itself.
+void wifi_connect_handle_error(esp_err_t err);
+
+// Drop the cached access point so the next connect does a full scan
+esp_err_t wifi_connect_forget(void);
+
+#ifdef __cplusplus
+}
+#endif
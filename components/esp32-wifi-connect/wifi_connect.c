@@ -0,0 +1,504 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <string.h>
+#include <esp_wifi.h>
+#include <esp_event.h>
+#include <esp_netif.h>
+#include <esp_log.h>
+#include <esp_mac.h>
+#include <esp_timer.h>
+#include <esp_random.h>
+#include <esp_system.h>
+#include <esp_attr.h>
+#include <freertos/FreeRTOS.h>
+#include <nvs.h>
+#include "wifi_connect.h"
+
+static const char *TAG = "WIFI_CONNECT";
+
+#define CACHE_NAMESPACE "wifi_connect"
+#define CACHE_KEY "ap"
+#define CACHE_VERSION 2
+
+// Last access point, keyed on the credentials it was joined with. The DHCP lease is kept by
+// lwIP itself (LWIP_DHCP_RESTORE_LAST_IP), which asks for the same address again.
+typedef struct {
+        uint8_t version;
+        uint8_t channel;
+        uint8_t bssid[6];
+        uint32_t credentials_hash;
+} wifi_connect_cache_t;
+
+static wifi_config_t wifi_config;
+static wifi_connect_cache_t stored;
+static uint8_t connected_bssid[6];
+static uint8_t connected_channel;
+static uint32_t credentials_hash;
+static wifi_connect_ready_cb_t ready_cb = NULL;
+static bool ready_called = false;
+static wifi_connect_timings_t timings;
+
+#define RESTART_MAGIC 0x57434e52
+#define RESTART_MAX_SHIFT 3
+
+// Survives a software restart so repeated supervisor restarts back off as well
+static RTC_NOINIT_ATTR uint32_t restart_magic;
+static RTC_NOINIT_ATTR uint32_t restart_count;
+
+// The supervisor state below is shared by the event loop task, the esp_timer task running the
+// retry timer, and callers of wifi_connect_handle_error(); `lock` guards it. No esp_wifi call
+// or log is made while holding it.
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static wifi_connect_stats_t stats;
+static esp_timer_handle_t retry_timer = NULL;
+static bool reinit_pending = false;
+static bool reinit_running = false;
+static uint32_t failures_since_reinit = 0;
+static int64_t offline_since_us = 0;
+
+// FNV-1a, so changed credentials never reuse a stale access point
+static uint32_t hash_credentials(const char *ssid, const char *password) {
+        uint32_t hash = 2166136261u;
+        for (const char *p = ssid; *p; p++) {
+                hash = (hash ^ (uint8_t)*p) * 16777619u;
+        }
+        hash = (hash ^ 0xff) * 16777619u;
+        for (const char *p = password; *p; p++) {
+                hash = (hash ^ (uint8_t)*p) * 16777619u;
+        }
+        return hash;
+}
+
+static bool cache_load(void) {
+#ifdef CONFIG_WIFI_CONNECT_FAST_RECONNECT
+        nvs_handle_t handle;
+        if (nvs_open(CACHE_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+                return false;
+        }
+        size_t size = sizeof(stored);
+        esp_err_t err = nvs_get_blob(handle, CACHE_KEY, &stored, &size);
+        nvs_close(handle);
+
+        return err == ESP_OK && size == sizeof(stored) &&
+               stored.version == CACHE_VERSION &&
+               stored.credentials_hash == credentials_hash &&
+               stored.channel != 0;
+#else
+        return false;
+#endif
+}
+
+static void cache_store(const wifi_connect_cache_t *update) {
+#ifdef CONFIG_WIFI_CONNECT_FAST_RECONNECT
+        // Only touch flash when the access point actually changed
+        if (memcmp(&stored, update, sizeof(stored)) == 0) {
+                return;
+        }
+        stored = *update;
+
+        nvs_handle_t handle;
+        esp_err_t err = nvs_open(CACHE_NAMESPACE, NVS_READWRITE, &handle);
+        if (err == ESP_OK) {
+                err = nvs_set_blob(handle, CACHE_KEY, &stored, sizeof(stored));
+                if (err == ESP_OK) {
+                        err = nvs_commit(handle);
+                }
+                nvs_close(handle);
+        }
+        if (err != ESP_OK) {
+                ESP_LOGW(TAG, "Could not store access point: %s", esp_err_to_name(err));
+        }
+#endif
+}
+
+// Return to a regular scan; the pinned access point is only used for the first attempt
+static void unpin_access_point(void) {
+        if (!wifi_config.sta.bssid_set && wifi_config.sta.channel == 0) {
+                return;
+        }
+        wifi_config.sta.bssid_set = false;
+        wifi_config.sta.channel = 0;
+        esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+}
+
+static void log_timings(void) {
+        ESP_LOGI(TAG, "Connected in %lld ms (driver %lld ms, association %lld ms, DHCP %lld ms, %s)",
+                 (long long)(timings.got_ip_us - timings.init_us) / 1000,
+                 (long long)(timings.start_us - timings.init_us) / 1000,
+                 (long long)(timings.connected_us - timings.start_us) / 1000,
+                 (long long)(timings.got_ip_us - timings.connected_us) / 1000,
+                 timings.fast_connect ? "cached access point" : "full scan");
+}
+
+static wifi_connect_failure_t classify_reason(uint8_t reason) {
+        switch (reason) {
+        case WIFI_REASON_NO_AP_FOUND:
+        case WIFI_REASON_NO_AP_FOUND_W_COMPATIBLE_SECURITY:
+        case WIFI_REASON_NO_AP_FOUND_IN_AUTHMODE_THRESHOLD:
+        case WIFI_REASON_NO_AP_FOUND_IN_RSSI_THRESHOLD:
+                return WIFI_CONNECT_FAILURE_NO_AP;
+        case WIFI_REASON_AUTH_FAIL:
+        case WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT:
+        case WIFI_REASON_HANDSHAKE_TIMEOUT:
+        case WIFI_REASON_802_1X_AUTH_FAILED:
+                return WIFI_CONNECT_FAILURE_AUTH;
+        case WIFI_REASON_ASSOC_FAIL:
+        case WIFI_REASON_ASSOC_TOOMANY:
+        case WIFI_REASON_ASSOC_EXPIRE:
+        case WIFI_REASON_CONNECTION_FAIL:
+                return WIFI_CONNECT_FAILURE_ASSOC;
+        case WIFI_REASON_BEACON_TIMEOUT:
+        case WIFI_REASON_AUTH_EXPIRE:
+        case WIFI_REASON_AUTH_LEAVE:
+        case WIFI_REASON_ASSOC_LEAVE:
+        case WIFI_REASON_NOT_AUTHED:
+        case WIFI_REASON_NOT_ASSOCED:
+        case WIFI_REASON_AP_TSF_RESET:
+                return WIFI_CONNECT_FAILURE_LINK_LOST;
+        default:
+                return WIFI_CONNECT_FAILURE_OTHER;
+        }
+}
+
+// Exponential backoff with equal jitter: half the window fixed, half random
+static uint32_t next_backoff_ms(uint32_t attempt) {
+        uint32_t window = CONFIG_WIFI_CONNECT_BACKOFF_MIN_MS;
+        while (attempt-- > 1 && window < CONFIG_WIFI_CONNECT_BACKOFF_MAX_MS) {
+                window *= 2;
+        }
+        if (window > CONFIG_WIFI_CONNECT_BACKOFF_MAX_MS) {
+                window = CONFIG_WIFI_CONNECT_BACKOFF_MAX_MS;
+        }
+        return window / 2 + esp_random() % (window / 2 + 1);
+}
+
+static void restart_if_offline_too_long(int64_t offline_us) {
+#if CONFIG_WIFI_CONNECT_RESTART_AFTER_MIN > 0
+        uint32_t shift = restart_count < RESTART_MAX_SHIFT ? restart_count : RESTART_MAX_SHIFT;
+        int64_t limit_us = (int64_t)CONFIG_WIFI_CONNECT_RESTART_AFTER_MIN * 60 * 1000000 << shift;
+        if (offline_us < limit_us) {
+                return;
+        }
+        ESP_LOGE(TAG, "No connection for %lld minutes, restarting", (long long)(limit_us / 60000000));
+        restart_count++;
+        esp_restart();
+#endif
+}
+
+static void reinit_driver(void) {
+        // The old driver's STA_DISCONNECTED is posted to the event loop and arrives after this
+        // returns, so the flag stays set until the new driver's STA_START
+        portENTER_CRITICAL(&lock);
+        uint32_t failures = failures_since_reinit;
+        failures_since_reinit = 0;
+        reinit_running = true;
+        stats.reinits++;
+        portEXIT_CRITICAL(&lock);
+
+        ESP_LOGW(TAG, "Reinitialising WiFi driver after %lu failed attempts", (unsigned long)failures);
+        esp_wifi_stop();
+        esp_wifi_deinit();
+
+        wifi_init_config_t wifi_init_config = WIFI_INIT_CONFIG_DEFAULT();
+        esp_err_t err = esp_wifi_init(&wifi_init_config);
+        if (err == ESP_OK) {
+                err = esp_wifi_set_storage(WIFI_STORAGE_RAM);
+        }
+        if (err == ESP_OK) {
+                err = esp_wifi_set_mode(WIFI_MODE_STA);
+        }
+        if (err == ESP_OK) {
+                err = esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+        }
+        if (err == ESP_OK) {
+                err = esp_wifi_start();
+        }
+        if (err != ESP_OK) {
+                // No STA_START will come to clear it
+                portENTER_CRITICAL(&lock);
+                reinit_running = false;
+                portEXIT_CRITICAL(&lock);
+                ESP_LOGE(TAG, "WiFi driver reinit failed: %s", esp_err_to_name(err));
+                wifi_connect_handle_error(err);
+        }
+}
+
+static void retry_timer_cb(void *arg) {
+        portENTER_CRITICAL(&lock);
+        bool reinit = reinit_pending;
+        reinit_pending = false;
+        if (!reinit) {
+                stats.retries++;
+        }
+        portEXIT_CRITICAL(&lock);
+
+        if (reinit) {
+                // STA_START of the fresh driver starts the next attempt
+                reinit_driver();
+                return;
+        }
+        ESP_LOGI(TAG, "Connecting to WiFi...");
+        esp_err_t err = esp_wifi_connect();
+        if (err != ESP_OK) {
+                wifi_connect_handle_error(err);
+        }
+}
+
+// Record a failed attempt and schedule the next one according to the escalation tiers
+static void schedule_retry(wifi_connect_failure_t failure) {
+        int64_t now_us = esp_timer_get_time();
+
+        portENTER_CRITICAL(&lock);
+        stats.failures[failure]++;
+        stats.consecutive_failures++;
+        stats.connected = false;
+        if (offline_since_us == 0) {
+                offline_since_us = now_us;
+        }
+        int64_t offline_us = now_us - offline_since_us;
+
+        // A driver reset cannot fix a wrong password, so auth failures only back off
+        if (failure != WIFI_CONNECT_FAILURE_AUTH) {
+                failures_since_reinit++;
+        }
+#if CONFIG_WIFI_CONNECT_REINIT_AFTER > 0
+        if (failures_since_reinit >= CONFIG_WIFI_CONNECT_REINIT_AFTER) {
+                reinit_pending = true;
+        }
+#endif
+        uint32_t consecutive_failures = stats.consecutive_failures;
+        uint32_t backoff_ms = next_backoff_ms(consecutive_failures);
+        stats.backoff_ms = backoff_ms;
+        portEXIT_CRITICAL(&lock);
+
+        restart_if_offline_too_long(offline_us);
+
+        ESP_LOGI(TAG, "Next attempt in %lu ms (%lu consecutive failures)",
+                 (unsigned long)backoff_ms, (unsigned long)consecutive_failures);
+        esp_timer_stop(retry_timer);
+        esp_timer_start_once(retry_timer, (uint64_t)backoff_ms * 1000);
+}
+
+static void event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data) {
+        if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
+                portENTER_CRITICAL(&lock);
+                reinit_running = false;
+                portEXIT_CRITICAL(&lock);
+                if (timings.start_us == 0) {
+                        timings.start_us = esp_timer_get_time();
+                }
+                ESP_LOGI(TAG, "Connecting to WiFi...");
+                esp_wifi_connect();
+        } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
+                wifi_event_sta_connected_t *event = (wifi_event_sta_connected_t *)event_data;
+                timings.connected_us = esp_timer_get_time();
+                memcpy(connected_bssid, event->bssid, sizeof(connected_bssid));
+                connected_channel = event->channel;
+        } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+                wifi_event_sta_disconnected_t *event = (wifi_event_sta_disconnected_t *)event_data;
+                portENTER_CRITICAL(&lock);
+                bool ignore = reinit_running;
+                if (!ignore) {
+                        stats.disconnects++;
+                        stats.last_reason = event->reason;
+                }
+                bool was_connected = stats.connected;
+                portEXIT_CRITICAL(&lock);
+                if (ignore) {
+                        return;
+                }
+                if (timings.fast_connect && !ready_called) {
+                        // The cached access point is gone; fall back to a scan straight away
+                        ESP_LOGW(TAG, "Cached access point unavailable (reason %d), scanning", event->reason);
+                        timings.fast_connect = false;
+                        unpin_access_point();
+                        ESP_LOGI(TAG, "Connecting to WiFi...");
+                        esp_wifi_connect();
+                        return;
+                }
+                unpin_access_point();
+
+                wifi_connect_failure_t failure = was_connected ? WIFI_CONNECT_FAILURE_LINK_LOST
+                                                               : classify_reason(event->reason);
+                ESP_LOGW(TAG, "WiFi disconnected (reason %d)", event->reason);
+                schedule_retry(failure);
+        } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+                ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
+                ESP_LOGI(TAG, "WiFi connected, IP obtained: " IPSTR, IP2STR(&event->ip_info.ip));
+
+                wifi_connect_cache_t update = {
+                        .version = CACHE_VERSION,
+                        .channel = connected_channel,
+                        .credentials_hash = credentials_hash,
+                };
+                memcpy(update.bssid, connected_bssid, sizeof(update.bssid));
+
+                portENTER_CRITICAL(&lock);
+                stats.connected = true;
+                stats.consecutive_failures = 0;
+                stats.backoff_ms = 0;
+                failures_since_reinit = 0;
+                offline_since_us = 0;
+                restart_count = 0;
+                portEXIT_CRITICAL(&lock);
+
+                if (!ready_called) {
+                        timings.got_ip_us = esp_timer_get_time();
+                        log_timings();
+                        cache_store(&update);
+                        ready_called = true;
+                        if (ready_cb) {
+                                ready_cb();
+                        }
+                } else {
+                        cache_store(&update);
+                }
+        }
+}
+
+esp_err_t wifi_connect_init(const char *ssid, const char *password, wifi_connect_ready_cb_t on_ready) {
+        memset(&timings, 0, sizeof(timings));
+        timings.init_us = esp_timer_get_time();
+        ready_cb = on_ready;
+        ready_called = false;
+
+        if (restart_magic != RESTART_MAGIC || esp_reset_reason() != ESP_RST_SW) {
+                restart_magic = RESTART_MAGIC;
+                restart_count = 0;
+        }
+        memset(&stats, 0, sizeof(stats));
+        stats.restarts = restart_count;
+        reinit_pending = false;
+        reinit_running = false;
+        failures_since_reinit = 0;
+        offline_since_us = 0;
+
+        const esp_timer_create_args_t retry_timer_args = {
+                .callback = retry_timer_cb,
+                .name = "wifi_retry",
+        };
+        esp_err_t err = esp_timer_create(&retry_timer_args, &retry_timer);
+        if (err != ESP_OK) {
+                return err;
+        }
+
+        err = esp_netif_init();
+        if (err != ESP_OK) {
+                return err;
+        }
+        err = esp_event_loop_create_default();
+        if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+                return err;
+        }
+        esp_netif_create_default_wifi_sta();
+
+        err = esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL);
+        if (err != ESP_OK) {
+                return err;
+        }
+        err = esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, NULL);
+        if (err != ESP_OK) {
+                return err;
+        }
+
+        wifi_init_config_t wifi_init_config = WIFI_INIT_CONFIG_DEFAULT();
+        err = esp_wifi_init(&wifi_init_config);
+        if (err != ESP_OK) {
+                return err;
+        }
+        err = esp_wifi_set_storage(WIFI_STORAGE_RAM);
+        if (err != ESP_OK) {
+                return err;
+        }
+
+        memset(&wifi_config, 0, sizeof(wifi_config));
+        strlcpy((char *)wifi_config.sta.ssid, ssid, sizeof(wifi_config.sta.ssid));
+        strlcpy((char *)wifi_config.sta.password, password, sizeof(wifi_config.sta.password));
+        wifi_config.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
+
+        credentials_hash = hash_credentials(ssid, password);
+        if (cache_load()) {
+                ESP_LOGI(TAG, "Using cached access point " MACSTR " on channel %d",
+                         MAC2STR(stored.bssid), stored.channel);
+                wifi_config.sta.bssid_set = true;
+                memcpy(wifi_config.sta.bssid, stored.bssid, sizeof(wifi_config.sta.bssid));
+                wifi_config.sta.channel = stored.channel;
+                timings.fast_connect = true;
+        } else {
+                memset(&stored, 0, sizeof(stored));
+        }
+
+        err = esp_wifi_set_mode(WIFI_MODE_STA);
+        if (err != ESP_OK) {
+                return err;
+        }
+        err = esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+        if (err != ESP_OK) {
+                return err;
+        }
+        return esp_wifi_start();
+}
+
+void wifi_connect_get_timings(wifi_connect_timings_t *out) {
+        *out = timings;
+}
+
+void wifi_connect_get_stats(wifi_connect_stats_t *out) {
+        portENTER_CRITICAL(&lock);
+        *out = stats;
+        portEXIT_CRITICAL(&lock);
+}
+
+void wifi_connect_handle_error(esp_err_t err) {
+        if (err == ESP_OK) {
+                return;
+        }
+        if (err >= ESP_ERR_WIFI_BASE && err < ESP_ERR_WIFI_BASE + 0x100) {
+                ESP_LOGW(TAG, "WiFi error: %s", esp_err_to_name(err));
+                if (retry_timer) {
+                        schedule_retry(WIFI_CONNECT_FAILURE_DRIVER);
+                }
+                return;
+        }
+        portENTER_CRITICAL(&lock);
+        stats.errors++;
+        portEXIT_CRITICAL(&lock);
+        ESP_LOGE(TAG, "Error: %s", esp_err_to_name(err));
+}
+
+esp_err_t wifi_connect_forget(void) {
+        memset(&stored, 0, sizeof(stored));
+
+        nvs_handle_t handle;
+        esp_err_t err = nvs_open(CACHE_NAMESPACE, NVS_READWRITE, &handle);
+        if (err != ESP_OK) {
+                return err;
+        }
+        err = nvs_erase_key(handle, CACHE_KEY);
+        if (err == ESP_OK || err == ESP_ERR_NVS_NOT_FOUND) {
+                err = nvs_commit(handle);
+        }
+        nvs_close(handle);
+        return err;
+}
@@ -0,0 +1,289 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include "bl0942.h"
+
+static const char *TAG = "BL0942";
+
+#define BL0942_READ_COMMAND 0x58
+#define BL0942_FULL_PACKET 0xAA
+#define BL0942_RX_BUFFER_SIZE 256
+#define BL0942_EVENT_QUEUE_SIZE 8
+#define BL0942_TASK_STACK_SIZE 3072
+#define BL0942_TASK_PRIORITY 5
+
+struct bl0942 {
+        bl0942_config_t config;
+        QueueHandle_t events;
+        bl0942_parser_t parser;
+        portMUX_TYPE lock;
+        bl0942_gains_t gains;
+        bl0942_sample_t sample;
+        bool valid;
+        bl0942_stats_t stats;
+};
+
+static uint32_t field(const uint8_t *bytes) {
+        return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16);
+}
+
+static void decode(const uint8_t *buffer, bl0942_packet_t *packet) {
+        // Registers follow the header least significant byte first, three bytes each
+        packet->i_rms = field(&buffer[1]);
+        packet->v_rms = field(&buffer[4]);
+        packet->i_fast_rms = field(&buffer[7]);
+        packet->watt = (int32_t)(field(&buffer[10]) << 8) >> 8;
+        packet->cf_count = field(&buffer[13]);
+        packet->frequency = field(&buffer[16]) & 0xFFFF;
+        packet->status = field(&buffer[19]);
+}
+
+void bl0942_parser_init(bl0942_parser_t *parser, uint8_t address) {
+        memset(parser, 0, sizeof(*parser));
+        parser->command = BL0942_READ_COMMAND | (address & 0x03);
+}
+
+void bl0942_parser_reset(bl0942_parser_t *parser) {
+        parser->length = 0;
+}
+
+bool bl0942_parser_push(bl0942_parser_t *parser, uint8_t byte, bl0942_packet_t *packet) {
+        if (!parser->length && byte != BL0942_PACKET_HEADER) {
+                parser->discarded++;
+                return false;
+        }
+        parser->buffer[parser->length++] = byte;
+        if (parser->length < BL0942_PACKET_SIZE) {
+                return false;
+        }
+
+        // The checksum covers the read command and every byte before it, inverted
+        uint8_t sum = parser->command;
+        for (int i = 0; i < BL0942_PACKET_SIZE - 1; i++) {
+                sum += parser->buffer[i];
+        }
+        if ((uint8_t)~sum == parser->buffer[BL0942_PACKET_SIZE - 1]) {
+                decode(parser->buffer, packet);
+                parser->length = 0;
+                parser->packets++;
+                return true;
+        }
+
+        // The header was a data byte; carry on from the next header already received
+        parser->checksum_errors++;
+        int next = 1;
+        while (next < BL0942_PACKET_SIZE && parser->buffer[next] != BL0942_PACKET_HEADER) {
+                next++;
+        }
+        memmove(parser->buffer, parser->buffer + next, BL0942_PACKET_SIZE - next);
+        parser->length = BL0942_PACKET_SIZE - next;
+        parser->discarded += next;
+        return false;
+}
+
+void bl0942_gains_from_reference(const bl0942_reference_t *reference, bl0942_gains_t *gains) {
+        const float one = 1000.0f * (1 << BL0942_GAIN_SHIFT);
+
+        gains->current = lroundf(one / reference->current);
+        gains->voltage = lroundf(one / reference->voltage);
+        gains->power = lroundf(one / reference->power);
+        gains->energy = lroundf(1e9f / reference->energy);
+}
+
+static void publish(struct bl0942 *meter, const bl0942_packet_t *packet) {
+        bl0942_gains_t gains;
+
+        portENTER_CRITICAL(&meter->lock);
+        gains = meter->gains;
+        portEXIT_CRITICAL(&meter->lock);
+
+        // Integer multiplies only; a register is at most 24 bits, so the products fit in 64 bits
+        const bl0942_sample_t sample = {
+                .current_ma = ((uint64_t)packet->i_rms * gains.current) >> BL0942_GAIN_SHIFT,
+                .voltage_mv = ((uint64_t)packet->v_rms * gains.voltage) >> BL0942_GAIN_SHIFT,
+                .power_mw = ((int64_t)packet->watt * gains.power) >> BL0942_GAIN_SHIFT,
+                .frequency_mhz = packet->frequency ? 1000000000u / packet->frequency : 0,
+                .cf_count = packet->cf_count,
+                .time_us = esp_timer_get_time(),
+        };
+
+        portENTER_CRITICAL(&meter->lock);
+        meter->sample = sample;
+        meter->valid = true;
+        meter->stats.samples++;
+        portEXIT_CRITICAL(&meter->lock);
+
+        if (meter->config.callback) {
+                meter->config.callback(&sample, meter->config.context);
+        }
+}
+
+static void receive(struct bl0942 *meter, size_t size, bool *awaiting) {
+        uint8_t data[64];
+
+        while (size) {
+                int length = uart_read_bytes(meter->config.port, data, size < sizeof(data) ? size : sizeof(data), 0);
+                if (length <= 0) {
+                        return;
+                }
+                for (int i = 0; i < length; i++) {
+                        bl0942_packet_t packet;
+                        if (bl0942_parser_push(&meter->parser, data[i], &packet)) {
+                                *awaiting = false;
+                                publish(meter, &packet);
+                        }
+                }
+                size -= length;
+        }
+}
+
+// Requests a packet every interval and parses the answer as it arrives. The 23 byte answer takes
+// about 25 ms at 9600 baud (50 ms at 4800), so waiting on the event queue leaves the CPU free.
+static void bl0942_task(void *arg) {
+        struct bl0942 *meter = arg;
+        const uint8_t request[] = { meter->parser.command, BL0942_FULL_PACKET };
+        const TickType_t interval = pdMS_TO_TICKS(meter->config.interval_ms);
+        TickType_t next_request = xTaskGetTickCount();
+        bool awaiting = false;
+
+        for (;;) {
+                TickType_t now = xTaskGetTickCount();
+                if ((int32_t)(now - next_request) >= 0) {
+                        if (awaiting) {
+                                portENTER_CRITICAL(&meter->lock);
+                                meter->stats.timeouts++;
+                                portEXIT_CRITICAL(&meter->lock);
+                                bl0942_parser_reset(&meter->parser);
+                        }
+                        uart_write_bytes(meter->config.port, request, sizeof(request));
+                        awaiting = true;
+                        next_request = now + interval;
+                }
+
+                uart_event_t event;
+                if (xQueueReceive(meter->events, &event, next_request - now) != pdTRUE) {
+                        continue;
+                }
+                switch (event.type) {
+                case UART_DATA:
+                        receive(meter, event.size, &awaiting);
+                        break;
+                case UART_FIFO_OVF:
+                case UART_BUFFER_FULL:
+                        uart_flush_input(meter->config.port);
+                        xQueueReset(meter->events);
+                        bl0942_parser_reset(&meter->parser);
+                        portENTER_CRITICAL(&meter->lock);
+                        meter->stats.overflows++;
+                        portEXIT_CRITICAL(&meter->lock);
+                        break;
+                default:
+                        break;
+                }
+
+                portENTER_CRITICAL(&meter->lock);
+                meter->stats.checksum_errors = meter->parser.checksum_errors;
+                meter->stats.discarded = meter->parser.discarded;
+                portEXIT_CRITICAL(&meter->lock);
+        }
+}
+
+esp_err_t bl0942_create(const bl0942_config_t *config, bl0942_handle_t *handle) {
+        if (!config || !handle || !config->baud_rate || !config->interval_ms || !config->gains.current ||
+            !config->gains.voltage || !config->gains.power || !config->gains.energy) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        struct bl0942 *meter = calloc(1, sizeof(*meter));
+        if (!meter) {
+                return ESP_ERR_NO_MEM;
+        }
+        meter->config = *config;
+        meter->gains = config->gains;
+        portMUX_INITIALIZE(&meter->lock);
+        bl0942_parser_init(&meter->parser, config->address);
+
+        const uart_config_t uart_config = {
+                .baud_rate = config->baud_rate,
+                .data_bits = UART_DATA_8_BITS,
+                .parity = UART_PARITY_DISABLE,
+                .stop_bits = UART_STOP_BITS_1,
+                .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        };
+        esp_err_t err = uart_param_config(config->port, &uart_config);
+        if (err == ESP_OK) {
+                err = uart_set_pin(config->port, config->tx_gpio, config->rx_gpio, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+        }
+        if (err == ESP_OK) {
+                err = uart_driver_install(config->port, BL0942_RX_BUFFER_SIZE, 0, BL0942_EVENT_QUEUE_SIZE,
+                                          &meter->events, 0);
+        }
+        if (err != ESP_OK) {
+                ESP_LOGE(TAG, "UART: %s", esp_err_to_name(err));
+                free(meter);
+                return err;
+        }
+        if (xTaskCreate(bl0942_task, "bl0942", BL0942_TASK_STACK_SIZE, meter, BL0942_TASK_PRIORITY, NULL) != pdPASS) {
+                uart_driver_delete(config->port);
+                free(meter);
+                return ESP_ERR_NO_MEM;
+        }
+
+        *handle = meter;
+        return ESP_OK;
+}
+
+esp_err_t bl0942_get_sample(bl0942_handle_t meter, bl0942_sample_t *sample) {
+        bool valid;
+
+        portENTER_CRITICAL(&meter->lock);
+        valid = meter->valid;
+        *sample = meter->sample;
+        portEXIT_CRITICAL(&meter->lock);
+        return valid ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+void bl0942_set_gains(bl0942_handle_t meter, const bl0942_gains_t *gains) {
+        portENTER_CRITICAL(&meter->lock);
+        meter->gains = *gains;
+        portEXIT_CRITICAL(&meter->lock);
+}
+
+void bl0942_get_gains(bl0942_handle_t meter, bl0942_gains_t *gains) {
+        portENTER_CRITICAL(&meter->lock);
+        *gains = meter->gains;
+        portEXIT_CRITICAL(&meter->lock);
+}
+
+void bl0942_get_stats(bl0942_handle_t meter, bl0942_stats_t *stats) {
+        portENTER_CRITICAL(&meter->lock);
+        *stats = meter->stats;
+        portEXIT_CRITICAL(&meter->lock);
+}
@@ -0,0 +1,146 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <driver/uart.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BL0942_PACKET_SIZE 23
+#define BL0942_PACKET_HEADER 0x55
+
+// Raw registers of one full-packet read, all taken by the chip at the same moment
+typedef struct {
+        uint32_t i_rms;
+        uint32_t v_rms;
+        uint32_t i_fast_rms;
+        int32_t watt;           // signed: negative when power flows back
+        uint32_t cf_count;      // energy pulses, wraps at 2^24
+        uint32_t frequency;     // line period in us
+        uint32_t status;
+} bl0942_packet_t;
+
+// Byte-wise parser for the packet stream; holds no hardware state, so recorded streams can be
+// replayed through it
+typedef struct {
+        uint8_t command;        // read command the checksum starts from, 0x58 | address
+        uint8_t buffer[BL0942_PACKET_SIZE];
+        uint8_t length;
+        uint32_t packets;
+        uint32_t checksum_errors;
+        uint32_t discarded;     // bytes dropped while looking for a header
+} bl0942_parser_t;
+
+void bl0942_parser_init(bl0942_parser_t *parser, uint8_t address);
+
+// Drop a partial packet, e.g. after a UART overflow
+void bl0942_parser_reset(bl0942_parser_t *parser);
+
+// Feed one byte. Returns true when it completed a packet with a valid checksum, which is then in
+// `packet`. After a checksum error the parser resynchronises on the next header it received.
+bool bl0942_parser_push(bl0942_parser_t *parser, uint8_t byte, bl0942_packet_t *packet);
+
+// Fixed-point scale of each register: milli-units = register * gain >> BL0942_GAIN_SHIFT
+#define BL0942_GAIN_SHIFT 20
+
+typedef struct {
+        uint32_t current;
+        uint32_t voltage;
+        uint32_t power;
+        uint32_t energy;        // micro-watt-hours per energy pulse, not shifted
+} bl0942_gains_t;
+
+// Counts per unit for the board's shunt and voltage divider, as the datasheet gives them
+typedef struct {
+        float current;          // per A
+        float voltage;          // per V
+        float power;            // per W
+        float energy;           // pulses per kWh
+} bl0942_reference_t;
+
+// 1 mOhm shunt and a 5 x 390 kOhm / 510 Ohm divider, as on the Aubess and Sonoff boards
+#define BL0942_REFERENCE_DEFAULT { \
+                .current = 251213.46f, \
+                .voltage = 15873.36f,  \
+                .power = 596.0f,       \
+                .energy = 3304.61f,    \
+}
+
+void bl0942_gains_from_reference(const bl0942_reference_t *reference, bl0942_gains_t *gains);
+
+typedef struct {
+        uint32_t current_ma;
+        uint32_t voltage_mv;
+        int32_t power_mw;       // negative when power flows back
+        uint32_t frequency_mhz; // 0 without a line
+        uint32_t cf_count;      // raw energy pulse counter
+        int64_t time_us;
+} bl0942_sample_t;
+
+typedef void (*bl0942_sample_cb_t)(const bl0942_sample_t *sample, void *context);
+
+typedef struct {
+        uart_port_t port;
+        int tx_gpio;
+        int rx_gpio;
+        int baud_rate;          // 4800 or 9600, as set by the SCLK_BPS pin
+        uint8_t address;        // 0-3, as set by the A1 and A2 pins
+        uint32_t interval_ms;   // time between packet requests; the chip refreshes RMS values every 400 ms
+        bl0942_gains_t gains;
+        bl0942_sample_cb_t callback;    // called on the driver task for every valid packet
+        void *context;
+} bl0942_config_t;
+
+typedef struct {
+        uint32_t samples;
+        uint32_t checksum_errors;
+        uint32_t discarded;
+        uint32_t timeouts;      // requests that got no valid packet before the next one
+        uint32_t overflows;     // UART receive overflows
+} bl0942_stats_t;
+
+typedef struct bl0942 *bl0942_handle_t;
+
+// Install the UART driver and start requesting packets on a task of its own; nothing blocks the caller
+esp_err_t bl0942_create(const bl0942_config_t *config, bl0942_handle_t *handle);
+
+// Latest sample, as one consistent set. Returns ESP_ERR_NOT_FOUND before the first packet.
+esp_err_t bl0942_get_sample(bl0942_handle_t meter, bl0942_sample_t *sample);
+
+// Replace the gains; the next sample uses them
+void bl0942_set_gains(bl0942_handle_t meter, const bl0942_gains_t *gains);
+
+void bl0942_get_gains(bl0942_handle_t meter, bl0942_gains_t *gains);
+
+void bl0942_get_stats(bl0942_handle_t meter, bl0942_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
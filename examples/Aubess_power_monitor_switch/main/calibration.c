@@ -0,0 +1,175 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <stdbool.h>
+#include <esp_log.h>
+#include <nvs.h>
+#include <freertos/FreeRTOS.h>
+#include "calibration.h"
+
+static const char *TAG = "CALIBRATION";
+
+#define CALIBRATION_NAMESPACE "calibration"
+#define CALIBRATION_KEY "gains"
+
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static bool running = false;
+static bl0942_handle_t meter;
+static uint16_t reference_volts;
+static uint16_t reference_watts;
+static calibration_done_cb_t done_cb;
+static void *done_context;
+static uint32_t samples;
+static uint64_t sum_ma;
+static uint64_t sum_mv;
+static int64_t sum_mw;
+
+void calibration_load(const bl0942_reference_t *reference, bl0942_gains_t *gains) {
+        nvs_handle_t handle;
+        bl0942_gains_t stored;
+        size_t size = sizeof(stored);
+        esp_err_t err = ESP_ERR_NOT_FOUND;
+
+        if (nvs_open(CALIBRATION_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+                err = nvs_get_blob(handle, CALIBRATION_KEY, &stored, &size);
+                nvs_close(handle);
+        }
+        if (err == ESP_OK && size == sizeof(stored) && stored.current && stored.voltage && stored.power &&
+            stored.energy) {
+                *gains = stored;
+                return;
+        }
+        bl0942_gains_from_reference(reference, gains);
+}
+
+static esp_err_t store(const bl0942_gains_t *gains) {
+        nvs_handle_t handle;
+        esp_err_t err = nvs_open(CALIBRATION_NAMESPACE, NVS_READWRITE, &handle);
+        if (err == ESP_OK) {
+                err = nvs_set_blob(handle, CALIBRATION_KEY, gains, sizeof(*gains));
+                if (err == ESP_OK) {
+                        err = nvs_commit(handle);
+                }
+                nvs_close(handle);
+        }
+        return err;
+}
+
+// Scale `gain` by expected / measured. A reading outside half to double the reference is a wrong
+// load or wiring rather than a gain error, and gives 0.
+static uint32_t solve(uint32_t gain, uint64_t expected, uint64_t measured) {
+        if (!measured || expected * 2 < measured || expected > measured * 2) {
+                return 0;
+        }
+        return ((uint64_t)gain * expected + measured / 2) / measured;
+}
+
+esp_err_t calibration_start(bl0942_handle_t calibrated_meter, uint16_t volts, uint16_t watts, calibration_done_cb_t done,
+                            void *context) {
+        if (!calibrated_meter || !volts || !watts) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        bool busy;
+
+        portENTER_CRITICAL(&lock);
+        busy = running;
+        if (!busy) {
+                running = true;
+                meter = calibrated_meter;
+                reference_volts = volts;
+                reference_watts = watts;
+                done_cb = done;
+                done_context = context;
+                samples = 0;
+                sum_ma = sum_mv = 0;
+                sum_mw = 0;
+        }
+        portEXIT_CRITICAL(&lock);
+
+        if (busy) {
+                return ESP_ERR_INVALID_STATE;
+        }
+        ESP_LOGI(TAG, "Calibrating against %u W at %u V", watts, volts);
+        return ESP_OK;
+}
+
+void calibration_add(const bl0942_sample_t *sample) {
+        bool complete = false;
+
+        portENTER_CRITICAL(&lock);
+        if (running) {
+                sum_ma += sample->current_ma;
+                sum_mv += sample->voltage_mv;
+                sum_mw += sample->power_mw;
+                complete = ++samples == CALIBRATION_SAMPLES;
+        }
+        portEXIT_CRITICAL(&lock);
+
+        if (!complete) {
+                return;
+        }
+
+        // Solve on the meter task; the averages are in the units of the gains in use
+        bl0942_gains_t gains;
+        bl0942_get_gains(meter, &gains);
+        uint64_t measured_ma = sum_ma / CALIBRATION_SAMPLES;
+        uint64_t measured_mv = sum_mv / CALIBRATION_SAMPLES;
+        uint64_t measured_mw = sum_mw > 0 ? (uint64_t)sum_mw / CALIBRATION_SAMPLES : 0;
+        // A resistive load draws watts / volts amperes
+        uint64_t expected_ma = ((uint64_t)reference_watts * 1000 + reference_volts / 2) / reference_volts;
+        uint32_t power = solve(gains.power, (uint64_t)reference_watts * 1000, measured_mw);
+
+        bl0942_gains_t solved = {
+                .current = solve(gains.current, expected_ma, measured_ma),
+                .voltage = solve(gains.voltage, (uint64_t)reference_volts * 1000, measured_mv),
+                .power = power,
+                // Energy pulses follow the power measurement, so they take the same correction
+                .energy = power ? ((uint64_t)gains.energy * power + gains.power / 2) / gains.power : 0,
+        };
+
+        bool valid = solved.current && solved.voltage && solved.power && solved.energy;
+        esp_err_t err = ESP_OK;
+        if (!valid) {
+                ESP_LOGW(TAG, "Readings of %llu mA, %llu mV, %llu mW do not match the reference load",
+                         (unsigned long long)measured_ma, (unsigned long long)measured_mv,
+                         (unsigned long long)measured_mw);
+                err = ESP_ERR_INVALID_RESPONSE;
+        } else {
+                bl0942_set_gains(meter, &solved);
+                err = store(&solved);
+                if (err != ESP_OK) {
+                        ESP_LOGW(TAG, "Could not store gains: %s", esp_err_to_name(err));
+                }
+                ESP_LOGI(TAG, "Gains %lu / %lu / %lu / %lu", (unsigned long)solved.current,
+                         (unsigned long)solved.voltage, (unsigned long)solved.power, (unsigned long)solved.energy);
+        }
+
+        calibration_done_cb_t done = done_cb;
+        void *context = done_context;
+        portENTER_CRITICAL(&lock);
+        running = false;
+        portEXIT_CRITICAL(&lock);
+        if (done) {
+                done(err, valid ? &solved : NULL, context);
+        }
+}
@@ -0,0 +1,56 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stdint.h>
+#include <esp_err.h>
+#include "bl0942.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Samples averaged against the reference load, ten seconds at five samples a second
+#define CALIBRATION_SAMPLES 50
+
+typedef void (*calibration_done_cb_t)(esp_err_t result, const bl0942_gains_t *gains, void *context);
+
+// Stored gains, or the gains of `reference` when the device was never calibrated
+void calibration_load(const bl0942_reference_t *reference, bl0942_gains_t *gains);
+
+// Average the next CALIBRATION_SAMPLES samples of `meter` while a resistive load of `watts` runs at
+// `volts`, then solve for the gains that make the readings match, store them and apply them.
+// Returns at once; readings keep being published meanwhile. `done` is called from
+// calibration_add() with ESP_OK and the new gains, with ESP_ERR_INVALID_RESPONSE and no gains when
+// the readings are too far off the reference to be the same load, or with the NVS error when the
+// gains were applied but could not be stored.
+esp_err_t calibration_start(bl0942_handle_t meter, uint16_t volts, uint16_t watts, calibration_done_cb_t done,
+                            void *context);
+
+// Feed every sample of the meter being calibrated
+void calibration_add(const bl0942_sample_t *sample);
+
+#ifdef __cplusplus
+}
+#endif
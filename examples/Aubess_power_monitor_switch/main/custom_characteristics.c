@@ -16,3 +16,7 @@ homekit_characteristic_t custom_volt = HOMEKIT_CHARACTERISTIC_(
 homekit_characteristic_t custom_watt = HOMEKIT_CHARACTERISTIC_(
         CUSTOM_WATTS, 0.0
         );
+
+homekit_characteristic_t custom_energy = HOMEKIT_CHARACTERISTIC_(
+        CUSTOM_KWH, 0.0
+        );
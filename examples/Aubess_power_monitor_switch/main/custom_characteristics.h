@@ -7,6 +7,7 @@
 extern homekit_characteristic_t custom_ampere;
 extern homekit_characteristic_t custom_volt;
 extern homekit_characteristic_t custom_watt;
+extern homekit_characteristic_t custom_energy;
 
 #ifndef __HOMEKIT_DBB_CUSTOM_CHARACTERISTICS__
 #define __HOMEKIT_DBB_CUSTOM_CHARACTERISTICS__
@@ -88,6 +89,19 @@ extern homekit_characteristic_t custom_watt;
         .value = HOMEKIT_FLOAT_(_value), \
         ## __VA_ARGS__
 
+#define HOMEKIT_CHARACTERISTIC_CUSTOM_KWH HOMEKIT_CUSTOM_UUID_DBB("F000001D")
+#define HOMEKIT_DECLARE_CHARACTERISTIC_CUSTOM_KWH(_value, ...) \
+        .type = HOMEKIT_CHARACTERISTIC_CUSTOM_KWH, \
+        .description = "KWH", \
+        .format = homekit_format_float, \
+        .permissions = homekit_permissions_paired_read \
+                       | homekit_permissions_notify, \
+        .min_value = (float[]) {0}, \
+        .max_value = (float[]) {1000000}, \
+        .min_step = (float[]) {0.001}, \
+        .value = HOMEKIT_FLOAT_(_value), \
+        ## __VA_ARGS__
+
 #define HOMEKIT_CHARACTERISTIC_CUSTOM_CALIBRATE_POW HOMEKIT_CUSTOM_UUID_DBB("F000001A")
 #define HOMEKIT_DECLARE_CHARACTERISTIC_CUSTOM_CALIBRATE_POW(_value, ...) \
         .type = HOMEKIT_CHARACTERISTIC_CUSTOM_CALIBRATE_POW, \
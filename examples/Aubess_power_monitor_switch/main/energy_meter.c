@@ -0,0 +1,207 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <stdbool.h>
+#include <esp_attr.h>
+#include <esp_log.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <nvs.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include "energy_meter.h"
+
+static const char *TAG = "ENERGY_METER";
+
+#define ENERGY_NAMESPACE "energy"
+#define ENERGY_KEY "total_uwh"
+#define ENERGY_MAGIC 0x454e5247
+#define CF_COUNT_MASK 0xFFFFFF
+#define CHECKPOINT_TASK_STACK_SIZE 3072
+
+// Kept in RTC slow memory, which a software, panic or watchdog reset leaves alone. A brown-out
+// reset only keeps it when the supply recovered before the memory lost its contents; the check
+// word tells the two apart.
+typedef struct {
+        uint32_t magic;
+        uint32_t check;
+        uint64_t total_uwh;
+} energy_copy_t;
+
+static RTC_NOINIT_ATTR energy_copy_t rtc_copy;
+
+static energy_meter_config_t config;
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t store_lock;    // one checkpoint at a time, so flash never goes backwards
+static TaskHandle_t checkpoint_task;
+static bool checkpoint_pending;         // the task was woken and has not stored yet
+static uint64_t total_uwh;              // micro-watt-hours, so a single pulse loses nothing
+static uint64_t stored_uwh;             // total at the last checkpoint
+static int64_t stored_us;
+static uint32_t last_cf_count;
+static bool counting = false;
+
+static uint32_t copy_check(uint64_t value) {
+        return ENERGY_MAGIC ^ (uint32_t)value ^ (uint32_t)(value >> 32);
+}
+
+// Store the total as it is now, unless the last checkpoint already holds it
+static esp_err_t store(void) {
+        xSemaphoreTake(store_lock, portMAX_DELAY);
+        portENTER_CRITICAL(&lock);
+        uint64_t value = total_uwh;
+        bool changed = value != stored_uwh;
+        portEXIT_CRITICAL(&lock);
+
+        esp_err_t err = ESP_OK;
+        if (changed) {
+                nvs_handle_t handle;
+                err = nvs_open(ENERGY_NAMESPACE, NVS_READWRITE, &handle);
+                if (err == ESP_OK) {
+                        err = nvs_set_u64(handle, ENERGY_KEY, value);
+                        if (err == ESP_OK) {
+                                err = nvs_commit(handle);
+                        }
+                        nvs_close(handle);
+                }
+                if (err == ESP_OK) {
+                        portENTER_CRITICAL(&lock);
+                        stored_uwh = value;
+                        stored_us = esp_timer_get_time();
+                        portEXIT_CRITICAL(&lock);
+                } else {
+                        ESP_LOGW(TAG, "Could not store checkpoint: %s", esp_err_to_name(err));
+                }
+        }
+        xSemaphoreGive(store_lock);
+        return err;
+}
+
+// A flash write can take tens of milliseconds while NVS erases a page, so checkpoints due while
+// sampling are stored here, behind everything else, instead of on the BL0942 task
+static void checkpoint_task_run(void *arg) {
+        for (;;) {
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+                store();
+                portENTER_CRITICAL(&lock);
+                checkpoint_pending = false;
+                portEXIT_CRITICAL(&lock);
+        }
+}
+
+// A planned restart stores the total even though the RTC copy would survive it, so the energy
+// is not lost when the power goes before the next checkpoint
+static void shutdown_handler(void) {
+        energy_meter_checkpoint();
+}
+
+esp_err_t energy_meter_init(const energy_meter_config_t *meter_config) {
+        if (!meter_config || !meter_config->uwh_per_pulse) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        config = *meter_config;
+        store_lock = xSemaphoreCreateMutex();
+        if (!store_lock) {
+                return ESP_ERR_NO_MEM;
+        }
+        if (xTaskCreate(checkpoint_task_run, "energy_store", CHECKPOINT_TASK_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1,
+                        &checkpoint_task) != pdPASS) {
+                vSemaphoreDelete(store_lock);
+                return ESP_ERR_NO_MEM;
+        }
+
+        uint64_t value = 0;
+        nvs_handle_t handle;
+        if (nvs_open(ENERGY_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+                nvs_get_u64(handle, ENERGY_KEY, &value);
+                nvs_close(handle);
+        }
+        stored_uwh = value;
+        stored_us = esp_timer_get_time();
+
+        // After anything but a power-on the RTC copy holds what was added since the checkpoint
+        if (esp_reset_reason() != ESP_RST_POWERON && rtc_copy.magic == ENERGY_MAGIC &&
+            rtc_copy.check == copy_check(rtc_copy.total_uwh) && rtc_copy.total_uwh > value) {
+                value = rtc_copy.total_uwh;
+        }
+        total_uwh = value;
+        rtc_copy = (energy_copy_t) {
+                .magic = ENERGY_MAGIC,
+                .check = copy_check(value),
+                .total_uwh = value,
+        };
+        ESP_LOGI(TAG, "Total %.3f kWh", value / 1e9);
+        return esp_register_shutdown_handler(shutdown_handler);
+}
+
+void energy_meter_add(const bl0942_sample_t *sample) {
+        uint32_t pulses = (sample->cf_count - last_cf_count) & CF_COUNT_MASK;
+
+        // The first sample, or one after the chip restarted and its counter went back to 0, only
+        // sets the starting point; half the counter range is far more than one interval can add
+        if (!counting || pulses > CF_COUNT_MASK / 2) {
+                counting = true;
+                last_cf_count = sample->cf_count;
+                return;
+        }
+        last_cf_count = sample->cf_count;
+        if (!pulses) {
+                return;
+        }
+
+        portENTER_CRITICAL(&lock);
+        total_uwh += (uint64_t)pulses * config.uwh_per_pulse;
+        uint64_t value = total_uwh;
+        rtc_copy.total_uwh = value;
+        rtc_copy.check = copy_check(value);
+        uint64_t added_uwh = value - stored_uwh;
+        int64_t since_s = (esp_timer_get_time() - stored_us) / 1000000;
+        bool due = !checkpoint_pending &&
+                   ((added_uwh >= (uint64_t)config.checkpoint_wh * 1000000 && since_s >= config.checkpoint_min_s) ||
+                    since_s >= config.checkpoint_max_s);
+        checkpoint_pending |= due;
+        portEXIT_CRITICAL(&lock);
+
+        // Samples that come in before the task got to it do not wake it again
+        if (due) {
+                xTaskNotifyGive(checkpoint_task);
+        }
+}
+
+void energy_meter_set_uwh_per_pulse(uint32_t uwh_per_pulse) {
+        portENTER_CRITICAL(&lock);
+        config.uwh_per_pulse = uwh_per_pulse;
+        portEXIT_CRITICAL(&lock);
+}
+
+double energy_meter_get_kwh(void) {
+        portENTER_CRITICAL(&lock);
+        uint64_t value = total_uwh;
+        portEXIT_CRITICAL(&lock);
+        return value / 1e9;
+}
+
+esp_err_t energy_meter_checkpoint(void) {
+        return store();
+}
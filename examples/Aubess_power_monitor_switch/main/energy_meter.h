@@ -0,0 +1,73 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stdint.h>
+#include <esp_err.h>
+#include "bl0942.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Energy drawn since the counter was first started, from the BL0942 pulse counter. The total is
+// copied to RTC memory on every sample, so a restart, panic or watchdog reset loses nothing.
+// Flash only holds checkpoints; a power cut loses at most what was drawn since the last one:
+// checkpoint_wh, or checkpoint_min_s at full load when that is more. A brown-out counts as a
+// power cut unless the supply recovers before RTC memory loses its contents. It does not trigger
+// a checkpoint, since flash written on a sagging supply may end up corrupt.
+typedef struct {
+        uint32_t uwh_per_pulse;         // the BL0942 energy gain
+        uint32_t checkpoint_wh;         // store once this much energy was added...
+        uint32_t checkpoint_min_s;      // ...but no more often than this
+        uint32_t checkpoint_max_s;      // store whatever was added at least this often
+} energy_meter_config_t;
+
+// At most 144 writes a day, one an hour at a low load
+#define ENERGY_METER_CONFIG_DEFAULT(gain) { \
+                .uwh_per_pulse = (gain),      \
+                .checkpoint_wh = 50,          \
+                .checkpoint_min_s = 600,      \
+                .checkpoint_max_s = 3600,     \
+}
+
+// Restore the total from RTC memory or NVS; call after nvs_flash_init()
+esp_err_t energy_meter_init(const energy_meter_config_t *config);
+
+// Add the pulses counted since the previous sample. A checkpoint that is due is stored by a
+// low-priority task of the meter, so the caller never waits for flash. Call for every BL0942
+// sample, from one task.
+void energy_meter_add(const bl0942_sample_t *sample);
+
+// Scale later pulses by a new energy gain, e.g. after calibration
+void energy_meter_set_uwh_per_pulse(uint32_t uwh_per_pulse);
+
+double energy_meter_get_kwh(void);
+
+// Store the total now, e.g. before a planned power down
+esp_err_t energy_meter_checkpoint(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -24,16 +24,22 @@
 #include <stdio.h>
 #include <string.h>
 #include <esp_wifi.h>
-#include <esp_event.h>
 #include <esp_log.h>
 #include <nvs_flash.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
-#include <driver/uart.h>
 #include <driver/gpio.h>
 #include <homekit/homekit.h>
 #include <homekit/characteristics.h>
+#include <wifi_connect.h>
+#include <boot_trace.h>
+#include <gpio_edge.h>
+#include <indicator.h>
+#include <notify_scheduler.h>
 #include "custom_characteristics.h"
+#include "bl0942.h"
+#include "energy_meter.h"
+#include "calibration.h"
 
 // GPIO Configuration
 #define LED_GPIO GPIO_NUM_13
@@ -41,77 +47,113 @@
 #define SWITCH_GPIO GPIO_NUM_12
 #define BUTTON_GPIO GPIO_NUM_17
 
+// Wall switch edges closer together than this are contact bounce
+#define SWITCH_DEBOUNCE_US 50000
+
 #define UART_TXD_PIN GPIO_NUM_1
 #define UART_RXD_PIN GPIO_NUM_3
 #define UART_PORT UART_NUM_1
 
+// A full packet is requested this often; the chip itself refreshes its RMS values every 400 ms
+#define BL0942_INTERVAL_MS 200
+
 // Logging Tag
 static const char *TAG = "AUBESS_SWITCH";
 
-// BL0942 Register Addresses
-#define REG_I_RMS 0x03
-#define REG_V_RMS 0x04
-#define REG_WATT 0x06
-
 // Utility Functions
 static void handle_error(esp_err_t err) {
-        if (err != ESP_OK) {
-                ESP_LOGE(TAG, "Error: %s", esp_err_to_name(err));
-                esp_restart();
-        }
+        // Wi-Fi errors reconnect with backoff, a restart is only the supervisor's last resort
+        wifi_connect_handle_error(err);
 }
 
-// UART Initialization for BL0942
-static void bl0942_uart_init() {
-        const uart_config_t uart_config = {
-                .baud_rate = 9600,
-                .data_bits = UART_DATA_8_BITS,
-                .parity = UART_PARITY_DISABLE,
-                .stop_bits = UART_STOP_BITS_1,
-                .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
-        };
-        handle_error(uart_param_config(UART_PORT, &uart_config));
-        handle_error(uart_set_pin(UART_PORT, UART_TXD_PIN, UART_RXD_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE));
-        handle_error(uart_driver_install(UART_PORT, 256, 0, 0, NULL, 0));
-}
-
-// BL0942 Reading Function
-static int32_t read_bl0942_register(uint8_t reg) {
-        uint8_t command[] = {0x5A, reg}; // Read command
-        uint8_t response[4] = {0};
-        uart_write_bytes(UART_PORT, (const char *)command, sizeof(command));
-        int len = uart_read_bytes(UART_PORT, response, sizeof(response), pdMS_TO_TICKS(500));
-        if (len < 4) {
-                ESP_LOGE(TAG, "BL0942 Read Error");
-                return -1;
-        }
-        return (response[1] << 16) | (response[2] << 8) | response[3];
+// Power Data, published by the BL0942 task as one consistent set per packet
+static bl0942_handle_t power_meter;
+
+static void power_sample(const bl0942_sample_t *sample, void *context) {
+        ESP_LOGD(TAG, "Current: %lu mA, Voltage: %lu mV, Power: %ld mW", (unsigned long)sample->current_ma,
+                 (unsigned long)sample->voltage_mv, (long)sample->power_mw);
+        energy_meter_add(sample);
+        calibration_add(sample);
+
+        // Volts and watts are whole numbers in HomeKit; the notify scheduler limits what is sent
+        notify_scheduler_update(&custom_ampere, HOMEKIT_FLOAT(sample->current_ma / 1000.0f));
+        notify_scheduler_update(&custom_volt, HOMEKIT_UINT16((sample->voltage_mv + 500) / 1000));
+        notify_scheduler_update(&custom_watt, HOMEKIT_UINT16(sample->power_mw > 0 ? (sample->power_mw + 500) / 1000 : 0));
+        notify_scheduler_update(&custom_energy, HOMEKIT_FLOAT(energy_meter_get_kwh()));
 }
 
-// Update Power Data
-static void update_power_data() {
-        int32_t i_rms = read_bl0942_register(REG_I_RMS);
-        int32_t v_rms = read_bl0942_register(REG_V_RMS);
-        int32_t watt = read_bl0942_register(REG_WATT);
+// Calibration: set the reference volts and watts, connect a resistive load that draws them and
+// switch Calibrate POW on. It switches itself off again once the gains are solved.
+static void calibrate_pow_set(homekit_value_t value);
+static void calibrate_value_set(homekit_characteristic_t *characteristic, homekit_value_t value);
+static void calibrate_volts_set(homekit_value_t value);
+static void calibrate_watts_set(homekit_value_t value);
+
+homekit_characteristic_t custom_calibrate_pow = HOMEKIT_CHARACTERISTIC_(CUSTOM_CALIBRATE_POW, false, .setter = calibrate_pow_set);
+homekit_characteristic_t custom_calibrate_volts = HOMEKIT_CHARACTERISTIC_(CUSTOM_CALIBRATE_VOLTS, 230, .setter = calibrate_volts_set);
+homekit_characteristic_t custom_calibrate_watts = HOMEKIT_CHARACTERISTIC_(CUSTOM_CALIBRATE_WATTS, 100, .setter = calibrate_watts_set);
 
-        if (i_rms < 0 || v_rms < 0 || watt < 0) {
-                ESP_LOGE(TAG, "Failed to read BL0942 registers");
+static void calibrate_value_set(homekit_characteristic_t *characteristic, homekit_value_t value) {
+        if (value.format != homekit_format_uint16 || !value.int_value) {
+                ESP_LOGE(TAG, "Invalid calibration value");
                 return;
         }
+        characteristic->value = value;
+}
 
-        float current = i_rms * 0.001; // Convert to Amps
-        float voltage = v_rms * 0.01; // Convert to Volts
-        float power = watt * 0.01; // Convert to Watts
+static void calibrate_volts_set(homekit_value_t value) {
+        calibrate_value_set(&custom_calibrate_volts, value);
+}
 
-        ESP_LOGI(TAG, "Current: %.3f A, Voltage: %.3f V, Power: %.3f W", current, voltage, power);
+static void calibrate_watts_set(homekit_value_t value) {
+        calibrate_value_set(&custom_calibrate_watts, value);
+}
 
-        custom_ampere.value = HOMEKIT_FLOAT(current);
-        custom_volt.value = HOMEKIT_FLOAT(voltage);
-        custom_watt.value = HOMEKIT_FLOAT(power);
+static void calibration_done(esp_err_t result, const bl0942_gains_t *gains, void *context) {
+        if (gains) {
+                energy_meter_set_uwh_per_pulse(gains->energy);
+        }
+        ESP_LOGI(TAG, "Calibration: %s", esp_err_to_name(result));
+        notify_scheduler_update_now(&custom_calibrate_pow, HOMEKIT_BOOL(false));
+}
 
-        homekit_characteristic_notify(&custom_ampere, custom_ampere.value);
-        homekit_characteristic_notify(&custom_volt, custom_volt.value);
-        homekit_characteristic_notify(&custom_watt, custom_watt.value);
+static void calibrate_pow_set(homekit_value_t value) {
+        if (value.format != homekit_format_bool) {
+                ESP_LOGE(TAG, "Invalid value format: %d", value.format);
+                return;
+        }
+        if (!value.bool_value) {
+                // A running calibration finishes on its own
+                return;
+        }
+        custom_calibrate_pow.value = value;
+        esp_err_t err = calibration_start(power_meter, custom_calibrate_volts.value.int_value,
+                                          custom_calibrate_watts.value.int_value, calibration_done, NULL);
+        if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+                ESP_LOGE(TAG, "Calibration: %s", esp_err_to_name(err));
+                notify_scheduler_update_now(&custom_calibrate_pow, HOMEKIT_BOOL(false));
+        }
+}
+
+static void bl0942_init() {
+        // Gains from an earlier calibration, or the board defaults
+        const bl0942_reference_t reference = BL0942_REFERENCE_DEFAULT;
+        bl0942_gains_t gains;
+        calibration_load(&reference, &gains);
+
+        const energy_meter_config_t energy_config = ENERGY_METER_CONFIG_DEFAULT(gains.energy);
+        handle_error(energy_meter_init(&energy_config));
+
+        const bl0942_config_t meter_config = {
+                .port = UART_PORT,
+                .tx_gpio = UART_TXD_PIN,
+                .rx_gpio = UART_RXD_PIN,
+                .baud_rate = 9600,
+                .interval_ms = BL0942_INTERVAL_MS,
+                .gains = gains,
+                .callback = power_sample,
+        };
+        handle_error(bl0942_create(&meter_config, &power_meter));
 }
 
 // GPIO and Relay Functions
@@ -119,11 +161,57 @@ static void relay_write(bool on) {
         gpio_set_level(RELAY_GPIO, on ? 1 : 0);
 }
 
+static void switch_on_set(homekit_value_t value);
+
+homekit_characteristic_t switch_on = HOMEKIT_CHARACTERISTIC_(ON, false, .setter = switch_on_set);
+
+static void switch_on_set(homekit_value_t value) {
+        if (value.format != homekit_format_bool) {
+                ESP_LOGE(TAG, "Invalid value format: %d", value.format);
+                return;
+        }
+        switch_on.value.bool_value = value.bool_value;
+        relay_write(switch_on.value.bool_value);
+}
+
+// Every debounced change of the wall switch toggles the relay, so either position works
+static void switch_edge(const gpio_edge_event_t *event, void *context) {
+        static int64_t last_us = 0;
+        static int last_level = -1;
+
+        if (event->level == last_level || event->time_us - last_us < SWITCH_DEBOUNCE_US) {
+                return;
+        }
+        last_us = event->time_us;
+        last_level = event->level;
+
+        bool on = !switch_on.value.bool_value;
+        relay_write(on);
+        notify_scheduler_update_now(&switch_on, HOMEKIT_BOOL(on));
+}
+
 // GPIO Initialization
 void gpio_init() {
         gpio_set_direction(RELAY_GPIO, GPIO_MODE_OUTPUT);
-        gpio_set_direction(SWITCH_GPIO, GPIO_MODE_INPUT);
         relay_write(false);
+        handle_error(gpio_edge_add(SWITCH_GPIO, GPIO_FLOATING, switch_edge, NULL));
+}
+
+// Readings arrive several times a second; only meaningful changes are pushed to controllers.
+// Wall switch toggles bypass the limits and are sent at once.
+static void notify_init() {
+        const notify_limits_t switch_limits = { 0 };
+        const notify_limits_t ampere_limits = { .min_interval_ms = 5000, .max_interval_ms = 300000, .deadband = 0.05 };
+        const notify_limits_t volt_limits = { .min_interval_ms = 5000, .max_interval_ms = 300000, .deadband = 2.0 };
+        const notify_limits_t watt_limits = { .min_interval_ms = 5000, .max_interval_ms = 300000, .deadband = 5.0 };
+        const notify_limits_t energy_limits = { .min_interval_ms = 5000, .max_interval_ms = 300000, .deadband = 0.01 };
+
+        handle_error(notify_scheduler_add(&switch_on, &switch_limits));
+        handle_error(notify_scheduler_add(&custom_ampere, &ampere_limits));
+        handle_error(notify_scheduler_add(&custom_volt, &volt_limits));
+        handle_error(notify_scheduler_add(&custom_watt, &watt_limits));
+        handle_error(notify_scheduler_add(&custom_energy, &energy_limits));
+        handle_error(notify_scheduler_add(&custom_calibrate_pow, &switch_limits));
 }
 
 // LED Control Function
@@ -131,23 +219,17 @@ static void led_write(bool on) {
         gpio_set_level(LED_GPIO, on ? 1 : 0);
 }
 
-// Accessory Identify Task
-static void accessory_identify_task(void *args) {
-        for (int i = 0; i < 3; i++) {
-                for (int j = 0; j < 2; j++) {
-                        led_write(true);
-                        vTaskDelay(pdMS_TO_TICKS(100));
-                        led_write(false);
-                        vTaskDelay(pdMS_TO_TICKS(100));
-                }
-                vTaskDelay(pdMS_TO_TICKS(250));
-        }
-        vTaskDelete(NULL);
-}
+// Accessory Identify
+static indicator_handle_t identify_indicator;
 
 static void accessory_identify(homekit_value_t _value) {
         ESP_LOGI(TAG, "Accessory identify");
-        xTaskCreate(accessory_identify_task, "Accessory identify", configMINIMAL_STACK_SIZE, NULL, 2, NULL);
+        indicator_play(identify_indicator, &indicator_pattern_identify);
+}
+
+static void identify_init(void) {
+        const indicator_config_t identify_config = INDICATOR_CONFIG_GPIO(LED_GPIO, NULL, NULL);
+        handle_error(indicator_create(&identify_config, &identify_indicator));
 }
 
 // HomeKit Characteristics
@@ -178,9 +260,14 @@ homekit_accessory_t *accessories[] = {
                 }),
                 HOMEKIT_SERVICE(SWITCH, .primary = true, .characteristics = (homekit_characteristic_t*[]) {
                         HOMEKIT_CHARACTERISTIC(NAME, "Power Switch"),
+                        &switch_on,
                         &custom_ampere,
                         &custom_volt,
                         &custom_watt,
+                        &custom_energy,
+                        &custom_calibrate_pow,
+                        &custom_calibrate_volts,
+                        &custom_calibrate_watts,
                         NULL
                 }),
                 NULL
@@ -189,28 +276,44 @@ homekit_accessory_t *accessories[] = {
 };
 #pragma GCC diagnostic pop
 
+static void on_homekit_event(homekit_event_t event) {
+        if (event == HOMEKIT_EVENT_CLIENT_CONNECTED) {
+                boot_trace_complete("hap_connected");
+        }
+}
+
 homekit_server_config_t config = {
         .accessories = accessories,
         .password = CONFIG_ESP_SETUP_CODE,
         .setupId = CONFIG_ESP_SETUP_ID,
+        .on_event = on_homekit_event,
 };
 
+static void on_wifi_ready() {
+        boot_trace_mark("on_wifi_ready");
+        ESP_LOGI(TAG, "Starting HomeKit server...");
+        homekit_server_init(&config);
+}
+
 // Main Function
 void app_main(void) {
+        boot_trace_init();
         esp_err_t ret = nvs_flash_init();
         if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
                 ESP_ERROR_CHECK(nvs_flash_erase());
+                boot_trace_mark("nvs_erase");
                 ESP_ERROR_CHECK(nvs_flash_init());
         }
+        boot_trace_mark("nvs_flash_init");
 
+        handle_error(wifi_connect_init(CONFIG_ESP_WIFI_SSID, CONFIG_ESP_WIFI_PASSWORD, on_wifi_ready));
+        boot_trace_mark("wifi_init");
         gpio_init();
-        bl0942_uart_init();
-
-        ESP_LOGI(TAG, "Starting HomeKit server...");
-        homekit_server_init(&config);
-
-        while (1) {
-                update_power_data();
-                vTaskDelay(pdMS_TO_TICKS(1000));
-        }
+        boot_trace_mark("gpio_init");
+        identify_init();
+        boot_trace_mark("identify_init");
+        notify_init();
+        boot_trace_mark("notify_init");
+        bl0942_init();
+        boot_trace_mark("bl0942_init");
 }
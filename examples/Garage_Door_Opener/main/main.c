@@ -23,7 +23,6 @@
 
 #include <stdio.h>
 #include <esp_wifi.h>
-#include <esp_event.h>
 #include <esp_log.h>
 #include <esp_timer.h>
 #include <nvs_flash.h>
@@ -32,6 +31,10 @@
 #include <driver/gpio.h>
 #include <homekit/homekit.h>
 #include <homekit/characteristics.h>
+#include <wifi_connect.h>
+#include <boot_trace.h>
+#include <gpio_edge.h>
+#include <indicator.h>
 
 // Error handling macro with logging
 #define CHECK_ERROR(x) do {                                                \
@@ -43,55 +46,8 @@
 } while(0)
 
 static void handle_error(esp_err_t err) {
-        switch (err) {
-        case ESP_ERR_WIFI_NOT_STARTED:
-        case ESP_ERR_WIFI_CONN:
-                ESP_LOGI("INFORMATION", "Restarting WiFi...");
-                esp_wifi_stop();
-                esp_wifi_start();
-                break;
-        default:
-                ESP_LOGE("ERROR", "Critical error, restarting device...");
-                esp_restart();
-                break;
-        }
-}
-
-static void on_wifi_ready();
-
-static void event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data) {
-        if (event_base == WIFI_EVENT && (event_id == WIFI_EVENT_STA_START || event_id == WIFI_EVENT_STA_DISCONNECTED)) {
-                ESP_LOGI("INFORMATION", "Connecting to WiFi...");
-                esp_wifi_connect();
-        } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
-                ESP_LOGI("INFORMATION", "WiFi connected, IP obtained");
-                on_wifi_ready();
-        }
-}
-
-static void wifi_init() {
-        CHECK_ERROR(esp_netif_init());
-        CHECK_ERROR(esp_event_loop_create_default());
-        esp_netif_create_default_wifi_sta();
-
-        CHECK_ERROR(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
-        CHECK_ERROR(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, NULL));
-
-        wifi_init_config_t wifi_init_config = WIFI_INIT_CONFIG_DEFAULT();
-        CHECK_ERROR(esp_wifi_init(&wifi_init_config));
-        CHECK_ERROR(esp_wifi_set_storage(WIFI_STORAGE_RAM));
-
-        wifi_config_t wifi_config = {
-                .sta = {
-                        .ssid = CONFIG_ESP_WIFI_SSID,
-                        .password = CONFIG_ESP_WIFI_PASSWORD,
-                        .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-                },
-        };
-
-        CHECK_ERROR(esp_wifi_set_mode(WIFI_MODE_STA));
-        CHECK_ERROR(esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_config));
-        CHECK_ERROR(esp_wifi_start());
+        // Wi-Fi errors reconnect with backoff, a restart is only the supervisor's last resort
+        wifi_connect_handle_error(err);
 }
 
 #define LED_GPIO            CONFIG_ESP_LED_GPIO
@@ -109,6 +65,10 @@ bool relay_closed = false;
 #define HOMEKIT_CHARACTERISTIC_TARGET_DOOR_STATE_CLOSED 0
 #define HOMEKIT_CHARACTERISTIC_TARGET_DOOR_STATE_OPEN 1
 
+// Reed switch levels as last captured by the edge service
+static volatile int reed_open_level = 0;
+static volatile int reed_close_level = 0;
+
 uint32_t door_operation_start_time = 0;
 #define MAX_DOOR_OPERATION_TIME CONFIG_ESP_DELAY
 
@@ -143,7 +103,7 @@ static void garage_door_target_state_set(homekit_value_t value) {
                 door_operation_start_time = esp_timer_get_time() / 1000; // Convert to milliseconds
                 vTaskDelay(pdMS_TO_TICKS(MAX_DOOR_OPERATION_TIME)); // Simulate door operation time
 
-                if (gpio_get_level(REED_OPEN_GPIO) == 0) {
+                if (reed_open_level == 0) {
                         relay_write_open(false);
                         garage_door_obstruction_detected.value = HOMEKIT_BOOL(true);
                         homekit_characteristic_notify(&garage_door_obstruction_detected, garage_door_obstruction_detected.value);
@@ -159,7 +119,7 @@ static void garage_door_target_state_set(homekit_value_t value) {
                 door_operation_start_time = esp_timer_get_time() / 1000; // Convert to milliseconds
                 vTaskDelay(pdMS_TO_TICKS(MAX_DOOR_OPERATION_TIME)); // Simulate door operation time
 
-                if (gpio_get_level(REED_CLOSE_GPIO) == 0) {
+                if (reed_close_level == 0) {
                         relay_write_closed(false);
                         garage_door_obstruction_detected.value = HOMEKIT_BOOL(true);
                         homekit_characteristic_notify(&garage_door_obstruction_detected, garage_door_obstruction_detected.value);
@@ -176,6 +136,21 @@ static void garage_door_target_state_set(homekit_value_t value) {
         }
 }
 
+// A reed switch closing means the door reached that end, whatever moved it
+static void reed_edge(const gpio_edge_event_t *event, void *context) {
+        uint8_t state = (uint8_t)(uintptr_t)context;
+
+        if (state == HOMEKIT_CHARACTERISTIC_CURRENT_DOOR_STATE_OPEN) {
+                reed_open_level = event->level;
+        } else {
+                reed_close_level = event->level;
+        }
+        if (event->level == 1 && garage_door_current_state.value.int_value != state) {
+                garage_door_current_state.value = HOMEKIT_UINT8(state);
+                homekit_characteristic_notify(&garage_door_current_state, garage_door_current_state.value);
+        }
+}
+
 static void gpio_init() {
         gpio_set_direction(LED_GPIO, GPIO_MODE_OUTPUT);
         led_write(led_on);
@@ -184,25 +159,29 @@ static void gpio_init() {
         relay_write_open(relay_open);
         gpio_set_direction(RELAY_CLOSE_GPIO, GPIO_MODE_OUTPUT);
         relay_write_closed(relay_closed);
+
+        CHECK_ERROR(gpio_edge_add(REED_OPEN_GPIO, GPIO_FLOATING, reed_edge,
+                                  (void *)(uintptr_t)HOMEKIT_CHARACTERISTIC_CURRENT_DOOR_STATE_OPEN));
+        CHECK_ERROR(gpio_edge_add(REED_CLOSE_GPIO, GPIO_FLOATING, reed_edge,
+                                  (void *)(uintptr_t)HOMEKIT_CHARACTERISTIC_CURRENT_DOOR_STATE_CLOSED));
+        reed_open_level = gpio_get_level(REED_OPEN_GPIO);
+        reed_close_level = gpio_get_level(REED_CLOSE_GPIO);
 }
 
-static void accessory_identify_task(void *args) {
-        for (int i = 0; i < 3; i++) {
-                for (int j = 0; j < 2; j++) {
-                        led_write(true);
-                        vTaskDelay(pdMS_TO_TICKS(100));
-                        led_write(false);
-                        vTaskDelay(pdMS_TO_TICKS(100));
-                }
-                vTaskDelay(pdMS_TO_TICKS(250));
-        }
+static indicator_handle_t identify_indicator;
+
+static void identify_restore(void *context) {
         led_write(led_on);
-        vTaskDelete(NULL);
 }
 
 static void accessory_identify(homekit_value_t _value) {
         ESP_LOGI("INFORMATION", "Accessory identify");
-        xTaskCreate(accessory_identify_task, "Accessory identify", configMINIMAL_STACK_SIZE, NULL, 2, NULL);
+        indicator_play(identify_indicator, &indicator_pattern_identify);
+}
+
+static void identify_init(void) {
+        const indicator_config_t identify_config = INDICATOR_CONFIG_GPIO(LED_GPIO, identify_restore, NULL);
+        CHECK_ERROR(indicator_create(&identify_config, &identify_indicator));
 }
 
 // HomeKit characteristics
@@ -244,26 +223,41 @@ homekit_accessory_t *accessories[] = {
 };
 #pragma GCC diagnostic pop
 
+static void on_homekit_event(homekit_event_t event) {
+        if (event == HOMEKIT_EVENT_CLIENT_CONNECTED) {
+                boot_trace_complete("hap_connected");
+        }
+}
+
 static homekit_server_config_t config = {
         .accessories = accessories,
         .password = CONFIG_ESP_SETUP_CODE,
         .setupId = CONFIG_ESP_SETUP_ID,
+        .on_event = on_homekit_event,
 };
 
 static void on_wifi_ready() {
+        boot_trace_mark("on_wifi_ready");
         ESP_LOGI("INFORMATION", "Starting HomeKit server...");
         homekit_server_init(&config);
 }
 
 void app_main(void) {
+        boot_trace_init();
         esp_err_t ret = nvs_flash_init();
         if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
                 ESP_LOGW("WARNING", "NVS flash initialization failed, erasing...");
                 CHECK_ERROR(nvs_flash_erase());
+                boot_trace_mark("nvs_erase");
                 ret = nvs_flash_init();
         }
         CHECK_ERROR(ret);
+        boot_trace_mark("nvs_flash_init");
 
-        wifi_init();
+        CHECK_ERROR(wifi_connect_init(CONFIG_ESP_WIFI_SSID, CONFIG_ESP_WIFI_PASSWORD, on_wifi_ready));
+        boot_trace_mark("wifi_init");
         gpio_init();
+        boot_trace_mark("gpio_init");
+        identify_init();
+        boot_trace_mark("identify_init");
 }
@@ -23,7 +23,6 @@
 
 #include <stdio.h>
 #include <esp_wifi.h>
-#include <esp_event.h>
 #include <esp_log.h>
 #include <nvs_flash.h>
 #include <freertos/FreeRTOS.h>
@@ -32,6 +31,10 @@
 #include <driver/ledc.h>
 #include <homekit/homekit.h>
 #include <homekit/characteristics.h>
+#include <wifi_connect.h>
+#include <boot_trace.h>
+#include <indicator.h>
+#include <pwm_pool.h>
 
 // Global variables
 static bool fan_on = false;
@@ -47,51 +50,8 @@ static float fan_speed = 100.0;
 } while(0)
 
 void handle_error(esp_err_t err) {
-        if (err == ESP_ERR_WIFI_NOT_STARTED || err == ESP_ERR_WIFI_CONN) {
-                ESP_LOGI("INFORMATION", "Restarting WiFi...");
-                esp_wifi_stop();
-                esp_wifi_start();
-        } else {
-                ESP_LOGE("ERROR", "Critical error, restarting device...");
-                esp_restart();
-        }
-}
-
-void on_wifi_ready();
-
-static void event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data) {
-        if (event_base == WIFI_EVENT && (event_id == WIFI_EVENT_STA_START || event_id == WIFI_EVENT_STA_DISCONNECTED)) {
-                ESP_LOGI("INFORMATION", "Connecting to WiFi...");
-                esp_wifi_connect();
-        } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
-                ESP_LOGI("INFORMATION", "WiFi connected, IP obtained");
-                on_wifi_ready();
-        }
-}
-
-static void wifi_init() {
-        CHECK_ERROR(esp_netif_init());
-        CHECK_ERROR(esp_event_loop_create_default());
-        esp_netif_create_default_wifi_sta();
-
-        CHECK_ERROR(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
-        CHECK_ERROR(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, NULL));
-
-        wifi_init_config_t wifi_init_config = WIFI_INIT_CONFIG_DEFAULT();
-        CHECK_ERROR(esp_wifi_init(&wifi_init_config));
-        CHECK_ERROR(esp_wifi_set_storage(WIFI_STORAGE_RAM));
-
-        wifi_config_t wifi_config = {
-                .sta = {
-                        .ssid = CONFIG_ESP_WIFI_SSID,
-                        .password = CONFIG_ESP_WIFI_PASSWORD,
-                        .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-                },
-        };
-
-        CHECK_ERROR(esp_wifi_set_mode(WIFI_MODE_STA));
-        CHECK_ERROR(esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_config));
-        CHECK_ERROR(esp_wifi_start());
+        // Wi-Fi errors reconnect with backoff, a restart is only the supervisor's last resort
+        wifi_connect_handle_error(err);
 }
 
 // LED control
@@ -100,37 +60,35 @@ static void led_write(bool on) {
 }
 
 // PWM Settings for FAN control
+#define FAN_PWM_RESOLUTION LEDC_TIMER_13_BIT
+#define FAN_PWM_FREQUENCY 5000
+
+static pwm_pool_group_t fan_pwm;
+
+// The pool picks the channel and timer, so other PWM accessories can share the board
 static void pwm_init() {
-        ledc_timer_config_t ledc_timer = {
-                .speed_mode = LEDC_HIGH_SPEED_MODE,
-                .duty_resolution = LEDC_TIMER_13_BIT,
-                .timer_num = LEDC_TIMER_0,
-                .freq_hz = 5000,
-                .clk_cfg = LEDC_AUTO_CLK
-        };
-        ledc_timer_config(&ledc_timer);
-
-        ledc_channel_config_t ledc_channel = {
-                .gpio_num   = CONFIG_ESP_FAN_GPIO,
-                .speed_mode = LEDC_HIGH_SPEED_MODE,
-                .channel    = LEDC_CHANNEL_0,
-                .intr_type  = LEDC_INTR_DISABLE,
-                .timer_sel  = LEDC_TIMER_0,
-                .duty       = 0,
-                .hpoint     = 0
+        const pwm_pool_config_t pwm_config = {
+                .owner = "fan",
+                .gpios = { CONFIG_ESP_FAN_GPIO },
+                .gpio_count = 1,
+                .freq_hz = FAN_PWM_FREQUENCY,
+                .duty_resolution = FAN_PWM_RESOLUTION,
         };
-        ledc_channel_config(&ledc_channel);
+        CHECK_ERROR(pwm_pool_claim(&pwm_config, &fan_pwm));
 }
 
 // Map speed linearly to PWM duty cycle
 static uint32_t map_speed(uint32_t speed) {
-        return (speed * (1 << LEDC_TIMER_13_BIT)) / 100;
+        return (speed * fan_pwm.duty_max) / 100;
 }
 
 static void fan_write(bool on, uint32_t speed) {
         uint32_t mapped_speed = on ? map_speed(speed) : 0;
-        ledc_set_duty(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_0, mapped_speed);
-        ledc_update_duty(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_0);
+        if (!fan_pwm.channel_count) {
+                return;
+        }
+        ledc_set_duty(fan_pwm.speed_mode, fan_pwm.channels[0], mapped_speed);
+        ledc_update_duty(fan_pwm.speed_mode, fan_pwm.channels[0]);
 }
 
 // GPIO initialization
@@ -142,18 +100,16 @@ static void gpio_init() {
 }
 
 // Accessory identification
+static indicator_handle_t identify_indicator;
+
 static void accessory_identify(homekit_value_t _value) {
         ESP_LOGI("INFORMATION", "Accessory identify");
-        for (int i = 0; i < 3; i++) {
-                for (int j = 0; j < 2; j++) {
-                        led_write(true);
-                        vTaskDelay(pdMS_TO_TICKS(100));
-                        led_write(false);
-                        vTaskDelay(pdMS_TO_TICKS(100));
-                }
-                vTaskDelay(pdMS_TO_TICKS(250));
-        }
-        led_write(false);
+        indicator_play(identify_indicator, &indicator_pattern_identify);
+}
+
+static void identify_init(void) {
+        const indicator_config_t identify_config = INDICATOR_CONFIG_GPIO(CONFIG_ESP_LED_GPIO, NULL, NULL);
+        CHECK_ERROR(indicator_create(&identify_config, &identify_indicator));
 }
 
 // HomeKit characteristic getters and setters
@@ -204,19 +160,33 @@ static homekit_accessory_t *accessories[] = {
 };
 #pragma GCC diagnostic pop
 
+static void on_homekit_event(homekit_event_t event) {
+        if (event == HOMEKIT_EVENT_CLIENT_CONNECTED) {
+                boot_trace_complete("hap_connected");
+        }
+}
+
 homekit_server_config_t config = {
         .accessories = accessories,
         .password = CONFIG_ESP_SETUP_CODE,
         .setupId = CONFIG_ESP_SETUP_ID,
+        .on_event = on_homekit_event,
 };
 
 void on_wifi_ready() {
+        boot_trace_mark("on_wifi_ready");
         ESP_LOGI("INFORMATION", "Starting HomeKit server...");
         homekit_server_init(&config);
 }
 
 void app_main(void) {
+        boot_trace_init();
         CHECK_ERROR(nvs_flash_init());
-        wifi_init();
+        boot_trace_mark("nvs_flash_init");
+        CHECK_ERROR(wifi_connect_init(CONFIG_ESP_WIFI_SSID, CONFIG_ESP_WIFI_PASSWORD, on_wifi_ready));
+        boot_trace_mark("wifi_init");
         gpio_init();
+        boot_trace_mark("gpio_init");
+        identify_init();
+        boot_trace_mark("identify_init");
 }
@@ -23,7 +23,6 @@
 
 #include <stdio.h>
 #include <esp_wifi.h>
-#include <esp_event.h>
 #include <esp_log.h>
 #include <nvs_flash.h>
 #include <freertos/FreeRTOS.h>
@@ -34,6 +33,9 @@
 #include <esp_h264.h>
 #include <homekit/homekit.h>
 #include <homekit/characteristics.h>
+#include <wifi_connect.h>
+#include <boot_trace.h>
+#include <indicator.h>
 #include <homekit/tlv.h>  // Added for TLV support
 #include <lwip/sockets.h>
 
@@ -47,51 +49,8 @@
 } while(0)
 
 void handle_error(esp_err_t err) {
-        if (err == ESP_ERR_WIFI_NOT_STARTED || err == ESP_ERR_WIFI_CONN) {
-                ESP_LOGI("INFORMATION", "Restarting WiFi...");
-                esp_wifi_stop();
-                esp_wifi_start();
-        } else {
-                ESP_LOGE("ERROR", "Critical error, restarting device...");
-                esp_restart();
-        }
-}
-
-void on_wifi_ready();
-
-static void event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data) {
-        if (event_base == WIFI_EVENT && (event_id == WIFI_EVENT_STA_START || event_id == WIFI_EVENT_STA_DISCONNECTED)) {
-                ESP_LOGI("INFORMATION", "Connecting to WiFi...");
-                esp_wifi_connect();
-        } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
-                ESP_LOGI("INFORMATION", "WiFi connected, IP obtained");
-                on_wifi_ready();
-        }
-}
-
-static void wifi_init() {
-        CHECK_ERROR(esp_netif_init());
-        CHECK_ERROR(esp_event_loop_create_default());
-        esp_netif_create_default_wifi_sta();
-
-        CHECK_ERROR(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
-        CHECK_ERROR(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, NULL));
-
-        wifi_init_config_t wifi_init_config = WIFI_INIT_CONFIG_DEFAULT();
-        CHECK_ERROR(esp_wifi_init(&wifi_init_config));
-        CHECK_ERROR(esp_wifi_set_storage(WIFI_STORAGE_RAM));
-
-        wifi_config_t wifi_config = {
-                .sta = {
-                        .ssid = CONFIG_ESP_WIFI_SSID,
-                        .password = CONFIG_ESP_WIFI_PASSWORD,
-                        .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-                },
-        };
-
-        CHECK_ERROR(esp_wifi_set_mode(WIFI_MODE_STA));
-        CHECK_ERROR(esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_config));
-        CHECK_ERROR(esp_wifi_start());
+        // Wi-Fi errors reconnect with backoff, a restart is only the supervisor's last resort
+        wifi_connect_handle_error(err);
 }
 
 // LED control
@@ -268,23 +227,20 @@ void gpio_init() {
 }
 
 // Accessory identification
-void accessory_identify_task(void *args) {
-        for (int i = 0; i < 3; i++) {
-                for (int j = 0; j < 2; j++) {
-                        led_write(true);
-                        vTaskDelay(pdMS_TO_TICKS(100));
-                        led_write(false);
-                        vTaskDelay(pdMS_TO_TICKS(100));
-                }
-                vTaskDelay(pdMS_TO_TICKS(250));
-        }
+static indicator_handle_t identify_indicator;
+
+static void identify_restore(void *context) {
         led_write(led_on);
-        vTaskDelete(NULL);
 }
 
 void accessory_identify(homekit_value_t _value) {
         ESP_LOGI("INFORMATION", "Accessory identify");
-        xTaskCreate(accessory_identify_task, "Accessory identify", configMINIMAL_STACK_SIZE, NULL, 2, NULL);
+        indicator_play(identify_indicator, &indicator_pattern_identify);
+}
+
+static void identify_init(void) {
+        const indicator_config_t identify_config = INDICATOR_CONFIG_GPIO(LED_GPIO, identify_restore, NULL);
+        CHECK_ERROR(indicator_create(&identify_config, &identify_indicator));
 }
 
 // HomeKit characteristics
@@ -328,28 +284,44 @@ homekit_accessory_t *accessories[] = {
 };
 #pragma GCC diagnostic pop
 
+static void on_homekit_event(homekit_event_t event) {
+        if (event == HOMEKIT_EVENT_CLIENT_CONNECTED) {
+                boot_trace_complete("hap_connected");
+        }
+}
+
 homekit_server_config_t config = {
         .accessories = accessories,
         .password = CONFIG_ESP_SETUP_CODE,
         .setupId = CONFIG_ESP_SETUP_ID,
+        .on_event = on_homekit_event,
 };
 
 void on_wifi_ready() {
+        boot_trace_mark("on_wifi_ready");
         ESP_LOGI("INFORMATION", "Starting HomeKit server...");
         homekit_server_init(&config);
         xTaskCreate(video_streaming_task, "Video Streaming", 4096, NULL, 5, NULL);
 }
 
 void app_main(void) {
+        boot_trace_init();
         esp_err_t ret = nvs_flash_init();
         if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
                 ESP_LOGW("WARNING", "NVS flash initialization failed, erasing...");
                 CHECK_ERROR(nvs_flash_erase());
+                boot_trace_mark("nvs_erase");
                 ret = nvs_flash_init();
         }
         CHECK_ERROR(ret);
+        boot_trace_mark("nvs_flash_init");
 
-        wifi_init();
+        CHECK_ERROR(wifi_connect_init(CONFIG_ESP_WIFI_SSID, CONFIG_ESP_WIFI_PASSWORD, on_wifi_ready));
+        boot_trace_mark("wifi_init");
         gpio_init();
+        boot_trace_mark("gpio_init");
+        identify_init();
+        boot_trace_mark("identify_init");
         camera_init();
+        boot_trace_mark("camera_init");
 }
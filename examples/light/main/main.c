@@ -23,15 +23,19 @@
 
 #include <stdio.h>
 #include <esp_wifi.h>
-#include <esp_event.h>
 #include <esp_log.h>
 #include <nvs_flash.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <driver/gpio.h>
-#include <driver/ledc.h>
 #include <homekit/homekit.h>
 #include <homekit/characteristics.h>
+#include <wifi_connect.h>
+#include <boot_trace.h>
+#include <indicator.h>
+#include <pwm_pool.h>
+#include <light_fade.h>
+#include <light_curve.h>
 #include <math.h>
 
 #define CHECK_ERROR(x) do { \
@@ -43,55 +47,8 @@
 } while(0)
 
 static void handle_error(esp_err_t err) {
-        switch (err) {
-        case ESP_ERR_WIFI_NOT_STARTED:
-        case ESP_ERR_WIFI_CONN:
-                ESP_LOGI("INFORMATION", "Restarting WiFi...");
-                esp_wifi_stop();
-                esp_wifi_start();
-                break;
-        default:
-                ESP_LOGE("ERROR", "Critical error, restarting device...");
-                esp_restart();
-                break;
-        }
-}
-
-static void on_wifi_ready();
-
-static void event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data) {
-        if (event_base == WIFI_EVENT && (event_id == WIFI_EVENT_STA_START || event_id == WIFI_EVENT_STA_DISCONNECTED)) {
-                ESP_LOGI("INFORMATION", "Connecting to WiFi...");
-                esp_wifi_connect();
-        } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
-                ESP_LOGI("INFORMATION", "WiFi connected, IP obtained");
-                on_wifi_ready();
-        }
-}
-
-static void wifi_init() {
-        CHECK_ERROR(esp_netif_init());
-        CHECK_ERROR(esp_event_loop_create_default());
-        esp_netif_create_default_wifi_sta();
-
-        CHECK_ERROR(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
-        CHECK_ERROR(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, NULL));
-
-        wifi_init_config_t wifi_init_config = WIFI_INIT_CONFIG_DEFAULT();
-        CHECK_ERROR(esp_wifi_init(&wifi_init_config));
-        CHECK_ERROR(esp_wifi_set_storage(WIFI_STORAGE_RAM));
-
-        wifi_config_t wifi_config = {
-                .sta = {
-                        .ssid = CONFIG_ESP_WIFI_SSID,
-                        .password = CONFIG_ESP_WIFI_PASSWORD,
-                        .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-                },
-        };
-
-        CHECK_ERROR(esp_wifi_set_mode(WIFI_MODE_STA));
-        CHECK_ERROR(esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_config));
-        CHECK_ERROR(esp_wifi_start());
+        // Wi-Fi errors reconnect with backoff, a restart is only the supervisor's last resort
+        wifi_connect_handle_error(err);
 }
 
 // LED control
@@ -100,41 +57,53 @@ static bool led_on = false;
 static uint32_t led_brightness = 100;  // Default brightness
 
 // PWM Settings
-#define LEDC_TIMER LEDC_TIMER_0
-#define LEDC_MODE LEDC_HIGH_SPEED_MODE
-#define LEDC_CHANNEL LEDC_CHANNEL_0
 #define LEDC_RESOLUTION LEDC_TIMER_13_BIT
 #define LEDC_FREQUENCY 5000
+#define LEDC_DUTY_MAX ((1 << LEDC_RESOLUTION) - 1)
+#define LED_FRACTION_BITS 3  // sub-LSB duty bits, dithered at the dim end when LIGHT_FADE_DITHER_HZ is set
+#define LED_FADE_MS 400      // fade time from off to full; smaller steps are faster
 
-// Initialize PWM
+static pwm_pool_group_t led_pwm;
+static light_fade_handle_t led_fade;
+
+// Initialize PWM; the pool picks the channel and timer, so other PWM accessories can share the board
 static void pwm_init() {
-        ledc_timer_config_t ledc_timer = {
-                .duty_resolution = LEDC_RESOLUTION,
+        const pwm_pool_config_t pwm_config = {
+                .owner = "light",
+                .gpios = { LED_GPIO },
+                .gpio_count = 1,
                 .freq_hz = LEDC_FREQUENCY,
-                .speed_mode = LEDC_MODE,
-                .timer_num = LEDC_TIMER,
+                .duty_resolution = LEDC_RESOLUTION,
         };
-        ledc_timer_config(&ledc_timer);
-
-        ledc_channel_config_t ledc_channel = {
-                .channel    = LEDC_CHANNEL,
-                .duty       = 0,
-                .gpio_num   = LED_GPIO,
-                .speed_mode = LEDC_MODE,
-                .timer_sel  = LEDC_TIMER,
+        esp_err_t err = pwm_pool_claim(&pwm_config, &led_pwm);
+        if (err != ESP_OK) {
+                // Without channels of its own the light stays dark rather than drive another output
+                CHECK_ERROR(err);
+                return;
+        }
+
+        const light_fade_config_t fade_config = {
+                .speed_mode = led_pwm.speed_mode,
+                .channels = { led_pwm.channels[0] },
+                .channel_count = 1,
+                .duty_max = LEDC_DUTY_MAX,
+                .full_scale_ms = LED_FADE_MS,
+                .fraction_bits = LED_FRACTION_BITS,
         };
-        ledc_channel_config(&ledc_channel);
+        CHECK_ERROR(light_fade_create(&fade_config, &led_fade));
 }
 
-// Map the brightness linearly to the PWM duty cycle
+// Map the brightness along the CIE lightness curve, so equal steps in HomeKit look equal
 static uint32_t map_brightness(uint32_t brightness) {
-        return (brightness * (1 << LEDC_RESOLUTION)) / 100; // Map 0-100 to the entire range of duty cycle
+        return light_curve_duty(light_curve_cie(light_curve_percent(brightness)), LEDC_DUTY_MAX, LED_FRACTION_BITS);
 }
 
 static void led_write(bool on, uint32_t brightness) {
-        uint32_t mapped_brightness = on ? map_brightness(brightness) : 0;
-        ledc_set_duty(LEDC_MODE, LEDC_CHANNEL, mapped_brightness);
-        ledc_update_duty(LEDC_MODE, LEDC_CHANNEL);
+        if (!led_fade) {
+                return;
+        }
+        uint32_t duty = on ? map_brightness(brightness) : 0;
+        CHECK_ERROR(light_fade_to(led_fade, &duty));
 }
 
 // All GPIO Settings
@@ -144,23 +113,29 @@ static void gpio_init() {
 }
 
 // Accessory identification
-static void accessory_identify_task(void *args) {
-        for (int i = 0; i < 3; i++) {
-                for (int j = 0; j < 2; j++) {
-                        led_write(true, led_brightness);
-                        vTaskDelay(pdMS_TO_TICKS(100));
-                        led_write(false, led_brightness);
-                        vTaskDelay(pdMS_TO_TICKS(100));
-                }
-                vTaskDelay(pdMS_TO_TICKS(250));
+static indicator_handle_t identify_indicator;
+
+// The pattern goes through the fade engine so it cancels any fade or dithering in progress
+static void identify_write(uint8_t level, void *context) {
+        if (!led_fade) {
+                return;
         }
+        uint32_t duty = light_curve_duty(level * 257, LEDC_DUTY_MAX, LED_FRACTION_BITS);
+        light_fade_set(led_fade, &duty);
+}
+
+static void identify_restore(void *context) {
         led_write(led_on, led_brightness);
-        vTaskDelete(NULL);
 }
 
 static void accessory_identify(homekit_value_t _value) {
         ESP_LOGI("INFORMATION", "Accessory identify");
-        xTaskCreate(accessory_identify_task, "Accessory identify", configMINIMAL_STACK_SIZE, NULL, 2, NULL);
+        indicator_play(identify_indicator, &indicator_pattern_identify);
+}
+
+static void identify_init(void) {
+        const indicator_config_t identify_config = INDICATOR_CONFIG_CUSTOM(identify_write, identify_restore, NULL);
+        CHECK_ERROR(indicator_create(&identify_config, &identify_indicator));
 }
 
 // HomeKit characteristics
@@ -235,26 +210,41 @@ homekit_accessory_t *accessories[] = {
 };
 #pragma GCC diagnostic pop
 
+static void on_homekit_event(homekit_event_t event) {
+        if (event == HOMEKIT_EVENT_CLIENT_CONNECTED) {
+                boot_trace_complete("hap_connected");
+        }
+}
+
 homekit_server_config_t config = {
         .accessories = accessories,
         .password = CONFIG_ESP_SETUP_CODE,
         .setupId = CONFIG_ESP_SETUP_ID,
+        .on_event = on_homekit_event,
 };
 
 static void on_wifi_ready() {
+        boot_trace_mark("on_wifi_ready");
         ESP_LOGI("INFORMATION", "Starting HomeKit server...");
         homekit_server_init(&config);
 }
 
 void app_main(void) {
+        boot_trace_init();
         esp_err_t ret = nvs_flash_init();
         if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
                 ESP_LOGW("WARNING", "NVS flash initialization failed, erasing...");
                 CHECK_ERROR(nvs_flash_erase());
+                boot_trace_mark("nvs_erase");
                 ret = nvs_flash_init();
         }
         CHECK_ERROR(ret);
+        boot_trace_mark("nvs_flash_init");
 
-        wifi_init();
+        CHECK_ERROR(wifi_connect_init(CONFIG_ESP_WIFI_SSID, CONFIG_ESP_WIFI_PASSWORD, on_wifi_ready));
+        boot_trace_mark("wifi_init");
         gpio_init();
+        boot_trace_mark("gpio_init");
+        identify_init();
+        boot_trace_mark("identify_init");
 }
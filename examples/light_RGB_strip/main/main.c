@@ -23,15 +23,20 @@
 
 #include <stdio.h>
 #include <esp_wifi.h>
-#include <esp_event.h>
 #include <esp_log.h>
 #include <nvs_flash.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
-#include <driver/ledc.h>
 #include <homekit/homekit.h>
 #include <homekit/characteristics.h>
-#include <math.h>
+#include <wifi_connect.h>
+#include <boot_trace.h>
+#include <indicator.h>
+#include <seqlock.h>
+#include <color_lut.h>
+#include <pwm_pool.h>
+#include <light_fade.h>
+#include <light_curve.h>
 
 // Custom error handling macro
 #define CHECK_ERROR(x) do {                        \
@@ -43,257 +48,171 @@
 } while(0)
 
 static void handle_error(esp_err_t err) {
-        switch (err) {
-        case ESP_ERR_WIFI_NOT_STARTED:
-        case ESP_ERR_WIFI_CONN:
-                ESP_LOGI("INFORMATION", "Restarting WiFi...");
-                esp_wifi_stop();
-                esp_wifi_start();
-                break;
-        default:
-                ESP_LOGE("ERROR", "Critical error, restarting device...");
-                esp_restart();
-                break;
-        }
-}
-
-static void on_wifi_ready();
-
-static void event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data) {
-        if (event_base == WIFI_EVENT && (event_id == WIFI_EVENT_STA_START || event_id == WIFI_EVENT_STA_DISCONNECTED)) {
-                ESP_LOGI("INFORMATION", "Connecting to WiFi...");
-                esp_wifi_connect();
-        } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
-                ESP_LOGI("INFORMATION", "WiFi connected, IP obtained");
-                on_wifi_ready();
-        }
-}
-
-static void wifi_init() {
-        CHECK_ERROR(esp_netif_init());
-        CHECK_ERROR(esp_event_loop_create_default());
-        esp_netif_create_default_wifi_sta();
-
-        CHECK_ERROR(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
-        CHECK_ERROR(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, NULL));
-
-        wifi_init_config_t wifi_init_config = WIFI_INIT_CONFIG_DEFAULT();
-        CHECK_ERROR(esp_wifi_init(&wifi_init_config));
-        CHECK_ERROR(esp_wifi_set_storage(WIFI_STORAGE_RAM));
-
-        wifi_config_t wifi_config = {
-                .sta = {
-                        .ssid = CONFIG_ESP_WIFI_SSID,
-                        .password = CONFIG_ESP_WIFI_PASSWORD,
-                        .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-                },
-        };
-
-        CHECK_ERROR(esp_wifi_set_mode(WIFI_MODE_STA));
-        CHECK_ERROR(esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_config));
-        CHECK_ERROR(esp_wifi_start());
+        // Wi-Fi errors reconnect with backoff, a restart is only the supervisor's last resort
+        wifi_connect_handle_error(err);
 }
 
 static void gpio_init() {
         // Initialize GPIO or other peripherals here if necessary
 }
 
-#define LPF_SHIFT 4  // divide by 16
-#define LPF_INTERVAL 10  // in milliseconds
-
 #define RED_PWM_PIN CONFIG_ESP_RED_LED_GPIO
 #define GREEN_PWM_PIN CONFIG_ESP_GREEN_LED_GPIO
 #define BLUE_PWM_PIN CONFIG_ESP_BLUE_LED_GPIO
-#define LED_RGB_SCALE 255  // scaling factor used for color conversion
-
-typedef union {
-        struct {
-                uint16_t blue;
-                uint16_t green;
-                uint16_t red;
-                uint16_t white;
-        };
-        uint64_t color;
-} rgb_color_t;
 
-// Color smoothing variables
-static rgb_color_t current_color = { { 0, 0, 0, 0 } };
-static rgb_color_t target_color = { { 0, 0, 0, 0 } };
+#define LEDC_RESOLUTION LEDC_TIMER_13_BIT
+#define LEDC_FREQUENCY 5000
+#define LEDC_DUTY_MAX ((1 << LEDC_RESOLUTION) - 1)
+#define LED_FRACTION_BITS 3  // sub-LSB duty bits, dithered at the dim end when LIGHT_FADE_DITHER_HZ is set
+#define LED_FADE_MS 400      // fade time from off to full; smaller steps are faster
 
 // Global variables
-static float led_hue = 0;              // hue is scaled 0 to 360
-static float led_saturation = 59;      // saturation is scaled 0 to 100
-static float led_brightness = 100;     // brightness is scaled 0 to 100
-static bool led_on = false;            // on is boolean on or off
-
-static void hsi2rgb(float h, float s, float i, rgb_color_t* rgb) {
-        int r, g, b;
-
-        h = fmodf(h, 360.0F); // cycle h around to 0-360 degrees
-        h = M_PI * h / 180.0F; // convert to radians.
-        s /= 100.0F;       // from percentage to ratio
-        i /= 100.0F;       // from percentage to ratio
-
-        s = fminf(fmaxf(s, 0.0F), 1.0F); // clamp s and i to interval [0,1]
-        i = fminf(fmaxf(i, 0.0F), 1.0F);
-
-        if (h < 2.09439) {
-                r = LED_RGB_SCALE * i / 3 * (1 + s * cosf(h) / cosf(1.047196667 - h));
-                g = LED_RGB_SCALE * i / 3 * (1 + s * (1 - cosf(h) / cosf(1.047196667 - h)));
-                b = LED_RGB_SCALE * i / 3 * (1 - s);
-        } else if (h < 4.188787) {
-                h -= 2.09439;
-                g = LED_RGB_SCALE * i / 3 * (1 + s * cosf(h) / cosf(1.047196667 - h));
-                b = LED_RGB_SCALE * i / 3 * (1 + s * (1 - cosf(h) / cosf(1.047196667 - h)));
-                r = LED_RGB_SCALE * i / 3 * (1 - s);
-        } else {
-                h -= 4.188787;
-                b = LED_RGB_SCALE * i / 3 * (1 + s * cosf(h) / cosf(1.047196667 - h));
-                r = LED_RGB_SCALE * i / 3 * (1 + s * (1 - cosf(h) / cosf(1.047196667 - h)));
-                g = LED_RGB_SCALE * i / 3 * (1 - s);
+typedef struct {
+        float hue;        // hue is scaled 0 to 360
+        float saturation; // saturation is scaled 0 to 100
+        float brightness; // brightness is scaled 0 to 100
+        bool on;          // on is boolean on or off
+} led_state_t;
+
+// Written by the HomeKit setters, read by the render path on another task
+static led_state_t led_state = { .hue = 0, .saturation = 59, .brightness = 100, .on = false };
+static seqlock_t led_state_lock = SEQLOCK_INIT;
+
+static pwm_pool_group_t led_pwm;
+static light_fade_handle_t led_fade;
+
+// Fade the LEDC outputs to the current HomeKit state; nothing runs once the fade has ended
+static void led_update(void) {
+        color_rgbw16_t color = {0};
+        if (!led_fade) {
+                return;
         }
-
-        rgb->red = (uint8_t) r;
-        rgb->green = (uint8_t) g;
-        rgb->blue = (uint8_t) b;
+        // identify_restore runs on the esp_timer task, so work from a consistent copy
+        led_state_t state;
+        SEQLOCK_READ(&led_state_lock, state, led_state);
+        if (state.on) {
+                color_lut_hsi_to_rgb16(state.hue, state.saturation, state.brightness, &color);
+        }
+        // Each channel follows the CIE lightness curve onto the full 13-bit duty range; the 16-bit
+        // colour keeps the dim end from collapsing onto a few 8-bit steps before the curve
+        const uint32_t duties[3] = {
+                light_curve_duty(light_curve_cie(color.red), LEDC_DUTY_MAX, LED_FRACTION_BITS),
+                light_curve_duty(light_curve_cie(color.green), LEDC_DUTY_MAX, LED_FRACTION_BITS),
+                light_curve_duty(light_curve_cie(color.blue), LEDC_DUTY_MAX, LED_FRACTION_BITS),
+        };
+        CHECK_ERROR(light_fade_to(led_fade, duties));
 }
 
-// Function to handle LED control tasks
-static void ledc_task(void *pvParameters) {
-        const TickType_t xPeriod = pdMS_TO_TICKS(LPF_INTERVAL);
-        TickType_t xLastWakeTime = xTaskGetTickCount();
-
-        // LEDC channel configuration for RGB channels
-        static const ledc_channel_config_t ledc_channel[3] = {
-                { .channel = LEDC_CHANNEL_0, .duty = 0, .gpio_num = RED_PWM_PIN, .speed_mode = LEDC_HIGH_SPEED_MODE, .hpoint = 0, .timer_sel = LEDC_TIMER_0 },
-                { .channel = LEDC_CHANNEL_1, .duty = 0, .gpio_num = GREEN_PWM_PIN, .speed_mode = LEDC_HIGH_SPEED_MODE, .hpoint = 0, .timer_sel = LEDC_TIMER_0 },
-                { .channel = LEDC_CHANNEL_2, .duty = 0, .gpio_num = BLUE_PWM_PIN, .speed_mode = LEDC_HIGH_SPEED_MODE, .hpoint = 0, .timer_sel = LEDC_TIMER_0 }
-        };
+static void ledc_init() {
+        ESP_LOGI("INFORMATION", "Initializing LED control");
 
-        // LEDC timer configuration
-        static const ledc_timer_config_t ledc_timer = {
-                .speed_mode = LEDC_HIGH_SPEED_MODE,
-                .timer_num = LEDC_TIMER_0,
-                .duty_resolution = LEDC_TIMER_13_BIT,
-                .freq_hz = 5000,
-                .clk_cfg = LEDC_AUTO_CLK
+        // The pool picks the channels and timer, so other PWM accessories can share the board
+        const pwm_pool_config_t pwm_config = {
+                .owner = "RGB strip",
+                .gpios = { RED_PWM_PIN, GREEN_PWM_PIN, BLUE_PWM_PIN },
+                .gpio_count = 3,
+                .freq_hz = LEDC_FREQUENCY,
+                .duty_resolution = LEDC_RESOLUTION,
         };
-
-        // Configure the LEDC timer and channels
-        CHECK_ERROR(ledc_timer_config(&ledc_timer));
-        for (int ch = 0; ch < 3; ch++) {
-                CHECK_ERROR(ledc_channel_config(&ledc_channel[ch]));
+        esp_err_t err = pwm_pool_claim(&pwm_config, &led_pwm);
+        if (err != ESP_OK) {
+                // Without channels of its own the strip stays dark rather than drive another output
+                CHECK_ERROR(err);
+                return;
         }
 
-        // Main loop for updating LED colors
-        while (true) {
-                if (led_on) {
-                        hsi2rgb(led_hue, led_saturation, led_brightness, &target_color);
-                } else {
-                        target_color = (rgb_color_t){{0, 0, 0, 0}};
-                }
-
-                // Apply low-pass filter to smoothly transition to target color
-                current_color.red += ((target_color.red * 256) - current_color.red) >> LPF_SHIFT;
-                current_color.green += ((target_color.green * 256) - current_color.green) >> LPF_SHIFT;
-                current_color.blue += ((target_color.blue * 256) - current_color.blue) >> LPF_SHIFT;
-
-                // Update LED duty cycle for RGB channels
-                ledc_set_duty(ledc_channel[0].speed_mode, ledc_channel[0].channel, current_color.red >> 8);
-                ledc_update_duty(ledc_channel[0].speed_mode, ledc_channel[0].channel);
-                ledc_set_duty(ledc_channel[1].speed_mode, ledc_channel[1].channel, current_color.green >> 8);
-                ledc_update_duty(ledc_channel[1].speed_mode, ledc_channel[1].channel);
-                ledc_set_duty(ledc_channel[2].speed_mode, ledc_channel[2].channel, current_color.blue >> 8);
-                ledc_update_duty(ledc_channel[2].speed_mode, ledc_channel[2].channel);
-
-                vTaskDelayUntil(&xLastWakeTime, xPeriod);
-        }
+        const light_fade_config_t fade_config = {
+                .speed_mode = led_pwm.speed_mode,
+                .channels = { led_pwm.channels[0], led_pwm.channels[1], led_pwm.channels[2] },
+                .channel_count = 3,
+                .duty_max = LEDC_DUTY_MAX,
+                .full_scale_ms = LED_FADE_MS,
+                .fraction_bits = LED_FRACTION_BITS,
+        };
+        CHECK_ERROR(light_fade_create(&fade_config, &led_fade));
+        led_update();
 }
 
-// Function to initialize LED control and create the task
-static void ledc_init() {
-        ESP_LOGI("INFORMATION", "Initializing LED control");
-        // Create the LEDC task with a specific stack size
-        xTaskCreate(ledc_task, "ledc_task", 2048, NULL, 2, NULL); // Reduced stack size for memory efficiency
-}
+static indicator_handle_t identify_indicator;
 
-static void led_identify_task(void *_args) {
-        ESP_LOGI("INFORMATION", "Starting LED identify task");
-
-        rgb_color_t original_color = target_color;
-        rgb_color_t off = { { 0, 0, 0, 0 } };
-        rgb_color_t on = { { 128, 128, 128, 0 } };
-
-        for (int i = 0; i < 3; i++) {
-                for (int j = 0; j < 2; j++) {
-                        led_on = true;
-                        led_brightness = 100;
-                        target_color = on;
-                        vTaskDelay(pdMS_TO_TICKS(100));
-
-                        led_on = false;
-                        led_brightness = 0;
-                        target_color = off;
-                        vTaskDelay(pdMS_TO_TICKS(100));
-                }
-                vTaskDelay(pdMS_TO_TICKS(250));
+// The identify pattern drives the outputs directly, so the HomeKit state is never touched
+static void identify_write(uint8_t level, void *context) {
+        if (!led_fade) {
+                return;
         }
+        const uint32_t duty = light_curve_duty(level * 257, LEDC_DUTY_MAX, LED_FRACTION_BITS);
+        const uint32_t duties[3] = { duty, duty, duty };
+        light_fade_set(led_fade, duties);
+}
 
-        led_on = false;
-        led_brightness = 100;
-        target_color = original_color;
-        ESP_LOGI("INFORMATION", "LED identify task completed");
-
-        vTaskDelete(NULL);
+static void identify_restore(void *context) {
+        led_update();
 }
 
 static void accessory_identify(homekit_value_t _value) {
         ESP_LOGI("INFORMATION", "Accessory identify");
-        xTaskCreate(led_identify_task, "Accessory identify", configMINIMAL_STACK_SIZE, NULL, 2, NULL);
+        indicator_play(identify_indicator, &indicator_pattern_identify);
+}
+
+static void identify_init(void) {
+        const indicator_config_t identify_config = INDICATOR_CONFIG_CUSTOM(identify_write, identify_restore, NULL);
+        CHECK_ERROR(indicator_create(&identify_config, &identify_indicator));
 }
 
 static homekit_value_t led_on_get() {
-        return HOMEKIT_BOOL(led_on);
+        return HOMEKIT_BOOL(led_state.on);
 }
 
 static void led_on_set(homekit_value_t value) {
         if (value.format != homekit_format_bool) {
                 return;
         }
-        led_on = value.bool_value;
+        seqlock_write_begin(&led_state_lock);
+        led_state.on = value.bool_value;
+        seqlock_write_end(&led_state_lock);
+        led_update();
 }
 
 static homekit_value_t led_brightness_get() {
-        return HOMEKIT_INT(led_brightness);
+        return HOMEKIT_INT(led_state.brightness);
 }
 
 static void led_brightness_set(homekit_value_t value) {
         if (value.format != homekit_format_int) {
                 return;
         }
-        led_brightness = value.int_value;
+        seqlock_write_begin(&led_state_lock);
+        led_state.brightness = value.int_value;
+        seqlock_write_end(&led_state_lock);
+        led_update();
 }
 
 static homekit_value_t led_hue_get() {
-        return HOMEKIT_FLOAT(led_hue);
+        return HOMEKIT_FLOAT(led_state.hue);
 }
 
 static void led_hue_set(homekit_value_t value) {
         if (value.format != homekit_format_float) {
                 return;
         }
-        led_hue = value.float_value;
+        seqlock_write_begin(&led_state_lock);
+        led_state.hue = value.float_value;
+        seqlock_write_end(&led_state_lock);
+        led_update();
 }
 
 static homekit_value_t led_saturation_get() {
-        return HOMEKIT_FLOAT(led_saturation);
+        return HOMEKIT_FLOAT(led_state.saturation);
 }
 
 static void led_saturation_set(homekit_value_t value) {
         if (value.format != homekit_format_float) {
                 return;
         }
-        led_saturation = value.float_value;
+        seqlock_write_begin(&led_state_lock);
+        led_state.saturation = value.float_value;
+        seqlock_write_end(&led_state_lock);
+        led_update();
 }
 
 // HomeKit characteristics
@@ -336,27 +255,43 @@ static homekit_accessory_t *accessories[] = {
 };
 #pragma GCC diagnostic pop
 
+static void on_homekit_event(homekit_event_t event) {
+        if (event == HOMEKIT_EVENT_CLIENT_CONNECTED) {
+                boot_trace_complete("hap_connected");
+        }
+}
+
 static homekit_server_config_t config = {
         .accessories = accessories,
         .password = CONFIG_ESP_SETUP_CODE,
         .setupId = CONFIG_ESP_SETUP_ID,
+        .on_event = on_homekit_event,
 };
 
 static void on_wifi_ready() {
+        boot_trace_mark("on_wifi_ready");
         ESP_LOGI("INFORMATION", "Starting HomeKit server...");
         homekit_server_init(&config);
 }
 
 void app_main(void) {
+        boot_trace_init();
         esp_err_t ret = nvs_flash_init();
         if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
                 ESP_LOGW("WARNING", "NVS flash initialization failed, erasing...");
                 CHECK_ERROR(nvs_flash_erase());
+                boot_trace_mark("nvs_erase");
                 ret = nvs_flash_init();
         }
         CHECK_ERROR(ret);
+        boot_trace_mark("nvs_flash_init");
 
-        wifi_init();
+        CHECK_ERROR(wifi_connect_init(CONFIG_ESP_WIFI_SSID, CONFIG_ESP_WIFI_PASSWORD, on_wifi_ready));
+        boot_trace_mark("wifi_init");
         gpio_init();
+        boot_trace_mark("gpio_init");
         ledc_init();
+        boot_trace_mark("ledc_init");
+        identify_init();
+        boot_trace_mark("identify_init");
 }
@@ -23,7 +23,6 @@
 
 #include <stdio.h>
 #include <esp_wifi.h>
-#include <esp_event.h>
 #include <esp_log.h>
 #include <nvs_flash.h>
 #include <freertos/FreeRTOS.h>
@@ -31,6 +30,9 @@
 #include <driver/gpio.h>
 #include <homekit/homekit.h>
 #include <homekit/characteristics.h>
+#include <wifi_connect.h>
+#include <boot_trace.h>
+#include <sensor_filter.h>
 #include <bh1750.h>
 #include <string.h>
 
@@ -44,51 +46,8 @@
 } while(0)
 
 static void handle_error(esp_err_t err) {
-    if (err == ESP_ERR_WIFI_NOT_STARTED || err == ESP_ERR_WIFI_CONN) {
-        ESP_LOGI("INFORMATION", "Restarting WiFi...");
-        CHECK_ERROR(esp_wifi_stop());
-        CHECK_ERROR(esp_wifi_start());
-    } else {
-        ESP_LOGE("ERROR", "Critical error, restarting device...");
-        esp_restart();
-    }
-}
-
-static void on_wifi_ready();
-
-static void event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data) {
-    if (event_base == WIFI_EVENT && (event_id == WIFI_EVENT_STA_START || event_id == WIFI_EVENT_STA_DISCONNECTED)) {
-        ESP_LOGI("INFORMATION", "Connecting to WiFi...");
-        CHECK_ERROR(esp_wifi_connect());
-    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
-        ESP_LOGI("INFORMATION", "WiFi connected, IP obtained");
-        on_wifi_ready();
-    }
-}
-
-static void wifi_init() {
-    CHECK_ERROR(esp_netif_init());
-    CHECK_ERROR(esp_event_loop_create_default());
-    esp_netif_create_default_wifi_sta();
-
-    CHECK_ERROR(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
-    CHECK_ERROR(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, NULL));
-
-    wifi_init_config_t wifi_init_config = WIFI_INIT_CONFIG_DEFAULT();
-    CHECK_ERROR(esp_wifi_init(&wifi_init_config));
-    CHECK_ERROR(esp_wifi_set_storage(WIFI_STORAGE_RAM));
-
-    wifi_config_t wifi_config = {
-        .sta = {
-            .ssid = CONFIG_ESP_WIFI_SSID,
-            .password = CONFIG_ESP_WIFI_PASSWORD,
-            .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-        },
-    };
-
-    CHECK_ERROR(esp_wifi_set_mode(WIFI_MODE_STA));
-    CHECK_ERROR(esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_config));
-    CHECK_ERROR(esp_wifi_start());
+    // Wi-Fi errors reconnect with backoff, a restart is only the supervisor's last resort
+    wifi_connect_handle_error(err);
 }
 
 #define I2C_SCL_PIN CONFIG_ESP_I2C_MASTER_SCL
@@ -111,9 +70,11 @@ static homekit_characteristic_t currentAmbientLightLevel = HOMEKIT_CHARACTERISTI
 
 // BH1750 Sensor Variables
 static i2c_dev_t bh1750_dev;
+static sensor_filter_handle_t lux_filter;
 
 static void light_sensor_task(void *arg) {
     uint16_t lux_value;
+    float lux;
 
     // Initialize BH1750 sensor with dynamic I2C address
     CHECK_ERROR(bh1750_init_desc(&bh1750_dev, I2C_ADDRESS, I2C_NUM_0, I2C_SDA_PIN, I2C_SCL_PIN));
@@ -123,8 +84,14 @@ static void light_sensor_task(void *arg) {
     while (1) {
         if (bh1750_read(&bh1750_dev, &lux_value) == ESP_OK) {
             ESP_LOGI("SENSOR", "Light Intensity: %d lux", lux_value);
-            currentAmbientLightLevel.value.float_value = lux_value;
-            homekit_characteristic_notify(&currentAmbientLightLevel, currentAmbientLightLevel.value);
+            if (sensor_filter_update(lux_filter, lux_value, &lux)) {
+                sensor_filter_stats_t stats;
+                sensor_filter_get_stats(lux_filter, &stats);
+                ESP_LOGI("SENSOR", "Notifying %.0f lux (%lu of %lu readings sent)", lux,
+                         (unsigned long)stats.published, (unsigned long)stats.readings);
+                currentAmbientLightLevel.value.float_value = lux;
+                homekit_characteristic_notify(&currentAmbientLightLevel, currentAmbientLightLevel.value);
+            }
         } else {
             ESP_LOGE("SENSOR", "Failed to read light intensity.");
         }
@@ -134,6 +101,14 @@ static void light_sensor_task(void *arg) {
 }
 
 static void light_sensor_init() {
+    // Lux spans five decades, so the deadband is on a log scale: about 12 % of the reading.
+    // A median of three drops a single shadow or reflection, and an unchanged level is sent every 30 minutes.
+    const sensor_filter_config_t filter_config = {
+        .log_deadband = 0.05,
+        .heartbeat_ms = 1800000,
+        .median_window = 3,
+    };
+    CHECK_ERROR(sensor_filter_create(&filter_config, &lux_filter));
     xTaskCreate(light_sensor_task, "Light Sensor", 4096, NULL, 2, NULL);
 }
 
@@ -169,20 +144,33 @@ static homekit_accessory_t *accessories[] = {
 };
 #pragma GCC diagnostic pop
 
+static void on_homekit_event(homekit_event_t event) {
+    if (event == HOMEKIT_EVENT_CLIENT_CONNECTED) {
+        boot_trace_complete("hap_connected");
+    }
+}
+
 static homekit_server_config_t config = {
     .accessories = accessories,
     .password = CONFIG_ESP_SETUP_CODE,
     .setupId = CONFIG_ESP_SETUP_ID,
+    .on_event = on_homekit_event,
 };
 
 static void on_wifi_ready() {
+    boot_trace_mark("on_wifi_ready");
     ESP_LOGI("INFORMATION", "Starting HomeKit server...");
     homekit_server_init(&config);
 }
 
 void app_main(void) {
+    boot_trace_init();
     CHECK_ERROR(nvs_flash_init());
-    wifi_init();
+    boot_trace_mark("nvs_flash_init");
+    CHECK_ERROR(wifi_connect_init(CONFIG_ESP_WIFI_SSID, CONFIG_ESP_WIFI_PASSWORD, on_wifi_ready));
+    boot_trace_mark("wifi_init");
     gpio_init();
+    boot_trace_mark("gpio_init");
     light_sensor_init();
+    boot_trace_mark("light_sensor_init");
 }
@@ -23,14 +23,19 @@
 
 #include <stdio.h>
 #include <esp_wifi.h>
-#include <esp_event.h>
 #include <esp_log.h>
 #include <nvs_flash.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
-#include <driver/ledc.h>
 #include <homekit/homekit.h>
 #include <homekit/characteristics.h>
+#include <wifi_connect.h>
+#include <boot_trace.h>
+#include <indicator.h>
+#include <pwm_pool.h>
+#include <light_fade.h>
+#include <light_curve.h>
+#include <tunable_white.h>
 
 #define CHECK_ERROR(x) do {                        \
                 esp_err_t __err_rc = (x);                  \
@@ -41,171 +46,104 @@
 } while(0)
 
 static void handle_error(esp_err_t err) {
-        switch (err) {
-        case ESP_ERR_WIFI_NOT_STARTED:
-        case ESP_ERR_WIFI_CONN:
-                ESP_LOGI("INFORMATION", "Restarting WiFi...");
-                esp_wifi_stop();
-                esp_wifi_start();
-                break;
-        default:
-                ESP_LOGE("ERROR", "Critical error, restarting device...");
-                esp_restart();
-                break;
-        }
+        // Wi-Fi errors reconnect with backoff, a restart is only the supervisor's last resort
+        wifi_connect_handle_error(err);
 }
 
-static void on_wifi_ready();
+#define WW_PWM_PIN CONFIG_ESP_WW_LED_GPIO
+#define CW_PWM_PIN CONFIG_ESP_CW_LED_GPIO
 
-static void event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data) {
-        if (event_base == WIFI_EVENT && (event_id == WIFI_EVENT_STA_START || event_id == WIFI_EVENT_STA_DISCONNECTED)) {
-                ESP_LOGI("INFORMATION", "Connecting to WiFi...");
-                esp_wifi_connect();
-        } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
-                ESP_LOGI("INFORMATION", "WiFi connected, IP obtained");
-                on_wifi_ready();
+#define LEDC_RESOLUTION LEDC_TIMER_13_BIT
+#define LEDC_FREQUENCY 5000
+#define LEDC_DUTY_MAX ((1 << LEDC_RESOLUTION) - 1)
+#define LED_FRACTION_BITS 3  // sub-LSB duty bits, dithered at the dim end when LIGHT_FADE_DITHER_HZ is set
+#define LED_FADE_MS 400      // transition time of a brightness or colour temperature change
+#define LED_MIRED_MIN 154    // 6500 K, the cold white LEDs
+#define LED_MIRED_MAX 370    // 2700 K, the warm white LEDs
+
+static float led_brightness = 100;  // brightness is scaled 0 to 100
+static uint32_t led_mired = 250;    // colour temperature in mired, 4000 K
+static bool led_on = false;         // on is boolean on or off
+
+static pwm_pool_group_t led_pwm;
+static light_fade_handle_t led_fade;
+static tunable_white_handle_t led_white;
+
+// Move the light to the current HomeKit brightness; the engine interpolates it together with the
+// colour temperature and splits the light over warm and cold at constant output
+static void led_update(void) {
+        if (!led_white) {
+                return;
         }
+        tunable_white_set_brightness(led_white, led_on ? led_brightness : 0);
 }
 
-static void wifi_init() {
-        CHECK_ERROR(esp_netif_init());
-        CHECK_ERROR(esp_event_loop_create_default());
-        esp_netif_create_default_wifi_sta();
-
-        CHECK_ERROR(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
-        CHECK_ERROR(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, NULL));
-
-        wifi_init_config_t wifi_init_config = WIFI_INIT_CONFIG_DEFAULT();
-        CHECK_ERROR(esp_wifi_init(&wifi_init_config));
-        CHECK_ERROR(esp_wifi_set_storage(WIFI_STORAGE_RAM));
-
-        wifi_config_t wifi_config = {
-                .sta = {
-                        .ssid = CONFIG_ESP_WIFI_SSID,
-                        .password = CONFIG_ESP_WIFI_PASSWORD,
-                        .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-                },
+static void ledc_init() {
+        // The pool picks the channels and timer, so other PWM accessories can share the board
+        const pwm_pool_config_t pwm_config = {
+                .owner = "white strip",
+                .gpios = { WW_PWM_PIN, CW_PWM_PIN },
+                .gpio_count = 2,
+                .freq_hz = LEDC_FREQUENCY,
+                .duty_resolution = LEDC_RESOLUTION,
         };
+        esp_err_t err = pwm_pool_claim(&pwm_config, &led_pwm);
+        if (err != ESP_OK) {
+                // Without channels of its own the strip stays dark rather than drive another output
+                CHECK_ERROR(err);
+                return;
+        }
 
-        CHECK_ERROR(esp_wifi_set_mode(WIFI_MODE_STA));
-        CHECK_ERROR(esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_config));
-        CHECK_ERROR(esp_wifi_start());
-}
-
-#define LPF_SHIFT 4  // divide by 16
-#define LPF_INTERVAL 10  // in milliseconds
-
-#define WW_PWM_PIN CONFIG_ESP_WW_LED_GPIO
-#define CW_PWM_PIN CONFIG_ESP_CW_LED_GPIO
-
-static uint16_t current_ww = 0;
-static uint16_t target_ww = 0;
-static uint16_t current_cw = 0;
-static uint16_t target_cw = 0;
-
-static float led_brightness_ww = 100; // brightness is scaled 0 to 100
-static float led_brightness_cw = 100; // brightness is scaled 0 to 100
-static bool led_on = false;           // on is boolean on or off
-
-static void ledc_task(void *pvParameters) {
-        const TickType_t xPeriod = pdMS_TO_TICKS(LPF_INTERVAL);
-        TickType_t xLastWakeTime = xTaskGetTickCount();
-
-        ledc_channel_config_t ledc_channel[2] = {
-                {
-                        .channel    = LEDC_CHANNEL_0,
-                        .duty       = 0,
-                        .gpio_num   = WW_PWM_PIN,
-                        .speed_mode = LEDC_HIGH_SPEED_MODE,
-                        .hpoint     = 0,
-                        .timer_sel  = LEDC_TIMER_0
-                },
-                {
-                        .channel    = LEDC_CHANNEL_1,
-                        .duty       = 0,
-                        .gpio_num   = CW_PWM_PIN,
-                        .speed_mode = LEDC_HIGH_SPEED_MODE,
-                        .hpoint     = 0,
-                        .timer_sel  = LEDC_TIMER_0
-                }
+        const light_fade_config_t fade_config = {
+                .speed_mode = led_pwm.speed_mode,
+                .channels = { led_pwm.channels[0], led_pwm.channels[1] },
+                .channel_count = 2,
+                .duty_max = LEDC_DUTY_MAX,
+                .full_scale_ms = LED_FADE_MS,
+                .fraction_bits = LED_FRACTION_BITS,
         };
+        CHECK_ERROR(light_fade_create(&fade_config, &led_fade));
 
-        ledc_timer_config_t ledc_timer = {
-                .speed_mode       = LEDC_HIGH_SPEED_MODE,
-                .timer_num        = LEDC_TIMER_0,
-                .duty_resolution  = LEDC_TIMER_13_BIT,
-                .freq_hz          = 5000,
-                .clk_cfg          = LEDC_AUTO_CLK
+        const tunable_white_config_t white_config = {
+                .fade = led_fade,
+                .duty_max = LEDC_DUTY_MAX,
+                .fraction_bits = LED_FRACTION_BITS,
+                .transition_ms = LED_FADE_MS,
         };
+        CHECK_ERROR(tunable_white_create(&white_config, &led_white));
+        tunable_white_set(led_white, led_mired, led_on ? led_brightness : 0);
+}
 
-        ledc_timer_config(&ledc_timer);
-        for (int ch = 0; ch < 2; ch++) {
-                ledc_channel_config(&ledc_channel[ch]);
-        }
-
-        while (1) {
-                if (led_on) {
-                        target_ww = (uint16_t)((led_brightness_ww / 100.0) * 8191); // 13-bit resolution
-                        target_cw = (uint16_t)((led_brightness_cw / 100.0) * 8191); // 13-bit resolution
-                } else {
-                        target_ww = 0;
-                        target_cw = 0;
-                }
-
-                current_ww += ((target_ww * 256) - current_ww) >> LPF_SHIFT;
-                current_cw += ((target_cw * 256) - current_cw) >> LPF_SHIFT;
-
-                ledc_set_duty(ledc_channel[0].speed_mode, ledc_channel[0].channel, current_ww >> 8);
-                ledc_update_duty(ledc_channel[0].speed_mode, ledc_channel[0].channel);
-                ledc_set_duty(ledc_channel[1].speed_mode, ledc_channel[1].channel, current_cw >> 8);
-                ledc_update_duty(ledc_channel[1].speed_mode, ledc_channel[1].channel);
+static indicator_handle_t identify_indicator;
 
-                vTaskDelayUntil(&xLastWakeTime, xPeriod);
+// The identify pattern drives the outputs directly, so the HomeKit state is never touched.
+// The transition ticks are paused meanwhile, otherwise they would overwrite the blink.
+static void identify_write(uint8_t level, void *context) {
+        if (!led_fade || !led_white) {
+                return;
         }
+        tunable_white_pause(led_white);
+        const uint32_t duty = light_curve_duty(level * 257, LEDC_DUTY_MAX, LED_FRACTION_BITS);
+        const uint32_t duties[2] = { duty, duty };
+        light_fade_set(led_fade, duties);
 }
 
-static void led_identify_task(void *_args) {
-        ESP_LOGI("LED", "Starting identification sequence");
-
-        const uint16_t original_ww = target_ww;
-        const uint16_t original_cw = target_cw;
-        const uint16_t off = 0;
-        const uint16_t on = 4096;
-
-        for (int i = 0; i < 3; i++) {
-                for (int j = 0; j < 2; j++) {
-                        // Turn LEDs on
-                        led_on = true;
-                        led_brightness_ww = led_brightness_cw = 50;
-                        target_ww = target_cw = on;
-                        ESP_LOGI("LED", "LEDs ON");
-                        vTaskDelay(pdMS_TO_TICKS(100));
-
-                        // Turn LEDs off
-                        led_on = false;
-                        led_brightness_ww = led_brightness_cw = 0;
-                        target_ww = target_cw = off;
-                        ESP_LOGI("LED", "LEDs OFF");
-                        vTaskDelay(pdMS_TO_TICKS(100));
-                }
-                vTaskDelay(pdMS_TO_TICKS(250));
+static void identify_restore(void *context) {
+        if (led_white) {
+                tunable_white_resume(led_white);
         }
-
-        // Restore original LED states
-        led_on = false;
-        led_brightness_ww = led_brightness_cw = 100;
-        target_ww = original_ww;
-        target_cw = original_cw;
-        ESP_LOGI("LED", "Identification sequence completed");
-
-        vTaskDelete(NULL);
+        led_update();
 }
 
 static void led_identify(homekit_value_t _value) {
         ESP_LOGI("LED", "Accessory identified");
-        xTaskCreate(led_identify_task, "LED_identify_task", 1024, NULL, 2, NULL);
+        indicator_play(identify_indicator, &indicator_pattern_identify);
 }
 
+static void identify_init(void) {
+        const indicator_config_t identify_config = INDICATOR_CONFIG_CUSTOM(identify_write, identify_restore, NULL);
+        CHECK_ERROR(indicator_create(&identify_config, &identify_indicator));
+}
 
 static homekit_value_t led_on_get() {
         return HOMEKIT_BOOL(led_on);
@@ -217,29 +155,35 @@ static void led_on_set(homekit_value_t value) {
         }
 
         led_on = value.bool_value;
+        led_update();
 }
 
-static homekit_value_t led_brightness_ww_get() {
-        return HOMEKIT_INT(led_brightness_ww);
+static homekit_value_t led_brightness_get() {
+        return HOMEKIT_INT(led_brightness);
 }
 
-static void led_brightness_ww_set(homekit_value_t value) {
+static void led_brightness_set(homekit_value_t value) {
         if (value.format != homekit_format_int) {
                 return;
         }
-        led_brightness_ww = value.int_value;
+        led_brightness = value.int_value;
+        led_update();
 }
 
-static homekit_value_t led_brightness_cw_get() {
-        return HOMEKIT_INT(led_brightness_cw);
+static homekit_value_t led_color_temperature_get() {
+        return HOMEKIT_UINT32(led_white ? tunable_white_get_mired(led_white) : led_mired);
 }
 
-static void led_brightness_cw_set(homekit_value_t value) {
-        if (value.format != homekit_format_int) {
+static void led_color_temperature_set(homekit_value_t value) {
+        if (value.format != homekit_format_uint32) {
                 return;
         }
-        led_brightness_cw = value.int_value;
+        led_mired = value.uint32_value;
+        if (led_white) {
+                tunable_white_set(led_white, led_mired, led_on ? led_brightness : 0);
+        }
 }
+
 // HomeKit characteristics
 #define DEVICE_NAME "HomeKit White Strip"
 #define DEVICE_MANUFACTURER "StudioPieters®"
@@ -275,13 +219,15 @@ static homekit_accessory_t *accessories[] = {
                                 ),
                         HOMEKIT_CHARACTERISTIC(
                                 BRIGHTNESS, 100,
-                                .getter = led_brightness_ww_get,
-                                .setter = led_brightness_ww_set
+                                .getter = led_brightness_get,
+                                .setter = led_brightness_set
                                 ),
                         HOMEKIT_CHARACTERISTIC(
-                                BRIGHTNESS, 100,
-                                .getter = led_brightness_cw_get,
-                                .setter = led_brightness_cw_set
+                                COLOR_TEMPERATURE, 250,
+                                .min_value = (float[]) {LED_MIRED_MIN},
+                                .max_value = (float[]) {LED_MIRED_MAX},
+                                .getter = led_color_temperature_get,
+                                .setter = led_color_temperature_set
                                 ),
                         NULL
                 }),
@@ -291,26 +237,41 @@ static homekit_accessory_t *accessories[] = {
 };
 #pragma GCC diagnostic pop
 
+static void on_homekit_event(homekit_event_t event) {
+        if (event == HOMEKIT_EVENT_CLIENT_CONNECTED) {
+                boot_trace_complete("hap_connected");
+        }
+}
+
 static homekit_server_config_t config = {
         .accessories = accessories,
         .password = CONFIG_ESP_SETUP_CODE,
         .setupId = CONFIG_ESP_SETUP_ID,
+        .on_event = on_homekit_event,
 };
 
 static void on_wifi_ready() {
+        boot_trace_mark("on_wifi_ready");
         ESP_LOGI("INFORMATION", "Starting HomeKit server...");
         homekit_server_init(&config);
 }
 
 void app_main(void) {
+        boot_trace_init();
         esp_err_t ret = nvs_flash_init();
         if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
                 ESP_LOGW("WARNING", "NVS flash initialization failed, erasing...");
                 CHECK_ERROR(nvs_flash_erase());
+                boot_trace_mark("nvs_erase");
                 ret = nvs_flash_init();
         }
         CHECK_ERROR(ret);
-
-        wifi_init();
-        xTaskCreate(ledc_task, "ledc_task", 2048, NULL, 5, NULL);
+        boot_trace_mark("nvs_flash_init");
+
+        CHECK_ERROR(wifi_connect_init(CONFIG_ESP_WIFI_SSID, CONFIG_ESP_WIFI_PASSWORD, on_wifi_ready));
+        boot_trace_mark("wifi_init");
+        ledc_init();
+        boot_trace_mark("ledc_init");
+        identify_init();
+        boot_trace_mark("identify_init");
 }
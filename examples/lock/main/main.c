@@ -23,7 +23,6 @@
  
 #include <stdio.h>
 #include <esp_wifi.h>
-#include <esp_event.h>
 #include <esp_log.h>
 #include <nvs_flash.h>
 #include <freertos/FreeRTOS.h>
@@ -31,51 +30,19 @@
 #include <driver/gpio.h>
 #include <homekit/homekit.h>
 #include <homekit/characteristics.h>
+#include <wifi_connect.h>
+#include <boot_trace.h>
+#include <indicator.h>
 
 // Custom error handling macro
 #define CHECK_ERROR(x) do {                        \
                 esp_err_t __err_rc = (x);                  \
                 if (__err_rc != ESP_OK) {                  \
                         ESP_LOGE("ERROR", "Error: %s", esp_err_to_name(__err_rc)); \
-                        esp_restart();                \
+                        wifi_connect_handle_error(__err_rc);   \
                 }                                          \
 } while(0)
 
-void on_wifi_ready();
-
-static void event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data) {
-    if (event_base == WIFI_EVENT && (event_id == WIFI_EVENT_STA_START || event_id == WIFI_EVENT_STA_DISCONNECTED)) {
-        ESP_LOGI("INFO", "Connecting to WiFi...");
-        esp_wifi_connect();
-    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
-        ESP_LOGI("INFO", "WiFi connected, IP obtained");
-        on_wifi_ready();
-    }
-}
-
-static void wifi_init() {
-    CHECK_ERROR(esp_netif_init());
-    CHECK_ERROR(esp_event_loop_create_default());
-    esp_netif_create_default_wifi_sta();
-    CHECK_ERROR(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
-    CHECK_ERROR(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, NULL));
-
-    wifi_init_config_t wifi_init_config = WIFI_INIT_CONFIG_DEFAULT();
-    CHECK_ERROR(esp_wifi_init(&wifi_init_config));
-    CHECK_ERROR(esp_wifi_set_mode(WIFI_MODE_STA));
-
-    wifi_config_t wifi_config = {
-        .sta = {
-            .ssid = CONFIG_ESP_WIFI_SSID,
-            .password = CONFIG_ESP_WIFI_PASSWORD,
-            .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-        },
-    };
-
-    CHECK_ERROR(esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_config));
-    CHECK_ERROR(esp_wifi_start());
-}
-
 // GPIO Settings
 #define LED_GPIO CONFIG_ESP_LED_GPIO
 #define RELAY_GPIO CONFIG_ESP_RELAY_GPIO
@@ -107,20 +74,28 @@ void gpio_init() {
 }
 
 // HomeKit Accessory Identification
-void accessory_identify_task(void *args) {
-    for (int i = 0; i < 3; i++) {
-        led_write(true);
-        vTaskDelay(pdMS_TO_TICKS(200));
-        led_write(false);
-        vTaskDelay(pdMS_TO_TICKS(200));
-    }
-    led_write(false);
-    vTaskDelete(NULL);
-}
+static indicator_handle_t identify_indicator;
+
+// Three slow blinks
+static const indicator_step_t identify_steps[] = {
+    { 255, 200 },
+    { 0, 200 },
+};
+
+static const indicator_pattern_t identify_pattern = {
+    .steps = identify_steps,
+    .step_count = 2,
+    .repeat = 3,
+};
 
 void accessory_identify(homekit_value_t _value) {
     ESP_LOGI("INFO", "Accessory identify");
-    xTaskCreate(accessory_identify_task, "Accessory Identify", configMINIMAL_STACK_SIZE, NULL, 2, NULL);
+    indicator_play(identify_indicator, &identify_pattern);
+}
+
+static void identify_init(void) {
+    const indicator_config_t identify_config = INDICATOR_CONFIG_GPIO(LED_GPIO, NULL, NULL);
+    CHECK_ERROR(indicator_create(&identify_config, &identify_indicator));
 }
 
 homekit_value_t lock_current_state_get() {
@@ -183,19 +158,33 @@ homekit_accessory_t *accessories[] = {
 };
 #pragma GCC diagnostic pop
 
+static void on_homekit_event(homekit_event_t event) {
+    if (event == HOMEKIT_EVENT_CLIENT_CONNECTED) {
+        boot_trace_complete("hap_connected");
+    }
+}
+
 homekit_server_config_t config = {
     .accessories = accessories,
     .password = CONFIG_ESP_SETUP_CODE,
     .setupId = CONFIG_ESP_SETUP_ID,
+    .on_event = on_homekit_event,
 };
 
 void on_wifi_ready() {
+    boot_trace_mark("on_wifi_ready");
     ESP_LOGI("INFO", "Starting HomeKit server...");
     homekit_server_init(&config);
 }
 
 void app_main(void) {
+    boot_trace_init();
     CHECK_ERROR(nvs_flash_init());
-    wifi_init();
+    boot_trace_mark("nvs_flash_init");
+    CHECK_ERROR(wifi_connect_init(CONFIG_ESP_WIFI_SSID, CONFIG_ESP_WIFI_PASSWORD, on_wifi_ready));
+    boot_trace_mark("wifi_init");
     gpio_init();
+    boot_trace_mark("gpio_init");
+    identify_init();
+    boot_trace_mark("identify_init");
 }
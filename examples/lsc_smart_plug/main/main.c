@@ -24,17 +24,18 @@
 #include <stdio.h>
 #include <string.h>
 #include <esp_wifi.h>
-#include <esp_event.h>
 #include <esp_log.h>
 #include <esp_system.h>     // For esp_restart()
 #include <nvs_flash.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
-#include <freertos/queue.h>
 #include <driver/gpio.h>
-#include <esp_timer.h>      // For esp_timer_get_time()
 #include <homekit/homekit.h>
 #include <homekit/characteristics.h>
+#include <wifi_connect.h>
+#include <boot_trace.h>
+#include <button_gesture.h>
+#include <indicator.h>
 
 // If you have defined these in Kconfig.projbuild, they're available via sdkconfig:
 #define BUTTON_GPIO CONFIG_ESP_BUTTON_GPIO
@@ -53,71 +54,10 @@
     }                                                       \
 } while(0)
 
-// For demonstration, we handle certain errors by restarting Wi-Fi or the device
+// Errors go to the Wi-Fi connection supervisor
 static void handle_error(esp_err_t err) {
-    switch (err) {
-    case ESP_ERR_WIFI_NOT_STARTED:
-    case ESP_ERR_WIFI_CONN:
-        ESP_LOGI("INFORMATION", "Recoverable error occurred. Restarting Wi-Fi...");
-        esp_wifi_stop();
-        esp_wifi_start();
-        break;
-    default:
-        ESP_LOGE("ERROR", "Critical error occurred. Restarting device...");
-        esp_restart();
-        break;
-    }
-}
-
-////////////////////////////////////////////////////////////////
-// Forward declarations
-////////////////////////////////////////////////////////////////
-static void on_wifi_ready(void);
-
-////////////////////////////////////////////////////////////////
-// Wi-Fi event handler
-////////////////////////////////////////////////////////////////
-static void event_handler(
-    void *arg,
-    esp_event_base_t event_base,
-    int32_t event_id,
-    void *event_data)
-{
-    if (event_base == WIFI_EVENT) {
-        if (event_id == WIFI_EVENT_STA_START || event_id == WIFI_EVENT_STA_DISCONNECTED) {
-            ESP_LOGI("INFORMATION", "Connecting to Wi-Fi...");
-            esp_wifi_connect();
-        }
-    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
-        ESP_LOGI("INFORMATION", "Wi-Fi connected, IP obtained");
-        on_wifi_ready();
-    }
-}
-
-static void wifi_init(void) {
-    CHECK_ERROR(esp_netif_init());
-    CHECK_ERROR(esp_event_loop_create_default());
-    esp_netif_create_default_wifi_sta();
-
-    CHECK_ERROR(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
-    CHECK_ERROR(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, NULL));
-
-    wifi_init_config_t wifi_init_config = WIFI_INIT_CONFIG_DEFAULT();
-    CHECK_ERROR(esp_wifi_init(&wifi_init_config));
-    CHECK_ERROR(esp_wifi_set_storage(WIFI_STORAGE_RAM));
-
-    // Grab SSID and password from Kconfig
-    wifi_config_t wifi_config = {
-        .sta = {
-            .ssid = CONFIG_ESP_WIFI_SSID,          // from Kconfig
-            .password = CONFIG_ESP_WIFI_PASSWORD,  // from Kconfig
-            .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-        },
-    };
-
-    CHECK_ERROR(esp_wifi_set_mode(WIFI_MODE_STA));
-    CHECK_ERROR(esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_config));
-    CHECK_ERROR(esp_wifi_start());
+    // Wi-Fi errors reconnect with backoff, a restart is only the supervisor's last resort
+    wifi_connect_handle_error(err);
 }
 
 ////////////////////////////////////////////////////////////////
@@ -157,113 +97,33 @@ static void gpio_init(void) {
 ////////////////////////////////////////////////////////////////
 // Button Handling (Single/Double/Long Press)
 ////////////////////////////////////////////////////////////////
-static QueueHandle_t button_evt_queue = NULL;
-
-// For multi-press logic
-static volatile int64_t press_start_time_ms = 0;
-static volatile bool button_pressed         = false;
-static volatile int press_count             = 0;
-
-// ISR handler
-static void IRAM_ATTR button_isr_handler(void *arg) {
-    uint32_t gpio_num = (uint32_t)arg;
-    xQueueSendFromISR(button_evt_queue, &gpio_num, NULL);
-}
-
-static void button_task(void *pvParameter) {
-    uint32_t io_num;
-    // Time thresholds for press logic
-    const int DOUBLE_PRESS_WINDOW_MS  = 500;
-    const int LONG_PRESS_THRESHOLD_MS = 1000;
-
-    int64_t last_release_time_ms     = 0;
-    bool waiting_for_second_press    = false;
-    bool double_press_detected       = false;
-
-    for (;;) {
-        if (xQueueReceive(button_evt_queue, &io_num, portMAX_DELAY)) {
-            int64_t now_ms = esp_timer_get_time() / 1000;
-            bool level     = gpio_get_level(io_num);  // Active low
-
-            if (level == 0) {
-                // Press
-                button_pressed = true;
-                press_start_time_ms = now_ms;
-                press_count++;
-                double_press_detected    = false;
-                waiting_for_second_press = false;
-            } else {
-                // Release
-                button_pressed = false;
-                int64_t press_duration_ms = now_ms - press_start_time_ms;
-
-                if (press_duration_ms >= LONG_PRESS_THRESHOLD_MS) {
-                    // Long press
-                    ESP_LOGI("INFORMATION", "Long press detected");
-                    // Additional long-press logic here...
-                    press_count = 0;
-                } else {
-                    // Short press
-                    if (press_count == 1) {
-                        // Possibly single press => wait for second press
-                        waiting_for_second_press = true;
-                        last_release_time_ms     = now_ms;
-                    } else if (press_count == 2) {
-                        // Possibly double press
-                        int64_t time_between_presses_ms = now_ms - last_release_time_ms;
-                        if (time_between_presses_ms <= DOUBLE_PRESS_WINDOW_MS) {
-                            ESP_LOGI("INFORMATION", "Double press detected");
-                            // Additional double-press logic...
-                            double_press_detected = true;
-                        }
-                        waiting_for_second_press = false;
-                        press_count = 0;
-                    }
-                }
-            }
-        }
-
-        // If we're waiting for a second press but time expires => single press
-        if (waiting_for_second_press) {
-            int64_t now_ms = esp_timer_get_time() / 1000;
-            if ((now_ms - last_release_time_ms) > DOUBLE_PRESS_WINDOW_MS) {
-                waiting_for_second_press = false;
-                if (!double_press_detected) {
-                    ESP_LOGI("INFORMATION", "Single press detected");
-                    // Single press => toggle the relay
-                    switch_on.value.bool_value = !switch_on.value.bool_value;
-                    relay_write(switch_on.value.bool_value);
-                    homekit_characteristic_notify(&switch_on, switch_on.value);
-                }
-                press_count = 0;
-            }
-        }
-
-        vTaskDelay(pdMS_TO_TICKS(10));
+static void button_callback(button_gesture_event_t event, void *context) {
+    switch (event) {
+    case BUTTON_GESTURE_SINGLE_PRESS:
+        ESP_LOGI("INFORMATION", "Single press detected");
+        // Single press => toggle the relay
+        switch_on.value.bool_value = !switch_on.value.bool_value;
+        relay_write(switch_on.value.bool_value);
+        homekit_characteristic_notify(&switch_on, switch_on.value);
+        break;
+    case BUTTON_GESTURE_DOUBLE_PRESS:
+        ESP_LOGI("INFORMATION", "Double press detected");
+        // Additional double-press logic...
+        break;
+    case BUTTON_GESTURE_LONG_PRESS:
+        ESP_LOGI("INFORMATION", "Long press detected");
+        // Additional long-press logic here...
+        break;
+    default:
+        break;
     }
 }
 
 static void button_init(void) {
-    gpio_config_t io_conf = {
-        .intr_type    = GPIO_INTR_ANYEDGE, // Trigger on both edges
-        .mode         = GPIO_MODE_INPUT,
-        .pull_up_en   = 1,                 // Use internal pull-up
-        .pull_down_en = 0,
-        .pin_bit_mask = (1ULL << BUTTON_GPIO)
-    };
-    gpio_config(&io_conf);
-
-    button_evt_queue = xQueueCreate(10, sizeof(uint32_t));
-    if (!button_evt_queue) {
-        ESP_LOGE(LOG_TAG, "Failed to create button queue");
-        return;
-    }
-
-    xTaskCreate(button_task, "button_task", 2048, NULL, 10, NULL);
-
-    // Install ISR service and attach our ISR
-    gpio_install_isr_service(0);
-    gpio_isr_handler_add(BUTTON_GPIO, button_isr_handler, (void *)BUTTON_GPIO);
+    // Active low with internal pull-up; presses are decided on esp_timer deadlines
+    button_gesture_config_t config = BUTTON_GESTURE_CONFIG_DEFAULT(BUTTON_GPIO, button_callback, NULL);
+    button_gesture_handle_t button;
+    CHECK_ERROR(button_gesture_create(&config, &button));
 }
 
 ////////////////////////////////////////////////////////////////
@@ -271,31 +131,20 @@ static void button_init(void) {
 ////////////////////////////////////////////////////////////////
 
 // Called by HomeKit for "Identify Accessory" functionality
-static void accessory_identify_task(void *args) {
-    for (int i = 0; i < 3; i++) {
-        for (int j = 0; j < 2; j++) {
-            led_write(true);
-            vTaskDelay(pdMS_TO_TICKS(100));
-            led_write(false);
-            vTaskDelay(pdMS_TO_TICKS(100));
-        }
-        vTaskDelay(pdMS_TO_TICKS(250));
-    }
-    // Restore LED to prior state
+static indicator_handle_t identify_indicator;
+
+static void identify_restore(void *context) {
     led_write(led_on);
-    vTaskDelete(NULL);
 }
 
 static void accessory_identify(homekit_value_t _value) {
     ESP_LOGI("INFORMATION", "Accessory identify");
-    xTaskCreate(
-        accessory_identify_task,
-        "Accessory identify",
-        configMINIMAL_STACK_SIZE,
-        NULL,
-        2,
-        NULL
-    );
+    indicator_play(identify_indicator, &indicator_pattern_identify);
+}
+
+static void identify_init(void) {
+    const indicator_config_t identify_config = INDICATOR_CONFIG_GPIO(LED_GPIO, identify_restore, NULL);
+    CHECK_ERROR(indicator_create(&identify_config, &identify_indicator));
 }
 
 // Switch callback
@@ -344,15 +193,23 @@ homekit_accessory_t *accessories[] = {
 };
 #pragma GCC diagnostic pop
 
+static void on_homekit_event(homekit_event_t event) {
+    if (event == HOMEKIT_EVENT_CLIENT_CONNECTED) {
+        boot_trace_complete("hap_connected");
+    }
+}
+
 // Use your Kconfig values for HomeKit server config
 homekit_server_config_t config = {
     .accessories = accessories,
     .password    = CONFIG_ESP_SETUP_CODE,  // from Kconfig
     .setupId     = CONFIG_ESP_SETUP_ID,    // from Kconfig
+    .on_event    = on_homekit_event,
 };
 
 // Once Wi-Fi is connected, start the HomeKit server
 static void on_wifi_ready(void) {
+    boot_trace_mark("on_wifi_ready");
     ESP_LOGI("INFORMATION", "Starting HomeKit server...");
     homekit_server_init(&config);
 }
@@ -361,19 +218,27 @@ static void on_wifi_ready(void) {
 // app_main
 ////////////////////////////////////////////////////////////////
 void app_main(void) {
+    boot_trace_init();
     // Initialize NVS
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
         ESP_LOGW("WARNING", "NVS flash init failed, erasing...");
         CHECK_ERROR(nvs_flash_erase());
+        boot_trace_mark("nvs_erase");
         ret = nvs_flash_init();
     }
     CHECK_ERROR(ret);
+    boot_trace_mark("nvs_flash_init");
 
     // Wi-Fi, GPIOs, and button
-    wifi_init();
+    CHECK_ERROR(wifi_connect_init(CONFIG_ESP_WIFI_SSID, CONFIG_ESP_WIFI_PASSWORD, on_wifi_ready));
+    boot_trace_mark("wifi_init");
     gpio_init();
+    boot_trace_mark("gpio_init");
+    identify_init();
+    boot_trace_mark("identify_init");
     button_init();
+    boot_trace_mark("button_init");
 
     // At this point, once Wi-Fi connects, HomeKit server will start in on_wifi_ready().
 }
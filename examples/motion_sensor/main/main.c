@@ -23,7 +23,6 @@
 
 #include <stdio.h>
 #include <esp_wifi.h>
-#include <esp_event.h>
 #include <esp_log.h>
 #include <nvs_flash.h>
 #include <freertos/FreeRTOS.h>
@@ -31,6 +30,11 @@
 #include <driver/gpio.h>
 #include <homekit/homekit.h>
 #include <homekit/characteristics.h>
+#include <wifi_connect.h>
+#include <boot_trace.h>
+#include <gpio_edge.h>
+#include <indicator.h>
+#include <notify_scheduler.h>
 
 // Define GPIO Pins
 #define LED_GPIO 2                 // GPIO pin for LED
@@ -62,106 +66,57 @@ void led_write(bool state) {
 
 // Error Handling Function
 static void handle_error(esp_err_t err) {
-    switch (err) {
-        case ESP_ERR_WIFI_NOT_STARTED:
-        case ESP_ERR_WIFI_CONN:
-            ESP_LOGI("ERROR", "Restarting WiFi...");
-            esp_wifi_stop();
-            esp_wifi_start();
-            break;
-        default:
-            ESP_LOGE("ERROR", "Critical error, restarting device...");
-            esp_restart();
-            break;
-    }
-}
-
-// Forward Declaration
-static void on_wifi_ready();
-
-// Event Handler for WiFi
-static void event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data) {
-    if (event_base == WIFI_EVENT) {
-        if (event_id == WIFI_EVENT_STA_START || event_id == WIFI_EVENT_STA_DISCONNECTED) {
-            ESP_LOGI("WIFI", "Connecting to WiFi...");
-            esp_wifi_connect();
-        }
-    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
-        ESP_LOGI("WIFI", "WiFi connected, IP obtained");
-        on_wifi_ready();
-    }
-}
-
-// WiFi Initialization
-static void wifi_init() {
-    CHECK_ERROR(esp_netif_init());
-    CHECK_ERROR(esp_event_loop_create_default());
-    esp_netif_create_default_wifi_sta();
-
-    CHECK_ERROR(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
-    CHECK_ERROR(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, NULL));
-
-    wifi_init_config_t wifi_init_config = WIFI_INIT_CONFIG_DEFAULT();
-    CHECK_ERROR(esp_wifi_init(&wifi_init_config));
-    CHECK_ERROR(esp_wifi_set_storage(WIFI_STORAGE_RAM));
-
-    wifi_config_t wifi_config = {
-        .sta = {
-            .ssid = CONFIG_ESP_WIFI_SSID,
-            .password = CONFIG_ESP_WIFI_PASSWORD,
-            .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-        },
-    };
-
-    CHECK_ERROR(esp_wifi_set_mode(WIFI_MODE_STA));
-    CHECK_ERROR(esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_config));
-    CHECK_ERROR(esp_wifi_start());
+    // Wi-Fi errors reconnect with backoff, a restart is only the supervisor's last resort
+    wifi_connect_handle_error(err);
 }
 
 // GPIO Initialization
 static void gpio_init() {
     gpio_set_direction(LED_GPIO, GPIO_MODE_OUTPUT);
-    gpio_set_direction(MOTION_SENSOR_GPIO, GPIO_MODE_INPUT);
     led_write(led_on);
 }
 
-// Accessory Identification Task
-static void accessory_identify_task(void *args) {
-    for (int i = 0; i < 3; i++) {
-        for (int j = 0; j < 2; j++) {
-            led_write(true);
-            vTaskDelay(pdMS_TO_TICKS(100));
-            led_write(false);
-            vTaskDelay(pdMS_TO_TICKS(100));
-        }
-        vTaskDelay(pdMS_TO_TICKS(250));
-    }
+// Accessory Identification
+static indicator_handle_t identify_indicator;
+
+static void identify_restore(void *context) {
     led_write(led_on);
-    vTaskDelete(NULL);
 }
 
-// Accessory Identify Function
 static void accessory_identify(homekit_value_t _value) {
     ESP_LOGI("HOMEKIT", "Accessory identify");
-    xTaskCreate(accessory_identify_task, "Accessory identify", configMINIMAL_STACK_SIZE, NULL, 2, NULL);
+    indicator_play(identify_indicator, &indicator_pattern_identify);
+}
+
+static void identify_init(void) {
+    const indicator_config_t identify_config = INDICATOR_CONFIG_GPIO(LED_GPIO, identify_restore, NULL);
+    CHECK_ERROR(indicator_create(&identify_config, &identify_indicator));
 }
 
 // HomeKit Characteristic for Motion Detection
 homekit_characteristic_t Motion_detected = HOMEKIT_CHARACTERISTIC_(MOTION_DETECTED, 0);
 
-// Motion Sensor Task
-static void motion_sensor_task(void *pvParameters) {
-    while (1) {
-        bool motion_detected = gpio_get_level(MOTION_SENSOR_GPIO) == 1;
-        homekit_characteristic_notify(&Motion_detected, HOMEKIT_BOOL(motion_detected));
-        vTaskDelay(pdMS_TO_TICKS(1000)); // Delay for 1 second
+// Motion Sensor Edge Handler
+// Motion onset is sent at once; the end of motion waits for the next notification tick
+static void motion_sensor_edge(const gpio_edge_event_t *event, void *context) {
+    bool motion_detected = event->level == 1;
+    if (motion_detected == Motion_detected.value.bool_value) {
+        return;
+    }
+    if (motion_detected) {
+        notify_scheduler_update_now(&Motion_detected, HOMEKIT_BOOL(true));
+    } else {
+        notify_scheduler_update(&Motion_detected, HOMEKIT_BOOL(false));
     }
 }
 
 // Motion Sensor Initialization
 static void motion_sensor_init() {
-    ESP_LOGI("HOMEKIT", "Initializing Motion Sensor Task");
-    xTaskCreate(motion_sensor_task, "MotionSensorTask", 1024, NULL, 2, NULL);
+    ESP_LOGI("HOMEKIT", "Initializing Motion Sensor");
+    const notify_limits_t motion_limits = { 0 };
+    CHECK_ERROR(notify_scheduler_add(&Motion_detected, &motion_limits));
+    CHECK_ERROR(gpio_edge_add(MOTION_SENSOR_GPIO, GPIO_FLOATING, motion_sensor_edge, NULL));
+    Motion_detected.value = HOMEKIT_BOOL(gpio_get_level(MOTION_SENSOR_GPIO) == 1);
 }
 
 // HomeKit Accessory Information
@@ -191,23 +146,38 @@ homekit_accessory_t *accessories[] = {
 };
 #pragma GCC diagnostic pop
 
+static void on_homekit_event(homekit_event_t event) {
+    if (event == HOMEKIT_EVENT_CLIENT_CONNECTED) {
+        boot_trace_complete("hap_connected");
+    }
+}
+
 // HomeKit Server Configuration
 static homekit_server_config_t config = {
     .accessories = accessories,
     .password = CONFIG_ESP_SETUP_CODE,
     .setupId = CONFIG_ESP_SETUP_ID,
+    .on_event = on_homekit_event,
 };
 
 // Callback when WiFi is Ready
 static void on_wifi_ready() {
+    boot_trace_mark("on_wifi_ready");
     ESP_LOGI("HOMEKIT", "Starting HomeKit server...");
     homekit_server_init(&config);
 }
 
 // Application Entry Point
 void app_main(void) {
+    boot_trace_init();
     CHECK_ERROR(nvs_flash_init());
-    wifi_init();
+    boot_trace_mark("nvs_flash_init");
+    CHECK_ERROR(wifi_connect_init(CONFIG_ESP_WIFI_SSID, CONFIG_ESP_WIFI_PASSWORD, on_wifi_ready));
+    boot_trace_mark("wifi_init");
     gpio_init();
+    boot_trace_mark("gpio_init");
+    identify_init();
+    boot_trace_mark("identify_init");
     motion_sensor_init();
+    boot_trace_mark("motion_sensor_init");
 }
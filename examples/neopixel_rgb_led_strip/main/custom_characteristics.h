@@ -0,0 +1,61 @@
+#include <homekit/homekit.h>
+#include <homekit/characteristics.h>
+
+#ifndef __HOMEKIT_DBB_CUSTOM_CHARACTERISTICS__
+#define __HOMEKIT_DBB_CUSTOM_CHARACTERISTICS__
+
+#define HOMEKIT_CUSTOM_UUID_DBB(value) (value "-4772-4466-80fd-a6ea3d5bcd55")
+
+#define HOMEKIT_CHARACTERISTIC_CUSTOM_LIGHT_EFFECT HOMEKIT_CUSTOM_UUID_DBB("F0000020")
+#define HOMEKIT_DECLARE_CHARACTERISTIC_CUSTOM_LIGHT_EFFECT(_value, ...) \
+        .type = HOMEKIT_CHARACTERISTIC_CUSTOM_LIGHT_EFFECT, \
+        .description = "Effect", \
+        .format = homekit_format_uint8, \
+        .permissions = homekit_permissions_paired_read \
+                       | homekit_permissions_paired_write \
+                       | homekit_permissions_notify, \
+        .min_value = (float[]) {0}, \
+        .max_value = (float[]) {6}, \
+        .min_step = (float[]) {1}, \
+        .value = HOMEKIT_UINT8_(_value), \
+        ## __VA_ARGS__
+
+#define HOMEKIT_CHARACTERISTIC_CUSTOM_EFFECT_FRAME_TIME HOMEKIT_CUSTOM_UUID_DBB("F0000021")
+#define HOMEKIT_DECLARE_CHARACTERISTIC_CUSTOM_EFFECT_FRAME_TIME(_value, ...) \
+        .type = HOMEKIT_CHARACTERISTIC_CUSTOM_EFFECT_FRAME_TIME, \
+        .description = "Effect Frame Time", \
+        .format = homekit_format_uint32, \
+        .permissions = homekit_permissions_paired_read, \
+        .min_value = (float[]) {0}, \
+        .max_value = (float[]) {1000000}, \
+        .min_step = (float[]) {1}, \
+        .value = HOMEKIT_UINT32_(_value), \
+        ## __VA_ARGS__
+
+#define HOMEKIT_CHARACTERISTIC_CUSTOM_SEGMENT_LENGTH HOMEKIT_CUSTOM_UUID_DBB("F0000022")
+#define HOMEKIT_DECLARE_CHARACTERISTIC_CUSTOM_SEGMENT_LENGTH(_value, ...) \
+        .type = HOMEKIT_CHARACTERISTIC_CUSTOM_SEGMENT_LENGTH, \
+        .description = "Segment Length", \
+        .format = homekit_format_uint16, \
+        .permissions = homekit_permissions_paired_read \
+                       | homekit_permissions_paired_write \
+                       | homekit_permissions_notify, \
+        .min_value = (float[]) {0}, \
+        .max_value = (float[]) {CONFIG_ESP_STRIP_LENGTH}, \
+        .min_step = (float[]) {1}, \
+        .value = HOMEKIT_UINT16_(_value), \
+        ## __VA_ARGS__
+
+#define HOMEKIT_CHARACTERISTIC_CUSTOM_STRIP_CURRENT HOMEKIT_CUSTOM_UUID_DBB("F0000023")
+#define HOMEKIT_DECLARE_CHARACTERISTIC_CUSTOM_STRIP_CURRENT(_value, ...) \
+        .type = HOMEKIT_CHARACTERISTIC_CUSTOM_STRIP_CURRENT, \
+        .description = "Strip Current", \
+        .format = homekit_format_uint16, \
+        .permissions = homekit_permissions_paired_read, \
+        .min_value = (float[]) {0}, \
+        .max_value = (float[]) {65535}, \
+        .min_step = (float[]) {1}, \
+        .value = HOMEKIT_UINT16_(_value), \
+        ## __VA_ARGS__
+
+#endif
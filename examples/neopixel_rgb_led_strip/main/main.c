@@ -22,17 +22,27 @@
  **/
 
 #include <stdio.h>
+#include <string.h>
 #include <esp_wifi.h>
-#include <esp_event.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <nvs_flash.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <driver/gpio.h>
 #include <homekit/homekit.h>
 #include <homekit/characteristics.h>
+#include <wifi_connect.h>
+#include <boot_trace.h>
+#include <indicator.h>
+#include <seqlock.h>
 #include <led_strip.h>
-#include <math.h>
+#include <soc/soc_caps.h>
+#include <strip_render.h>
+#include <render_scheduler.h>
+#include <strip_effects.h>
+#include <color_lut.h>
+#include "custom_characteristics.h"
 
 #define CHECK_ERROR(x) do { \
         esp_err_t __err_rc = (x); \
@@ -43,118 +53,192 @@
     } while(0)
 
 static void handle_error(esp_err_t err) {
-    switch (err) {
-    case ESP_ERR_WIFI_NOT_STARTED:
-    case ESP_ERR_WIFI_CONN:
-        ESP_LOGI("INFORMATION", "Restarting WiFi...");
-        esp_wifi_stop();
-        esp_wifi_start();
-        break;
-    default:
-        ESP_LOGE("ERROR", "Critical error, restarting device...");
-        esp_restart();
-        break;
-    }
+    // Wi-Fi errors reconnect with backoff, a restart is only the supervisor's last resort
+    wifi_connect_handle_error(err);
 }
 
-static void on_wifi_ready(void);
+#define LED_STRIP_GPIO CONFIG_ESP_LED_GPIO
+#define LED_STRIP_LENGTH CONFIG_ESP_STRIP_LENGTH
+#define LED_STRIP_MAX_CURRENT CONFIG_ESP_STRIP_MAX_CURRENT
+#define LED_SEGMENT_COUNT CONFIG_ESP_SEGMENT_COUNT
+#define LED_RENDER_INTERVAL_MS 16  // one frame at 60 Hz
+#define LED_EFFECT_FPS 50          // frame rate of the animated effects
+#define LED_FADE_MS 400            // fade time of a segment to its new colour
 
-static void event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data) {
-    if (event_base == WIFI_EVENT && (event_id == WIFI_EVENT_STA_START || event_id == WIFI_EVENT_STA_DISCONNECTED)) {
-        ESP_LOGI("INFORMATION", "Connecting to WiFi...");
-        esp_wifi_connect();
-    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
-        ESP_LOGI("INFORMATION", "WiFi connected, IP obtained");
-        on_wifi_ready();
+#define SEGMENT_NAMESPACE "segments"
+#define SEGMENT_KEY "lengths"
+
+static led_strip_handle_t led_strip = NULL;
+static strip_render_handle_t strip_render;
+static render_scheduler_handle_t led_render;
+static strip_effects_handle_t led_effects;
+
+typedef struct {
+    bool on;
+    float brightness;
+    float hue;
+    float saturation;
+} led_segment_t;
+
+typedef struct {
+    led_segment_t segments[LED_SEGMENT_COUNT];
+    uint16_t lengths[LED_SEGMENT_COUNT];  // pixels per segment, in strip order
+    uint8_t effect;                       // strip_effect_t over the whole strip, STRIP_EFFECT_NONE for the segments
+} led_state_t;
+
+// Written by the HomeKit setters, read by the render path on another task
+static led_state_t led_state = { .effect = STRIP_EFFECT_NONE };
+static seqlock_t led_state_lock = SEQLOCK_INIT;
+
+// Colour each segment shows and fades towards; only touched by the render path
+typedef struct {
+    color_rgbw_t from;
+    color_rgbw_t to;
+    color_rgbw_t shown;
+    int64_t start_us;
+} led_fade_t;
+
+static led_fade_t led_fades[LED_SEGMENT_COUNT];
+
+static color_rgbw_t segment_color(const led_segment_t *segment) {
+    color_rgbw_t color = {0};
+    if (segment->on) {
+        color_lut_hsi_to_rgb(segment->hue, segment->saturation, segment->brightness, &color);
     }
+    return color;
 }
 
-static void wifi_init(void) {
-    CHECK_ERROR(esp_netif_init());
-    CHECK_ERROR(esp_event_loop_create_default());
-    esp_netif_create_default_wifi_sta();
-
-    CHECK_ERROR(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
-    CHECK_ERROR(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, NULL));
-
-    wifi_init_config_t wifi_init_config = WIFI_INIT_CONFIG_DEFAULT();
-    CHECK_ERROR(esp_wifi_init(&wifi_init_config));
-    CHECK_ERROR(esp_wifi_set_storage(WIFI_STORAGE_RAM));
+static uint8_t blend(uint8_t from, uint8_t to, uint32_t amount) {
+    return from + ((int)to - from) * (int)amount / 255;
+}
 
-    wifi_config_t wifi_config = {
-        .sta = {
-            .ssid = CONFIG_ESP_WIFI_SSID,
-            .password = CONFIG_ESP_WIFI_PASSWORD,
-            .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-        },
-    };
+// Lay the segment colours out along the strip and send them as one frame
+static void led_compose(const led_state_t *state, const color_rgbw_t *colors) {
+    static const color_rgbw_t black = {0};
+    uint32_t start = 0;
 
-    CHECK_ERROR(esp_wifi_set_mode(WIFI_MODE_STA));
-    CHECK_ERROR(esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_config));
-    CHECK_ERROR(esp_wifi_start());
+    strip_effects_stop(led_effects);
+    for (int i = 0; i < LED_SEGMENT_COUNT; i++) {
+        strip_render_fill_range(strip_render, start, state->lengths[i], &colors[i]);
+        start += state->lengths[i];
+    }
+    // Pixels past the last segment stay dark
+    if (start < LED_STRIP_LENGTH) {
+        strip_render_fill_range(strip_render, start, LED_STRIP_LENGTH - start, &black);
+    }
+    esp_err_t err = strip_render_show(strip_render);
+    if (err != ESP_OK) {
+        ESP_LOGE("LED", "Could not show frame: %s", esp_err_to_name(err));
+    }
 }
 
-#define LED_STRIP_GPIO CONFIG_ESP_LED_GPIO
-#define LED_STRIP_LENGTH CONFIG_ESP_STRIP_LENGTH
+// Returns true while a segment is still fading and another frame is needed
+static bool led_write(const led_state_t *state) {
+    if (!strip_render) {
+        return false;
+    }
+    if (state->effect != STRIP_EFFECT_NONE && state->segments[0].on) {
+        // The effect takes over the whole strip in the colour of the first segment and draws at
+        // its own frame rate; the gradient runs from that colour to its complement
+        const led_segment_t *segment = &state->segments[0];
+        strip_effect_params_t params = {
+            .effect = state->effect,
+            .primary = segment_color(segment),
+            .brightness = segment->brightness,
+        };
+        color_lut_hsi_to_rgb(segment->hue + 180, segment->saturation, segment->brightness, &params.secondary);
+        esp_err_t err = strip_effects_start(led_effects, &params);
+        if (err != ESP_OK) {
+            ESP_LOGE("LED", "Could not start effect: %s", esp_err_to_name(err));
+        }
+        return false;
+    }
 
-static led_strip_handle_t led_strip = NULL;
-static bool led_on = false;
-static float led_brightness = 50;
-static float led_hue = 180;
-static float led_saturation = 50;
-
-#define DEG_TO_RAD(X) (M_PI*(X)/180)
-
-static void hsi2rgbw(float H, float S, float I, int* rgbw) {
-    int r = 0, g = 0, b = 0, w = 0;
-    float cos_h, cos_1047_h;
-    H = fmod(H, 360);
-    H = M_PI * H / 180;
-    S = fmin(fmax(S, 0), 1);
-    I = fmin(fmax(I, 0), 1);
-
-    if (H < 2.09439) {
-        cos_h = cos(H);
-        cos_1047_h = cos(1.047196667 - H);
-        r = S * 255 * I / 3 * (1 + cos_h / cos_1047_h);
-        g = S * 255 * I / 3 * (1 + (1 - cos_h / cos_1047_h));
-        w = 255 * (1 - S) * I;
-    } else if (H < 4.188787) {
-        H -= 2.09439;
-        cos_h = cos(H);
-        cos_1047_h = cos(1.047196667 - H);
-        g = S * 255 * I / 3 * (1 + cos_h / cos_1047_h);
-        b = S * 255 * I / 3 * (1 + (1 - cos_h / cos_1047_h));
-        w = 255 * (1 - S) * I;
-    } else {
-        H -= 4.188787;
-        cos_h = cos(H);
-        cos_1047_h = cos(1.047196667 - H);
-        b = S * 255 * I / 3 * (1 + cos_h / cos_1047_h);
-        r = S * 255 * I / 3 * (1 + (1 - cos_h / cos_1047_h));
-        w = 255 * (1 - S) * I;
+    int64_t now = esp_timer_get_time();
+    color_rgbw_t colors[LED_SEGMENT_COUNT];
+    bool fading = false;
+    for (int i = 0; i < LED_SEGMENT_COUNT; i++) {
+        led_fade_t *fade = &led_fades[i];
+        color_rgbw_t target = segment_color(&state->segments[i]);
+        if (memcmp(&target, &fade->to, sizeof(target)) != 0) {
+            // A new target starts from whatever the segment shows right now
+            fade->from = fade->shown;
+            fade->to = target;
+            fade->start_us = now;
+        }
+        int64_t elapsed_us = now - fade->start_us;
+        if (elapsed_us >= LED_FADE_MS * 1000) {
+            fade->shown = fade->to;
+        } else {
+            uint32_t amount = elapsed_us * 255 / (LED_FADE_MS * 1000);
+            fade->shown = (color_rgbw_t) {
+                .red = blend(fade->from.red, fade->to.red, amount),
+                .green = blend(fade->from.green, fade->to.green, amount),
+                .blue = blend(fade->from.blue, fade->to.blue, amount),
+            };
+            fading = true;
+        }
+        colors[i] = fade->shown;
     }
+    led_compose(state, colors);
+    return fading;
+}
 
-    rgbw[0] = r;
-    rgbw[1] = g;
-    rgbw[2] = b;
-    rgbw[3] = w;
+// One HomeKit scene change sets On, Brightness, Hue and Saturation back to back; the setters
+// only store the new state and the strip is rendered once for the whole burst. While a
+// segment fades the callback asks for the next frame itself, so all segments share one refresh.
+static void led_render_cb(void *context) {
+    led_state_t state;
+    SEQLOCK_READ(&led_state_lock, state, led_state);
+    if (led_write(&state)) {
+        render_scheduler_request(led_render);
+    }
 }
 
-static void led_write(bool on) {
-    if (led_strip) {
-        for (int i = 0; i < LED_STRIP_LENGTH; i++) {
-            int rgbw[4] = {0};
-            if (on) {
-                hsi2rgbw(led_hue, led_saturation / 100.0, led_brightness / 100.0, rgbw);
+// Segment lengths as stored in NVS, or the strip split evenly when nothing valid is stored
+static void led_segments_load(uint16_t *lengths) {
+    nvs_handle_t handle;
+    uint32_t total = 0;
+
+    if (nvs_open(SEGMENT_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+        size_t size = sizeof(uint16_t) * LED_SEGMENT_COUNT;
+        esp_err_t err = nvs_get_blob(handle, SEGMENT_KEY, lengths, &size);
+        nvs_close(handle);
+        if (err == ESP_OK && size == sizeof(uint16_t) * LED_SEGMENT_COUNT) {
+            for (int i = 0; i < LED_SEGMENT_COUNT; i++) {
+                total += lengths[i];
+            }
+            if (total <= LED_STRIP_LENGTH) {
+                return;
             }
-            ESP_ERROR_CHECK(led_strip_set_pixel(led_strip, i, rgbw[0], rgbw[1], rgbw[2]));
         }
-        ESP_ERROR_CHECK(led_strip_refresh(led_strip));
+    }
+    for (int i = 0; i < LED_SEGMENT_COUNT; i++) {
+        lengths[i] = LED_STRIP_LENGTH / LED_SEGMENT_COUNT + (i < LED_STRIP_LENGTH % LED_SEGMENT_COUNT ? 1 : 0);
+    }
+}
+
+static void led_segments_store(const uint16_t *lengths) {
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(SEGMENT_NAMESPACE, NVS_READWRITE, &handle);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(handle, SEGMENT_KEY, lengths, sizeof(uint16_t) * LED_SEGMENT_COUNT);
+        if (err == ESP_OK) {
+            err = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW("LED", "Could not store segment layout: %s", esp_err_to_name(err));
     }
 }
 
 static void led_strip_init(void) {
+    for (int i = 0; i < LED_SEGMENT_COUNT; i++) {
+        led_state.segments[i] = (led_segment_t) { .on = false, .brightness = 50, .hue = 180, .saturation = 50 };
+    }
+    led_segments_load(led_state.lengths);
+
     led_strip_config_t strip_config = {
         .strip_gpio_num = LED_STRIP_GPIO,
         .max_leds = LED_STRIP_LENGTH,
@@ -167,63 +251,187 @@ static void led_strip_init(void) {
         .clk_src = RMT_CLK_SRC_DEFAULT,
         .resolution_hz = 10 * 1000 * 1000,
         .flags = {
-            .with_dma = false,
+#if SOC_RMT_SUPPORT_DMA
+            // Frames go out by DMA on chips that have it, so long strips don't keep the CPU busy
+            .with_dma = true,
+#endif
         },
     };
 
     ESP_ERROR_CHECK(led_strip_new_rmt_device(&strip_config, &rmt_config, &led_strip));
-    ESP_LOGI("LED", "LED strip initialized");
+
+    const strip_render_config_t render_config = {
+        .strip = led_strip,
+        .length = LED_STRIP_LENGTH,
+        .rgbw = false,
+        .async = true,
+        .max_current_ma = LED_STRIP_MAX_CURRENT,
+    };
+    ESP_ERROR_CHECK(strip_render_create(&render_config, &strip_render));
+
+    const strip_effects_config_t effects_config = {
+        .render = strip_render,
+        .length = LED_STRIP_LENGTH,
+        .frame_rate = LED_EFFECT_FPS,
+    };
+    ESP_ERROR_CHECK(strip_effects_create(&effects_config, &led_effects));
+
+    const render_scheduler_config_t scheduler_config = {
+        .interval_ms = LED_RENDER_INTERVAL_MS,
+        .callback = led_render_cb,
+    };
+    ESP_ERROR_CHECK(render_scheduler_create(&scheduler_config, &led_render));
+    ESP_LOGI("LED", "LED strip initialized with %d segments", LED_SEGMENT_COUNT);
 }
 
-static void accessory_identify_task(void *args) {
-    for (int i = 0; i < 3; i++) {
-        led_write(true);
-        vTaskDelay(pdMS_TO_TICKS(100));
-        led_write(false);
-        vTaskDelay(pdMS_TO_TICKS(100));
-        vTaskDelay(pdMS_TO_TICKS(250));
+static indicator_handle_t identify_indicator;
+
+// Blink every segment in its own colour; the fades are left alone and resume on restore
+static void identify_write(uint8_t level, void *context) {
+    led_state_t state;
+    color_rgbw_t colors[LED_SEGMENT_COUNT];
+    SEQLOCK_READ(&led_state_lock, state, led_state);
+    for (int i = 0; i < LED_SEGMENT_COUNT; i++) {
+        state.segments[i].on = level != 0;
+        colors[i] = segment_color(&state.segments[i]);
     }
-    led_write(led_on);
-    vTaskDelete(NULL);
+    led_compose(&state, colors);
+}
+
+static void identify_restore(void *context) {
+    led_render_cb(NULL);
 }
 
 void accessory_identify(homekit_value_t _value) {
     ESP_LOGI("INFORMATION", "Accessory identify");
-    xTaskCreate(accessory_identify_task, "Accessory identify", configMINIMAL_STACK_SIZE, NULL, 2, NULL);
+    indicator_play(identify_indicator, &indicator_pattern_identify);
+}
+
+static void identify_init(void) {
+    const indicator_config_t identify_config = INDICATOR_CONFIG_CUSTOM(identify_write, identify_restore, NULL);
+    CHECK_ERROR(indicator_create(&identify_config, &identify_indicator));
 }
 
-homekit_value_t led_on_get(void) { return HOMEKIT_BOOL(led_on); }
-void led_on_set(homekit_value_t value) {
+static void led_on_set(int index, homekit_value_t value) {
     if (value.format == homekit_format_bool) {
-        led_on = value.bool_value;
-        led_write(led_on);
+        seqlock_write_begin(&led_state_lock);
+        led_state.segments[index].on = value.bool_value;
+        seqlock_write_end(&led_state_lock);
+        render_scheduler_request(led_render);
     }
 }
 
-homekit_value_t led_brightness_get(void) { return HOMEKIT_INT((int)led_brightness); }
-void led_brightness_set(homekit_value_t value) {
+static void led_brightness_set(int index, homekit_value_t value) {
     if (value.format == homekit_format_int) {
-        led_brightness = value.int_value;
-        led_write(led_on);
+        seqlock_write_begin(&led_state_lock);
+        led_state.segments[index].brightness = value.int_value;
+        seqlock_write_end(&led_state_lock);
+        render_scheduler_request(led_render);
     }
 }
 
-homekit_value_t led_hue_get(void) { return HOMEKIT_FLOAT(led_hue); }
-void led_hue_set(homekit_value_t value) {
+static void led_hue_set(int index, homekit_value_t value) {
     if (value.format == homekit_format_float) {
-        led_hue = value.float_value;
-        led_write(led_on);
+        seqlock_write_begin(&led_state_lock);
+        led_state.segments[index].hue = value.float_value;
+        seqlock_write_end(&led_state_lock);
+        render_scheduler_request(led_render);
     }
 }
 
-homekit_value_t led_saturation_get(void) { return HOMEKIT_FLOAT(led_saturation); }
-void led_saturation_set(homekit_value_t value) {
+static void led_saturation_set(int index, homekit_value_t value) {
     if (value.format == homekit_format_float) {
-        led_saturation = value.float_value;
-        led_write(led_on);
+        seqlock_write_begin(&led_state_lock);
+        led_state.segments[index].saturation = value.float_value;
+        seqlock_write_end(&led_state_lock);
+        render_scheduler_request(led_render);
+    }
+}
+
+// A segment can only grow into pixels that no other segment uses. Other controllers are told
+// about a new length; a refused one is sent back so the writer shows the length kept.
+static void led_length_set(int index, homekit_characteristic_t *characteristic, homekit_value_t value) {
+    if (value.format != homekit_format_uint16) {
+        return;
+    }
+    uint32_t others = 0;
+    for (int i = 0; i < LED_SEGMENT_COUNT; i++) {
+        if (i != index) {
+            others += led_state.lengths[i];
+        }
+    }
+    if (others + value.uint16_value > LED_STRIP_LENGTH) {
+        ESP_LOGW("LED", "Segment %d cannot have %u pixels, %lu are free", index + 1,
+                 value.uint16_value, (unsigned long)(LED_STRIP_LENGTH - others));
+        homekit_characteristic_notify(characteristic, HOMEKIT_UINT16(led_state.lengths[index]));
+        return;
+    }
+    if (value.uint16_value == led_state.lengths[index]) {
+        return;
+    }
+    seqlock_write_begin(&led_state_lock);
+    led_state.lengths[index] = value.uint16_value;
+    seqlock_write_end(&led_state_lock);
+    led_segments_store(led_state.lengths);
+    render_scheduler_request(led_render);
+    homekit_characteristic_notify(characteristic, value);
+}
+
+// The HomeKit getters and setters take no context, so each segment gets its own thin wrappers,
+// and its own Segment Length characteristic to notify
+#define LED_SEGMENT_ACCESSORS(n) \
+    static homekit_characteristic_t led_length_##n; \
+    static homekit_value_t led_on_get_##n(void) { return HOMEKIT_BOOL(led_state.segments[n].on); } \
+    static void led_on_set_##n(homekit_value_t value) { led_on_set(n, value); } \
+    static homekit_value_t led_brightness_get_##n(void) { return HOMEKIT_INT((int)led_state.segments[n].brightness); } \
+    static void led_brightness_set_##n(homekit_value_t value) { led_brightness_set(n, value); } \
+    static homekit_value_t led_hue_get_##n(void) { return HOMEKIT_FLOAT(led_state.segments[n].hue); } \
+    static void led_hue_set_##n(homekit_value_t value) { led_hue_set(n, value); } \
+    static homekit_value_t led_saturation_get_##n(void) { return HOMEKIT_FLOAT(led_state.segments[n].saturation); } \
+    static void led_saturation_set_##n(homekit_value_t value) { led_saturation_set(n, value); } \
+    static homekit_value_t led_length_get_##n(void) { return HOMEKIT_UINT16(led_state.lengths[n]); } \
+    static void led_length_set_##n(homekit_value_t value) { led_length_set(n, &led_length_##n, value); } \
+    static homekit_characteristic_t led_length_##n = \
+        HOMEKIT_CHARACTERISTIC_(CUSTOM_SEGMENT_LENGTH, 0, .getter = led_length_get_##n, .setter = led_length_set_##n);
+
+LED_SEGMENT_ACCESSORS(0)
+#if LED_SEGMENT_COUNT > 1
+LED_SEGMENT_ACCESSORS(1)
+#endif
+#if LED_SEGMENT_COUNT > 2
+LED_SEGMENT_ACCESSORS(2)
+#endif
+#if LED_SEGMENT_COUNT > 3
+LED_SEGMENT_ACCESSORS(3)
+#endif
+
+static homekit_value_t led_effect_get(void) {
+    return HOMEKIT_UINT8(led_state.effect);
+}
+
+static void led_effect_set(homekit_value_t value) {
+    if (value.format == homekit_format_uint8 && value.uint8_value < STRIP_EFFECT_COUNT) {
+        seqlock_write_begin(&led_state_lock);
+        led_state.effect = value.uint8_value;
+        seqlock_write_end(&led_state_lock);
+        render_scheduler_request(led_render);
     }
 }
 
+// Compute time of the last effect frame in microseconds, read on demand
+static homekit_value_t led_effect_frame_time_get(void) {
+    strip_effects_stats_t stats;
+    strip_effects_get_stats(led_effects, &stats);
+    return HOMEKIT_UINT32(stats.compute_us);
+}
+
+// Estimated current of the frame on the strip in mA, after the power limit
+static homekit_value_t led_current_get(void) {
+    strip_render_stats_t stats;
+    strip_render_get_stats(strip_render, &stats);
+    return HOMEKIT_UINT16(stats.current_ma > UINT16_MAX ? UINT16_MAX : stats.current_ma);
+}
+
 #define DEVICE_NAME "HomeKit RGB Light"
 #define DEVICE_MANUFACTURER "StudioPieters®"
 #define DEVICE_SERIAL "NLDA4SQN1466"
@@ -236,6 +444,14 @@ homekit_characteristic_t serial = HOMEKIT_CHARACTERISTIC_(SERIAL_NUMBER, DEVICE_
 homekit_characteristic_t model = HOMEKIT_CHARACTERISTIC_(MODEL, DEVICE_MODEL);
 homekit_characteristic_t revision = HOMEKIT_CHARACTERISTIC_(FIRMWARE_REVISION, FW_VERSION);
 
+#define LED_SEGMENT_CHARACTERISTICS(n, segment_name) \
+            HOMEKIT_CHARACTERISTIC(NAME, segment_name), \
+            HOMEKIT_CHARACTERISTIC(ON, true, .getter = led_on_get_##n, .setter = led_on_set_##n), \
+            HOMEKIT_CHARACTERISTIC(BRIGHTNESS, 100, .getter = led_brightness_get_##n, .setter = led_brightness_set_##n), \
+            HOMEKIT_CHARACTERISTIC(HUE, 0, .getter = led_hue_get_##n, .setter = led_hue_set_##n), \
+            HOMEKIT_CHARACTERISTIC(SATURATION, 0, .getter = led_saturation_get_##n, .setter = led_saturation_set_##n), \
+            &led_length_##n
+
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Woverride-init"
 homekit_accessory_t *accessories[] = {
@@ -250,39 +466,71 @@ homekit_accessory_t *accessories[] = {
             NULL
         }),
         HOMEKIT_SERVICE(LIGHTBULB, .primary = true, .characteristics = (homekit_characteristic_t*[]) {
-            HOMEKIT_CHARACTERISTIC(NAME, "HomeKit RGB Light"),
-            HOMEKIT_CHARACTERISTIC(ON, true, .getter = led_on_get, .setter = led_on_set),
-            HOMEKIT_CHARACTERISTIC(BRIGHTNESS, 100, .getter = led_brightness_get, .setter = led_brightness_set),
-            HOMEKIT_CHARACTERISTIC(HUE, 0, .getter = led_hue_get, .setter = led_hue_set),
-            HOMEKIT_CHARACTERISTIC(SATURATION, 0, .getter = led_saturation_get, .setter = led_saturation_set),
+            LED_SEGMENT_CHARACTERISTICS(0, DEVICE_NAME),
+            HOMEKIT_CHARACTERISTIC(CUSTOM_LIGHT_EFFECT, STRIP_EFFECT_NONE, .getter = led_effect_get, .setter = led_effect_set),
+            HOMEKIT_CHARACTERISTIC(CUSTOM_EFFECT_FRAME_TIME, 0, .getter = led_effect_frame_time_get),
+            HOMEKIT_CHARACTERISTIC(CUSTOM_STRIP_CURRENT, 0, .getter = led_current_get),
             NULL
         }),
+#if LED_SEGMENT_COUNT > 1
+        HOMEKIT_SERVICE(LIGHTBULB, .characteristics = (homekit_characteristic_t*[]) {
+            LED_SEGMENT_CHARACTERISTICS(1, "Segment 2"),
+            NULL
+        }),
+#endif
+#if LED_SEGMENT_COUNT > 2
+        HOMEKIT_SERVICE(LIGHTBULB, .characteristics = (homekit_characteristic_t*[]) {
+            LED_SEGMENT_CHARACTERISTICS(2, "Segment 3"),
+            NULL
+        }),
+#endif
+#if LED_SEGMENT_COUNT > 3
+        HOMEKIT_SERVICE(LIGHTBULB, .characteristics = (homekit_characteristic_t*[]) {
+            LED_SEGMENT_CHARACTERISTICS(3, "Segment 4"),
+            NULL
+        }),
+#endif
         NULL
     }),
     NULL
 };
 #pragma GCC diagnostic pop
 
+static void on_homekit_event(homekit_event_t event) {
+    if (event == HOMEKIT_EVENT_CLIENT_CONNECTED) {
+        boot_trace_complete("hap_connected");
+    }
+}
+
 static homekit_server_config_t config = {
     .accessories = accessories,
     .password = CONFIG_ESP_SETUP_CODE,
     .setupId = CONFIG_ESP_SETUP_ID,
+    .on_event = on_homekit_event,
 };
 
 static void on_wifi_ready(void) {
+    boot_trace_mark("on_wifi_ready");
     ESP_LOGI("INFORMATION", "Starting HomeKit server...");
     homekit_server_init(&config);
 }
 
 void app_main(void) {
+    boot_trace_init();
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
         ESP_LOGW("WARNING", "NVS flash initialization failed, erasing...");
         CHECK_ERROR(nvs_flash_erase());
+        boot_trace_mark("nvs_erase");
         ret = nvs_flash_init();
     }
     CHECK_ERROR(ret);
+    boot_trace_mark("nvs_flash_init");
 
-    wifi_init();
+    CHECK_ERROR(wifi_connect_init(CONFIG_ESP_WIFI_SSID, CONFIG_ESP_WIFI_PASSWORD, on_wifi_ready));
+    boot_trace_mark("wifi_init");
     led_strip_init();
+    boot_trace_mark("led_strip_init");
+    identify_init();
+    boot_trace_mark("identify_init");
 }
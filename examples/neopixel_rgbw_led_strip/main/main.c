@@ -23,7 +23,6 @@
 
 #include <stdio.h>
 #include <esp_wifi.h>
-#include <esp_event.h>
 #include <esp_log.h>
 #include <nvs_flash.h>
 #include <freertos/FreeRTOS.h>
@@ -31,8 +30,17 @@
 #include <driver/gpio.h>
 #include <homekit/homekit.h>
 #include <homekit/characteristics.h>
+#include <wifi_connect.h>
+#include <boot_trace.h>
+#include <indicator.h>
+#include <seqlock.h>
 #include <led_strip.h>
-#include <math.h>
+#include <soc/soc_caps.h>
+#include <strip_render.h>
+#include <render_scheduler.h>
+#include <strip_effects.h>
+#include <color_lut.h>
+#include "custom_characteristics.h"
 
 #define CHECK_ERROR(x) do { \
                 esp_err_t __err_rc = (x); \
@@ -44,114 +52,70 @@
 
 #define LED_STRIP_GPIO CONFIG_ESP_LED_GPIO
 #define LED_STRIP_LENGTH CONFIG_ESP_STRIP_LENGTH
-#define DEG_TO_RAD(X) (M_PI*(X)/180)
+#define LED_STRIP_MAX_CURRENT CONFIG_ESP_STRIP_MAX_CURRENT
+#define LED_RENDER_INTERVAL_MS 16  // one frame at 60 Hz
+#define LED_EFFECT_FPS 50          // frame rate of the animated effects
 
 static led_strip_handle_t led_strip;
-static bool led_on = false;
-static float led_brightness = 50;
-static float led_hue = 180;
-static float led_saturation = 50;
+static strip_render_handle_t strip_render;
+static render_scheduler_handle_t led_render;
+static strip_effects_handle_t led_effects;
+typedef struct {
+        bool on;
+        float brightness;
+        float hue;
+        float saturation;
+        uint8_t effect;  // strip_effect_t, STRIP_EFFECT_NONE for a static colour
+} led_state_t;
+
+// Written by the HomeKit setters, read by the render path on another task
+static led_state_t led_state = { .on = false, .brightness = 50, .hue = 180, .saturation = 50, .effect = STRIP_EFFECT_NONE };
+static seqlock_t led_state_lock = SEQLOCK_INIT;
 
 static void handle_error(esp_err_t err) {
-        if (err == ESP_ERR_WIFI_NOT_STARTED || err == ESP_ERR_WIFI_CONN) {
-                ESP_LOGI("INFORMATION", "Restarting WiFi...");
-                esp_wifi_stop();
-                esp_wifi_start();
-        } else {
-                ESP_LOGE("ERROR", "Critical error, restarting device...");
-                esp_restart();
-        }
+        // Wi-Fi errors reconnect with backoff, a restart is only the supervisor's last resort
+        wifi_connect_handle_error(err);
 }
 
-static void on_wifi_ready(void);
-
-static void event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data) {
-        if (event_base == WIFI_EVENT) {
-                if (event_id == WIFI_EVENT_STA_START || event_id == WIFI_EVENT_STA_DISCONNECTED) {
-                        ESP_LOGI("INFORMATION", "Connecting to WiFi...");
-                        esp_wifi_connect();
+static void led_write(const led_state_t *state) {
+        if (strip_render) {
+                color_rgbw_t color = {0};
+                if (state->on) {
+                        color_lut_hsi_to_rgbw(state->hue, state->saturation, state->brightness, &color);
                 }
-        } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
-                ESP_LOGI("INFORMATION", "WiFi connected, IP obtained");
-                on_wifi_ready();
-        }
-}
-
-static void wifi_init() {
-        CHECK_ERROR(esp_netif_init());
-        CHECK_ERROR(esp_event_loop_create_default());
-        esp_netif_create_default_wifi_sta();
-
-        CHECK_ERROR(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
-        CHECK_ERROR(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, NULL));
-
-        wifi_init_config_t wifi_init_config = WIFI_INIT_CONFIG_DEFAULT();
-        CHECK_ERROR(esp_wifi_init(&wifi_init_config));
-        CHECK_ERROR(esp_wifi_set_storage(WIFI_STORAGE_RAM));
-
-        wifi_config_t wifi_config = {
-                .sta = {
-                        .ssid = CONFIG_ESP_WIFI_SSID,
-                        .password = CONFIG_ESP_WIFI_PASSWORD,
-                        .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-                },
-        };
-
-        CHECK_ERROR(esp_wifi_set_mode(WIFI_MODE_STA));
-        CHECK_ERROR(esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_config));
-        CHECK_ERROR(esp_wifi_start());
-}
-
-static void hsi2rgbw(float H, float S, float I, int* rgbw) {
-        int r = 0, g = 0, b = 0, w = 0;
-        float cos_h, cos_1047_h;
-
-        H = fmod(H, 360);
-        H = DEG_TO_RAD(H);
-        S = fminf(fmaxf(S, 0), 1);
-        I = fminf(fmaxf(I, 0), 1);
-
-        if (H < 2.09439) {
-                cos_h = cos(H);
-                cos_1047_h = cos(1.047196667 - H);
-                r = S * 255 * I / 3 * (1 + cos_h / cos_1047_h);
-                g = S * 255 * I / 3 * (1 + (1 - cos_h / cos_1047_h));
-                w = 255 * (1 - S) * I;
-        } else if (H < 4.188787) {
-                H -= 2.09439;
-                cos_h = cos(H);
-                cos_1047_h = cos(1.047196667 - H);
-                g = S * 255 * I / 3 * (1 + cos_h / cos_1047_h);
-                b = S * 255 * I / 3 * (1 + (1 - cos_h / cos_1047_h));
-                w = 255 * (1 - S) * I;
-        } else {
-                H -= 4.188787;
-                cos_h = cos(H);
-                cos_1047_h = cos(1.047196667 - H);
-                b = S * 255 * I / 3 * (1 + cos_h / cos_1047_h);
-                r = S * 255 * I / 3 * (1 + (1 - cos_h / cos_1047_h));
-                w = 255 * (1 - S) * I;
-        }
-
-        rgbw[0] = r;
-        rgbw[1] = g;
-        rgbw[2] = b;
-        rgbw[3] = w;
-}
-
-static void led_write(bool on) {
-        if (led_strip) {
-                for (int i = 0; i < LED_STRIP_LENGTH; i++) {
-                        int rgbw[4] = {0};
-                        if (on) {
-                                hsi2rgbw(led_hue, led_saturation / 100.0, led_brightness / 100.0, rgbw);
+                if (state->on && state->effect != STRIP_EFFECT_NONE) {
+                        // The effect takes over the frame buffer and draws at its own frame rate; the gradient
+                        // runs from the chosen colour to its complement
+                        strip_effect_params_t params = {
+                                .effect = state->effect,
+                                .primary = color,
+                                .brightness = state->brightness,
+                        };
+                        color_lut_hsi_to_rgbw(state->hue + 180, state->saturation, state->brightness, &params.secondary);
+                        esp_err_t err = strip_effects_start(led_effects, &params);
+                        if (err != ESP_OK) {
+                                ESP_LOGE("LED", "Could not start effect: %s", esp_err_to_name(err));
                         }
-                        ESP_ERROR_CHECK(led_strip_set_pixel_rgbw(led_strip, i, rgbw[0], rgbw[1], rgbw[2], rgbw[3]));
+                        return;
+                }
+                strip_effects_stop(led_effects);
+                // The render layer skips the refresh when the strip already shows this colour
+                strip_render_fill(strip_render, &color);
+                esp_err_t err = strip_render_show(strip_render);
+                if (err != ESP_OK) {
+                        ESP_LOGE("LED", "Could not show frame: %s", esp_err_to_name(err));
                 }
-                ESP_ERROR_CHECK(led_strip_refresh(led_strip));
         }
 }
 
+// One HomeKit scene change sets On, Brightness, Hue and Saturation back to back; the setters
+// only store the new state and the strip is rendered once for the whole burst
+static void led_render_cb(void *context) {
+        led_state_t state;
+        SEQLOCK_READ(&led_state_lock, state, led_state);
+        led_write(&state);
+}
+
 static void led_strip_init() {
         led_strip_config_t strip_config = {
                 .strip_gpio_num = LED_STRIP_GPIO,
@@ -165,62 +129,126 @@ static void led_strip_init() {
                 .clk_src = RMT_CLK_SRC_DEFAULT,
                 .resolution_hz = 10 * 1000 * 1000,
                 .flags = {
-                        .with_dma = false,
+#if SOC_RMT_SUPPORT_DMA
+                        // Frames go out by DMA on chips that have it, so long strips don't keep the CPU busy
+                        .with_dma = true,
+#endif
                 },
         };
 
         CHECK_ERROR(led_strip_new_rmt_device(&strip_config, &rmt_config, &led_strip));
+
+        const strip_render_config_t render_config = {
+                .strip = led_strip,
+                .length = LED_STRIP_LENGTH,
+                .rgbw = true,
+                .async = true,
+                .max_current_ma = LED_STRIP_MAX_CURRENT,
+        };
+        CHECK_ERROR(strip_render_create(&render_config, &strip_render));
+
+        const strip_effects_config_t effects_config = {
+                .render = strip_render,
+                .length = LED_STRIP_LENGTH,
+                .frame_rate = LED_EFFECT_FPS,
+        };
+        CHECK_ERROR(strip_effects_create(&effects_config, &led_effects));
+
+        const render_scheduler_config_t scheduler_config = {
+                .interval_ms = LED_RENDER_INTERVAL_MS,
+                .callback = led_render_cb,
+        };
+        CHECK_ERROR(render_scheduler_create(&scheduler_config, &led_render));
 }
 
-static void accessory_identify_task(void *args) {
-        for (int i = 0; i < 3; i++) {
-                led_write(true);
-                vTaskDelay(pdMS_TO_TICKS(100));
-                led_write(false);
-                vTaskDelay(pdMS_TO_TICKS(100));
-        }
-        vTaskDelay(pdMS_TO_TICKS(250));
-        led_write(led_on);
-        vTaskDelete(NULL);
+static indicator_handle_t identify_indicator;
+
+static void identify_write(uint8_t level, void *context) {
+        led_state_t state;
+        SEQLOCK_READ(&led_state_lock, state, led_state);
+        state.on = level != 0;
+        state.effect = STRIP_EFFECT_NONE;
+        led_write(&state);
+}
+
+static void identify_restore(void *context) {
+        led_render_cb(NULL);
 }
 
 static void accessory_identify(homekit_value_t _value) {
         ESP_LOGI("INFORMATION", "Accessory identify");
-        xTaskCreate(accessory_identify_task, "Accessory identify", configMINIMAL_STACK_SIZE, NULL, 2, NULL);
+        indicator_play(identify_indicator, &indicator_pattern_identify);
+}
+
+static void identify_init(void) {
+        const indicator_config_t identify_config = INDICATOR_CONFIG_CUSTOM(identify_write, identify_restore, NULL);
+        CHECK_ERROR(indicator_create(&identify_config, &identify_indicator));
 }
 
-static homekit_value_t led_on_get() { return HOMEKIT_BOOL(led_on); }
+static homekit_value_t led_on_get() { return HOMEKIT_BOOL(led_state.on); }
 static void led_on_set(homekit_value_t value) {
         if (value.format == homekit_format_bool) {
-                led_on = value.bool_value;
-                led_write(led_on);
+                seqlock_write_begin(&led_state_lock);
+                led_state.on = value.bool_value;
+                seqlock_write_end(&led_state_lock);
+                render_scheduler_request(led_render);
         }
 }
 
-static homekit_value_t led_brightness_get() { return HOMEKIT_INT(led_brightness); }
+static homekit_value_t led_brightness_get() { return HOMEKIT_INT(led_state.brightness); }
 static void led_brightness_set(homekit_value_t value) {
         if (value.format == homekit_format_int) {
-                led_brightness = value.int_value;
-                led_write(led_on);
+                seqlock_write_begin(&led_state_lock);
+                led_state.brightness = value.int_value;
+                seqlock_write_end(&led_state_lock);
+                render_scheduler_request(led_render);
         }
 }
 
-static homekit_value_t led_hue_get() { return HOMEKIT_FLOAT(led_hue); }
+static homekit_value_t led_hue_get() { return HOMEKIT_FLOAT(led_state.hue); }
 static void led_hue_set(homekit_value_t value) {
         if (value.format == homekit_format_float) {
-                led_hue = value.float_value;
-                led_write(led_on);
+                seqlock_write_begin(&led_state_lock);
+                led_state.hue = value.float_value;
+                seqlock_write_end(&led_state_lock);
+                render_scheduler_request(led_render);
         }
 }
 
-static homekit_value_t led_saturation_get() { return HOMEKIT_FLOAT(led_saturation); }
+static homekit_value_t led_saturation_get() { return HOMEKIT_FLOAT(led_state.saturation); }
 static void led_saturation_set(homekit_value_t value) {
         if (value.format == homekit_format_float) {
-                led_saturation = value.float_value;
-                led_write(led_on);
+                seqlock_write_begin(&led_state_lock);
+                led_state.saturation = value.float_value;
+                seqlock_write_end(&led_state_lock);
+                render_scheduler_request(led_render);
         }
 }
 
+static homekit_value_t led_effect_get() { return HOMEKIT_UINT8(led_state.effect); }
+static void led_effect_set(homekit_value_t value) {
+        if (value.format == homekit_format_uint8 && value.uint8_value < STRIP_EFFECT_COUNT) {
+                seqlock_write_begin(&led_state_lock);
+                led_state.effect = value.uint8_value;
+                seqlock_write_end(&led_state_lock);
+                render_scheduler_request(led_render);
+        }
+}
+
+// Compute time of the last effect frame in microseconds, read on demand
+static homekit_value_t led_effect_frame_time_get() {
+        strip_effects_stats_t stats;
+        strip_effects_get_stats(led_effects, &stats);
+        return HOMEKIT_UINT32(stats.compute_us);
+}
+
+// Estimated current of the frame on the strip in mA, after the power limit
+static homekit_value_t led_current_get() {
+        strip_render_stats_t stats;
+        strip_render_get_stats(strip_render, &stats);
+        return HOMEKIT_UINT16(stats.current_ma > UINT16_MAX ? UINT16_MAX : stats.current_ma);
+}
+
 #define DEVICE_NAME "HomeKit RGBW Light"
 #define DEVICE_MANUFACTURER "StudioPieters®"
 #define DEVICE_SERIAL "NLDA4SQN1466"
@@ -252,6 +280,9 @@ static homekit_accessory_t *accessories[] = {
                         HOMEKIT_CHARACTERISTIC(BRIGHTNESS, 100, .getter = led_brightness_get, .setter = led_brightness_set),
                         HOMEKIT_CHARACTERISTIC(HUE, 0, .getter = led_hue_get, .setter = led_hue_set),
                         HOMEKIT_CHARACTERISTIC(SATURATION, 0, .getter = led_saturation_get, .setter = led_saturation_set),
+                        HOMEKIT_CHARACTERISTIC(CUSTOM_LIGHT_EFFECT, STRIP_EFFECT_NONE, .getter = led_effect_get, .setter = led_effect_set),
+                        HOMEKIT_CHARACTERISTIC(CUSTOM_EFFECT_FRAME_TIME, 0, .getter = led_effect_frame_time_get),
+                        HOMEKIT_CHARACTERISTIC(CUSTOM_STRIP_CURRENT, 0, .getter = led_current_get),
                         NULL
                 }),
                 NULL
@@ -260,26 +291,41 @@ static homekit_accessory_t *accessories[] = {
 };
 #pragma GCC diagnostic pop
 
+static void on_homekit_event(homekit_event_t event) {
+        if (event == HOMEKIT_EVENT_CLIENT_CONNECTED) {
+                boot_trace_complete("hap_connected");
+        }
+}
+
 static homekit_server_config_t config = {
         .accessories = accessories,
         .password = CONFIG_ESP_SETUP_CODE,
         .setupId = CONFIG_ESP_SETUP_ID,
+        .on_event = on_homekit_event,
 };
 
 static void on_wifi_ready() {
+        boot_trace_mark("on_wifi_ready");
         ESP_LOGI("INFORMATION", "Starting HomeKit server...");
         homekit_server_init(&config);
 }
 
 void app_main(void) {
+        boot_trace_init();
         esp_err_t ret = nvs_flash_init();
         if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
                 ESP_LOGW("WARNING", "NVS flash initialization failed, erasing...");
                 CHECK_ERROR(nvs_flash_erase());
+                boot_trace_mark("nvs_erase");
                 ret = nvs_flash_init();
         }
         CHECK_ERROR(ret);
+        boot_trace_mark("nvs_flash_init");
 
-        wifi_init();
+        CHECK_ERROR(wifi_connect_init(CONFIG_ESP_WIFI_SSID, CONFIG_ESP_WIFI_PASSWORD, on_wifi_ready));
+        boot_trace_mark("wifi_init");
         led_strip_init();
+        boot_trace_mark("led_strip_init");
+        identify_init();
+        boot_trace_mark("identify_init");
 }
@@ -23,17 +23,18 @@
 
 #include <stdio.h>
 #include <esp_wifi.h>
-#include <esp_event.h>
 #include <esp_log.h>
 #include <esp_system.h>    // for esp_restart()
 #include <nvs_flash.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
-#include <freertos/queue.h>
 #include <driver/gpio.h>
-#include <esp_timer.h>     // for esp_timer_get_time()
 #include <homekit/homekit.h>
 #include <homekit/characteristics.h>
+#include <wifi_connect.h>
+#include <boot_trace.h>
+#include <button_gesture.h>
+#include <indicator.h>
 
 
 // =======================
@@ -48,60 +49,8 @@
 } while(0)
 
 void handle_error(esp_err_t err) {
-    // Custom error handling logic
-    if (err == ESP_ERR_WIFI_NOT_STARTED || err == ESP_ERR_WIFI_CONN) {
-        ESP_LOGI("INFORMATION", "Restarting WiFi...");
-        esp_wifi_stop();
-        esp_wifi_start();
-    } else {
-        ESP_LOGE("ERROR", "Critical error, restarting device...");
-        esp_restart();
-    }
-}
-
-// Forward declaration for once Wi-Fi is ready
-void on_wifi_ready(void);
-
-// ==================
-// Wi-Fi Event Logic
-// ==================
-static void event_handler(void *arg, esp_event_base_t event_base,
-                          int32_t event_id, void *event_data)
-{
-    if (event_base == WIFI_EVENT) {
-        if (event_id == WIFI_EVENT_STA_START || event_id == WIFI_EVENT_STA_DISCONNECTED) {
-            ESP_LOGI("INFORMATION", "Connecting to WiFi...");
-            esp_wifi_connect();
-        }
-    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
-        ESP_LOGI("INFORMATION", "WiFi connected, IP obtained");
-        on_wifi_ready();
-    }
-}
-
-static void wifi_init() {
-    CHECK_ERROR(esp_netif_init());
-    CHECK_ERROR(esp_event_loop_create_default());
-    esp_netif_create_default_wifi_sta();
-
-    CHECK_ERROR(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
-    CHECK_ERROR(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, NULL));
-
-    wifi_init_config_t wifi_init_config = WIFI_INIT_CONFIG_DEFAULT();
-    CHECK_ERROR(esp_wifi_init(&wifi_init_config));
-    CHECK_ERROR(esp_wifi_set_storage(WIFI_STORAGE_RAM));
-
-    wifi_config_t wifi_config = {
-        .sta = {
-            .ssid = CONFIG_ESP_WIFI_SSID,
-            .password = CONFIG_ESP_WIFI_PASSWORD,
-            .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-        },
-    };
-
-    CHECK_ERROR(esp_wifi_set_mode(WIFI_MODE_STA));
-    CHECK_ERROR(esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_config));
-    CHECK_ERROR(esp_wifi_start());
+    // Wi-Fi errors reconnect with backoff, a restart is only the supervisor's last resort
+    wifi_connect_handle_error(err);
 }
 
 // ====================================
@@ -125,25 +74,20 @@ void gpio_init() {
 // ========================
 // Accessory Identification
 // ========================
-void accessory_identify_task(void *args) {
-    for (int i = 0; i < 3; i++) {
-        for (int j = 0; j < 2; j++) {
-            led_write(true);
-            vTaskDelay(pdMS_TO_TICKS(100));
-            led_write(false);
-            vTaskDelay(pdMS_TO_TICKS(100));
-        }
-        vTaskDelay(pdMS_TO_TICKS(250));
-    }
-    // Restore LED
+static indicator_handle_t identify_indicator;
+
+static void identify_restore(void *context) {
     led_write(led_on);
-    vTaskDelete(NULL);
 }
 
 void accessory_identify(homekit_value_t _value) {
     ESP_LOGI("INFORMATION", "Accessory identify");
-    xTaskCreate(accessory_identify_task, "Accessory identify",
-                configMINIMAL_STACK_SIZE, NULL, 2, NULL);
+    indicator_play(identify_indicator, &indicator_pattern_identify);
+}
+
+static void identify_init(void) {
+    const indicator_config_t identify_config = INDICATOR_CONFIG_GPIO(LED_GPIO, identify_restore, NULL);
+    CHECK_ERROR(indicator_create(&identify_config, &identify_indicator));
 }
 
 // (Optional) "Button identify" if you had a second identify
@@ -160,25 +104,18 @@ void button_identify(homekit_value_t _value) {
 homekit_characteristic_t button_event =
     HOMEKIT_CHARACTERISTIC_(PROGRAMMABLE_SWITCH_EVENT, 0);
 
-// Custom button event types
-typedef enum {
-    button_event_single_press,
-    button_event_double_press,
-    button_event_long_press
-} custom_button_event_t;
-
 // This is the callback your code triggers for single/double/long:
-void button_callback(custom_button_event_t event, void *context) {
+void button_callback(button_gesture_event_t event, void *context) {
     switch (event) {
-    case button_event_single_press:
+    case BUTTON_GESTURE_SINGLE_PRESS:
         ESP_LOGI("SINGLE_PRESS", "single press");
         homekit_characteristic_notify(&button_event, HOMEKIT_UINT8(0));
         break;
-    case button_event_double_press:
+    case BUTTON_GESTURE_DOUBLE_PRESS:
         ESP_LOGI("DOUBLE_PRESS", "Double press");
         homekit_characteristic_notify(&button_event, HOMEKIT_UINT8(1));
         break;
-    case button_event_long_press:
+    case BUTTON_GESTURE_LONG_PRESS:
         ESP_LOGI("LONG_PRESS", "Long press");
         homekit_characteristic_notify(&button_event, HOMEKIT_UINT8(2));
         break;
@@ -189,112 +126,14 @@ void button_callback(custom_button_event_t event, void *context) {
 }
 
 // ===============================================
-// Button implementation using ESP-IDF APIs
+// Button (esp32-button-gesture)
 // ===============================================
 
-// We'll track press times for single/double/long press
-static QueueHandle_t button_evt_queue = NULL;
-
-// State machine for 1 button
-static bool button_pressed = false;
-static int press_count     = 0;
-static bool waiting_for_second_press  = false;
-static bool double_press_detected     = false;
-static int64_t press_start_time_ms    = 0;
-static int64_t last_release_time_ms   = 0;
-
-// ISR: push the GPIO number into a queue
-static void IRAM_ATTR button_isr_handler(void *arg) {
-    uint32_t gpio_num = (uint32_t) arg;
-    xQueueSendFromISR(button_evt_queue, &gpio_num, NULL);
-}
-
-static void button_task(void *pvParameter) {
-    // Press thresholds (ms)
-    const int DOUBLE_PRESS_WINDOW_MS  = 500;
-    const int LONG_PRESS_THRESHOLD_MS = 1000;
-
-    uint32_t io_num;
-    for (;;) {
-        // Wait for ISR event
-        if (xQueueReceive(button_evt_queue, &io_num, portMAX_DELAY)) {
-            int64_t now_ms = esp_timer_get_time() / 1000;
-            bool level = gpio_get_level(io_num); // active low
-
-            if (level == 0) {
-                // Press
-                button_pressed = true;
-                press_start_time_ms = now_ms;
-                press_count++;
-                double_press_detected = false;
-                waiting_for_second_press = false;
-            } else {
-                // Release
-                button_pressed = false;
-                int64_t press_duration_ms = now_ms - press_start_time_ms;
-
-                if (press_duration_ms >= LONG_PRESS_THRESHOLD_MS) {
-                    // Long press
-                    ESP_LOGI("BUTTON", "Long press detected");
-                    button_callback(button_event_long_press, NULL);
-                    press_count = 0;
-                } else {
-                    // Short press
-                    if (press_count == 1) {
-                        // Possibly single press => wait for second press
-                        waiting_for_second_press = true;
-                        last_release_time_ms     = now_ms;
-                    } else if (press_count == 2) {
-                        // Possibly double press
-                        int64_t diff = now_ms - last_release_time_ms;
-                        if (diff <= DOUBLE_PRESS_WINDOW_MS) {
-                            ESP_LOGI("BUTTON", "Double press detected");
-                            button_callback(button_event_double_press, NULL);
-                            double_press_detected = true;
-                        }
-                        waiting_for_second_press = false;
-                        press_count = 0;
-                    }
-                }
-            }
-        }
-
-        // If we were waiting for a second press, see if time expired
-        if (waiting_for_second_press) {
-            int64_t now_ms = esp_timer_get_time() / 1000;
-            if ((now_ms - last_release_time_ms) > DOUBLE_PRESS_WINDOW_MS) {
-                // Timed out => single press
-                waiting_for_second_press = false;
-                if (!double_press_detected) {
-                    ESP_LOGI("BUTTON", "Single press detected");
-                    button_callback(button_event_single_press, NULL);
-                }
-                press_count = 0;
-            }
-        }
-
-        vTaskDelay(pdMS_TO_TICKS(10)); // small delay
-    }
-}
-
 static void custom_button_init(void) {
-    // Setup the button GPIO
-    gpio_config_t io_conf = {
-        .intr_type    = GPIO_INTR_ANYEDGE,
-        .mode         = GPIO_MODE_INPUT,
-        .pull_up_en   = 1, // active low button
-        .pull_down_en = 0,
-        .pin_bit_mask = (1ULL << BUTTON_GPIO),
-    };
-    gpio_config(&io_conf);
-
-    // Create a queue & button_task
-    button_evt_queue = xQueueCreate(10, sizeof(uint32_t));
-    xTaskCreate(button_task, "button_task", 2048, NULL, 10, NULL);
-
-    // ISR service
-    gpio_install_isr_service(0);
-    gpio_isr_handler_add(BUTTON_GPIO, button_isr_handler, (void *)BUTTON_GPIO);
+    // Active low with internal pull-up; presses are decided on esp_timer deadlines
+    button_gesture_config_t config = BUTTON_GESTURE_CONFIG_DEFAULT(BUTTON_GPIO, button_callback, NULL);
+    button_gesture_handle_t button;
+    CHECK_ERROR(button_gesture_create(&config, &button));
 }
 
 // =======================
@@ -347,14 +186,22 @@ homekit_accessory_t *accessories[] = {
 };
 #pragma GCC diagnostic pop
 
+static void on_homekit_event(homekit_event_t event) {
+    if (event == HOMEKIT_EVENT_CLIENT_CONNECTED) {
+        boot_trace_complete("hap_connected");
+    }
+}
+
 homekit_server_config_t config = {
     .accessories = accessories,
     .password = CONFIG_ESP_SETUP_CODE,
     .setupId  = CONFIG_ESP_SETUP_ID,
+    .on_event = on_homekit_event,
 };
 
 // Called once Wi-Fi is connected
 void on_wifi_ready() {
+    boot_trace_mark("on_wifi_ready");
     ESP_LOGI("INFORMATION", "Starting HomeKit server...");
     homekit_server_init(&config);
 }
@@ -363,17 +210,25 @@ void on_wifi_ready() {
 // app_main
 // ============
 void app_main(void) {
+    boot_trace_init();
     // NVS init
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
         ESP_LOGW("WARNING", "NVS flash initialization failed, erasing...");
         CHECK_ERROR(nvs_flash_erase());
+        boot_trace_mark("nvs_erase");
         ret = nvs_flash_init();
     }
     CHECK_ERROR(ret);
+    boot_trace_mark("nvs_flash_init");
 
     // Wi-Fi, GPIO, Button
-    wifi_init();
+    CHECK_ERROR(wifi_connect_init(CONFIG_ESP_WIFI_SSID, CONFIG_ESP_WIFI_PASSWORD, on_wifi_ready));
+    boot_trace_mark("wifi_init");
     gpio_init();
+    boot_trace_mark("gpio_init");
+    identify_init();
+    boot_trace_mark("identify_init");
     custom_button_init();  // Initialize button handling
+    boot_trace_mark("custom_button_init");
 }
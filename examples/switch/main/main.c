@@ -23,17 +23,18 @@
 
 #include <stdio.h>
 #include <esp_wifi.h>
-#include <esp_event.h>
 #include <esp_log.h>
 #include <esp_system.h>      // for esp_restart()
 #include <nvs_flash.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
-#include <freertos/queue.h>
 #include <driver/gpio.h>
-#include <esp_timer.h>       // for esp_timer_get_time()
 #include <homekit/homekit.h>
 #include <homekit/characteristics.h>
+#include <wifi_connect.h>
+#include <boot_trace.h>
+#include <button_gesture.h>
+#include <indicator.h>
 
 
 // Logging tag
@@ -52,61 +53,8 @@ static const char *TAG = "HOMEKIT_SWITCH";
 
 // Handle recoverable vs. critical errors
 static void handle_error(esp_err_t err) {
-    switch (err) {
-    case ESP_ERR_WIFI_NOT_STARTED:
-    case ESP_ERR_WIFI_CONN:
-        ESP_LOGI("INFORMATION", "Recoverable error, restarting WiFi...");
-        esp_wifi_stop();
-        esp_wifi_start();
-        break;
-    default:
-        ESP_LOGE("ERROR", "Critical error, restarting device...");
-        esp_restart();
-        break;
-    }
-}
-
-// ========================
-// Wi-Fi Event Handlers
-// ========================
-static void on_wifi_ready(void);
-
-static void event_handler(void *arg, esp_event_base_t event_base,
-                          int32_t event_id, void *event_data)
-{
-    if (event_base == WIFI_EVENT &&
-       (event_id == WIFI_EVENT_STA_START || event_id == WIFI_EVENT_STA_DISCONNECTED)) {
-        ESP_LOGI("INFORMATION", "Connecting to WiFi...");
-        esp_wifi_connect();
-    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
-        ESP_LOGI("INFORMATION", "WiFi connected, IP obtained");
-        on_wifi_ready();
-    }
-}
-
-static void wifi_init() {
-    CHECK_ERROR(esp_netif_init());
-    CHECK_ERROR(esp_event_loop_create_default());
-    esp_netif_create_default_wifi_sta();
-
-    CHECK_ERROR(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
-    CHECK_ERROR(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, NULL));
-
-    wifi_init_config_t wifi_init_config = WIFI_INIT_CONFIG_DEFAULT();
-    CHECK_ERROR(esp_wifi_init(&wifi_init_config));
-    CHECK_ERROR(esp_wifi_set_storage(WIFI_STORAGE_RAM));
-
-    wifi_config_t wifi_config = {
-        .sta = {
-            .ssid = CONFIG_ESP_WIFI_SSID,
-            .password = CONFIG_ESP_WIFI_PASSWORD,
-            .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-        },
-    };
-
-    CHECK_ERROR(esp_wifi_set_mode(WIFI_MODE_STA));
-    CHECK_ERROR(esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_config));
-    CHECK_ERROR(esp_wifi_start());
+    // Wi-Fi errors reconnect with backoff, a restart is only the supervisor's last resort
+    wifi_connect_handle_error(err);
 }
 
 // ========================
@@ -151,26 +99,22 @@ static void gpio_init() {
 }
 
 // ==============================
-// Accessory Identification Task
+// Accessory Identification
 // ==============================
-static void accessory_identify_task(void *args) {
-    for (int i = 0; i < 3; i++) {
-        for (int j = 0; j < 2; j++) {
-            led_write(true);
-            vTaskDelay(pdMS_TO_TICKS(100));
-            led_write(false);
-            vTaskDelay(pdMS_TO_TICKS(100));
-        }
-        vTaskDelay(pdMS_TO_TICKS(250));
-    }
+static indicator_handle_t identify_indicator;
+
+static void identify_restore(void *context) {
     led_write(led_on);
-    vTaskDelete(NULL);
 }
 
 static void accessory_identify(homekit_value_t _value) {
     ESP_LOGI("INFORMATION", "Accessory identify");
-    xTaskCreate(accessory_identify_task, "Accessory identify",
-                configMINIMAL_STACK_SIZE, NULL, 2, NULL);
+    indicator_play(identify_indicator, &indicator_pattern_identify);
+}
+
+static void identify_init(void) {
+    const indicator_config_t identify_config = INDICATOR_CONFIG_GPIO(LED_GPIO, identify_restore, NULL);
+    CHECK_ERROR(indicator_create(&identify_config, &identify_indicator));
 }
 
 // Switch on/off callback
@@ -185,17 +129,10 @@ static void switch_on_callback(homekit_characteristic_t *_ch,
 // Single/Double/Long Press Logic
 // =============================
 
-// Define button event types
-typedef enum {
-    button_event_single_press,
-    button_event_double_press,
-    button_event_long_press
-} button_event_t;
-
 // The same callback logic you had before for single/double/long
-static void button_callback(button_event_t event, void *context) {
+static void button_callback(button_gesture_event_t event, void *context) {
     switch (event) {
-    case button_event_single_press:
+    case BUTTON_GESTURE_SINGLE_PRESS:
         ESP_LOGI("INFORMATION", "Single press");
         // Toggle the switch
         switch_on.value.bool_value = !switch_on.value.bool_value;
@@ -203,12 +140,12 @@ static void button_callback(button_event_t event, void *context) {
         homekit_characteristic_notify(&switch_on, switch_on.value);
         break;
 
-    case button_event_double_press:
+    case BUTTON_GESTURE_DOUBLE_PRESS:
         ESP_LOGI("INFORMATION", "Double press");
         // Additional double-press logic here
         break;
 
-    case button_event_long_press:
+    case BUTTON_GESTURE_LONG_PRESS:
         ESP_LOGI("INFORMATION", "Long press");
         // Additional long-press logic here
         break;
@@ -220,105 +157,13 @@ static void button_callback(button_event_t event, void *context) {
 }
 
 // =============================
-// Button event handling
+// Button
 // =============================
-static QueueHandle_t button_evt_queue = NULL;
-
-// For single/double/long press detection
-static volatile bool button_pressed = false;
-static volatile int press_count     = 0;
-static bool waiting_for_second_press = false;
-static bool double_press_detected    = false;
-static int64_t press_start_time_ms   = 0;
-static int64_t last_release_time_ms  = 0;
-
-static void IRAM_ATTR button_isr_handler(void *arg) {
-    uint32_t gpio_num = (uint32_t)arg;
-    xQueueSendFromISR(button_evt_queue, &gpio_num, NULL);
-}
-
-static void button_task(void *pvParameter) {
-    // Tweak these thresholds as needed
-    const int DOUBLE_PRESS_WINDOW_MS  = 500;
-    const int LONG_PRESS_THRESHOLD_MS = 1000;
-
-    uint32_t io_num;
-    for (;;) {
-        if (xQueueReceive(button_evt_queue, &io_num, portMAX_DELAY)) {
-            int64_t now_ms = esp_timer_get_time() / 1000;
-            bool level     = gpio_get_level(io_num);  // active low
-
-            if (level == 0) {
-                // Press
-                button_pressed = true;
-                press_start_time_ms = now_ms;
-                press_count++;
-                double_press_detected   = false;
-                waiting_for_second_press = false;
-            } else {
-                // Release
-                button_pressed = false;
-                int64_t press_duration_ms = now_ms - press_start_time_ms;
-
-                if (press_duration_ms >= LONG_PRESS_THRESHOLD_MS) {
-                    // Long press
-                    ESP_LOGI("BUTTON", "Long press detected");
-                    button_callback(button_event_long_press, NULL);
-                    press_count = 0;
-                } else {
-                    // Short press
-                    if (press_count == 1) {
-                        // Possibly single press => wait to see if second press occurs
-                        waiting_for_second_press = true;
-                        last_release_time_ms     = now_ms;
-                    } else if (press_count == 2) {
-                        // Possibly double press
-                        int64_t diff = now_ms - last_release_time_ms;
-                        if (diff <= DOUBLE_PRESS_WINDOW_MS) {
-                            ESP_LOGI("BUTTON", "Double press detected");
-                            button_callback(button_event_double_press, NULL);
-                            double_press_detected = true;
-                        }
-                        waiting_for_second_press = false;
-                        press_count = 0;
-                    }
-                }
-            }
-        }
-
-        // If we are waiting for a second press but time expires => single press
-        if (waiting_for_second_press) {
-            int64_t now_ms = esp_timer_get_time() / 1000;
-            if ((now_ms - last_release_time_ms) > DOUBLE_PRESS_WINDOW_MS) {
-                waiting_for_second_press = false;
-                if (!double_press_detected) {
-                    ESP_LOGI("BUTTON", "Single press detected");
-                    button_callback(button_event_single_press, NULL);
-                }
-                press_count = 0;
-            }
-        }
-        vTaskDelay(pdMS_TO_TICKS(10));
-    }
-}
-
 static void button_init(void) {
-    gpio_config_t io_conf = {
-        .intr_type    = GPIO_INTR_ANYEDGE, // interrupt on both rising/falling edges
-        .mode         = GPIO_MODE_INPUT,
-        .pull_up_en   = 1,                 // active low
-        .pull_down_en = 0,
-        .pin_bit_mask = (1ULL << BUTTON_GPIO),
-    };
-    gpio_config(&io_conf);
-
-    // Create queue and task
-    button_evt_queue = xQueueCreate(10, sizeof(uint32_t));
-    xTaskCreate(button_task, "button_task", 2048, NULL, 10, NULL);
-
-    // Install ISR service and attach the handler
-    gpio_install_isr_service(0);
-    gpio_isr_handler_add(BUTTON_GPIO, button_isr_handler, (void *)BUTTON_GPIO);
+    // Active low with internal pull-up; presses are decided on esp_timer deadlines
+    button_gesture_config_t config = BUTTON_GESTURE_CONFIG_DEFAULT(BUTTON_GPIO, button_callback, NULL);
+    button_gesture_handle_t button;
+    CHECK_ERROR(button_gesture_create(&config, &button));
 }
 
 // =============================
@@ -376,14 +221,22 @@ static homekit_accessory_t *accessories[] = {
 };
 #pragma GCC diagnostic pop
 
+static void on_homekit_event(homekit_event_t event) {
+    if (event == HOMEKIT_EVENT_CLIENT_CONNECTED) {
+        boot_trace_complete("hap_connected");
+    }
+}
+
 static homekit_server_config_t config = {
     .accessories = accessories,
     .password = CONFIG_ESP_SETUP_CODE,
     .setupId = CONFIG_ESP_SETUP_ID,
+    .on_event = on_homekit_event,
 };
 
 // Once Wi-Fi is connected
 static void on_wifi_ready() {
+    boot_trace_mark("on_wifi_ready");
     ESP_LOGI("INFORMATION", "Starting HomeKit server...");
     homekit_server_init(&config);
 }
@@ -392,19 +245,27 @@ static void on_wifi_ready() {
 // Main Entry Point
 // ===================
 void app_main(void) {
+    boot_trace_init();
     // Initialize NVS
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
         ESP_LOGW("WARNING", "NVS flash initialization failed, erasing...");
         CHECK_ERROR(nvs_flash_erase());
+        boot_trace_mark("nvs_erase");
         ret = nvs_flash_init();
     }
     CHECK_ERROR(ret);
+    boot_trace_mark("nvs_flash_init");
 
     // Setup Wi-Fi, I/O, and Button
-    wifi_init();
+    CHECK_ERROR(wifi_connect_init(CONFIG_ESP_WIFI_SSID, CONFIG_ESP_WIFI_PASSWORD, on_wifi_ready));
+    boot_trace_mark("wifi_init");
     gpio_init();
+    boot_trace_mark("gpio_init");
+    identify_init();
+    boot_trace_mark("identify_init");
     button_init(); // Initialize button handling
+    boot_trace_mark("button_init");
 
     // Done. The rest is event-driven via ISR + tasks.
 }
@@ -23,7 +23,6 @@
 
 #include <stdio.h>
 #include <esp_wifi.h>
-#include <esp_event.h>
 #include <esp_log.h>
 #include <nvs_flash.h>
 #include <freertos/FreeRTOS.h>
@@ -31,7 +30,11 @@
 #include <driver/gpio.h>
 #include <homekit/homekit.h>
 #include <homekit/characteristics.h>
-#include <math.h> // Include for fabs
+#include <wifi_connect.h>
+#include <boot_trace.h>
+#include <indicator.h>
+#include <notify_scheduler.h>
+#include <sensor_filter.h>
 #include <dht.h>
 
 #define CHECK_ERROR(x) do {                          \
@@ -43,57 +46,8 @@
 } while(0)
 
 void handle_error(esp_err_t err) {
-    switch (err) {
-    case ESP_ERR_WIFI_NOT_STARTED:
-    case ESP_ERR_WIFI_CONN:
-        ESP_LOGI("INFORMATION", "Restarting WiFi...");
-        esp_wifi_stop();
-        esp_wifi_start();
-        break;
-    default:
-        ESP_LOGE("ERROR", "Critical error, restarting device...");
-        esp_restart();
-        break;
-    }
-}
-
-static void on_wifi_ready();
-
-static void event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data) {
-    if (event_base == WIFI_EVENT) {
-        if (event_id == WIFI_EVENT_STA_START || event_id == WIFI_EVENT_STA_DISCONNECTED) {
-            ESP_LOGI("INFORMATION", "Connecting to WiFi...");
-            esp_wifi_connect();
-        }
-    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
-        ESP_LOGI("INFORMATION", "WiFi connected, IP obtained");
-        on_wifi_ready();
-    }
-}
-
-static void wifi_init() {
-    CHECK_ERROR(esp_netif_init());
-    CHECK_ERROR(esp_event_loop_create_default());
-    esp_netif_create_default_wifi_sta();
-
-    CHECK_ERROR(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
-    CHECK_ERROR(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, NULL));
-
-    wifi_init_config_t wifi_init_config = WIFI_INIT_CONFIG_DEFAULT();
-    CHECK_ERROR(esp_wifi_init(&wifi_init_config));
-    CHECK_ERROR(esp_wifi_set_storage(WIFI_STORAGE_RAM));
-
-    wifi_config_t wifi_config = {
-        .sta = {
-            .ssid = CONFIG_ESP_WIFI_SSID,
-            .password = CONFIG_ESP_WIFI_PASSWORD,
-            .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-        },
-    };
-
-    CHECK_ERROR(esp_wifi_set_mode(WIFI_MODE_STA));
-    CHECK_ERROR(esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_config));
-    CHECK_ERROR(esp_wifi_start());
+    // Wi-Fi errors reconnect with backoff, a restart is only the supervisor's last resort
+    wifi_connect_handle_error(err);
 }
 
 // Sensor type definitions
@@ -120,36 +74,30 @@ void gpio_init() {
     led_write(led_on);
 }
 
-void accessory_identify_task(void *args) {
-    for (int i = 0; i < 3; i++) {
-        for (int j = 0; j < 2; j++) {
-            led_write(true);
-            vTaskDelay(pdMS_TO_TICKS(100));
-            led_write(false);
-            vTaskDelay(pdMS_TO_TICKS(100));
-        }
-        vTaskDelay(pdMS_TO_TICKS(250));
-    }
+static indicator_handle_t identify_indicator;
+
+static void identify_restore(void *context) {
     led_write(led_on);
-    vTaskDelete(NULL);
 }
 
 void accessory_identify(homekit_value_t _value) {
     ESP_LOGI("INFORMATION", "Accessory identify");
-    xTaskCreate(accessory_identify_task, "Accessory identify", configMINIMAL_STACK_SIZE, NULL, 2, NULL);
+    indicator_play(identify_indicator, &indicator_pattern_identify);
+}
+
+static void identify_init(void) {
+    const indicator_config_t identify_config = INDICATOR_CONFIG_GPIO(LED_GPIO, identify_restore, NULL);
+    CHECK_ERROR(indicator_create(&identify_config, &identify_indicator));
 }
 
 homekit_characteristic_t temperature = HOMEKIT_CHARACTERISTIC_(CURRENT_TEMPERATURE, 0);
 homekit_characteristic_t humidity = HOMEKIT_CHARACTERISTIC_(CURRENT_RELATIVE_HUMIDITY, 0);
 
+static sensor_filter_handle_t temperature_filter;
+static sensor_filter_handle_t humidity_filter;
+
 void temperature_sensor_task(void *pvParameters) {
     float temperature_value, humidity_value;
-    float last_temperature = -100.0;
-    float last_humidity = -100.0;
-    const float temp_threshold = 0.5;
-    const float hum_threshold = 1.0;
-    const int periodic_interval = 1800;
-    int elapsed_time = 0;
 
 #ifdef CONFIG_EXAMPLE_INTERNAL_PULLUP
     gpio_set_pull_mode(CONFIG_ESP_TEMP_SENSOR_GPIO, GPIO_PULLUP_ONLY);
@@ -157,31 +105,31 @@ void temperature_sensor_task(void *pvParameters) {
 
     while (1) {
         if (dht_read_float_data(SENSOR_TYPE, CONFIG_ESP_TEMP_SENSOR_GPIO, &humidity_value, &temperature_value) == ESP_OK) {
-            bool should_update_temp = fabs(temperature_value - last_temperature) >= temp_threshold;
-            bool should_update_hum = fabs(humidity_value - last_humidity) >= hum_threshold;
-
-            if (should_update_temp || should_update_hum || elapsed_time >= periodic_interval) {
-                ESP_LOGI("INFORMATION", "Updating values - Humidity: %.1f%%, Temp: %.1f°C", humidity_value, temperature_value);
-
-                temperature.value.float_value = temperature_value;
-                humidity.value.float_value = humidity_value;
-                homekit_characteristic_notify(&temperature, HOMEKIT_FLOAT(temperature_value));
-                homekit_characteristic_notify(&humidity, HOMEKIT_FLOAT(humidity_value));
-
-                last_temperature = temperature_value;
-                last_humidity = humidity_value;
-                elapsed_time = 0;
-            }
+            ESP_LOGI("INFORMATION", "Humidity: %.1f%%, Temp: %.1f°C", humidity_value, temperature_value);
+            // Only the median goes on; the scheduler applies the deadband and heartbeat
+            sensor_filter_update(temperature_filter, temperature_value, &temperature_value);
+            sensor_filter_update(humidity_filter, humidity_value, &humidity_value);
+            notify_scheduler_update(&temperature, HOMEKIT_FLOAT(temperature_value));
+            notify_scheduler_update(&humidity, HOMEKIT_FLOAT(humidity_value));
         } else {
             ESP_LOGE("ERROR", "Cannot read data from sensor");
         }
 
         vTaskDelay(pdMS_TO_TICKS(10000));
-        elapsed_time += 10;
     }
 }
 
 void temperature_sensor_init() {
+    // Notify on a 0.5 °C or 1 % change, and at least every 30 minutes
+    const notify_limits_t temperature_limits = { .max_interval_ms = 1800000, .deadband = 0.5 };
+    const notify_limits_t humidity_limits = { .max_interval_ms = 1800000, .deadband = 1.0 };
+    CHECK_ERROR(notify_scheduler_add(&temperature, &temperature_limits));
+    CHECK_ERROR(notify_scheduler_add(&humidity, &humidity_limits));
+
+    // A median of three drops the occasional corrupted DHT frame before it reaches the deadband
+    const sensor_filter_config_t filter_config = { .median_window = 3 };
+    CHECK_ERROR(sensor_filter_create(&filter_config, &temperature_filter));
+    CHECK_ERROR(sensor_filter_create(&filter_config, &humidity_filter));
     xTaskCreate(temperature_sensor_task, "Temperature Sensor Task", configMINIMAL_STACK_SIZE * 3, NULL, 5, NULL);
 }
 // Define device characteristics
@@ -226,27 +174,43 @@ homekit_accessory_t *accessories[] = {
 };
 #pragma GCC diagnostic pop
 
+static void on_homekit_event(homekit_event_t event) {
+    if (event == HOMEKIT_EVENT_CLIENT_CONNECTED) {
+        boot_trace_complete("hap_connected");
+    }
+}
+
 homekit_server_config_t config = {
     .accessories = accessories,
     .password = CONFIG_ESP_SETUP_CODE,
     .setupId = CONFIG_ESP_SETUP_ID,
+    .on_event = on_homekit_event,
 };
 
 static void on_wifi_ready() {
+    boot_trace_mark("on_wifi_ready");
     ESP_LOGI("INFORMATION", "Starting HomeKit server...");
     homekit_server_init(&config);
 }
 
 void app_main(void) {
+    boot_trace_init();
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
         ESP_LOGW("WARNING", "NVS flash initialization failed, erasing...");
         CHECK_ERROR(nvs_flash_erase());
+        boot_trace_mark("nvs_erase");
         ret = nvs_flash_init();
     }
     CHECK_ERROR(ret);
+    boot_trace_mark("nvs_flash_init");
 
-    wifi_init();
+    CHECK_ERROR(wifi_connect_init(CONFIG_ESP_WIFI_SSID, CONFIG_ESP_WIFI_PASSWORD, on_wifi_ready));
+    boot_trace_mark("wifi_init");
     gpio_init();
+    boot_trace_mark("gpio_init");
+    identify_init();
+    boot_trace_mark("identify_init");
     temperature_sensor_init();
+    boot_trace_mark("temperature_sensor_init");
 }
@@ -30,11 +30,14 @@
 #include <homekit/homekit.h>
 #include <homekit/characteristics.h>
 #include <wifi_config.h>
+#include <boot_trace.h>
+#include <indicator.h>
+#include "reset_button.h"
 
 // GPIO-definities
 #define LED_GPIO CONFIG_ESP_LED_GPIO
 #define BUTTON_GPIO CONFIG_ESP_BUTTON_GPIO
-#define DEBOUNCE_TIME_MS 50
+#define RESET_HOLD_MS CONFIG_ESP_RESET_HOLD_MS
 
 static const char *TAG = "main";
 
@@ -49,16 +52,6 @@ void gpio_init() {
         gpio_reset_pin(LED_GPIO);
         gpio_set_direction(LED_GPIO, GPIO_MODE_OUTPUT);
         led_write(led_on);
-
-        // Knop setup
-        gpio_config_t io_conf = {
-                .pin_bit_mask = 1ULL << BUTTON_GPIO,
-                        .mode = GPIO_MODE_INPUT,
-                        .pull_up_en = GPIO_PULLUP_ENABLE,
-                        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-                        .intr_type = GPIO_INTR_DISABLE
-        };
-        gpio_config(&io_conf);
 }
 
 // Task factory_reset
@@ -84,46 +77,29 @@ void factory_reset() {
         xTaskCreate(factory_reset_task, "factory_reset", 4096, NULL, 2, NULL);
 }
 
-// Task button
-void button_task(void *pvParameter) {
-        ESP_LOGI(TAG, "Button task started");
-        bool last_state = true;
-
-        while (1) {
-                bool current_state = gpio_get_level(BUTTON_GPIO);
-
-                // Detecteer overgang van HIGH naar LOW (knop ingedrukt)
-                if (last_state && !current_state) {
-                        ESP_LOGW(TAG, "BUTTON PRESSED → RESETTING CONFIGURATION");
-                        factory_reset();
-                }
-
-                last_state = current_state;
-                vTaskDelay(pdMS_TO_TICKS(DEBOUNCE_TIME_MS));
-        }
-}
-
 // Accessory identify
-void accessory_identify_task(void *args) {
-        for (int i = 0; i < 3; i++) {
-                for (int j = 0; j < 2; j++) {
-                        led_write(true);
-                        vTaskDelay(pdMS_TO_TICKS(100));
-                        led_write(false);
-                        vTaskDelay(pdMS_TO_TICKS(100));
-                }
-                vTaskDelay(pdMS_TO_TICKS(250));
-        }
+static indicator_handle_t identify_indicator;
+
+static void identify_restore(void *context) {
         led_write(led_on);
-        vTaskDelete(NULL);
 }
 
 void accessory_identify(homekit_value_t _value) {
         ESP_LOGI(TAG, "Accessory identify");
-        xTaskCreate(accessory_identify_task, "identify", configMINIMAL_STACK_SIZE, NULL, 2, NULL);
+        indicator_play(identify_indicator, &indicator_pattern_identify);
+}
+
+static void identify_init(void) {
+        const indicator_config_t identify_config = INDICATOR_CONFIG_GPIO(LED_GPIO, identify_restore, NULL);
+        ESP_ERROR_CHECK(indicator_create(&identify_config, &identify_indicator));
 }
 
 // HomeKit callbacks
+homekit_value_t led_on_get();
+void led_on_set(homekit_value_t value);
+
+homekit_characteristic_t lightbulb_on = HOMEKIT_CHARACTERISTIC_(ON, false, .getter = led_on_get, .setter = led_on_set);
+
 homekit_value_t led_on_get() {
         return HOMEKIT_BOOL(led_on);
 }
@@ -137,6 +113,29 @@ void led_on_set(homekit_value_t value) {
         led_write(led_on);
 }
 
+// Reset button: a short press toggles the LED, holding it erases the configuration
+static void reset_button_press(void) {
+        led_on = !led_on;
+        led_write(led_on);
+        homekit_characteristic_notify(&lightbulb_on, HOMEKIT_BOOL(led_on));
+}
+
+static void reset_button_cancel(void) {
+        led_write(led_on);
+}
+
+void button_init() {
+        const reset_button_config_t reset_config = {
+                .gpio = BUTTON_GPIO,
+                .hold_ms = RESET_HOLD_MS,
+                .led_write = led_write,
+                .on_press = reset_button_press,
+                .on_confirm = factory_reset,
+                .on_cancel = reset_button_cancel,
+        };
+        ESP_ERROR_CHECK(reset_button_init(&reset_config));
+}
+
 // HomeKit metadata
 #define DEVICE_NAME "LED"
 #define DEVICE_MANUFACTURER "StudioPieters®"
@@ -165,7 +164,7 @@ homekit_accessory_t *accessories[] = {
                 }),
                 HOMEKIT_SERVICE(LIGHTBULB, .primary = true, .characteristics = (homekit_characteristic_t*[]) {
                         HOMEKIT_CHARACTERISTIC(NAME, DEVICE_NAME),
-                        HOMEKIT_CHARACTERISTIC(ON, false, .getter = led_on_get, .setter = led_on_set),
+                        &lightbulb_on,
                         NULL
                 }),
                 NULL
@@ -174,20 +173,35 @@ homekit_accessory_t *accessories[] = {
 };
 #pragma GCC diagnostic pop
 
+static void on_homekit_event(homekit_event_t event) {
+        if (event == HOMEKIT_EVENT_CLIENT_CONNECTED) {
+                boot_trace_complete("hap_connected");
+        }
+}
+
 homekit_server_config_t config = {
         .accessories = accessories,
         .password = CONFIG_ESP_SETUP_CODE,
         .setupId = CONFIG_ESP_SETUP_ID,
+        .on_event = on_homekit_event,
 };
 
 void on_wifi_ready() {
+        boot_trace_mark("on_wifi_ready");
         ESP_LOGI(TAG, "WiFi ready, starting HomeKit");
         homekit_server_init(&config);
 }
 
 void app_main(void) {
+        boot_trace_init();
         ESP_ERROR_CHECK(nvs_flash_init());
+        boot_trace_mark("nvs_flash_init");
         gpio_init();
-        xTaskCreate(button_task, "button_task", 2048, NULL, 10, NULL);
+        boot_trace_mark("gpio_init");
+        identify_init();
+        boot_trace_mark("identify_init");
+        button_init();
+        boot_trace_mark("button_init");
         wifi_config_init(DEVICE_NAME, NULL, on_wifi_ready);
+        boot_trace_mark("wifi_init");
 }
@@ -0,0 +1,110 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <esp_log.h>
+#include <button_gesture.h>
+#include "reset_button.h"
+
+// The LED starts blinking once the long press is recognised and speeds up from
+// RESET_BLINK_SLOW_MS to RESET_BLINK_FAST_MS until the reset is confirmed
+#define RESET_STEP_MS 100
+#define RESET_BLINK_SLOW_MS 800
+#define RESET_BLINK_FAST_MS 200
+
+static const char *TAG = "reset_button";
+
+// Driven by esp_timer deadlines from the gesture engine
+static reset_button_config_t config;
+static uint32_t long_press_ms;
+static uint32_t held_ms;
+static uint32_t blink_ms;
+static bool led;
+static bool holding = false;        // a long press started this gesture
+static bool confirmed = false;
+
+static void button_callback(button_gesture_event_t event, void *context) {
+        if (confirmed) {
+                return;
+        }
+        switch (event) {
+        case BUTTON_GESTURE_SINGLE_PRESS:
+                config.on_press();
+                break;
+        case BUTTON_GESTURE_LONG_PRESS:
+                ESP_LOGW(TAG, "Keep holding the button to reset the configuration");
+                holding = true;
+                held_ms = long_press_ms;
+                blink_ms = 0;
+                led = true;
+                config.led_write(led);
+                break;
+        case BUTTON_GESTURE_HOLD_REPEAT:
+                if (!holding) {
+                        break;
+                }
+                held_ms += RESET_STEP_MS;
+                if (held_ms >= config.hold_ms) {
+                        confirmed = true;
+                        config.led_write(true);
+                        ESP_LOGW(TAG, "BUTTON HELD → RESETTING CONFIGURATION");
+                        config.on_confirm();
+                        break;
+                }
+                // Half period shrinks linearly with the hold progress
+                uint32_t span = config.hold_ms - long_press_ms;
+                uint32_t progress = held_ms - long_press_ms;
+                uint32_t half_period = (RESET_BLINK_SLOW_MS - (RESET_BLINK_SLOW_MS - RESET_BLINK_FAST_MS) * progress / span) / 2;
+                blink_ms += RESET_STEP_MS;
+                if (blink_ms >= half_period) {
+                        blink_ms = 0;
+                        led = !led;
+                        config.led_write(led);
+                }
+                break;
+        case BUTTON_GESTURE_LONG_RELEASE:
+                if (!holding) {
+                        break;
+                }
+                holding = false;
+                ESP_LOGI(TAG, "Reset cancelled");
+                config.on_cancel();
+                break;
+        default:
+                break;
+        }
+}
+
+esp_err_t reset_button_init(const reset_button_config_t *reset_config) {
+        config = *reset_config;
+
+        button_gesture_config_t button_config = BUTTON_GESTURE_CONFIG_DEFAULT(config.gpio, button_callback, NULL);
+        button_config.double_press_ms = 0;
+        button_config.hold_repeat_ms = RESET_STEP_MS;
+        long_press_ms = button_config.long_press_ms;
+        if (config.hold_ms <= long_press_ms) {
+                return ESP_ERR_INVALID_ARG;
+        }
+
+        button_gesture_handle_t button;
+        return button_gesture_create(&button_config, &button);
+}
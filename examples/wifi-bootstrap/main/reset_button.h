@@ -0,0 +1,42 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <driver/gpio.h>
+
+// Hold-to-confirm reset button. A short press toggles, a long press starts the countdown and the
+// LED blinks faster until the button has been held for `hold_ms`; releasing earlier cancels.
+typedef struct {
+        gpio_num_t gpio;
+        uint32_t hold_ms;               // from the press until the reset is confirmed
+        void (*led_write)(bool on);
+        void (*on_press)(void);         // short press
+        void (*on_confirm)(void);       // held for hold_ms; later presses are ignored
+        void (*on_cancel)(void);        // released during the countdown
+} reset_button_config_t;
+
+esp_err_t reset_button_init(const reset_button_config_t *config);
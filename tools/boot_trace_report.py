@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+#
+# Copyright 2025 Achim Pieters | StudioPieters®
+#
+# Compare boot timelines printed by the esp32-boot-trace component.
+#
+# Capture the serial output of one or more boots per example or build, e.g.
+#   idf.py monitor | tee led-1.0.0.log
+# and compare the captures:
+#   tools/boot_trace_report.py led-1.0.0.log led-1.1.0.log --threshold-ms 50
+#
+# A capture can be labelled explicitly with LABEL=FILE; otherwise every
+# project/version pair found in the log becomes its own column. The first
+# column is the baseline unless --baseline is given. With --threshold-ms the
+# script exits with status 1 when any phase in any column finishes later than
+# in the baseline by more than the threshold.
+#
+# for more information visit https://www.studiopieters.nl
+
+import argparse
+import re
+import statistics
+import sys
+from collections import OrderedDict
+
+LINE = re.compile(r'BOOT_TRACE: ([^,\s]+),([^,]*),(\d+),([^,\s]+),(\d+)')
+
+
+def parse(path, label=None):
+    """Return {label: {boot: OrderedDict(phase -> first time_us)}} for one capture."""
+    timelines = OrderedDict()
+    with open(path, errors='replace') as capture:
+        for line in capture:
+            match = LINE.search(line)
+            if not match:
+                continue
+            project, version, boot, phase, time_us = match.groups()
+            key = label or '%s %s' % (project, version)
+            boots = timelines.setdefault(key, OrderedDict())
+            phases = boots.setdefault(int(boot), OrderedDict())
+            # Repeated events (e.g. sta_disconnected) keep their first timestamp
+            phases.setdefault(phase, int(time_us))
+    return timelines
+
+
+def summarise(boots):
+    """Median time per phase across all boots of one column, in milliseconds."""
+    samples = OrderedDict()
+    for phases in boots.values():
+        for phase, time_us in phases.items():
+            samples.setdefault(phase, []).append(time_us / 1000.0)
+    return OrderedDict((phase, statistics.median(values)) for phase, values in samples.items())
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compare esp32-boot-trace timelines.')
+    parser.add_argument('captures', nargs='+', metavar='[LABEL=]FILE',
+                        help='serial log containing BOOT_TRACE lines')
+    parser.add_argument('--baseline', help='column to compare against (default: the first)')
+    parser.add_argument('--threshold-ms', type=float,
+                        help='fail when a phase is this much later than in the baseline')
+    args = parser.parse_args()
+
+    columns = OrderedDict()
+    for capture in args.captures:
+        label, path = capture.split('=', 1) if '=' in capture else (None, capture)
+        for key, boots in parse(path, label).items():
+            columns.setdefault(key, OrderedDict()).update(boots)
+    if not columns:
+        sys.exit('No BOOT_TRACE lines found')
+
+    summaries = OrderedDict((key, summarise(boots)) for key, boots in columns.items())
+    baseline = args.baseline or next(iter(summaries))
+    if baseline not in summaries:
+        sys.exit('Unknown baseline %r, choose from: %s' % (baseline, ', '.join(summaries)))
+
+    phases = []
+    for summary in summaries.values():
+        phases.extend(phase for phase in summary if phase not in phases)
+
+    width = max(len(phase) for phase in phases) + 2
+    header = 'phase'.ljust(width) + ''.join(key[:22].rjust(24) for key in summaries)
+    print(header)
+    print('boots'.ljust(width) + ''.join(str(len(columns[key])).rjust(24) for key in summaries))
+    print('-' * len(header))
+
+    regressions = []
+    for phase in phases:
+        row = phase.ljust(width)
+        reference = summaries[baseline].get(phase)
+        for key, summary in summaries.items():
+            value = summary.get(phase)
+            if value is None:
+                cell = '-'
+            elif key == baseline or reference is None:
+                cell = '%.1f ms' % value
+            else:
+                delta = value - reference
+                cell = '%.1f ms (%+.1f)' % (value, delta)
+                if args.threshold_ms is not None and delta > args.threshold_ms:
+                    regressions.append((key, phase, delta))
+            row += cell.rjust(24)
+        print(row)
+
+    for key, phase, delta in regressions:
+        print('REGRESSION: %s %s is %.1f ms later than %s' % (key, phase, delta, baseline))
+    return 1 if regressions else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
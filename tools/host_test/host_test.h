@@ -0,0 +1,57 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stdio.h>
+
+// Checks for the host tests. A failed check is reported and the test goes on; main() returns
+// host_test_result() so ctest sees the failure.
+
+static int host_test_failures;
+
+#define CHECK(condition) do { \
+                if (!(condition)) { \
+                        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+                        host_test_failures++; \
+                } \
+} while (0)
+
+// Also print both values; for integers
+#define CHECK_EQ(actual, expected) do { \
+                long long actual_ = (actual), expected_ = (expected); \
+                if (actual_ != expected_) { \
+                        fprintf(stderr, "%s:%d: check failed: %s == %s (%lld != %lld)\n", __FILE__, __LINE__, \
+                                #actual, #expected, actual_, expected_); \
+                        host_test_failures++; \
+                } \
+} while (0)
+
+static inline int host_test_result(const char *name) {
+        if (host_test_failures) {
+                fprintf(stderr, "%s: %d checks failed\n", name, host_test_failures);
+                return 1;
+        }
+        fprintf(stderr, "%s: passed\n", name);
+        return 0;
+}
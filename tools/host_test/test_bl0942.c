@@ -0,0 +1,223 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <string.h>
+#include <bl0942.h>
+#include "host_test.h"
+
+// Recorded packet streams replayed through the BL0942 parser: clean streams decode every packet,
+// a bad checksum costs that packet only, and a header byte in the data never yields a packet
+// that was not sent.
+
+#define ADDRESS 0
+#define READ_COMMAND 0x58
+
+typedef struct {
+        uint8_t bytes[BL0942_PACKET_SIZE];
+        bl0942_packet_t packet;
+} frame_t;
+
+static void put(uint8_t *bytes, uint32_t value) {
+        bytes[0] = value;
+        bytes[1] = value >> 8;
+        bytes[2] = value >> 16;
+}
+
+// A packet as the chip sends it; `seed` varies the registers
+static void frame(frame_t *frame, uint32_t seed) {
+        frame->packet = (bl0942_packet_t) {
+                .i_rms = 0x012345 + seed * 0x111,
+                .v_rms = 0x2a1b0c + seed,
+                .i_fast_rms = 0x013344 + seed * 7,
+                .watt = seed & 1 ? -1000 - (int32_t)seed : 2000 + (int32_t)seed,
+                .cf_count = 0x000100 + seed * 3,
+                .frequency = 20000 - seed,
+                .status = 0,
+        };
+        const bl0942_packet_t *packet = &frame->packet;
+        uint8_t *bytes = frame->bytes;
+        bytes[0] = BL0942_PACKET_HEADER;
+        put(&bytes[1], packet->i_rms);
+        put(&bytes[4], packet->v_rms);
+        put(&bytes[7], packet->i_fast_rms);
+        put(&bytes[10], (uint32_t)packet->watt & 0xFFFFFF);
+        put(&bytes[13], packet->cf_count);
+        put(&bytes[16], packet->frequency);
+        put(&bytes[19], packet->status);
+        uint8_t sum = READ_COMMAND | ADDRESS;
+        for (int i = 0; i < BL0942_PACKET_SIZE - 1; i++) {
+                sum += bytes[i];
+        }
+        bytes[BL0942_PACKET_SIZE - 1] = ~sum;
+}
+
+static bool same(const bl0942_packet_t *a, const bl0942_packet_t *b) {
+        return a->i_rms == b->i_rms && a->v_rms == b->v_rms && a->i_fast_rms == b->i_fast_rms &&
+               a->watt == b->watt && a->cf_count == b->cf_count && a->frequency == b->frequency &&
+               a->status == b->status;
+}
+
+// Feed `stream` and check every packet that comes out against `expected`, in order; returns
+// how many came out
+static uint32_t replay(bl0942_parser_t *parser, const uint8_t *stream, size_t size, const frame_t *expected,
+                       uint32_t expected_count) {
+        uint32_t count = 0;
+
+        for (size_t i = 0; i < size; i++) {
+                bl0942_packet_t packet;
+                if (bl0942_parser_push(parser, stream[i], &packet)) {
+                        CHECK(count < expected_count);
+                        if (count < expected_count) {
+                                CHECK(same(&packet, &expected[count].packet));
+                        }
+                        count++;
+                }
+        }
+        return count;
+}
+
+static void test_clean(void) {
+        frame_t frames[8];
+        uint8_t stream[8 * BL0942_PACKET_SIZE + 3];
+        bl0942_parser_t parser;
+
+        for (int i = 0; i < 8; i++) {
+                frame(&frames[i], i);
+                memcpy(stream + 3 + i * BL0942_PACKET_SIZE, frames[i].bytes, BL0942_PACKET_SIZE);
+        }
+        bl0942_parser_init(&parser, ADDRESS);
+        CHECK_EQ(replay(&parser, stream + 3, sizeof(stream) - 3, frames, 8), 8);
+        CHECK_EQ(parser.packets, 8);
+        CHECK_EQ(parser.checksum_errors, 0);
+        CHECK_EQ(parser.discarded, 0);
+
+        // Line noise before the first header is dropped byte by byte
+        stream[0] = 0x00;
+        stream[1] = 0xFF;
+        stream[2] = 0xAA;
+        bl0942_parser_init(&parser, ADDRESS);
+        CHECK_EQ(replay(&parser, stream, sizeof(stream), frames, 8), 8);
+        CHECK_EQ(parser.packets, 8);
+        CHECK_EQ(parser.checksum_errors, 0);
+        CHECK_EQ(parser.discarded, 3);
+
+        // A parser set up for another address sums from another command and takes none of them
+        bl0942_parser_init(&parser, ADDRESS + 1);
+        CHECK_EQ(replay(&parser, stream, sizeof(stream), frames, 0), 0);
+        CHECK_EQ(parser.packets, 0);
+        CHECK_EQ(parser.checksum_errors, 8);
+}
+
+static void test_bad_checksum(void) {
+        frame_t frames[4];
+        uint8_t stream[4 * BL0942_PACKET_SIZE];
+        bl0942_parser_t parser;
+
+        for (int i = 0; i < 4; i++) {
+                frame(&frames[i], i);
+                memcpy(stream + i * BL0942_PACKET_SIZE, frames[i].bytes, BL0942_PACKET_SIZE);
+        }
+        // None of the data holds a header byte, so the whole packet goes
+        stream[BL0942_PACKET_SIZE + 5] ^= 0x01;
+        bl0942_parser_init(&parser, ADDRESS);
+        const frame_t expected[] = { frames[0], frames[2], frames[3] };
+        CHECK_EQ(replay(&parser, stream, sizeof(stream), expected, 3), 3);
+        CHECK_EQ(parser.packets, 3);
+        CHECK_EQ(parser.checksum_errors, 1);
+        CHECK_EQ(parser.discarded, BL0942_PACKET_SIZE);
+
+        // A flipped checksum byte in every other packet
+        for (int i = 0; i < 4; i += 2) {
+                stream[i * BL0942_PACKET_SIZE + BL0942_PACKET_SIZE - 1] ^= 0x80;
+        }
+        stream[BL0942_PACKET_SIZE + 5] ^= 0x01;
+        bl0942_parser_init(&parser, ADDRESS);
+        const frame_t odd[] = { frames[1], frames[3] };
+        CHECK_EQ(replay(&parser, stream, sizeof(stream), odd, 2), 2);
+        CHECK_EQ(parser.packets, 2);
+        CHECK_EQ(parser.checksum_errors, 2);
+        CHECK_EQ(parser.discarded, 2 * BL0942_PACKET_SIZE);
+}
+
+static void test_header_in_data(void) {
+        frame_t frames[3];
+        uint8_t stream[3 * BL0942_PACKET_SIZE];
+        bl0942_parser_t parser;
+
+        for (int i = 0; i < 3; i++) {
+                frame(&frames[i], i);
+        }
+        // The low voltage byte of the first packet looks like a header
+        frames[0].packet.v_rms = 0x2a1b00 | BL0942_PACKET_HEADER;
+        put(&frames[0].bytes[4], frames[0].packet.v_rms);
+        frames[0].bytes[BL0942_PACKET_SIZE - 1] -= BL0942_PACKET_HEADER - 0x0c;
+        for (int i = 0; i < 3; i++) {
+                memcpy(stream + i * BL0942_PACKET_SIZE, frames[i].bytes, BL0942_PACKET_SIZE);
+        }
+
+        // Whole, it is just data
+        bl0942_parser_init(&parser, ADDRESS);
+        CHECK_EQ(replay(&parser, stream, sizeof(stream), frames, 3), 3);
+        CHECK_EQ(parser.checksum_errors, 0);
+        CHECK_EQ(parser.discarded, 0);
+
+        // Joined after the real header went by, the parser locks onto the data byte, fails the
+        // checksum and carries on from the next real header it already holds
+        bl0942_parser_init(&parser, ADDRESS);
+        CHECK_EQ(replay(&parser, stream + 3, sizeof(stream) - 3, frames + 1, 2), 2);
+        CHECK_EQ(parser.packets, 2);
+        CHECK_EQ(parser.checksum_errors, 1);
+        CHECK_EQ(parser.discarded, 1 + (BL0942_PACKET_SIZE - 4));
+}
+
+// Losing any one byte costs at most the packets it touched, and never gives a wrong one
+static void test_dropped_byte(void) {
+        frame_t frames[4];
+        uint8_t stream[sizeof(frames) / sizeof(frames[0]) * BL0942_PACKET_SIZE];
+        bl0942_parser_t parser;
+
+        for (int i = 0; i < 4; i++) {
+                frame(&frames[i], i + 10);
+                memcpy(stream + i * BL0942_PACKET_SIZE, frames[i].bytes, BL0942_PACKET_SIZE);
+        }
+        for (int drop = 0; drop < BL0942_PACKET_SIZE; drop++) {
+                uint8_t lossy[sizeof(stream) - 1];
+                size_t at = BL0942_PACKET_SIZE + drop;
+                memcpy(lossy, stream, at);
+                memcpy(lossy + at, stream + at + 1, sizeof(stream) - at - 1);
+
+                const frame_t expected[] = { frames[0], frames[2], frames[3] };
+                bl0942_parser_init(&parser, ADDRESS);
+                uint32_t count = replay(&parser, lossy, sizeof(lossy), expected, 3);
+                CHECK(count >= 2);
+                CHECK_EQ(parser.packets, count);
+        }
+}
+
+int main(int argc, char **argv) {
+        test_clean();
+        test_bad_checksum();
+        test_header_in_data();
+        test_dropped_byte();
+        return host_test_result("bl0942");
+}
@@ -0,0 +1,209 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <string.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <button_gesture.h>
+#include "sim.h"
+#include "host_test.h"
+
+// button_gesture on a simulated pin: bouncing presses are driven into the GPIO interrupt and
+// every gesture is checked for its kind and for the virtual time it was reported at.
+
+#define PIN GPIO_NUM_4
+#define DEBOUNCE_MS 20
+#define DOUBLE_PRESS_MS 500
+#define LONG_PRESS_MS 1000
+#define HOLD_REPEAT_MS 200
+#define BOUNCE_US 300               // between the edges of a bounce burst
+#define MS 1000
+
+typedef struct {
+        button_gesture_event_t event;
+        int64_t time_us;
+} gesture_t;
+
+static gesture_t gestures[32];
+static int count;
+
+static void on_gesture(button_gesture_event_t event, void *context) {
+        if (count < (int)(sizeof(gestures) / sizeof(gestures[0]))) {
+                gestures[count] = (gesture_t) { event, esp_timer_get_time() };
+        }
+        count++;
+}
+
+static button_gesture_handle_t create(void) {
+        button_gesture_config_t config = BUTTON_GESTURE_CONFIG_DEFAULT(PIN, on_gesture, NULL);
+        config.debounce_ms = DEBOUNCE_MS;
+        config.double_press_ms = DOUBLE_PRESS_MS;
+        config.long_press_ms = LONG_PRESS_MS;
+        config.hold_repeat_ms = HOLD_REPEAT_MS;
+
+        button_gesture_handle_t button = NULL;
+        CHECK(button_gesture_create(&config, &button) == ESP_OK);
+        count = 0;
+        return button;
+}
+
+// Move the contact to `pressed` with a few bounces on the way; the time of its first edge
+static int64_t contact(bool pressed) {
+        int64_t first_us = esp_timer_get_time();
+        int level = pressed ? 0 : 1;
+
+        for (int bounce = 0; bounce < 3; bounce++) {
+                sim_gpio_set_input(PIN, level);
+                sim_sleep(BOUNCE_US);
+                sim_gpio_set_input(PIN, !level);
+                sim_sleep(BOUNCE_US);
+        }
+        sim_gpio_set_input(PIN, level);
+        return first_us;
+}
+
+static void check_gesture(int index, button_gesture_event_t event, int64_t time_us) {
+        CHECK(index < count);
+        if (index < count) {
+                CHECK_EQ(gestures[index].event, event);
+                CHECK_EQ(gestures[index].time_us, time_us);
+        }
+}
+
+static void test_click(void) {
+        button_gesture_handle_t button = create();
+
+        contact(true);
+        sim_sleep(120 * MS);
+        int64_t release_us = contact(false);
+
+        // Nothing until the double press window has closed
+        sim_sleep(DOUBLE_PRESS_MS * MS - 50 * MS);
+        CHECK_EQ(count, 0);
+        sim_sleep(1000 * MS);
+        CHECK_EQ(count, 1);
+        check_gesture(0, BUTTON_GESTURE_SINGLE_PRESS, release_us + DOUBLE_PRESS_MS * MS);
+
+        button_gesture_delete(button);
+}
+
+static void test_double_click(void) {
+        button_gesture_handle_t button = create();
+
+        contact(true);
+        sim_sleep(80 * MS);
+        contact(false);
+        sim_sleep(150 * MS);
+        contact(true);
+        sim_sleep(80 * MS);
+        int64_t release_us = contact(false);
+        sim_sleep(1000 * MS);
+
+        // Reported once the second release has settled, with no single press before it
+        CHECK_EQ(count, 1);
+        int64_t last_edge_us = release_us + 6 * BOUNCE_US;
+        check_gesture(0, BUTTON_GESTURE_DOUBLE_PRESS, last_edge_us + DEBOUNCE_MS * MS);
+
+        // Two presses further apart than the window are two single presses
+        contact(true);
+        sim_sleep(80 * MS);
+        contact(false);
+        sim_sleep(DOUBLE_PRESS_MS * MS + 100 * MS);
+        contact(true);
+        sim_sleep(80 * MS);
+        contact(false);
+        sim_sleep(1000 * MS);
+        CHECK_EQ(count, 3);
+        CHECK_EQ(gestures[1].event, BUTTON_GESTURE_SINGLE_PRESS);
+        CHECK_EQ(gestures[2].event, BUTTON_GESTURE_SINGLE_PRESS);
+
+        button_gesture_delete(button);
+}
+
+static void test_long_press_and_repeat(void) {
+        button_gesture_handle_t button = create();
+
+        int64_t press_us = contact(true);
+        sim_sleep(LONG_PRESS_MS * MS + 5 * HOLD_REPEAT_MS * MS + 50 * MS);
+        int64_t release_us = contact(false);
+        sim_sleep(1000 * MS);
+
+        // One long press, a repeat every interval after it, and the release; never a click
+        CHECK_EQ(count, 7);
+        check_gesture(0, BUTTON_GESTURE_LONG_PRESS, press_us + LONG_PRESS_MS * MS);
+        for (int repeat = 1; repeat <= 5; repeat++) {
+                check_gesture(repeat, BUTTON_GESTURE_HOLD_REPEAT,
+                              press_us + (LONG_PRESS_MS + repeat * HOLD_REPEAT_MS) * MS);
+        }
+        int64_t last_edge_us = release_us + 6 * BOUNCE_US;
+        check_gesture(6, BUTTON_GESTURE_LONG_RELEASE, last_edge_us + DEBOUNCE_MS * MS);
+
+        button_gesture_delete(button);
+}
+
+static void test_glitch(void) {
+        button_gesture_handle_t button = create();
+
+        // Shorter than the debounce time: the input settles back where it was
+        sim_gpio_set_input(PIN, 0);
+        sim_sleep(5 * MS);
+        sim_gpio_set_input(PIN, 1);
+        sim_sleep(2000 * MS);
+        CHECK_EQ(count, 0);
+
+        button_gesture_delete(button);
+}
+
+static void test_held_at_boot(void) {
+        sim_gpio_set_input(PIN, 0);
+        button_gesture_handle_t button = create();
+
+        // No press time to measure from: no long press, no repeats and no release event
+        sim_sleep(3000 * MS);
+        CHECK_EQ(count, 0);
+        contact(false);
+        sim_sleep(2000 * MS);
+        CHECK_EQ(count, 0);
+
+        // The next press is an ordinary one
+        contact(true);
+        sim_sleep(100 * MS);
+        int64_t release_us = contact(false);
+        sim_sleep(1000 * MS);
+        CHECK_EQ(count, 1);
+        check_gesture(0, BUTTON_GESTURE_SINGLE_PRESS, release_us + DOUBLE_PRESS_MS * MS);
+
+        button_gesture_delete(button);
+}
+
+int main(void) {
+        sim_log_level = ESP_LOG_WARN;
+        sim_gpio_set_input(PIN, 1);
+
+        test_click();
+        test_double_click();
+        test_long_press_and_repeat();
+        test_glitch();
+        test_held_at_boot();
+        return host_test_result("button_gesture");
+}
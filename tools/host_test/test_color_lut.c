@@ -0,0 +1,317 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+#include <color_lut.h>
+#include "host_test.h"
+
+// color_lut against the float conversions it replaced, over every HomeKit hue, saturation and
+// brightness. hsi2rgb is the one light_RGB_strip had and hsi2rgbw the one of the neopixel
+// examples, both copied unchanged; they truncate, so they are also compared against the same
+// formulas in double precision and rounded. Then a benchmark of both on the host.
+
+#define LED_RGB_SCALE 255
+
+typedef struct {
+        int red, green, blue, white;
+} reference_t;
+
+// examples/light_RGB_strip, before color_lut
+static void hsi2rgb(float h, float s, float i, reference_t *rgb) {
+        int r, g, b;
+
+        h = fmodf(h, 360.0F); // cycle h around to 0-360 degrees
+        h = M_PI * h / 180.0F; // convert to radians.
+        s /= 100.0F;       // from percentage to ratio
+        i /= 100.0F;       // from percentage to ratio
+
+        s = fminf(fmaxf(s, 0.0F), 1.0F); // clamp s and i to interval [0,1]
+        i = fminf(fmaxf(i, 0.0F), 1.0F);
+
+        if (h < 2.09439) {
+                r = LED_RGB_SCALE * i / 3 * (1 + s * cosf(h) / cosf(1.047196667 - h));
+                g = LED_RGB_SCALE * i / 3 * (1 + s * (1 - cosf(h) / cosf(1.047196667 - h)));
+                b = LED_RGB_SCALE * i / 3 * (1 - s);
+        } else if (h < 4.188787) {
+                h -= 2.09439;
+                g = LED_RGB_SCALE * i / 3 * (1 + s * cosf(h) / cosf(1.047196667 - h));
+                b = LED_RGB_SCALE * i / 3 * (1 + s * (1 - cosf(h) / cosf(1.047196667 - h)));
+                r = LED_RGB_SCALE * i / 3 * (1 - s);
+        } else {
+                h -= 4.188787;
+                b = LED_RGB_SCALE * i / 3 * (1 + s * cosf(h) / cosf(1.047196667 - h));
+                r = LED_RGB_SCALE * i / 3 * (1 + s * (1 - cosf(h) / cosf(1.047196667 - h)));
+                g = LED_RGB_SCALE * i / 3 * (1 - s);
+        }
+
+        rgb->red = (uint8_t) r;
+        rgb->green = (uint8_t) g;
+        rgb->blue = (uint8_t) b;
+        rgb->white = 0;
+}
+
+// examples/neopixel_rgbw_led_strip, before color_lut
+static void hsi2rgbw(float H, float S, float I, int* rgbw) {
+        int r = 0, g = 0, b = 0, w = 0;
+        float cos_h, cos_1047_h;
+        H = fmod(H, 360);
+        H = M_PI * H / 180;
+        S = fmin(fmax(S, 0), 1);
+        I = fmin(fmax(I, 0), 1);
+
+        if (H < 2.09439) {
+                cos_h = cos(H);
+                cos_1047_h = cos(1.047196667 - H);
+                r = S * 255 * I / 3 * (1 + cos_h / cos_1047_h);
+                g = S * 255 * I / 3 * (1 + (1 - cos_h / cos_1047_h));
+                w = 255 * (1 - S) * I;
+        } else if (H < 4.188787) {
+                H -= 2.09439;
+                cos_h = cos(H);
+                cos_1047_h = cos(1.047196667 - H);
+                g = S * 255 * I / 3 * (1 + cos_h / cos_1047_h);
+                b = S * 255 * I / 3 * (1 + (1 - cos_h / cos_1047_h));
+                w = 255 * (1 - S) * I;
+        } else {
+                H -= 4.188787;
+                cos_h = cos(H);
+                cos_1047_h = cos(1.047196667 - H);
+                b = S * 255 * I / 3 * (1 + cos_h / cos_1047_h);
+                r = S * 255 * I / 3 * (1 + (1 - cos_h / cos_1047_h));
+                w = 255 * (1 - S) * I;
+        }
+
+        rgbw[0] = r;
+        rgbw[1] = g;
+        rgbw[2] = b;
+        rgbw[3] = w;
+}
+
+// The HSI formulas in double precision with exact sector bounds, unrounded, on a 0-1 scale
+static void hsi_exact(int hue, int saturation, int brightness, bool white, double channels[4]) {
+        int sector = hue / 120;
+        double h = (hue % 120) * M_PI / 180;
+        double s = saturation / 100.0, i = brightness / 100.0;
+        double ratio = cos(h) / cos(M_PI / 3 - h);
+        double first, second, third, w = 0;
+
+        if (white) {
+                first = s * i / 3 * (1 + ratio);
+                second = s * i / 3 * (2 - ratio);
+                third = 0;
+                w = (1 - s) * i;
+        } else {
+                first = i / 3 * (1 + s * ratio);
+                second = i / 3 * (1 + s * (1 - ratio));
+                third = i / 3 * (1 - s);
+        }
+        channels[sector] = first;
+        channels[(sector + 1) % 3] = second;
+        channels[(sector + 2) % 3] = third;
+        channels[3] = w;
+}
+
+typedef struct {
+        const char *name;
+        int max_error;              // in output steps
+        double total_error;
+        uint32_t count;
+        uint32_t off;               // channels not exactly equal
+} error_t;
+
+static void compare(error_t *error, int actual, int expected) {
+        int delta = abs(actual - expected);
+        if (delta > error->max_error) {
+                error->max_error = delta;
+        }
+        error->total_error += delta;
+        error->count++;
+        error->off += delta != 0;
+}
+
+static void print_error(const error_t *error, int bound) {
+        printf("  %-36s max %4d, mean %.4f, %5.2f %% of channels differ (bound %d)\n", error->name,
+               error->max_error, error->total_error / error->count, 100.0 * error->off / error->count, bound);
+        CHECK(error->max_error <= bound);
+}
+
+static void test_accuracy(void) {
+        error_t rgb_legacy = { "hsi_to_rgb vs hsi2rgb" };
+        error_t rgb_exact = { "hsi_to_rgb vs exact" };
+        error_t rgbw_legacy = { "hsi_to_rgbw vs hsi2rgbw" };
+        error_t rgbw_exact = { "hsi_to_rgbw vs exact" };
+        error_t rgb16_exact = { "hsi_to_rgb16 vs exact" };
+        error_t rgb16_rgb = { "hsi_to_rgb16 / 257 vs hsi_to_rgb" };
+
+        for (int hue = 0; hue < 360; hue++) {
+                for (int saturation = 0; saturation <= 100; saturation++) {
+                        for (int brightness = 0; brightness <= 100; brightness++) {
+                                color_rgbw_t rgb, rgbw;
+                                color_rgbw16_t rgb16;
+                                color_lut_hsi_to_rgb(hue, saturation, brightness, &rgb);
+                                color_lut_hsi_to_rgbw(hue, saturation, brightness, &rgbw);
+                                color_lut_hsi_to_rgb16(hue, saturation, brightness, &rgb16);
+
+                                reference_t legacy;
+                                hsi2rgb(hue, saturation, brightness, &legacy);
+                                compare(&rgb_legacy, rgb.red, legacy.red);
+                                compare(&rgb_legacy, rgb.green, legacy.green);
+                                compare(&rgb_legacy, rgb.blue, legacy.blue);
+
+                                int legacy_rgbw[4];
+                                hsi2rgbw(hue, saturation / 100.0, brightness / 100.0, legacy_rgbw);
+                                compare(&rgbw_legacy, rgbw.red, legacy_rgbw[0]);
+                                compare(&rgbw_legacy, rgbw.green, legacy_rgbw[1]);
+                                compare(&rgbw_legacy, rgbw.blue, legacy_rgbw[2]);
+                                compare(&rgbw_legacy, rgbw.white, legacy_rgbw[3]);
+
+                                double exact[4];
+                                hsi_exact(hue, saturation, brightness, false, exact);
+                                compare(&rgb_exact, rgb.red, lround(exact[0] * 255));
+                                compare(&rgb_exact, rgb.green, lround(exact[1] * 255));
+                                compare(&rgb_exact, rgb.blue, lround(exact[2] * 255));
+                                compare(&rgb16_exact, rgb16.red, lround(exact[0] * 65535));
+                                compare(&rgb16_exact, rgb16.green, lround(exact[1] * 65535));
+                                compare(&rgb16_exact, rgb16.blue, lround(exact[2] * 65535));
+                                CHECK_EQ(rgb16.white, 0);
+                                compare(&rgb16_rgb, (rgb16.red + 128) / 257, rgb.red);
+                                compare(&rgb16_rgb, (rgb16.green + 128) / 257, rgb.green);
+                                compare(&rgb16_rgb, (rgb16.blue + 128) / 257, rgb.blue);
+
+                                hsi_exact(hue, saturation, brightness, true, exact);
+                                compare(&rgbw_exact, rgbw.red, lround(exact[0] * 255));
+                                compare(&rgbw_exact, rgbw.green, lround(exact[1] * 255));
+                                compare(&rgbw_exact, rgbw.blue, lround(exact[2] * 255));
+                                compare(&rgbw_exact, rgbw.white, lround(exact[3] * 255));
+                        }
+                }
+        }
+
+        printf("%lu inputs, per channel:\n", (unsigned long)rgb_legacy.count / 3);
+        // The old code truncated where the table rounds: one step either way
+        print_error(&rgb_legacy, 1);
+        print_error(&rgbw_legacy, 1);
+        print_error(&rgb_exact, 1);
+        print_error(&rgbw_exact, 1);
+        // 16 bits show the table's own resolution, 1/8192 of the ratio
+        print_error(&rgb16_exact, 2);
+        print_error(&rgb16_rgb, 1);
+
+        // Hue wraps and saturation and brightness clamp like the float code
+        color_rgbw_t wrapped, plain, clamped, full;
+        color_lut_hsi_to_rgb(400, 60, 70, &wrapped);
+        color_lut_hsi_to_rgb(40, 60, 70, &plain);
+        CHECK(wrapped.red == plain.red && wrapped.green == plain.green && wrapped.blue == plain.blue);
+        color_lut_hsi_to_rgb(200, 150, 250, &clamped);
+        color_lut_hsi_to_rgb(200, 100, 100, &full);
+        CHECK(clamped.red == full.red && clamped.green == full.green && clamped.blue == full.blue);
+}
+
+static volatile uint32_t sink;
+
+static double seconds_since(const struct timespec *start) {
+        struct timespec end;
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Nanoseconds per conversion over the whole input range, on this host; an ESP32 without an
+// FPU for double (hsi2rgbw) or with a slow cosf gains far more than this shows
+static void benchmark(void) {
+        const int rounds = 3;
+        const uint32_t conversions = rounds * 360 * 101 * 101;
+        struct timespec start;
+        uint32_t sum = 0;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int round = 0; round < rounds; round++) {
+                for (int hue = 0; hue < 360; hue++) {
+                        for (int saturation = 0; saturation <= 100; saturation++) {
+                                for (int brightness = 0; brightness <= 100; brightness++) {
+                                        reference_t legacy;
+                                        hsi2rgb(hue, saturation, brightness, &legacy);
+                                        sum += legacy.red + legacy.green + legacy.blue;
+                                }
+                        }
+                }
+        }
+        double legacy_s = seconds_since(&start);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int round = 0; round < rounds; round++) {
+                for (int hue = 0; hue < 360; hue++) {
+                        for (int saturation = 0; saturation <= 100; saturation++) {
+                                for (int brightness = 0; brightness <= 100; brightness++) {
+                                        int rgbw[4];
+                                        hsi2rgbw(hue, saturation / 100.0, brightness / 100.0, rgbw);
+                                        sum += rgbw[0] + rgbw[1] + rgbw[2] + rgbw[3];
+                                }
+                        }
+                }
+        }
+        double legacy_rgbw_s = seconds_since(&start);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int round = 0; round < rounds; round++) {
+                for (int hue = 0; hue < 360; hue++) {
+                        for (int saturation = 0; saturation <= 100; saturation++) {
+                                for (int brightness = 0; brightness <= 100; brightness++) {
+                                        color_rgbw_t color;
+                                        color_lut_hsi_to_rgb(hue, saturation, brightness, &color);
+                                        sum += color.red + color.green + color.blue;
+                                }
+                        }
+                }
+        }
+        double lut_s = seconds_since(&start);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int round = 0; round < rounds; round++) {
+                for (int hue = 0; hue < 360; hue++) {
+                        for (int saturation = 0; saturation <= 100; saturation++) {
+                                for (int brightness = 0; brightness <= 100; brightness++) {
+                                        color_rgbw_t color;
+                                        color_lut_hsi_to_rgbw(hue, saturation, brightness, &color);
+                                        sum += color.red + color.green + color.blue + color.white;
+                                }
+                        }
+                }
+        }
+        double lut_rgbw_s = seconds_since(&start);
+        sink = sum;
+
+        printf("host time per conversion:\n");
+        printf("  hsi2rgb     %6.1f ns   color_lut_hsi_to_rgb  %6.1f ns\n", legacy_s * 1e9 / conversions,
+               lut_s * 1e9 / conversions);
+        printf("  hsi2rgbw    %6.1f ns   color_lut_hsi_to_rgbw %6.1f ns\n", legacy_rgbw_s * 1e9 / conversions,
+               lut_rgbw_s * 1e9 / conversions);
+}
+
+int main(int argc, char **argv) {
+        test_accuracy();
+        benchmark();
+        return host_test_result("color_lut");
+}
@@ -0,0 +1,165 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <math.h>
+#include <esp_timer.h>
+#include <nvs.h>
+#include <bl0942.h>
+#include <energy_meter.h>
+#include "sim.h"
+#include "host_test.h"
+
+// A year of a household plug on the virtual clock and the NVS fake: how often the energy meter
+// writes flash, and how much a power cut could lose at any moment. Samples come every 10 s
+// instead of every 200 ms, which moves a checkpoint by at most one sample and keeps the run short.
+
+#define SAMPLE_S 10
+#define DAYS 365
+#define DAY_S (24 * 3600)
+#define FULL_LOAD_W 3680            // 16 A at 230 V
+#define FULL_LOAD_DAY 100
+#define AWAY_FIRST_DAY 200          // two weeks with everything switched off
+#define AWAY_LAST_DAY 213
+
+// Same namespace and key as energy_meter.c
+#define ENERGY_NAMESPACE "energy"
+#define ENERGY_KEY "total_uwh"
+
+static double load_w(int day, int second) {
+        if (day >= AWAY_FIRST_DAY && day <= AWAY_LAST_DAY) {
+                return 0;
+        }
+        if (day == FULL_LOAD_DAY) {
+                return FULL_LOAD_W;
+        }
+        int minute = second / 60;
+        if (minute >= 7 * 60 && minute < 7 * 60 + 5) {
+                return 2000;                // kettle
+        }
+        if (day % 7 >= 5 && minute >= 12 * 60 && minute < 16 * 60) {
+                return 2000;                // heater at the weekend
+        }
+        if (minute >= 18 * 60 && minute < 22 * 60) {
+                return 350;                 // television and lamps
+        }
+        return 3;                           // standby
+}
+
+static uint64_t stored_uwh(void) {
+        nvs_handle_t handle;
+        uint64_t value = 0;
+
+        if (nvs_open(ENERGY_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+                nvs_get_u64(handle, ENERGY_KEY, &value);
+                nvs_close(handle);
+        }
+        return value;
+}
+
+int main(int argc, char **argv) {
+        const bl0942_reference_t reference = BL0942_REFERENCE_DEFAULT;
+        const energy_meter_config_t config = ENERGY_METER_CONFIG_DEFAULT(0);
+        bl0942_gains_t gains;
+        sim_nvs_stats_t before, after;
+
+        sim_nvs_erase_all();
+        bl0942_gains_from_reference(&reference, &gains);
+        energy_meter_config_t meter_config = config;
+        meter_config.uwh_per_pulse = gains.energy;
+        CHECK(energy_meter_init(&meter_config) == ESP_OK);
+
+        // What a power cut may lose (see energy_meter.h): checkpoint_wh, or what full load draws in
+        // checkpoint_min_s when that is more, plus the sample a due checkpoint waits for
+        const uint64_t full_load_uwh = (uint64_t)FULL_LOAD_W * config.checkpoint_min_s * 1000000 / 3600;
+        const uint64_t threshold_uwh = (uint64_t)config.checkpoint_wh * 1000000;
+        const uint64_t loss_max_uwh = (full_load_uwh > threshold_uwh ? full_load_uwh : threshold_uwh) +
+                                      (uint64_t)FULL_LOAD_W * SAMPLE_S * 1000000 / 3600;
+        double pulses = 0;
+        uint64_t stored = 0;
+        uint32_t inline_writes = 0, loss_violations = 0, max_day_writes = 0, away_writes = 0;
+        uint32_t full_load_writes = 0;
+        uint64_t max_loss_uwh = 0;
+
+        for (int day = 0; day < DAYS; day++) {
+                uint32_t day_writes = 0;
+                for (int second = 0; second < DAY_S; second += SAMPLE_S) {
+                        pulses += load_w(day, second) * SAMPLE_S / 3600 * 1e6 / gains.energy;
+                        const bl0942_sample_t sample = {
+                                .cf_count = (uint32_t)pulses & 0xFFFFFF,
+                                .time_us = esp_timer_get_time(),
+                        };
+
+                        // The sampling task only wakes the checkpoint task, it never writes itself
+                        sim_nvs_get_stats(&before);
+                        energy_meter_add(&sample);
+                        sim_nvs_get_stats(&after);
+                        inline_writes += after.writes != before.writes;
+                        sim_sleep(SAMPLE_S * 1000000LL);
+
+                        uint64_t value = stored_uwh();
+                        if (value != stored) {
+                                stored = value;
+                                day_writes++;
+                        }
+
+                        // What a power cut now would lose
+                        uint64_t loss_uwh = llround(energy_meter_get_kwh() * 1e9) - stored;
+                        if (loss_uwh > loss_max_uwh) {
+                                loss_violations++;
+                        }
+                        if (loss_uwh > max_loss_uwh) {
+                                max_loss_uwh = loss_uwh;
+                        }
+                }
+                if (day_writes > max_day_writes) {
+                        max_day_writes = day_writes;
+                }
+                if (day >= AWAY_FIRST_DAY && day <= AWAY_LAST_DAY) {
+                        away_writes += day_writes;
+                }
+                if (day == FULL_LOAD_DAY) {
+                        full_load_writes = day_writes;
+                }
+        }
+
+        sim_nvs_get_stats(&after);
+        CHECK_EQ(inline_writes, 0);
+        CHECK_EQ(loss_violations, 0);
+        CHECK(max_day_writes <= DAY_S / config.checkpoint_min_s);
+        // Nothing drawn, nothing written
+        CHECK_EQ(away_writes, 0);
+        // Flat out, every checkpoint waits out the minimum interval and no more
+        CHECK(full_load_writes >= DAY_S / (config.checkpoint_min_s + SAMPLE_S));
+        CHECK(full_load_writes <= DAY_S / config.checkpoint_min_s);
+        CHECK_EQ(after.writes, after.commits);
+
+        // A planned power down stores the rest
+        CHECK(energy_meter_checkpoint() == ESP_OK);
+        CHECK_EQ(stored_uwh(), llround(energy_meter_get_kwh() * 1e9));
+
+        fprintf(stderr, "energy_meter: %.1f kWh in %d days, %lu checkpoints (%lu on the busiest day), "
+                "%llu bytes written, at most %.1f Wh at risk\n", energy_meter_get_kwh(), DAYS,
+                (unsigned long)after.writes, (unsigned long)max_day_writes, (unsigned long long)after.bytes,
+                max_loss_uwh / 1e6);
+        return host_test_result("energy_meter");
+}
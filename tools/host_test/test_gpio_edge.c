@@ -0,0 +1,207 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <string.h>
+#include <time.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <gpio_edge.h>
+#include "sim.h"
+#include "host_test.h"
+
+// The gpio_edge ring between the interrupt and the dispatch task. Edges are driven into the
+// ISR from the scenario; the dispatch task only runs when the scenario lets time pass, so a
+// burst without a pause is a burst the task could not keep up with.
+
+#define PIN_A GPIO_NUM_4
+#define PIN_B GPIO_NUM_5
+#define RING_SIZE 64                // CONFIG_GPIO_EDGE_RING_SIZE, a power of two already
+
+typedef struct {
+        int count;
+        int64_t last_time_us;
+        uint8_t last_level[GPIO_NUM_MAX];
+        bool in_order;
+        int64_t cost_us;            // virtual time each callback takes
+} sink_t;
+
+static sink_t sink;
+
+static void on_edge(const gpio_edge_event_t *event, void *context) {
+        if (event->time_us < sink.last_time_us || event->level == sink.last_level[event->gpio]) {
+                sink.in_order = false;
+        }
+        sink.last_time_us = event->time_us;
+        sink.last_level[event->gpio] = event->level;
+        sink.count++;
+        if (sink.cost_us) {
+                sim_sleep(sink.cost_us);
+        }
+}
+
+static void reset_sink(int64_t cost_us) {
+        memset(&sink, 0, sizeof(sink));
+        sink.in_order = true;
+        sink.last_level[PIN_A] = sink.last_level[PIN_B] = 1;
+        sink.last_time_us = esp_timer_get_time();
+        sink.cost_us = cost_us;
+}
+
+static uint8_t level[GPIO_NUM_MAX];
+
+static void toggle(gpio_num_t gpio) {
+        level[gpio] = !level[gpio];
+        sim_gpio_set_input(gpio, level[gpio]);
+}
+
+static gpio_edge_stats_t stats_since(const gpio_edge_stats_t *before) {
+        gpio_edge_stats_t now;
+        gpio_edge_get_stats(&now);
+        return (gpio_edge_stats_t) {
+                .captured = now.captured - before->captured,
+                .dispatched = now.dispatched - before->dispatched,
+                .overflows = now.overflows - before->overflows,
+                .high_water = now.high_water,
+        };
+}
+
+static void test_flood(void) {
+        gpio_edge_stats_t before, stats;
+        gpio_edge_get_stats(&before);
+        reset_sink(0);
+
+        // Three rings' worth from two pins, all inside one interrupt burst
+        for (int edge = 0; edge < 3 * RING_SIZE; edge++) {
+                toggle(edge % 2 ? PIN_B : PIN_A);
+        }
+        stats = stats_since(&before);
+        CHECK_EQ(stats.captured, RING_SIZE);
+        CHECK_EQ(stats.overflows, 2 * RING_SIZE);
+        CHECK_EQ(stats.high_water, RING_SIZE);
+        CHECK_EQ(gpio_edge_get_overflows(PIN_A), RING_SIZE);
+        CHECK_EQ(gpio_edge_get_overflows(PIN_B), RING_SIZE);
+        CHECK_EQ(sink.count, 0);
+
+        // The task drains everything that was captured, in capture order
+        sim_sleep(1000);
+        stats = stats_since(&before);
+        CHECK_EQ(stats.dispatched, RING_SIZE);
+        CHECK_EQ(sink.count, RING_SIZE);
+        CHECK(sink.in_order);
+
+        // The ring is usable again and the high-water mark stays where it was
+        for (int edge = 0; edge < RING_SIZE / 4; edge++) {
+                toggle(PIN_A);
+        }
+        sim_sleep(1000);
+        stats = stats_since(&before);
+        CHECK_EQ(stats.captured, RING_SIZE + RING_SIZE / 4);
+        CHECK_EQ(stats.overflows, 2 * RING_SIZE);
+        CHECK_EQ(stats.dispatched, stats.captured);
+        CHECK_EQ(stats.high_water, RING_SIZE);
+        CHECK_EQ(gpio_edge_get_overflows(PIN_A), RING_SIZE);
+}
+
+// Sweep the edge rate against a consumer that needs `cost_us` per edge
+static void stress(int64_t cost_us) {
+        static const uint32_t rates[] = { 1000, 5000, 10000, 20000, 40000, 100000 };
+        const int64_t duration_us = 200000;
+        uint32_t capacity = 1000000 / cost_us;
+
+        printf("callback %lld us (%lu edges/s):\n", (long long)cost_us, (unsigned long)capacity);
+        printf("  %8s %8s %8s %8s %10s\n", "edges/s", "captured", "dropped", "depth", "dispatched");
+        for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+                gpio_edge_stats_t before, stats;
+                gpio_edge_get_stats(&before);
+                reset_sink(cost_us);
+
+                // The high-water mark is kept since boot, so the depth of this run is tracked here:
+                // captured edges the task has not taken out of the ring yet
+                uint32_t edges = duration_us * rates[i] / 1000000;
+                uint32_t deepest = 0;
+                for (uint32_t edge = 0; edge < edges; edge++) {
+                        toggle(PIN_A);
+                        gpio_edge_stats_t now = stats_since(&before);
+                        uint32_t depth = now.captured - sink.count;
+                        deepest = depth > deepest ? depth : deepest;
+                        sim_sleep(1000000 / rates[i]);
+                }
+                sim_sleep(RING_SIZE * cost_us + 1000);
+                stats = stats_since(&before);
+                printf("  %8lu %8lu %8lu %8lu %10lu\n", (unsigned long)rates[i], (unsigned long)stats.captured,
+                       (unsigned long)stats.overflows, (unsigned long)deepest, (unsigned long)stats.dispatched);
+
+                // Nothing lost without a trace, and nothing lost below the consumer's rate
+                CHECK_EQ(stats.captured + stats.overflows, edges);
+                CHECK_EQ(stats.dispatched, stats.captured);
+                CHECK(deepest <= RING_SIZE);
+                CHECK(sink.in_order || stats.overflows);
+                if (rates[i] < capacity) {
+                        CHECK_EQ(stats.overflows, 0);
+                        CHECK(deepest <= 1);
+                } else if (rates[i] > 2 * capacity) {
+                        CHECK(stats.overflows > 0);
+                        CHECK_EQ(deepest, RING_SIZE);
+                }
+        }
+}
+
+// Host time per edge through the ISR, the ring and the dispatch task
+static void benchmark(void) {
+        const int bursts = 20000;
+        struct timespec start, end;
+        gpio_edge_stats_t before, stats;
+
+        gpio_edge_get_stats(&before);
+        reset_sink(0);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int burst = 0; burst < bursts; burst++) {
+                for (int edge = 0; edge < RING_SIZE / 2; edge++) {
+                        toggle(PIN_A);
+                }
+                sim_sleep(100);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        stats = stats_since(&before);
+        CHECK_EQ(stats.dispatched, bursts * RING_SIZE / 2);
+        CHECK_EQ(stats.overflows, 0);
+
+        double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        printf("%lu edges in bursts of %d: %.1f ns per edge on the host\n", (unsigned long)stats.dispatched,
+               RING_SIZE / 2, seconds * 1e9 / stats.dispatched);
+}
+
+int main(void) {
+        sim_log_level = ESP_LOG_WARN;
+        level[PIN_A] = level[PIN_B] = 1;
+        sim_gpio_set_input(PIN_A, 1);
+        sim_gpio_set_input(PIN_B, 1);
+        CHECK(gpio_edge_add(PIN_A, GPIO_PULLUP_ONLY, on_edge, NULL) == ESP_OK);
+        CHECK(gpio_edge_add(PIN_B, GPIO_PULLUP_ONLY, on_edge, NULL) == ESP_OK);
+
+        test_flood();
+        stress(50);
+        stress(200);
+        benchmark();
+        return host_test_result("gpio_edge");
+}
@@ -0,0 +1,180 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <string.h>
+#include <esp_timer.h>
+#include <render_scheduler.h>
+#include "sim.h"
+#include "host_test.h"
+
+// render_scheduler driven the way the strip examples drive it: every HomeKit setter stores its
+// value and requests a render, and the callback on the esp_timer task renders the snapshot.
+
+#define INTERVAL_MS 16              // LED_RENDER_INTERVAL_MS of the strip examples
+#define INTERVAL_US (INTERVAL_MS * 1000)
+
+typedef struct {
+        bool on;
+        int brightness;
+        float hue;
+        float saturation;
+} light_t;
+
+static light_t light;
+static render_scheduler_handle_t scheduler;
+
+// What the callbacks saw
+static struct {
+        int count;
+        int64_t time_us[512];
+        light_t state[512];
+} renders;
+
+static void render_cb(void *context) {
+        if (renders.count < 512) {
+                renders.time_us[renders.count] = esp_timer_get_time();
+                renders.state[renders.count] = light;
+        }
+        renders.count++;
+}
+
+static void set_on(bool on) {
+        light.on = on;
+        render_scheduler_request(scheduler);
+}
+
+static void set_brightness(int brightness) {
+        light.brightness = brightness;
+        render_scheduler_request(scheduler);
+}
+
+static void set_hue(float hue) {
+        light.hue = hue;
+        render_scheduler_request(scheduler);
+}
+
+static void set_saturation(float saturation) {
+        light.saturation = saturation;
+        render_scheduler_request(scheduler);
+}
+
+// A scene change: the four setters back to back, `gap_us` apart
+static void scene(bool on, int brightness, float hue, float saturation, int64_t gap_us) {
+        set_on(on);
+        sim_sleep(gap_us);
+        set_brightness(brightness);
+        sim_sleep(gap_us);
+        set_hue(hue);
+        sim_sleep(gap_us);
+        set_saturation(saturation);
+}
+
+// One burst of `writes` setter calls spread over less than a frame renders once, within a frame
+// of its first write, and that render already shows the last write
+static void test_burst(int writes, int64_t gap_us) {
+        render_scheduler_stats_t before, after;
+        render_scheduler_get_stats(scheduler, &before);
+        memset(&renders, 0, sizeof(renders));
+
+        int64_t first_us = esp_timer_get_time();
+        for (int i = 0; i < writes; i++) {
+                set_brightness(i);
+                if (i + 1 < writes) {
+                        sim_sleep(gap_us);
+                }
+        }
+        int64_t last_us = esp_timer_get_time();
+        sim_sleep(10 * INTERVAL_US);
+        render_scheduler_get_stats(scheduler, &after);
+
+        CHECK_EQ(renders.count, 1);
+        CHECK_EQ(after.requests - before.requests, writes);
+        CHECK_EQ(after.renders - before.renders, 1);
+        CHECK_EQ(renders.state[0].brightness, writes - 1);
+        CHECK(renders.time_us[0] >= last_us);
+        CHECK(renders.time_us[0] - first_us <= INTERVAL_US);
+        CHECK(after.latency_max_us <= INTERVAL_US);
+}
+
+static void test_scenes(void) {
+        memset(&renders, 0, sizeof(renders));
+
+        // Back to back, and with the gaps a HomeKit write of four characteristics leaves
+        scene(true, 80, 120, 50, 0);
+        sim_sleep(10 * INTERVAL_US);
+        scene(true, 30, 240, 100, 1000);
+        sim_sleep(10 * INTERVAL_US);
+        scene(false, 30, 240, 100, 3000);
+        sim_sleep(10 * INTERVAL_US);
+
+        // One render per scene, never an intermediate colour
+        CHECK_EQ(renders.count, 3);
+        CHECK(renders.state[0].on && renders.state[0].brightness == 80 && renders.state[0].hue == 120 &&
+              renders.state[0].saturation == 50);
+        CHECK(renders.state[1].on && renders.state[1].brightness == 30 && renders.state[1].hue == 240 &&
+              renders.state[1].saturation == 100);
+        CHECK(!renders.state[2].on);
+}
+
+// A slider dragged in the Home app writes every 5 ms for two seconds: renders stay a frame
+// apart, and every write is on the strip within a frame
+static void test_stream(void) {
+        render_scheduler_stats_t stats;
+        memset(&renders, 0, sizeof(renders));
+
+        int64_t start_us = esp_timer_get_time();
+        for (int i = 0; i < 400; i++) {
+                set_hue(i % 360);
+                sim_sleep(5000);
+        }
+        int64_t last_us = esp_timer_get_time() - 5000;
+        sim_sleep(10 * INTERVAL_US);
+        render_scheduler_get_stats(scheduler, &stats);
+
+        CHECK(renders.count <= (last_us - start_us) / INTERVAL_US + 1);
+        // The next frame starts with the first write after a render, up to one write period later
+        CHECK(renders.count >= (last_us - start_us) / (INTERVAL_US + 5000));
+        for (int i = 1; i < renders.count && i < 512; i++) {
+                CHECK(renders.time_us[i] - renders.time_us[i - 1] >= INTERVAL_US);
+        }
+        CHECK(renders.time_us[renders.count - 1] - last_us <= INTERVAL_US);
+        CHECK_EQ(renders.state[renders.count - 1].hue, 399 % 360);
+        CHECK(stats.latency_max_us <= INTERVAL_US);
+}
+
+int main(int argc, char **argv) {
+        const render_scheduler_config_t config = {
+                .interval_ms = INTERVAL_MS,
+                .callback = render_cb,
+        };
+        CHECK(render_scheduler_create(&config, &scheduler) == ESP_OK);
+
+        test_burst(4, 0);
+        test_burst(4, 2000);
+        test_burst(100, 100);
+        test_scenes();
+        test_stream();
+
+        render_scheduler_delete(scheduler);
+        return host_test_result("render_scheduler");
+}
@@ -0,0 +1,174 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <reset_button.h>
+#include "sim.h"
+#include "host_test.h"
+
+// The hold-to-confirm reset button of examples/wifi-bootstrap on a simulated pin: when the reset
+// is confirmed, how the LED blinks on the way, and what cancels it. The button keeps its state
+// for the life of the firmware, so the cases run in order on one button, the confirm last.
+
+#define PIN GPIO_NUM_33
+#define HOLD_MS 5000
+#define LONG_PRESS_MS CONFIG_BUTTON_GESTURE_LONG_PRESS_MS
+#define DEBOUNCE_MS CONFIG_BUTTON_GESTURE_DEBOUNCE_MS
+#define MS 1000
+
+static struct {
+        int presses;
+        int confirms;
+        int cancels;
+        int64_t confirm_us;
+        int64_t cancel_us;
+        int writes;
+        int64_t write_us[64];
+        bool led;
+} seen;
+
+static void led_write(bool on) {
+        if (seen.writes < (int)(sizeof(seen.write_us) / sizeof(seen.write_us[0]))) {
+                seen.write_us[seen.writes] = esp_timer_get_time();
+        }
+        seen.writes++;
+        seen.led = on;
+}
+
+static void on_press(void) {
+        seen.presses++;
+}
+
+static void on_confirm(void) {
+        seen.confirms++;
+        seen.confirm_us = esp_timer_get_time();
+}
+
+static void on_cancel(void) {
+        seen.cancels++;
+        seen.cancel_us = esp_timer_get_time();
+}
+
+// Press or release with one bounce; the time of the first edge
+static int64_t contact(bool pressed) {
+        int64_t first_us = esp_timer_get_time();
+        sim_gpio_set_input(PIN, !pressed);
+        sim_sleep(500);
+        sim_gpio_set_input(PIN, pressed);
+        sim_sleep(500);
+        sim_gpio_set_input(PIN, !pressed);
+        return first_us;
+}
+
+static void test_held_at_boot(void) {
+        // Held while the firmware starts: never a reset, however long
+        sim_sleep(2 * HOLD_MS * MS);
+        contact(false);
+        sim_sleep(1000 * MS);
+        CHECK_EQ(seen.confirms, 0);
+        CHECK_EQ(seen.cancels, 0);
+        CHECK_EQ(seen.presses, 0);
+        CHECK_EQ(seen.writes, 0);
+}
+
+static void test_short_press(void) {
+        contact(true);
+        sim_sleep(150 * MS);
+        contact(false);
+        sim_sleep(100 * MS);
+        CHECK_EQ(seen.presses, 1);
+        CHECK_EQ(seen.writes, 0);
+}
+
+static void test_cancel(void) {
+        int64_t press_us = contact(true);
+        sim_sleep((HOLD_MS - 100) * MS);
+        CHECK(seen.writes > 0);
+        CHECK_EQ(seen.write_us[0], press_us + LONG_PRESS_MS * MS);
+        int64_t release_us = contact(false);
+        sim_sleep(1000 * MS);
+
+        CHECK_EQ(seen.confirms, 0);
+        CHECK_EQ(seen.cancels, 1);
+        CHECK_EQ(seen.cancel_us, release_us + MS + DEBOUNCE_MS * MS);
+        CHECK_EQ(seen.presses, 1);
+}
+
+static void test_confirm(void) {
+        seen.writes = 0;
+        int64_t press_us = contact(true);
+        sim_sleep((HOLD_MS + 2000) * MS);
+
+        // Confirmed on the dot, with the LED left on
+        CHECK_EQ(seen.confirms, 1);
+        CHECK_EQ(seen.confirm_us, press_us + HOLD_MS * MS);
+        CHECK(seen.led);
+
+        // Blinking from the long press on, faster as the hold goes on
+        CHECK_EQ(seen.write_us[0], press_us + LONG_PRESS_MS * MS);
+        int writes = seen.writes - 1;
+        CHECK(writes > 10);
+        int64_t first_us = seen.write_us[1] - seen.write_us[0];
+        int64_t last_us = seen.write_us[writes - 1] - seen.write_us[writes - 2];
+        for (int i = 2; i < writes; i++) {
+                CHECK(seen.write_us[i] - seen.write_us[i - 1] <= seen.write_us[i - 1] - seen.write_us[i - 2]);
+        }
+        CHECK(first_us >= 300 * MS);
+        CHECK(last_us <= 200 * MS);
+        printf("reset confirmed after %lld ms, %d blinks from %lld ms down to %lld ms\n",
+               (long long)(seen.confirm_us - press_us) / MS, writes / 2, (long long)first_us / MS,
+               (long long)last_us / MS);
+
+        // Nothing more once the reset is under way
+        contact(false);
+        sim_sleep(1000 * MS);
+        contact(true);
+        sim_sleep(100 * MS);
+        contact(false);
+        sim_sleep(1000 * MS);
+        CHECK_EQ(seen.presses, 1);
+        CHECK_EQ(seen.cancels, 1);
+        CHECK_EQ(seen.confirms, 1);
+}
+
+int main(void) {
+        sim_log_level = ESP_LOG_ERROR;
+        sim_gpio_set_input(PIN, 0);
+
+        const reset_button_config_t config = {
+                .gpio = PIN,
+                .hold_ms = HOLD_MS,
+                .led_write = led_write,
+                .on_press = on_press,
+                .on_confirm = on_confirm,
+                .on_cancel = on_cancel,
+        };
+        CHECK(reset_button_init(&config) == ESP_OK);
+
+        test_held_at_boot();
+        test_short_press();
+        test_cancel();
+        test_confirm();
+        return host_test_result("reset_button");
+}
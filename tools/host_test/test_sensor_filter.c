@@ -0,0 +1,296 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <sensor_filter.h>
+#include "sim.h"
+#include "host_test.h"
+
+// sensor_filter over a day of sensor readings, one configuration after another, on the virtual
+// clock. Reports how many notifies each configuration saves and how far the notified value lags
+// the reading, and checks the filter's promises along the way.
+//
+// The traces are synthetic and generated from a fixed seed, so every run sees the same day:
+// a temperature and a humidity with daily cycles, sensor noise and rare single-reading spikes,
+// and an illuminance with clouds and a dark night. A recorded trace can be given instead:
+//
+//   test_sensor_filter trace.csv       one "seconds,value" line per reading
+
+#define DAY_S (24 * 60 * 60)
+#define MAX_READINGS 20000
+#define SPIKE_EVERY 700             // readings between spikes, on average
+
+typedef struct {
+        const char *name;
+        const char *unit;
+        uint32_t count;
+        float time_s[MAX_READINGS];
+        float value[MAX_READINGS];
+} trace_t;
+
+typedef struct {
+        const char *name;
+        sensor_filter_config_t config;
+} setup_t;
+
+static uint32_t random_state;
+
+static float uniform(void) {
+        random_state ^= random_state << 13;
+        random_state ^= random_state >> 17;
+        random_state ^= random_state << 5;
+        return (random_state >> 8) / 16777216.0f;
+}
+
+// Roughly normal, from four uniforms
+static float noise(float sigma) {
+        return (uniform() + uniform() + uniform() + uniform() - 2) * sigma * 1.7f;
+}
+
+static bool spike(void) {
+        return uniform() < 1.0f / SPIKE_EVERY;
+}
+
+static float daily(float time_s, float low, float high) {
+        // Coldest at 05:00, warmest at 17:00
+        return low + (high - low) * (0.5f - 0.5f * cosf(2 * (float)M_PI * (time_s - 5 * 3600) / DAY_S));
+}
+
+// A DHT22 read every 10 s: 0.1 °C steps
+static void generate_temperature(trace_t *trace) {
+        *trace = (trace_t) { .name = "temperature", .unit = "°C" };
+        for (float t = 0; t < DAY_S; t += 10) {
+                float value = daily(t, 18, 23) + noise(0.08f);
+                if (spike()) {
+                        value += 40;
+                }
+                trace->time_s[trace->count] = t;
+                trace->value[trace->count++] = roundf(value * 10) / 10;
+        }
+}
+
+// Relative humidity every 10 s: 0.1 % steps, falling as the room warms
+static void generate_humidity(trace_t *trace) {
+        *trace = (trace_t) { .name = "humidity", .unit = "%" };
+        for (float t = 0; t < DAY_S; t += 10) {
+                float value = 65 - daily(t, 0, 20) + noise(0.4f);
+                if (spike()) {
+                        value = 0;
+                }
+                trace->time_s[trace->count] = t;
+                trace->value[trace->count++] = roundf(value * 10) / 10;
+        }
+}
+
+// Illuminance every 5 s: daylight between 07:00 and 21:00 with passing clouds, a lamp at night
+static void generate_illuminance(trace_t *trace) {
+        float cloud = 1;
+
+        *trace = (trace_t) { .name = "illuminance", .unit = "lx" };
+        for (float t = 0; t < DAY_S && trace->count < MAX_READINGS; t += 5) {
+                float sun = sinf((float)M_PI * (t - 7 * 3600) / (14 * 3600));
+                cloud += (0.7f + 0.3f * uniform() - cloud) * 0.02f + noise(0.01f);
+                cloud = fminf(fmaxf(cloud, 0.2f), 1);
+                float value = sun > 0 ? 20000 * sun * sun * cloud : 0;
+                if (t > 19 * 3600 && t < 23 * 3600) {
+                        value += 150;
+                }
+                value *= 1 + noise(0.01f);
+                trace->time_s[trace->count] = t;
+                trace->value[trace->count++] = fmaxf(roundf(value), 0);
+        }
+}
+
+static bool load_csv(trace_t *trace, const char *path) {
+        FILE *file = fopen(path, "r");
+        if (!file) {
+                perror(path);
+                return false;
+        }
+        *trace = (trace_t) { .name = path, .unit = "" };
+        char line[128];
+        while (fgets(line, sizeof(line), file) && trace->count < MAX_READINGS) {
+                float time_s, value;
+                if (sscanf(line, "%f,%f", &time_s, &value) == 2) {
+                        trace->time_s[trace->count] = time_s;
+                        trace->value[trace->count++] = value;
+                }
+        }
+        fclose(file);
+        return trace->count > 0;
+}
+
+typedef struct {
+        sensor_filter_stats_t stats;
+        float max_lag;              // largest |notified value - filtered reading| while held
+        float max_notified;
+        float min_notified;
+        double longest_silence_s;
+} result_t;
+
+// Play the trace through one filter; the virtual clock follows the reading times
+static result_t play(const trace_t *trace, const sensor_filter_config_t *config) {
+        sensor_filter_handle_t filter;
+        result_t result = { .max_notified = -INFINITY, .min_notified = INFINITY };
+        float notified = 0;
+        int64_t start_us = esp_timer_get_time();
+        int64_t notified_us = start_us;
+
+        CHECK(sensor_filter_create(config, &filter) == ESP_OK);
+        for (uint32_t i = 0; i < trace->count; i++) {
+                sim_run_until(start_us + (int64_t)(trace->time_s[i] * 1e6));
+                float value;
+                if (sensor_filter_update(filter, trace->value[i], &value)) {
+                        double silence_s = (esp_timer_get_time() - notified_us) / 1e6;
+                        if (silence_s > result.longest_silence_s) {
+                                result.longest_silence_s = silence_s;
+                        }
+                        notified = value;
+                        notified_us = esp_timer_get_time();
+                        result.max_notified = fmaxf(result.max_notified, value);
+                        result.min_notified = fminf(result.min_notified, value);
+                }
+                result.max_lag = fmaxf(result.max_lag, fabsf(value - notified));
+        }
+        sensor_filter_get_stats(filter, &result.stats);
+        sensor_filter_delete(filter);
+
+        // Leave a gap so the next run starts on a clean clock
+        sim_sleep(3600 * 1000000LL);
+        return result;
+}
+
+static void report(const trace_t *trace, const char *setup, const result_t *result, uint32_t baseline) {
+        double saved = baseline ? 100.0 * (1 - (double)result->stats.published / baseline) : 0;
+        printf("  %-38s %8lu %9lu %10lu %6.1f %% %9.2f %s\n", setup, (unsigned long)result->stats.readings,
+               (unsigned long)result->stats.published, (unsigned long)result->stats.heartbeats, saved,
+               result->max_lag, trace->unit);
+}
+
+static void print_header(const trace_t *trace) {
+        printf("%s, %lu readings over %.1f h:\n", trace->name, (unsigned long)trace->count,
+               trace->count ? trace->time_s[trace->count - 1] / 3600 : 0);
+        printf("  %-38s %8s %9s %10s %8s %9s\n", "configuration", "readings", "notified", "heartbeats",
+               "saved", "max lag");
+}
+
+// Every configuration against notifying each change; checks what each option promises
+static void run_trace(const trace_t *trace, const setup_t *setups, size_t count, bool synthetic) {
+        print_header(trace);
+        result_t baseline = play(trace, &(sensor_filter_config_t) { 0 });
+        report(trace, "every change", &baseline, baseline.stats.published);
+
+        for (size_t i = 0; i < count; i++) {
+                const sensor_filter_config_t *config = &setups[i].config;
+                result_t result = play(trace, config);
+                report(trace, setups[i].name, &result, baseline.stats.published);
+
+                CHECK_EQ(result.stats.readings, trace->count);
+                CHECK(result.stats.published <= baseline.stats.published);
+                if (config->heartbeat_ms) {
+                        // Never quiet for longer than the heartbeat and one reading interval
+                        CHECK(result.longest_silence_s <= config->heartbeat_ms / 1000.0 + 10);
+                } else {
+                        CHECK_EQ(result.stats.heartbeats, 0);
+                }
+                if (config->abs_deadband && !config->rel_deadband && !config->log_deadband) {
+                        // A held value is never off by the deadband or more
+                        CHECK(result.max_lag < config->abs_deadband);
+                }
+                if (synthetic && config->median_window >= 3) {
+                        // Single-reading spikes never reach a notify
+                        CHECK(result.max_notified < baseline.max_notified);
+                        CHECK(result.min_notified > baseline.min_notified || baseline.min_notified > 0);
+                }
+        }
+        printf("\n");
+}
+
+static const setup_t temperature_setups[] = {
+        { "0.2 °C", { .abs_deadband = 0.2f } },
+        { "0.2 °C, median 3", { .abs_deadband = 0.2f, .median_window = 3 } },
+        { "0.2 °C, median 3, heartbeat 15 min", { .abs_deadband = 0.2f, .median_window = 3, .heartbeat_ms = 900000 } },
+        { "0.5 °C, median 5, heartbeat 15 min", { .abs_deadband = 0.5f, .median_window = 5, .heartbeat_ms = 900000 } },
+};
+
+static const setup_t humidity_setups[] = {
+        { "1 %", { .abs_deadband = 1 } },
+        { "1 %, median 3", { .abs_deadband = 1, .median_window = 3 } },
+        { "2 %, median 3, heartbeat 15 min", { .abs_deadband = 2, .median_window = 3, .heartbeat_ms = 900000 } },
+};
+
+static const setup_t illuminance_setups[] = {
+        { "10 lx", { .abs_deadband = 10 } },
+        { "5 %", { .rel_deadband = 0.05f } },
+        { "log 0.05", { .log_deadband = 0.05f } },
+        { "log 0.05, median 3", { .log_deadband = 0.05f, .median_window = 3 } },
+        { "log 0.05, median 3, heartbeat 15 min", { .log_deadband = 0.05f, .median_window = 3, .heartbeat_ms = 900000 } },
+};
+
+// For a recorded trace of unknown units
+static const setup_t generic_setups[] = {
+        { "5 %", { .rel_deadband = 0.05f } },
+        { "5 %, median 3", { .rel_deadband = 0.05f, .median_window = 3 } },
+        { "log 0.05, median 3", { .log_deadband = 0.05f, .median_window = 3 } },
+        { "5 %, median 3, heartbeat 15 min", { .rel_deadband = 0.05f, .median_window = 3, .heartbeat_ms = 900000 } },
+};
+
+#define COUNT(array) (sizeof(array) / sizeof((array)[0]))
+
+// Notifies left with the configuration the examples use, as a fraction of every change
+static double notified_fraction(const trace_t *trace, const sensor_filter_config_t *config) {
+        result_t baseline = play(trace, &(sensor_filter_config_t) { 0 });
+        result_t result = play(trace, config);
+        return (double)result.stats.published / baseline.stats.published;
+}
+
+int main(int argc, char **argv) {
+        static trace_t trace;
+
+        sim_log_level = ESP_LOG_WARN;
+        if (argc > 1) {
+                if (!load_csv(&trace, argv[1])) {
+                        return 1;
+                }
+                run_trace(&trace, generic_setups, COUNT(generic_setups), false);
+                return host_test_result("sensor_filter");
+        }
+
+        random_state = 0x5eed5eed;
+        generate_temperature(&trace);
+        run_trace(&trace, temperature_setups, COUNT(temperature_setups), true);
+        CHECK(notified_fraction(&trace, &temperature_setups[2].config) < 0.2);
+
+        generate_humidity(&trace);
+        run_trace(&trace, humidity_setups, COUNT(humidity_setups), true);
+        CHECK(notified_fraction(&trace, &humidity_setups[2].config) < 0.1);
+
+        generate_illuminance(&trace);
+        run_trace(&trace, illuminance_setups, COUNT(illuminance_setups), false);
+        CHECK(notified_fraction(&trace, &illuminance_setups[4].config) < 0.2);
+        return host_test_result("sensor_filter");
+}
@@ -0,0 +1,166 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <seqlock.h>
+#include "host_test.h"
+
+// seqlock under real threads: one writer stores generation after generation of a struct while
+// readers copy it with SEQLOCK_READ and check every copy is a single generation. The shim's
+// critical section is a no-op, so the writer here can be preempted mid-write, which an ESP32
+// writer with interrupts off cannot; that only makes the readers retry more. There is one
+// writer because nothing on the host serialises writers.
+
+#define FIELDS 64                   // a copy takes long enough to be preempted or overtaken
+#define READERS 3
+#define RUN_NS 500000000LL
+
+typedef struct {
+        uint32_t generation;
+        uint32_t fields[FIELDS];    // generation * (i + 1)
+} state_t;
+
+static state_t state;
+static seqlock_t lock = SEQLOCK_INIT;
+static atomic_bool done;
+
+typedef struct {
+        uint64_t snapshots;
+        uint64_t torn;
+        uint64_t backwards;         // a snapshot older than the one before it
+} reader_result_t;
+
+static bool consistent(const state_t *copy) {
+        for (int i = 0; i < FIELDS; i++) {
+                if (copy->fields[i] != copy->generation * (i + 1)) {
+                        return false;
+                }
+        }
+        return true;
+}
+
+static int64_t now_ns(void) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+static void *writer(void *arg) {
+        uint64_t *writes = arg;
+        int64_t end_ns = now_ns() + RUN_NS;
+
+        // Generations go on from the previous run, whose last one the readers may still see first
+        for (uint32_t generation = state.generation + 1; now_ns() < end_ns; generation++) {
+                seqlock_write_begin(&lock);
+                state.generation = generation;
+                for (int i = 0; i < FIELDS; i++) {
+                        state.fields[i] = generation * (i + 1);
+                }
+                seqlock_write_end(&lock);
+                (*writes)++;
+                if (!(generation % 64)) {
+                        sched_yield();
+                }
+        }
+        atomic_store(&done, true);
+        return NULL;
+}
+
+static void *reader(void *arg) {
+        reader_result_t *result = arg;
+        uint32_t last = 0;
+
+        while (!atomic_load(&done)) {
+                state_t copy;
+                SEQLOCK_READ(&lock, copy, state);
+                result->snapshots++;
+                if (!consistent(&copy)) {
+                        result->torn++;
+                }
+                if (copy.generation < last) {
+                        result->backwards++;
+                }
+                last = copy.generation;
+        }
+        return NULL;
+}
+
+// The same readers without the seqlock, to show the writer does tear unprotected copies
+static void *unprotected_reader(void *arg) {
+        reader_result_t *result = arg;
+
+        while (!atomic_load(&done)) {
+                state_t copy = *(volatile state_t *)&state;
+                result->snapshots++;
+                if (!consistent(&copy)) {
+                        result->torn++;
+                }
+        }
+        return NULL;
+}
+
+static void run(void *(*read)(void *), reader_result_t *total, uint64_t *writes) {
+        pthread_t writer_thread, reader_threads[READERS];
+        reader_result_t results[READERS] = { 0 };
+
+        atomic_store(&done, false);
+        *writes = 0;
+        for (int i = 0; i < READERS; i++) {
+                CHECK(pthread_create(&reader_threads[i], NULL, read, &results[i]) == 0);
+        }
+        CHECK(pthread_create(&writer_thread, NULL, writer, writes) == 0);
+        pthread_join(writer_thread, NULL);
+
+        *total = (reader_result_t) { 0 };
+        for (int i = 0; i < READERS; i++) {
+                pthread_join(reader_threads[i], NULL);
+                total->snapshots += results[i].snapshots;
+                total->torn += results[i].torn;
+                total->backwards += results[i].backwards;
+        }
+}
+
+int main(int argc, char **argv) {
+        reader_result_t result;
+        uint64_t writes;
+        uint32_t sequence;
+
+        run(unprotected_reader, &result, &writes);
+        printf("unprotected: %llu writes, %llu copies, %llu torn\n", (unsigned long long)writes,
+               (unsigned long long)result.snapshots, (unsigned long long)result.torn);
+
+        sequence = lock.sequence;
+        run(reader, &result, &writes);
+        printf("seqlock:     %llu writes, %llu snapshots, %llu torn, %llu out of order\n",
+               (unsigned long long)writes, (unsigned long long)result.snapshots, (unsigned long long)result.torn,
+               (unsigned long long)result.backwards);
+        CHECK(writes > 0);
+        CHECK(result.snapshots > 0);
+        CHECK_EQ(result.torn, 0);
+        CHECK_EQ(result.backwards, 0);
+        CHECK_EQ(lock.sequence - sequence, 2 * writes);
+        return host_test_result("seqlock");
+}
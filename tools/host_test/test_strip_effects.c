@@ -0,0 +1,217 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <esp_timer.h>
+#include <led_strip.h>
+#include <strip_render.h>
+#include <strip_effects.h>
+#include "sim.h"
+#include "host_test.h"
+
+// The strip_effects frame timer on the render_sim shim: frames come at the configured rate,
+// whatever the effect, the strip length or a change of effect, and a frame that does not fit
+// its period is counted as an overrun.
+
+typedef struct {
+        led_strip_handle_t strip;
+        strip_render_handle_t render;
+        strip_effects_handle_t effects;
+} rig_t;
+
+static const strip_effect_params_t rainbow = {
+        .effect = STRIP_EFFECT_RAINBOW,
+        .brightness = 100,
+};
+
+static void rig_create(rig_t *rig, uint32_t length, bool async, uint32_t frame_rate) {
+        const led_strip_config_t strip_config = {
+                .max_leds = length,
+                .led_pixel_format = LED_PIXEL_FORMAT_GRB,
+        };
+        const led_strip_rmt_config_t rmt_config = { 0 };
+        CHECK(led_strip_new_rmt_device(&strip_config, &rmt_config, &rig->strip) == ESP_OK);
+
+        const strip_render_config_t render_config = {
+                .strip = rig->strip,
+                .length = length,
+                .async = async,
+        };
+        CHECK(strip_render_create(&render_config, &rig->render) == ESP_OK);
+
+        const strip_effects_config_t effects_config = {
+                .render = rig->render,
+                .length = length,
+                .frame_rate = frame_rate,
+        };
+        CHECK(strip_effects_create(&effects_config, &rig->effects) == ESP_OK);
+}
+
+static void rig_delete(rig_t *rig) {
+        strip_effects_delete(rig->effects);
+        // Let an asynchronous transmit still in flight finish
+        sim_sleep(100000);
+        strip_render_delete(rig->render);
+        led_strip_del(rig->strip);
+}
+
+static uint32_t frames(const rig_t *rig) {
+        strip_effects_stats_t stats;
+        strip_effects_get_stats(rig->effects, &stats);
+        return stats.frames;
+}
+
+// Every second of `seconds` holds exactly `frame_rate` frames, each one shown on the strip
+static void test_rate(uint32_t length, bool async, uint32_t frame_rate, int seconds) {
+        rig_t rig;
+        strip_effects_stats_t stats;
+        strip_render_stats_t render_stats;
+
+        rig_create(&rig, length, async, frame_rate);
+        CHECK(strip_effects_start(rig.effects, &rainbow) == ESP_OK);
+        // The first frame comes one period after the start
+        int64_t period_us = 1000000 / frame_rate;
+        sim_sleep(period_us / 2);
+        for (int second = 0; second < seconds; second++) {
+                uint32_t before = frames(&rig);
+                sim_sleep(1000000);
+                CHECK_EQ(frames(&rig) - before, frame_rate);
+        }
+        strip_effects_stop(rig.effects);
+        sim_sleep(100000);
+
+        strip_effects_get_stats(rig.effects, &stats);
+        strip_render_get_stats(rig.render, &render_stats);
+        CHECK_EQ(stats.frames, frame_rate * seconds);
+        CHECK_EQ(stats.overruns, 0);
+        CHECK(stats.compute_max_us < period_us);
+        CHECK_EQ(render_stats.frames, stats.frames);
+        CHECK_EQ(render_stats.refreshes, stats.frames);
+        CHECK_EQ(render_stats.dropped, 0);
+        rig_delete(&rig);
+}
+
+// Changing the effect or its colours keeps the running timer; stopping and starting again
+// neither loses nor adds frames
+static void test_restart(void) {
+        rig_t rig;
+        strip_effect_params_t params = rainbow;
+
+        rig_create(&rig, 60, true, 50);
+        CHECK(strip_effects_start(rig.effects, &params) == ESP_OK);
+        sim_sleep(1010000);
+        CHECK_EQ(frames(&rig), 50);
+
+        for (int effect = STRIP_EFFECT_CHASE; effect < STRIP_EFFECT_COUNT; effect++) {
+                params.effect = effect;
+                params.primary = (color_rgbw_t) { .red = 10 * effect };
+                CHECK(strip_effects_start(rig.effects, &params) == ESP_OK);
+                sim_sleep(100000);
+        }
+        CHECK_EQ(frames(&rig), 50 + 5 * 5);
+
+        strip_effects_stop(rig.effects);
+        CHECK(!strip_effects_running(rig.effects));
+        sim_sleep(1000000);
+        CHECK_EQ(frames(&rig), 75);
+
+        CHECK(strip_effects_start(rig.effects, &rainbow) == ESP_OK);
+        sim_sleep(1000000);
+        CHECK_EQ(frames(&rig), 125);
+
+        // STRIP_EFFECT_NONE stops the engine as well
+        params.effect = STRIP_EFFECT_NONE;
+        CHECK(strip_effects_start(rig.effects, &params) == ESP_OK);
+        sim_sleep(1000000);
+        CHECK_EQ(frames(&rig), 125);
+        rig_delete(&rig);
+}
+
+// A synchronous 1000 pixel strip takes 30 ms on the wire, longer than a 50 fps frame: every
+// frame is an overrun and the strip runs as fast as the wire allows
+static void test_overrun(void) {
+        rig_t rig;
+        strip_effects_stats_t stats;
+
+        rig_create(&rig, 1000, false, 50);
+        CHECK(strip_effects_start(rig.effects, &rainbow) == ESP_OK);
+        sim_sleep(5000000);
+        strip_effects_stop(rig.effects);
+        sim_sleep(100000);
+        strip_effects_get_stats(rig.effects, &stats);
+
+        int64_t wire_us = 1000 * 3 * 10 + 280;
+        CHECK(stats.frames < 5 * 50);
+        CHECK(stats.frames >= 5000000 / (wire_us + 20000) - 1);
+        CHECK(stats.frames <= 5000000 / wire_us + 1);
+        CHECK_EQ(stats.overruns, stats.frames);
+        CHECK(stats.compute_max_us >= wire_us);
+        rig_delete(&rig);
+}
+
+static void stall_cb(void *arg) {
+        sim_sleep(200000);
+}
+
+// Another esp_timer callback holds the timer task for 200 ms: the frames missed meanwhile are
+// skipped, not replayed back to back once it lets go, and the rate then picks up again
+static void test_stall(void) {
+        rig_t rig;
+        esp_timer_handle_t stall;
+        const esp_timer_create_args_t stall_args = {
+                .callback = stall_cb,
+                .name = "stall",
+        };
+
+        rig_create(&rig, 60, true, 50);
+        CHECK(esp_timer_create(&stall_args, &stall) == ESP_OK);
+        CHECK(strip_effects_start(rig.effects, &rainbow) == ESP_OK);
+        sim_sleep(1010000);
+        CHECK_EQ(frames(&rig), 50);
+
+        CHECK(esp_timer_start_once(stall, 0) == ESP_OK);
+        sim_sleep(190000);
+        CHECK_EQ(frames(&rig), 50);
+        // One late frame as the stall ends, then one per period
+        sim_sleep(110000);
+        CHECK(frames(&rig) - 50 <= 6);
+        sim_sleep(1000000);
+        uint32_t before = frames(&rig);
+        sim_sleep(1000000);
+        CHECK_EQ(frames(&rig) - before, 50);
+
+        esp_timer_delete(stall);
+        rig_delete(&rig);
+}
+
+int main(int argc, char **argv) {
+        sim_capture = fopen("/dev/null", "w");
+
+        test_rate(300, true, 50, 10);
+        test_rate(300, true, 60, 10);
+        test_rate(60, false, 30, 5);
+        test_rate(150, false, 100, 5);
+        test_restart();
+        test_overrun();
+        test_stall();
+        return host_test_result("strip_effects");
+}
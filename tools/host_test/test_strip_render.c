@@ -0,0 +1,359 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <esp_timer.h>
+#include <led_strip.h>
+#include <strip_render.h>
+#include "sim.h"
+#include "host_test.h"
+
+// strip_render on the simulated strip. The shim writes one trace line per refresh, with the
+// range of pixels set since the previous refresh and a hash of every pixel the driver holds;
+// the checks read that capture back and compare it with a model of the frame.
+
+#define LENGTH 300
+#define PIXEL_SIZE 3
+
+typedef struct {
+        uint32_t first;
+        uint32_t last;
+        uint32_t hash;
+} refresh_t;
+
+static long capture_read;
+
+// The refreshes traced since the last call
+static int read_refreshes(refresh_t *refreshes, int max) {
+        char line[256];
+        int count = 0;
+
+        fflush(sim_capture);
+        fseek(sim_capture, capture_read, SEEK_SET);
+        while (fgets(line, sizeof(line), sim_capture)) {
+                unsigned long time_us, transmit_us, first, last, current_ma, hash;
+                if (sscanf(line, "STRIP_RENDER: trace,%*[^,],%lu,%lu,%lu,%lu,-,%lu,%lx", &time_us, &transmit_us,
+                           &first, &last, &current_ma, &hash) == 6 && count < max) {
+                        refreshes[count++] = (refresh_t) { .first = first, .last = last, .hash = hash };
+                }
+        }
+        capture_read = ftell(sim_capture);
+        fseek(sim_capture, 0, SEEK_END);
+        return count;
+}
+
+// FNV-1a over the pixels, as the shim hashes what the driver holds
+static uint32_t model_hash(const uint8_t *pixels) {
+        uint32_t hash = 2166136261u;
+
+        for (size_t i = 0; i < LENGTH * PIXEL_SIZE; i++) {
+                hash = (hash ^ pixels[i]) * 16777619u;
+        }
+        return hash;
+}
+
+static uint32_t random_state = 0x2545f491;
+
+static uint32_t random_below(uint32_t limit) {
+        random_state ^= random_state << 13;
+        random_state ^= random_state >> 17;
+        random_state ^= random_state << 5;
+        return random_state % limit;
+}
+
+static const color_rgbw_t palette[] = {
+        { .red = 255 }, { .green = 255 }, { .blue = 255 }, { .red = 40, .green = 20, .blue = 10 },
+};
+#define PALETTE_SIZE (sizeof(palette) / sizeof(palette[0]))
+
+static strip_render_handle_t create_render(bool async, led_strip_handle_t *strip) {
+        const led_strip_config_t strip_config = {
+                .max_leds = LENGTH,
+                .led_pixel_format = LED_PIXEL_FORMAT_GRB,
+        };
+        const led_strip_rmt_config_t rmt_config = { 0 };
+        CHECK(led_strip_new_rmt_device(&strip_config, &rmt_config, strip) == ESP_OK);
+
+        const strip_render_config_t config = {
+                .strip = *strip,
+                .length = LENGTH,
+                .async = async,
+        };
+        strip_render_handle_t render = NULL;
+        CHECK(strip_render_create(&config, &render) == ESP_OK);
+        return render;
+}
+
+// The model of what strip_render holds: the pixels, whether the last change was a fill, and
+// the span changed since the last show
+typedef struct {
+        uint8_t pixels[LENGTH * PIXEL_SIZE];
+        bool uniform;
+        bool dirty;
+        uint32_t first;
+        uint32_t last;
+} model_t;
+
+static void model_set(model_t *model, uint32_t index, const color_rgbw_t *color) {
+        uint8_t *pixel = model->pixels + index * PIXEL_SIZE;
+        const uint8_t packed[PIXEL_SIZE] = { color->red, color->green, color->blue };
+
+        if (memcmp(pixel, packed, PIXEL_SIZE) == 0) {
+                return;
+        }
+        memcpy(pixel, packed, PIXEL_SIZE);
+        model->uniform = false;
+        if (!model->dirty || index < model->first) {
+                model->first = index;
+        }
+        if (!model->dirty || index > model->last) {
+                model->last = index;
+        }
+        model->dirty = true;
+}
+
+// strip_render_fill rewrites the whole strip unless the last change was a fill with this colour
+static void model_fill(model_t *model, const color_rgbw_t *color) {
+        const uint8_t packed[PIXEL_SIZE] = { color->red, color->green, color->blue };
+
+        if (model->uniform && memcmp(model->pixels, packed, PIXEL_SIZE) == 0) {
+                return;
+        }
+        for (uint32_t i = 0; i < LENGTH; i++) {
+                memcpy(model->pixels + i * PIXEL_SIZE, packed, PIXEL_SIZE);
+        }
+        model->uniform = true;
+        model->dirty = true;
+        model->first = 0;
+        model->last = LENGTH - 1;
+}
+
+// Show, and check that exactly the changed span went out and the driver ends up with the model
+static void show_and_check(strip_render_handle_t render, model_t *model) {
+        strip_render_stats_t before, after;
+        refresh_t refreshes[4];
+
+        strip_render_get_stats(render, &before);
+        CHECK(strip_render_show(render) == ESP_OK);
+        strip_render_get_stats(render, &after);
+        int count = read_refreshes(refreshes, 4);
+
+        CHECK_EQ(after.frames - before.frames, 1);
+        if (!model->dirty) {
+                CHECK_EQ(count, 0);
+                CHECK_EQ(after.refreshes, before.refreshes);
+                CHECK_EQ(after.pixels_written, before.pixels_written);
+                return;
+        }
+        CHECK_EQ(count, 1);
+        CHECK_EQ(after.refreshes - before.refreshes, 1);
+        CHECK_EQ(after.pixels_written - before.pixels_written, model->last - model->first + 1);
+        if (count == 1) {
+                CHECK_EQ(refreshes[0].first, model->first);
+                CHECK_EQ(refreshes[0].last, model->last);
+                CHECK_EQ(refreshes[0].hash, model_hash(model->pixels));
+        }
+        model->dirty = false;
+}
+
+static void test_dirty_range(void) {
+        led_strip_handle_t strip;
+        strip_render_handle_t render = create_render(false, &strip);
+        // The driver and the frame both start out black
+        static model_t model = { .uniform = true };
+
+        strip_render_fill(render, &palette[0]);
+        model_fill(&model, &palette[0]);
+        show_and_check(render, &model);
+
+        // Two pixels apart go out as one span
+        strip_render_set_pixel(render, 100, &palette[1]);
+        strip_render_set_pixel(render, 120, &palette[2]);
+        model_set(&model, 100, &palette[1]);
+        model_set(&model, 120, &palette[2]);
+        CHECK_EQ(model.last - model.first + 1, 21);
+        show_and_check(render, &model);
+
+        // Nothing changed: no refresh at all
+        show_and_check(render, &model);
+        strip_render_set_pixel(render, 100, &palette[1]);
+        strip_render_fill_range(render, 0, 50, &palette[0]);
+        show_and_check(render, &model);
+
+        // A range past the end is cut at the last pixel
+        strip_render_fill_range(render, LENGTH - 20, 40, &palette[2]);
+        for (uint32_t i = LENGTH - 20; i < LENGTH; i++) {
+                model_set(&model, i, &palette[2]);
+        }
+        show_and_check(render, &model);
+
+        // Random edits through every call, a few per frame
+        for (int frame = 0; frame < 2000; frame++) {
+                int edits = random_below(4);
+                for (int edit = 0; edit < edits; edit++) {
+                        const color_rgbw_t *color = &palette[random_below(PALETTE_SIZE)];
+                        uint32_t start = random_below(LENGTH);
+                        uint32_t count = 1 + random_below(LENGTH / 4);
+                        switch (random_below(8)) {
+                        case 0:
+                                strip_render_fill(render, color);
+                                model_fill(&model, color);
+                                break;
+                        case 1:
+                        case 2:
+                        case 3:
+                                strip_render_set_pixel(render, start, color);
+                                model_set(&model, start, color);
+                                break;
+                        case 4:
+                        case 5:
+                                strip_render_fill_range(render, start, count, color);
+                                for (uint32_t i = start; i < start + count && i < LENGTH; i++) {
+                                        model_set(&model, i, color);
+                                }
+                                break;
+                        default: {
+                                color_rgbw_t colors[LENGTH];
+                                for (uint32_t i = 0; i < count; i++) {
+                                        colors[i] = palette[random_below(PALETTE_SIZE)];
+                                }
+                                strip_render_set_pixels(render, start, count, colors);
+                                for (uint32_t i = 0; i < count && start + i < LENGTH; i++) {
+                                        model_set(&model, start + i, &colors[i]);
+                                }
+                                break;
+                        }
+                        }
+                }
+                show_and_check(render, &model);
+        }
+
+        strip_render_delete(render);
+        led_strip_del(strip);
+}
+
+// A frame of its own for every `frame` number
+static void compose(strip_render_handle_t render, int frame, uint8_t *pixels) {
+        static color_rgbw_t colors[LENGTH];
+
+        for (uint32_t i = 0; i < LENGTH; i++) {
+                colors[i] = (color_rgbw_t) { .red = i + frame, .green = frame, .blue = i * frame };
+                pixels[i * PIXEL_SIZE] = colors[i].red;
+                pixels[i * PIXEL_SIZE + 1] = colors[i].green;
+                pixels[i * PIXEL_SIZE + 2] = colors[i].blue;
+        }
+        strip_render_set_pixels(render, 0, LENGTH, colors);
+}
+
+// Send `frames` frames, one every `period_us`, and check that every refresh is a whole frame
+// that was shown, in order, that only superseded frames are missing and that the last one
+// always goes out. Returns the refreshes.
+static int stream(strip_render_handle_t render, int frames, int64_t period_us) {
+        static uint8_t pixels[LENGTH * PIXEL_SIZE];
+        static uint32_t hashes[200];
+        static refresh_t refreshes[200];
+        strip_render_stats_t before, after;
+
+        strip_render_get_stats(render, &before);
+        for (int frame = 0; frame < frames; frame++) {
+                compose(render, frame, pixels);
+                hashes[frame] = model_hash(pixels);
+                int64_t start_us = esp_timer_get_time();
+                CHECK(strip_render_show(render) == ESP_OK);
+                // The caller never waits for the strip
+                CHECK_EQ(esp_timer_get_time(), start_us);
+                sim_sleep(period_us);
+        }
+        sim_sleep(100000);
+        strip_render_get_stats(render, &after);
+        int count = read_refreshes(refreshes, 200);
+
+        CHECK_EQ(after.refreshes - before.refreshes, count);
+        CHECK_EQ(after.dropped - before.dropped, frames - count);
+        CHECK_EQ(after.errors, 0);
+        int frame = 0;
+        for (int i = 0; i < count; i++) {
+                while (frame < frames && hashes[frame] != refreshes[i].hash) {
+                        frame++;
+                }
+                CHECK(frame < frames);
+        }
+        CHECK(count > 0 && refreshes[count - 1].hash == hashes[frames - 1]);
+        return count;
+}
+
+static void test_double_buffer(void) {
+        led_strip_handle_t strip;
+        strip_render_handle_t render = create_render(true, &strip);
+        static model_t model = { .uniform = true };
+        static uint8_t sent[LENGTH * PIXEL_SIZE];
+        strip_render_stats_t stats;
+        refresh_t refreshes[4];
+
+        // Change the frame while its predecessor is on the wire: the transmit holds its own copy
+        strip_render_fill(render, &palette[0]);
+        model_fill(&model, &palette[0]);
+        memcpy(sent, model.pixels, sizeof(sent));
+        CHECK(strip_render_show(render) == ESP_OK);
+        sim_sleep(1000);
+        strip_render_fill(render, &palette[1]);
+        strip_render_set_pixel(render, 10, &palette[2]);
+        model_fill(&model, &palette[1]);
+        model_set(&model, 10, &palette[2]);
+        CHECK(strip_render_show(render) == ESP_OK);
+        // Superseded before the task took it: the two shows go out as one frame
+        strip_render_set_pixel(render, 20, &palette[2]);
+        model_set(&model, 20, &palette[2]);
+        CHECK(strip_render_show(render) == ESP_OK);
+        sim_sleep(100000);
+
+        strip_render_get_stats(render, &stats);
+        CHECK_EQ(read_refreshes(refreshes, 4), 2);
+        CHECK_EQ(refreshes[0].hash, model_hash(sent));
+        CHECK_EQ(refreshes[1].hash, model_hash(model.pixels));
+        CHECK_EQ(refreshes[1].first, 0);
+        CHECK_EQ(refreshes[1].last, LENGTH - 1);
+        CHECK_EQ(stats.refreshes, 2);
+        CHECK_EQ(stats.dropped, 1);
+
+        // 60 fps leaves the 9.3 ms transmit room: every frame goes out
+        CHECK_EQ(stream(render, 120, 16667), 120);
+        // Frames every 4 ms come faster than the wire; the strip shows the newest it can
+        int sent_frames = stream(render, 120, 4000);
+        CHECK(sent_frames < 120 && sent_frames >= 120 * 4000 / 9280 - 1);
+
+        // Delete with a transmit in flight
+        compose(render, 7, sent);
+        CHECK(strip_render_show(render) == ESP_OK);
+        sim_sleep(1000);
+        strip_render_delete(render);
+        led_strip_del(strip);
+}
+
+int main(int argc, char **argv) {
+        sim_capture = tmpfile();
+        test_dirty_range();
+        test_double_buffer();
+        return host_test_result("strip_render");
+}
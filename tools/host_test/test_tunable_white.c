@@ -0,0 +1,171 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <esp_timer.h>
+#include <light_fade.h>
+#include <tunable_white.h>
+#include "sim.h"
+#include "host_test.h"
+
+// tunable_white on the render_sim shim: transitions end on their target and then stop writing,
+// and a pause leaves the outputs to someone else until resume puts the transition back.
+
+#define DUTY_MAX 8191
+#define TRANSITION_MS 500
+
+typedef struct {
+        light_fade_handle_t fade;
+        tunable_white_handle_t white;
+} rig_t;
+
+static void rig_create(rig_t *rig) {
+        const light_fade_config_t fade_config = {
+                .speed_mode = LEDC_LOW_SPEED_MODE,
+                .channels = { LEDC_CHANNEL_0, LEDC_CHANNEL_1 },
+                .channel_count = 2,
+                .duty_max = DUTY_MAX,
+                .full_scale_ms = 1000,
+        };
+        CHECK(light_fade_create(&fade_config, &rig->fade) == ESP_OK);
+
+        const tunable_white_config_t white_config = {
+                .fade = rig->fade,
+                .duty_max = DUTY_MAX,
+                .transition_ms = TRANSITION_MS,
+        };
+        CHECK(tunable_white_create(&white_config, &rig->white) == ESP_OK);
+}
+
+static void rig_delete(rig_t *rig) {
+        tunable_white_delete(rig->white);
+        light_fade_delete(rig->fade);
+}
+
+static uint32_t duty(ledc_channel_t channel) {
+        return ledc_get_duty(LEDC_LOW_SPEED_MODE, channel);
+}
+
+// Size of the capture, which grows with every duty update
+static long writes(void) {
+        fflush(sim_capture);
+        return ftell(sim_capture);
+}
+
+// The duties where a transition to `mired` and `brightness` ends, from a fresh light. Uses the
+// same channels, so call it while no other light is created.
+static void reference(uint16_t mired, float brightness, uint32_t *warm, uint32_t *cold) {
+        rig_t rig;
+
+        rig_create(&rig);
+        tunable_white_set(rig.white, mired, brightness);
+        sim_sleep((TRANSITION_MS + 100) * 1000);
+        *warm = duty(LEDC_CHANNEL_0);
+        *cold = duty(LEDC_CHANNEL_1);
+        rig_delete(&rig);
+}
+
+static void test_transition(void) {
+        rig_t rig;
+        uint32_t warm, cold, warm_dim, cold_dim;
+
+        reference(250, 80, &warm, &cold);
+        reference(400, 80, &warm_dim, &cold_dim);
+        CHECK(warm > 0 && cold > 0);
+
+        rig_create(&rig);
+        tunable_white_set(rig.white, 250, 80);
+        CHECK_EQ(tunable_white_get_mired(rig.white), 250);
+        // Half way the outputs are still moving
+        sim_sleep(TRANSITION_MS / 2 * 1000);
+        CHECK(duty(LEDC_CHANNEL_0) < warm || duty(LEDC_CHANNEL_1) < cold);
+
+        sim_sleep((TRANSITION_MS / 2 + 100) * 1000);
+        CHECK_EQ(duty(LEDC_CHANNEL_0), warm);
+        CHECK_EQ(duty(LEDC_CHANNEL_1), cold);
+        // Nothing moves anymore, so nothing is written
+        long before = writes();
+        sim_sleep(1000000);
+        CHECK_EQ(writes(), before);
+
+        // A change half way starts from where the light is, and ends on the new target
+        tunable_white_set(rig.white, 400, 20);
+        sim_sleep(TRANSITION_MS / 2 * 1000);
+        tunable_white_set_brightness(rig.white, 80);
+        sim_sleep((TRANSITION_MS + 100) * 1000);
+        CHECK_EQ(duty(LEDC_CHANNEL_0), warm_dim);
+        CHECK_EQ(duty(LEDC_CHANNEL_1), cold_dim);
+        rig_delete(&rig);
+}
+
+static void test_pause(void) {
+        rig_t rig;
+        uint32_t warm, cold, warm_full, cold_full;
+        const uint32_t blink[2] = { DUTY_MAX, DUTY_MAX };
+
+        reference(300, 60, &warm, &cold);
+        reference(200, 100, &warm_full, &cold_full);
+
+        // Paused in the middle of a transition, the blink stays on the outputs
+        rig_create(&rig);
+        tunable_white_set(rig.white, 200, 100);
+        sim_sleep(TRANSITION_MS / 2 * 1000);
+        tunable_white_pause(rig.white);
+        CHECK(light_fade_set(rig.fade, blink) == ESP_OK);
+        long before = writes();
+        sim_sleep(TRANSITION_MS * 1000);
+        CHECK_EQ(writes(), before);
+        CHECK_EQ(duty(LEDC_CHANNEL_0), DUTY_MAX);
+        CHECK_EQ(duty(LEDC_CHANNEL_1), DUTY_MAX);
+
+        // A change while paused is not shown, but keeps its timing
+        tunable_white_set(rig.white, 300, 60);
+        sim_sleep(TRANSITION_MS * 1000);
+        CHECK_EQ(writes(), before);
+        CHECK_EQ(tunable_white_get_mired(rig.white), 300);
+
+        // The transition has ended meanwhile, so resume goes straight to the target
+        tunable_white_resume(rig.white);
+        sim_sleep(1000);
+        CHECK_EQ(duty(LEDC_CHANNEL_0), warm);
+        CHECK_EQ(duty(LEDC_CHANNEL_1), cold);
+        before = writes();
+        sim_sleep(1000000);
+        CHECK_EQ(writes(), before);
+
+        // Pause and resume back to back, as a blink of one level does
+        tunable_white_set(rig.white, 200, 100);
+        tunable_white_pause(rig.white);
+        tunable_white_resume(rig.white);
+        sim_sleep((TRANSITION_MS + 100) * 1000);
+        CHECK_EQ(duty(LEDC_CHANNEL_0), warm_full);
+        CHECK_EQ(duty(LEDC_CHANNEL_1), cold_full);
+        rig_delete(&rig);
+}
+
+int main(int argc, char **argv) {
+        sim_capture = tmpfile();
+
+        test_transition();
+        test_pause();
+        return host_test_result("tunable_white");
+}
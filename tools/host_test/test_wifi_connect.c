@@ -0,0 +1,391 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <string.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_wifi.h>
+#include <nvs.h>
+#include <wifi_connect.h>
+#include "sim.h"
+#include "host_test.h"
+
+// wifi_connect against the simulated station: what each boot finds in the access point cache,
+// and whether it joins with one probe on the cached channel or with a full scan; then how the
+// supervisor backs off, reinitialises the driver and restarts the device through an outage.
+
+#define SSID "studio"
+#define PASSWORD "pieters1"
+#define BOOT_US 5000000             // a full scan and DHCP fit with room to spare
+#define STEP_US 10000
+#define MINUTE_US (60 * 1000000LL)
+
+static const uint8_t bssid[6] = { 0x24, 0x0a, 0xc4, 0x00, 0x00, 0x01 };
+static const uint8_t moved_bssid[6] = { 0x24, 0x0a, 0xc4, 0x00, 0x00, 0x02 };
+
+static bool ready;
+
+static void on_ready(void) {
+        ready = true;
+}
+
+typedef struct {
+        bool ready;
+        bool fast_connect;
+        uint32_t scans;
+        uint32_t pinned;
+        uint32_t nvs_writes;
+        int64_t connect_us;
+} boot_t;
+
+// Reset the firmware and run it for BOOT_US; what the boot did on the way
+static boot_t boot(const char *ssid, const char *password) {
+        sim_wifi_stats_t wifi_before, wifi_after;
+        sim_nvs_stats_t nvs_before, nvs_after;
+        wifi_connect_timings_t timings;
+
+        sim_reboot(ESP_RST_SW);
+        sim_wifi_get_stats(&wifi_before);
+        sim_nvs_get_stats(&nvs_before);
+
+        ready = false;
+        CHECK(wifi_connect_init(ssid, password, on_ready) == ESP_OK);
+        sim_sleep(BOOT_US);
+
+        sim_wifi_get_stats(&wifi_after);
+        sim_nvs_get_stats(&nvs_after);
+        wifi_connect_get_timings(&timings);
+        return (boot_t) {
+                .ready = ready,
+                .fast_connect = timings.fast_connect,
+                .scans = wifi_after.scans - wifi_before.scans,
+                .pinned = wifi_after.pinned - wifi_before.pinned,
+                .nvs_writes = nvs_after.writes - nvs_before.writes,
+                .connect_us = timings.got_ip_us - timings.init_us,
+        };
+}
+
+// The stored blob, read and written as raw bytes so the test does not depend on its layout
+static size_t read_cache(uint8_t *blob, size_t size) {
+        nvs_handle_t handle;
+        CHECK(nvs_open("wifi_connect", NVS_READWRITE, &handle) == ESP_OK);
+        CHECK(nvs_get_blob(handle, "ap", blob, &size) == ESP_OK);
+        nvs_close(handle);
+        return size;
+}
+
+static void write_cache(const uint8_t *blob, size_t size) {
+        nvs_handle_t handle;
+        CHECK(nvs_open("wifi_connect", NVS_READWRITE, &handle) == ESP_OK);
+        CHECK(nvs_set_blob(handle, "ap", blob, size) == ESP_OK);
+        CHECK(nvs_commit(handle) == ESP_OK);
+        nvs_close(handle);
+}
+
+static void test_cold_and_warm_boot(void) {
+        boot_t cold = boot(SSID, PASSWORD);
+        CHECK(cold.ready);
+        CHECK(!cold.fast_connect);
+        CHECK_EQ(cold.scans, 1);
+        CHECK_EQ(cold.pinned, 0);
+        CHECK_EQ(cold.nvs_writes, 1);
+
+        boot_t warm = boot(SSID, PASSWORD);
+        CHECK(warm.ready);
+        CHECK(warm.fast_connect);
+        CHECK_EQ(warm.scans, 0);
+        CHECK_EQ(warm.pinned, 1);
+        // Same access point again: nothing to write
+        CHECK_EQ(warm.nvs_writes, 0);
+        CHECK(warm.connect_us < cold.connect_us / 2);
+        printf("cold boot %lld ms, warm boot %lld ms\n", (long long)cold.connect_us / 1000,
+               (long long)warm.connect_us / 1000);
+}
+
+static void test_changed_credentials(void) {
+        // A new password hashes differently, so the cached access point is not trusted
+        sim_wifi_set_ap(SSID, "pieters2", bssid, 6);
+        boot_t changed = boot(SSID, "pieters2");
+        CHECK(changed.ready);
+        CHECK(!changed.fast_connect);
+        CHECK_EQ(changed.pinned, 0);
+        CHECK_EQ(changed.scans, 1);
+        CHECK_EQ(changed.nvs_writes, 1);
+
+        boot_t again = boot(SSID, "pieters2");
+        CHECK(again.fast_connect);
+        CHECK_EQ(again.scans, 0);
+
+        // Same for a new network name behind the same access point
+        sim_wifi_set_ap("studio-2g", "pieters2", bssid, 6);
+        boot_t renamed = boot("studio-2g", "pieters2");
+        CHECK(renamed.ready);
+        CHECK(!renamed.fast_connect);
+        CHECK_EQ(renamed.pinned, 0);
+
+        sim_wifi_set_ap(SSID, PASSWORD, bssid, 6);
+        boot(SSID, PASSWORD);
+}
+
+static void test_cache_version(void) {
+        uint8_t blob[64];
+        size_t size = read_cache(blob, sizeof(blob));
+
+        // A cache written by another firmware version is ignored and replaced
+        uint8_t other_version[64];
+        memcpy(other_version, blob, size);
+        other_version[0]++;
+        write_cache(other_version, size);
+        boot_t mismatch = boot(SSID, PASSWORD);
+        CHECK(mismatch.ready);
+        CHECK(!mismatch.fast_connect);
+        CHECK_EQ(mismatch.pinned, 0);
+        CHECK_EQ(mismatch.nvs_writes, 1);
+
+        uint8_t rewritten[64];
+        CHECK_EQ(read_cache(rewritten, sizeof(rewritten)), size);
+        CHECK(memcmp(rewritten, blob, size) == 0);
+
+        // So is one of a different size
+        write_cache(blob, size - 4);
+        boot_t shorter = boot(SSID, PASSWORD);
+        CHECK(!shorter.fast_connect);
+        CHECK_EQ(shorter.pinned, 0);
+
+        uint8_t longer[64] = { 0 };
+        memcpy(longer, blob, size);
+        write_cache(longer, size + 8);
+        boot_t longer_boot = boot(SSID, PASSWORD);
+        CHECK(!longer_boot.fast_connect);
+        CHECK_EQ(longer_boot.pinned, 0);
+
+        boot_t restored = boot(SSID, PASSWORD);
+        CHECK(restored.fast_connect);
+}
+
+static void test_forget(void) {
+        CHECK(wifi_connect_forget() == ESP_OK);
+        boot_t forgotten = boot(SSID, PASSWORD);
+        CHECK(forgotten.ready);
+        CHECK(!forgotten.fast_connect);
+        CHECK_EQ(forgotten.scans, 1);
+        CHECK_EQ(forgotten.pinned, 0);
+}
+
+static void test_moved_access_point(void) {
+        // The cached BSSID is gone: one failed probe, then a scan in the same boot
+        sim_wifi_set_ap(SSID, PASSWORD, moved_bssid, 11);
+        boot_t moved = boot(SSID, PASSWORD);
+        CHECK(moved.ready);
+        CHECK(!moved.fast_connect);
+        CHECK_EQ(moved.pinned, 1);
+        CHECK_EQ(moved.scans, 1);
+        CHECK_EQ(moved.nvs_writes, 1);
+
+        wifi_connect_stats_t stats;
+        wifi_connect_get_stats(&stats);
+        CHECK_EQ(stats.consecutive_failures, 0);
+        CHECK_EQ(stats.retries, 0);
+
+        boot_t settled = boot(SSID, PASSWORD);
+        CHECK(settled.fast_connect);
+        CHECK_EQ(settled.scans, 0);
+}
+
+static uint32_t backoff_window_ms(uint32_t attempt) {
+        uint64_t window = (uint64_t)CONFIG_WIFI_CONNECT_BACKOFF_MIN_MS << (attempt < 20 ? attempt - 1 : 19);
+        return window < CONFIG_WIFI_CONNECT_BACKOFF_MAX_MS ? window : CONFIG_WIFI_CONNECT_BACKOFF_MAX_MS;
+}
+
+// Follow the supervisor failure by failure until `failures` consecutive failures, checking
+// every delay against the backoff window and the driver reinitialisations against the tier
+static void follow_outage(uint32_t failures, bool auth) {
+        wifi_connect_stats_t stats;
+        sim_wifi_stats_t wifi_start, wifi;
+        wifi_connect_get_stats(&stats);
+        sim_wifi_get_stats(&wifi_start);
+        uint32_t seen = stats.consecutive_failures;
+        uint32_t retries = stats.retries;
+        uint32_t reinits = stats.reinits;
+        uint32_t reinits_start = stats.reinits;
+        uint32_t since_reinit = 0;
+        int64_t failed_us = 0;
+        uint32_t backoff_ms = 0;
+
+        while (seen < failures) {
+                sim_sleep(STEP_US);
+                wifi_connect_get_stats(&stats);
+                sim_wifi_get_stats(&wifi);
+                if (stats.retries != retries) {
+                        // The timer fired after the delay it was given
+                        CHECK_EQ(stats.retries, retries + 1);
+                        CHECK(esp_timer_get_time() - failed_us - backoff_ms * 1000LL < STEP_US);
+                        retries = stats.retries;
+                }
+                if (stats.reinits != reinits) {
+                        CHECK_EQ(stats.reinits, reinits + 1);
+                        CHECK_EQ(since_reinit, CONFIG_WIFI_CONNECT_REINIT_AFTER);
+                        CHECK(esp_timer_get_time() - failed_us - backoff_ms * 1000LL < STEP_US);
+                        reinits = stats.reinits;
+                        since_reinit = 0;
+                }
+                if (stats.consecutive_failures == seen) {
+                        continue;
+                }
+                CHECK_EQ(stats.consecutive_failures, seen + 1);
+                seen = stats.consecutive_failures;
+                failed_us = esp_timer_get_time();
+                backoff_ms = stats.backoff_ms;
+                uint32_t window = backoff_window_ms(seen);
+                CHECK(backoff_ms >= window / 2 && backoff_ms <= window);
+                if (!auth) {
+                        since_reinit++;
+                }
+        }
+        CHECK_EQ(wifi.inits - wifi_start.inits, stats.reinits - reinits_start);
+        if (auth) {
+                CHECK_EQ(stats.reinits, 0);
+                CHECK_EQ(stats.failures[WIFI_CONNECT_FAILURE_AUTH], failures);
+        }
+}
+
+static void test_backoff_and_reinit(void) {
+        sim_wifi_set_ap(SSID, PASSWORD, bssid, 6);
+        boot_t up = boot(SSID, PASSWORD);
+        CHECK(up.ready);
+
+        // Beacon loss, then scans that find nothing
+        wifi_connect_stats_t stats;
+        wifi_connect_get_stats(&stats);
+        uint32_t disconnects = stats.disconnects;
+        sim_wifi_set_ap_up(false);
+        follow_outage(3 * CONFIG_WIFI_CONNECT_REINIT_AFTER + 2, false);
+
+        wifi_connect_get_stats(&stats);
+        CHECK_EQ(stats.reinits, 3);
+        CHECK_EQ(stats.failures[WIFI_CONNECT_FAILURE_LINK_LOST], 1);
+        CHECK_EQ(stats.failures[WIFI_CONNECT_FAILURE_NO_AP], stats.consecutive_failures - 1);
+        CHECK_EQ(stats.disconnects - disconnects, stats.consecutive_failures);
+        CHECK_EQ(stats.last_reason, WIFI_REASON_NO_AP_FOUND);
+        CHECK(stats.backoff_ms >= CONFIG_WIFI_CONNECT_BACKOFF_MAX_MS / 2);
+        CHECK_EQ(sim_restarts, 0);
+
+        // Back on the next attempt, with the counters reset
+        sim_wifi_set_ap_up(true);
+        sim_sleep(stats.backoff_ms * 1000LL + BOOT_US);
+        wifi_connect_get_stats(&stats);
+        CHECK(stats.connected);
+        CHECK_EQ(stats.consecutive_failures, 0);
+        CHECK_EQ(stats.backoff_ms, 0);
+}
+
+static void test_auth_failures(void) {
+        // A driver reset cannot fix a wrong password: back off only
+        sim_wifi_set_ap(SSID, "changed", bssid, 6);
+        boot_t rejected = boot(SSID, PASSWORD);
+        CHECK(!rejected.ready);
+        follow_outage(3 * CONFIG_WIFI_CONNECT_REINIT_AFTER, true);
+        sim_wifi_set_ap(SSID, PASSWORD, bssid, 6);
+}
+
+// Run until the supervisor restarts the device; the offline time it gave up after
+static int64_t wait_for_restart(void) {
+        uint32_t restarts = sim_restarts;
+        wifi_connect_stats_t stats;
+
+        wifi_connect_get_stats(&stats);
+        int64_t offline_us = 0;
+        while (sim_restarts == restarts && esp_timer_get_time() < 100 * 24 * 60 * MINUTE_US) {
+                sim_sleep(STEP_US * 100);
+                wifi_connect_get_stats(&stats);
+                if (stats.consecutive_failures == 1 && offline_us == 0) {
+                        offline_us = esp_timer_get_time();
+                }
+        }
+        CHECK_EQ(sim_restarts, restarts + 1);
+        return sim_restart_us - offline_us;
+}
+
+static void test_restart_tiers(void) {
+        sim_wifi_set_ap(SSID, PASSWORD, bssid, 6);
+        sim_reboot(ESP_RST_POWERON);
+        CHECK(wifi_connect_init(SSID, PASSWORD, on_ready) == ESP_OK);
+        sim_sleep(BOOT_US);
+
+        // Every restart that did not bring the connection back doubles the period, up to eight times
+        sim_wifi_set_ap_up(false);
+        int64_t limit_us = CONFIG_WIFI_CONNECT_RESTART_AFTER_MIN * MINUTE_US;
+        for (int restart = 0; restart < 5; restart++) {
+                int64_t offline_us = wait_for_restart();
+                int64_t tier_us = limit_us << (restart < 3 ? restart : 3);
+                CHECK(offline_us >= tier_us);
+                // Checked after each failure, so at most one maximum delay and a scan late
+                CHECK(offline_us < tier_us + CONFIG_WIFI_CONNECT_BACKOFF_MAX_MS * 1000LL + BOOT_US);
+                printf("restart %d after %lld minutes offline\n", restart + 1, (long long)(offline_us / MINUTE_US));
+
+                sim_reboot(ESP_RST_SW);
+                ready = false;
+                CHECK(wifi_connect_init(SSID, PASSWORD, on_ready) == ESP_OK);
+                wifi_connect_stats_t stats;
+                wifi_connect_get_stats(&stats);
+                CHECK_EQ(stats.restarts, restart + 1);
+                CHECK_EQ(stats.consecutive_failures, 0);
+                CHECK_EQ(stats.reinits, 0);
+        }
+
+        // A connection ends the escalation
+        sim_wifi_set_ap_up(true);
+        sim_sleep(BOOT_US);
+        CHECK(ready);
+        sim_reboot(ESP_RST_SW);
+        CHECK(wifi_connect_init(SSID, PASSWORD, on_ready) == ESP_OK);
+        wifi_connect_stats_t stats;
+        wifi_connect_get_stats(&stats);
+        CHECK_EQ(stats.restarts, 0);
+        sim_sleep(BOOT_US);
+
+        // A restart count left from before a power cycle is not trusted
+        sim_wifi_set_ap_up(false);
+        wait_for_restart();
+        sim_reboot(ESP_RST_POWERON);
+        CHECK(wifi_connect_init(SSID, PASSWORD, on_ready) == ESP_OK);
+        wifi_connect_get_stats(&stats);
+        CHECK_EQ(stats.restarts, 0);
+        sim_wifi_set_ap_up(true);
+        sim_sleep(BOOT_US);
+}
+
+int main(void) {
+        sim_log_level = ESP_LOG_WARN;
+        sim_wifi_set_ap(SSID, PASSWORD, bssid, 6);
+
+        test_cold_and_warm_boot();
+        test_changed_credentials();
+        test_cache_version();
+        test_forget();
+        test_moved_access_point();
+        test_backoff_and_reinit();
+        test_auth_failures();
+        test_restart_tiers();
+        return host_test_result("wifi_connect");
+}
@@ -0,0 +1,334 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+// Run the lighting components on the host against simulated led_strip and LEDC drivers.
+//
+// esp32-strip-render, esp32-strip-effects and esp32-light-fade are built unchanged on top of
+// shim/, which provides FreeRTOS tasks and esp_timer on a virtual clock. Every strip refresh
+// and every LEDC update or fade is written to stdout in the trace formats of the components,
+// so tools/render_trace_report.py reports frame rates, intervals and duty histories for a run,
+// and --golden compares two runs frame by frame. It is built with the host tools in tools/; the top
+// level README lists the scenarios.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <led_strip.h>
+#include <driver/ledc.h>
+#include <strip_render.h>
+#include <strip_effects.h>
+#include <light_fade.h>
+#include <light_curve.h>
+#include "shim/sim.h"
+
+#define MAX_STEPS 64
+
+static const char *effect_names[STRIP_EFFECT_COUNT] = {
+        [STRIP_EFFECT_NONE] = "none",
+        [STRIP_EFFECT_RAINBOW] = "rainbow",
+        [STRIP_EFFECT_CHASE] = "chase",
+        [STRIP_EFFECT_TWINKLE] = "twinkle",
+        [STRIP_EFFECT_FIRE] = "fire",
+        [STRIP_EFFECT_BREATHING] = "breathing",
+        [STRIP_EFFECT_GRADIENT] = "gradient",
+};
+
+typedef struct {
+        uint32_t time_ms;
+        bool jump;
+        uint32_t values[LIGHT_FADE_MAX_CHANNELS];
+} step_t;
+
+static void usage(void) {
+        fprintf(stderr,
+                "usage: render_sim strip [options]   run an effect on a simulated strip\n"
+                "       render_sim fade [options]    run light_fade on simulated LEDC channels\n"
+                "\n"
+                "common options:\n"
+                "  --seconds S           virtual time to run (default 10)\n"
+                "  --name NAME           name of the strip or fade group in the capture\n"
+                "  --verbose             log at debug level on stderr\n"
+                "\n"
+                "strip options:\n"
+                "  --effect NAME         rainbow, chase, twinkle, fire, breathing or gradient (default rainbow)\n"
+                "  --length N            pixels (default 60)\n"
+                "  --rgbw                four channels per pixel\n"
+                "  --async               transmit from the render task, as the strip examples do\n"
+                "  --fps N               effect frame rate (default 50)\n"
+                "  --budget MA           supply budget of the render limiter (default none)\n"
+                "  --brightness P        percent (default 100)\n"
+                "  --primary R,G,B[,W]   primary colour (default 255,0,0)\n"
+                "  --secondary R,G,B[,W] secondary colour (default 0,0,255)\n"
+                "  --pixels              also write the pixel contents of every refresh\n"
+                "\n"
+                "fade options:\n"
+                "  --channels N          LEDC channels in the group, 1-%d (default 1)\n"
+                "  --resolution BITS     duty resolution (default 13)\n"
+                "  --fraction-bits N     bits below the duty LSB (default 3)\n"
+                "  --full-scale-ms MS    fade time from off to full (default 400)\n"
+                "  --to MS:P[,P...]      at MS, fade to brightness P percent per channel; repeat for more steps\n"
+                "  --set MS:P[,P...]     at MS, jump to brightness P percent per channel\n"
+                "  --duty                take the --to and --set values as duties with fraction bits instead\n",
+                LIGHT_FADE_MAX_CHANNELS);
+        exit(2);
+}
+
+static int parse_list(const char *text, uint32_t *values, int max) {
+        int count = 0;
+        char *end;
+
+        while (count < max) {
+                values[count++] = strtoul(text, &end, 10);
+                if (*end != ',') {
+                        break;
+                }
+                text = end + 1;
+        }
+        if (*end) {
+                fprintf(stderr, "render_sim: cannot read \"%s\"\n", text);
+                exit(2);
+        }
+        return count;
+}
+
+static color_rgbw_t parse_color(const char *text) {
+        uint32_t values[4] = { 0 };
+        parse_list(text, values, 4);
+        return (color_rgbw_t) { .red = values[0], .green = values[1], .blue = values[2], .white = values[3] };
+}
+
+static void check(esp_err_t err, const char *what) {
+        if (err != ESP_OK) {
+                fprintf(stderr, "render_sim: %s: %s\n", what, esp_err_to_name(err));
+                exit(1);
+        }
+}
+
+static int run_strip(int argc, char **argv, uint32_t seconds, const char *name) {
+        strip_effect_params_t params = {
+                .effect = STRIP_EFFECT_RAINBOW,
+                .primary = { .red = 255 },
+                .secondary = { .blue = 255 },
+                .brightness = 100,
+        };
+        uint32_t length = 60;
+        uint32_t fps = 50;
+        uint32_t budget_ma = 0;
+        bool rgbw = false;
+        bool async = false;
+
+        for (int i = 0; i < argc; i++) {
+                const char *arg = argv[i];
+                const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+                if (!strcmp(arg, "--rgbw")) {
+                        rgbw = true;
+                } else if (!strcmp(arg, "--async")) {
+                        async = true;
+                } else if (!strcmp(arg, "--pixels")) {
+                        sim_capture_pixels = true;
+                } else if (!value) {
+                        usage();
+                } else if (!strcmp(arg, "--effect")) {
+                        params.effect = STRIP_EFFECT_COUNT;
+                        for (int effect = STRIP_EFFECT_RAINBOW; effect < STRIP_EFFECT_COUNT; effect++) {
+                                if (!strcmp(value, effect_names[effect])) {
+                                        params.effect = effect;
+                                }
+                        }
+                        if (params.effect == STRIP_EFFECT_COUNT) {
+                                usage();
+                        }
+                        i++;
+                } else if (!strcmp(arg, "--length")) {
+                        length = strtoul(argv[++i], NULL, 10);
+                } else if (!strcmp(arg, "--fps")) {
+                        fps = strtoul(argv[++i], NULL, 10);
+                } else if (!strcmp(arg, "--budget")) {
+                        budget_ma = strtoul(argv[++i], NULL, 10);
+                } else if (!strcmp(arg, "--brightness")) {
+                        params.brightness = strtoul(argv[++i], NULL, 10);
+                } else if (!strcmp(arg, "--primary")) {
+                        params.primary = parse_color(argv[++i]);
+                } else if (!strcmp(arg, "--secondary")) {
+                        params.secondary = parse_color(argv[++i]);
+                } else {
+                        usage();
+                }
+        }
+
+        const led_strip_config_t strip_config = {
+                .max_leds = length,
+                .led_pixel_format = rgbw ? LED_PIXEL_FORMAT_GRBW : LED_PIXEL_FORMAT_GRB,
+        };
+        const led_strip_rmt_config_t rmt_config = { 0 };
+        led_strip_handle_t strip;
+        check(led_strip_new_rmt_device(&strip_config, &rmt_config, &strip), "led_strip");
+        if (name) {
+                sim_led_strip_set_name(strip, name);
+        }
+
+        const strip_render_config_t render_config = {
+                .strip = strip,
+                .length = length,
+                .rgbw = rgbw,
+                .async = async,
+                .max_current_ma = budget_ma,
+                .name = name,
+        };
+        strip_render_handle_t render;
+        check(strip_render_create(&render_config, &render), "strip_render");
+
+        const strip_effects_config_t effects_config = {
+                .render = render,
+                .length = length,
+                .frame_rate = fps,
+        };
+        strip_effects_handle_t effects;
+        check(strip_effects_create(&effects_config, &effects), "strip_effects");
+        check(strip_effects_start(effects, &params), "strip_effects_start");
+
+        sim_run_until((int64_t)seconds * 1000000);
+        strip_effects_stop(effects);
+        // Let an asynchronous transmit still in flight finish
+        sim_sleep(100000);
+
+        strip_render_stats_t render_stats;
+        strip_effects_stats_t effects_stats;
+        strip_render_get_stats(render, &render_stats);
+        strip_effects_get_stats(effects, &effects_stats);
+        sim_print_summary();
+        fprintf(stderr, "  render: %u frames, %u refreshes, %u dropped, %u limited, %u pixels written, wire %u us\n",
+                render_stats.frames, render_stats.refreshes, render_stats.dropped, render_stats.limited,
+                render_stats.pixels_written, render_stats.wire_us);
+        fprintf(stderr, "  effects: %u frames, %u overruns\n", effects_stats.frames, effects_stats.overruns);
+        return 0;
+}
+
+static int run_fade(int argc, char **argv, uint32_t seconds, const char *name) {
+        static step_t steps[MAX_STEPS];
+        int step_count = 0;
+        int channel_count = 1;
+        int resolution = 13;
+        int fraction_bits = 3;
+        uint32_t full_scale_ms = 400;
+        bool raw = false;
+
+        for (int i = 0; i < argc; i++) {
+                const char *arg = argv[i];
+                if (!strcmp(arg, "--duty")) {
+                        raw = true;
+                        continue;
+                }
+                if (i + 1 >= argc) {
+                        usage();
+                }
+                const char *value = argv[++i];
+                if (!strcmp(arg, "--channels")) {
+                        channel_count = atoi(value);
+                } else if (!strcmp(arg, "--resolution")) {
+                        resolution = atoi(value);
+                } else if (!strcmp(arg, "--fraction-bits")) {
+                        fraction_bits = atoi(value);
+                } else if (!strcmp(arg, "--full-scale-ms")) {
+                        full_scale_ms = strtoul(value, NULL, 10);
+                } else if ((!strcmp(arg, "--to") || !strcmp(arg, "--set")) && step_count < MAX_STEPS) {
+                        step_t *step = &steps[step_count++];
+                        char *end;
+                        step->time_ms = strtoul(value, &end, 10);
+                        step->jump = !strcmp(arg, "--set");
+                        if (*end != ':') {
+                                usage();
+                        }
+                        int count = parse_list(end + 1, step->values, LIGHT_FADE_MAX_CHANNELS);
+                        // One value sets every channel
+                        for (int ch = count; ch < LIGHT_FADE_MAX_CHANNELS; ch++) {
+                                step->values[ch] = step->values[count - 1];
+                        }
+                } else {
+                        usage();
+                }
+        }
+        if (channel_count < 1 || channel_count > LIGHT_FADE_MAX_CHANNELS || resolution < 1 || resolution > 20) {
+                usage();
+        }
+
+        uint32_t duty_max = (1 << resolution) - 1;
+        light_fade_config_t fade_config = {
+                .speed_mode = LEDC_LOW_SPEED_MODE,
+                .channel_count = channel_count,
+                .duty_max = duty_max,
+                .full_scale_ms = full_scale_ms,
+                .fraction_bits = fraction_bits,
+                .name = name,
+        };
+        for (int ch = 0; ch < channel_count; ch++) {
+                fade_config.channels[ch] = ch;
+        }
+        light_fade_handle_t fade;
+        check(light_fade_create(&fade_config, &fade), "light_fade");
+
+        for (int i = 0; i < step_count; i++) {
+                const step_t *step = &steps[i];
+                uint32_t duties[LIGHT_FADE_MAX_CHANNELS];
+                for (int ch = 0; ch < channel_count; ch++) {
+                        // The brightness mapping of the light examples
+                        duties[ch] = raw ? step->values[ch] :
+                                     light_curve_duty(light_curve_cie(light_curve_percent(step->values[ch])),
+                                                      duty_max, fraction_bits);
+                }
+                sim_run_until((int64_t)step->time_ms * 1000);
+                check(step->jump ? light_fade_set(fade, duties) : light_fade_to(fade, duties), "fade");
+        }
+        sim_run_until((int64_t)seconds * 1000000);
+        sim_print_summary();
+        return 0;
+}
+
+int main(int argc, char **argv) {
+        uint32_t seconds = 10;
+        const char *name = NULL;
+        char *rest[argc];
+        int rest_count = 0;
+
+        if (argc < 2) {
+                usage();
+        }
+        for (int i = 2; i < argc; i++) {
+                if (!strcmp(argv[i], "--seconds") && i + 1 < argc) {
+                        seconds = strtoul(argv[++i], NULL, 10);
+                } else if (!strcmp(argv[i], "--name") && i + 1 < argc) {
+                        name = argv[++i];
+                } else if (!strcmp(argv[i], "--verbose")) {
+                        sim_log_level = 4;
+                } else {
+                        rest[rest_count++] = argv[i];
+                }
+        }
+        if (!strcmp(argv[1], "strip")) {
+                return run_strip(rest_count, rest, seconds, name);
+        }
+        if (!strcmp(argv[1], "fade")) {
+                return run_fade(rest_count, rest, seconds, name);
+        }
+        usage();
+}
@@ -0,0 +1,149 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <esp_event.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include "sim_internal.h"
+
+#define EVENT_TASK_PRIORITY 20      // ESP_TASKD_EVENT_PRIO
+#define EVENT_QUEUE_LENGTH  32
+
+typedef struct {
+        esp_event_base_t base;
+        int32_t id;
+        void *data;
+} event_t;
+
+struct handler {
+        esp_event_base_t base;
+        int32_t id;
+        esp_event_handler_t function;
+        void *arg;
+        struct handler *next;
+};
+
+static QueueHandle_t event_queue;
+static struct handler *handlers;
+
+static bool matches(const struct handler *handler, esp_event_base_t base, int32_t id) {
+        return handler->base == base && (handler->id == ESP_EVENT_ANY_ID || handler->id == id);
+}
+
+static void event_task(void *arg) {
+        event_t event;
+
+        for (;;) {
+                xQueueReceive(event_queue, &event, portMAX_DELAY);
+                struct handler *next;
+                for (struct handler *handler = handlers; handler; handler = next) {
+                        next = handler->next;
+                        if (matches(handler, event.base, event.id)) {
+                                handler->function(handler->arg, event.base, event.id, event.data);
+                        }
+                }
+                free(event.data);
+        }
+}
+
+esp_err_t esp_event_loop_create_default(void) {
+        if (event_queue) {
+                return ESP_ERR_INVALID_STATE;
+        }
+        event_queue = xQueueCreate(EVENT_QUEUE_LENGTH, sizeof(event_t));
+        if (!event_queue) {
+                return ESP_ERR_NO_MEM;
+        }
+        if (xTaskCreate(event_task, "sys_evt", 2304, NULL, EVENT_TASK_PRIORITY, NULL) != pdPASS) {
+                return ESP_ERR_NO_MEM;
+        }
+        return ESP_OK;
+}
+
+esp_err_t esp_event_handler_register(esp_event_base_t base, int32_t id, esp_event_handler_t function, void *arg) {
+        if (!event_queue) {
+                return ESP_ERR_INVALID_STATE;
+        }
+        struct handler *handler = calloc(1, sizeof(*handler));
+        if (!handler) {
+                return ESP_ERR_NO_MEM;
+        }
+        *handler = (struct handler) { .base = base, .id = id, .function = function, .arg = arg };
+
+        struct handler **tail = &handlers;
+        while (*tail) {
+                tail = &(*tail)->next;
+        }
+        *tail = handler;
+        return ESP_OK;
+}
+
+esp_err_t esp_event_handler_unregister(esp_event_base_t base, int32_t id, esp_event_handler_t function) {
+        for (struct handler **link = &handlers; *link; link = &(*link)->next) {
+                struct handler *handler = *link;
+                if (handler->base == base && handler->id == id && handler->function == function) {
+                        *link = handler->next;
+                        free(handler);
+                        return ESP_OK;
+                }
+        }
+        return ESP_OK;
+}
+
+esp_err_t esp_event_post(esp_event_base_t base, int32_t id, const void *data, size_t size, TickType_t ticks_to_wait) {
+        if (!event_queue) {
+                return ESP_ERR_INVALID_STATE;
+        }
+        event_t event = { .base = base, .id = id };
+        if (size) {
+                event.data = malloc(size);
+                if (!event.data) {
+                        return ESP_ERR_NO_MEM;
+                }
+                memcpy(event.data, data, size);
+        }
+        if (xQueueSend(event_queue, &event, ticks_to_wait) != pdTRUE) {
+                free(event.data);
+                return ESP_ERR_TIMEOUT;
+        }
+        return ESP_OK;
+}
+
+void sim_event_reset(void) {
+        while (handlers) {
+                struct handler *next = handlers->next;
+                free(handlers);
+                handlers = next;
+        }
+        if (event_queue) {
+                event_t event;
+                while (xQueueReceive(event_queue, &event, 0) == pdTRUE) {
+                        free(event.data);
+                }
+                vQueueDelete(event_queue);
+                event_queue = NULL;
+        }
+}
@@ -0,0 +1,169 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <string.h>
+#include <driver/gpio.h>
+#include "sim.h"
+
+typedef struct {
+        gpio_mode_t mode;
+        bool pull_up;
+        bool driven;                // an outside level from sim_gpio_set_input()
+        uint8_t input;
+        uint8_t output;
+        gpio_int_type_t intr_type;
+        gpio_isr_t handler;
+        void *arg;
+} pin_t;
+
+static pin_t pins[GPIO_NUM_MAX];
+static bool isr_service;
+
+static int level_of(const pin_t *pin) {
+        if (pin->mode == GPIO_MODE_OUTPUT) {
+                return pin->output;
+        }
+        return pin->driven ? pin->input : pin->pull_up;
+}
+
+esp_err_t gpio_config(const gpio_config_t *config) {
+        if (!config->pin_bit_mask || config->pin_bit_mask >> GPIO_NUM_MAX) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        for (int gpio = 0; gpio < GPIO_NUM_MAX; gpio++) {
+                if (config->pin_bit_mask & (1ULL << gpio)) {
+                        pins[gpio].mode = config->mode;
+                        pins[gpio].pull_up = config->pull_up_en;
+                        pins[gpio].intr_type = config->intr_type;
+                }
+        }
+        return ESP_OK;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio) {
+        if (!GPIO_IS_VALID_GPIO(gpio)) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        bool driven = pins[gpio].driven;
+        uint8_t input = pins[gpio].input;
+        memset(&pins[gpio], 0, sizeof(pins[gpio]));
+        pins[gpio].mode = GPIO_MODE_INPUT;
+        pins[gpio].pull_up = true;
+        pins[gpio].driven = driven;
+        pins[gpio].input = input;
+        return ESP_OK;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio, gpio_mode_t mode) {
+        if (!GPIO_IS_VALID_GPIO(gpio)) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        pins[gpio].mode = mode;
+        return ESP_OK;
+}
+
+esp_err_t gpio_set_pull_mode(gpio_num_t gpio, gpio_pull_mode_t pull) {
+        if (!GPIO_IS_VALID_GPIO(gpio)) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        pins[gpio].pull_up = pull == GPIO_PULLUP_ONLY || pull == GPIO_PULLUP_PULLDOWN;
+        return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio, uint32_t level) {
+        if (!GPIO_IS_VALID_GPIO(gpio)) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        pins[gpio].output = level ? 1 : 0;
+        return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio) {
+        return GPIO_IS_VALID_GPIO(gpio) ? level_of(&pins[gpio]) : 0;
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t gpio, gpio_int_type_t intr_type) {
+        if (!GPIO_IS_VALID_GPIO(gpio)) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        pins[gpio].intr_type = intr_type;
+        return ESP_OK;
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags) {
+        if (isr_service) {
+                return ESP_ERR_INVALID_STATE;
+        }
+        isr_service = true;
+        return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio, gpio_isr_t handler, void *arg) {
+        if (!GPIO_IS_VALID_GPIO(gpio)) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        if (!isr_service) {
+                return ESP_ERR_INVALID_STATE;
+        }
+        pins[gpio].handler = handler;
+        pins[gpio].arg = arg;
+        return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio) {
+        if (!GPIO_IS_VALID_GPIO(gpio)) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        if (!isr_service) {
+                return ESP_ERR_INVALID_STATE;
+        }
+        pins[gpio].handler = NULL;
+        pins[gpio].arg = NULL;
+        return ESP_OK;
+}
+
+static bool edge_enabled(gpio_int_type_t intr_type, int level) {
+        switch (intr_type) {
+        case GPIO_INTR_POSEDGE:
+        case GPIO_INTR_HIGH_LEVEL:
+                return level == 1;
+        case GPIO_INTR_NEGEDGE:
+        case GPIO_INTR_LOW_LEVEL:
+                return level == 0;
+        case GPIO_INTR_ANYEDGE:
+                return true;
+        default:
+                return false;
+        }
+}
+
+void sim_gpio_set_input(int gpio, int level) {
+        pin_t *pin = &pins[gpio];
+        int before = level_of(pin);
+
+        pin->driven = true;
+        pin->input = level ? 1 : 0;
+        if (level_of(pin) != before && pin->handler && edge_enabled(pin->intr_type, pin->input)) {
+                pin->handler(pin->arg);
+        }
+}
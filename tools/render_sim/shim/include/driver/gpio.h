@@ -0,0 +1,96 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+// Pins with a level, a pull and an interrupt type. Inputs are driven from the scenario with
+// sim_gpio_set_input(), which runs the pin's ISR handler at once when the edge is enabled.
+
+typedef enum {
+        GPIO_NUM_NC = -1,
+        GPIO_NUM_0, GPIO_NUM_1, GPIO_NUM_2, GPIO_NUM_3, GPIO_NUM_4, GPIO_NUM_5, GPIO_NUM_6, GPIO_NUM_7,
+        GPIO_NUM_8, GPIO_NUM_9, GPIO_NUM_10, GPIO_NUM_11, GPIO_NUM_12, GPIO_NUM_13, GPIO_NUM_14, GPIO_NUM_15,
+        GPIO_NUM_16, GPIO_NUM_17, GPIO_NUM_18, GPIO_NUM_19, GPIO_NUM_20, GPIO_NUM_21, GPIO_NUM_22, GPIO_NUM_23,
+        GPIO_NUM_24, GPIO_NUM_25, GPIO_NUM_26, GPIO_NUM_27, GPIO_NUM_28, GPIO_NUM_29, GPIO_NUM_30, GPIO_NUM_31,
+        GPIO_NUM_32, GPIO_NUM_33, GPIO_NUM_34, GPIO_NUM_35, GPIO_NUM_36, GPIO_NUM_37, GPIO_NUM_38, GPIO_NUM_39,
+        GPIO_NUM_MAX,
+} gpio_num_t;
+
+#define GPIO_IS_VALID_GPIO(gpio) ((gpio) >= 0 && (gpio) < GPIO_NUM_MAX)
+
+typedef enum {
+        GPIO_MODE_DISABLE,
+        GPIO_MODE_INPUT,
+        GPIO_MODE_OUTPUT,
+} gpio_mode_t;
+
+typedef enum {
+        GPIO_PULLUP_ONLY,
+        GPIO_PULLDOWN_ONLY,
+        GPIO_PULLUP_PULLDOWN,
+        GPIO_FLOATING,
+} gpio_pull_mode_t;
+
+typedef enum {
+        GPIO_PULLUP_DISABLE,
+        GPIO_PULLUP_ENABLE,
+} gpio_pullup_t;
+
+typedef enum {
+        GPIO_PULLDOWN_DISABLE,
+        GPIO_PULLDOWN_ENABLE,
+} gpio_pulldown_t;
+
+typedef enum {
+        GPIO_INTR_DISABLE,
+        GPIO_INTR_POSEDGE,
+        GPIO_INTR_NEGEDGE,
+        GPIO_INTR_ANYEDGE,
+        GPIO_INTR_LOW_LEVEL,
+        GPIO_INTR_HIGH_LEVEL,
+} gpio_int_type_t;
+
+typedef struct {
+        uint64_t pin_bit_mask;
+        gpio_mode_t mode;
+        gpio_pullup_t pull_up_en;
+        gpio_pulldown_t pull_down_en;
+        gpio_int_type_t intr_type;
+} gpio_config_t;
+
+typedef void (*gpio_isr_t)(void *arg);
+
+esp_err_t gpio_config(const gpio_config_t *config);
+esp_err_t gpio_reset_pin(gpio_num_t gpio);
+esp_err_t gpio_set_direction(gpio_num_t gpio, gpio_mode_t mode);
+esp_err_t gpio_set_pull_mode(gpio_num_t gpio, gpio_pull_mode_t pull);
+esp_err_t gpio_set_level(gpio_num_t gpio, uint32_t level);
+int gpio_get_level(gpio_num_t gpio);
+esp_err_t gpio_set_intr_type(gpio_num_t gpio, gpio_int_type_t intr_type);
+esp_err_t gpio_install_isr_service(int intr_alloc_flags);
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio, gpio_isr_t handler, void *arg);
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio);
@@ -0,0 +1,62 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+// LEDC channels with a duty and a linear hardware fade on the virtual clock. Every duty update
+// and fade start is written to the capture.
+
+typedef enum {
+        LEDC_LOW_SPEED_MODE,
+        LEDC_SPEED_MODE_MAX,
+} ledc_mode_t;
+
+typedef enum {
+        LEDC_CHANNEL_0,
+        LEDC_CHANNEL_1,
+        LEDC_CHANNEL_2,
+        LEDC_CHANNEL_3,
+        LEDC_CHANNEL_4,
+        LEDC_CHANNEL_5,
+        LEDC_CHANNEL_6,
+        LEDC_CHANNEL_7,
+        LEDC_CHANNEL_MAX,
+} ledc_channel_t;
+
+typedef enum {
+        LEDC_FADE_NO_WAIT,
+        LEDC_FADE_WAIT_DONE,
+} ledc_fade_mode_t;
+
+esp_err_t ledc_fade_func_install(int intr_alloc_flags);
+esp_err_t ledc_set_duty(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t duty);
+esp_err_t ledc_update_duty(ledc_mode_t speed_mode, ledc_channel_t channel);
+uint32_t ledc_get_duty(ledc_mode_t speed_mode, ledc_channel_t channel);
+esp_err_t ledc_set_fade_with_time(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t target_duty,
+                                  int max_fade_time_ms);
+esp_err_t ledc_fade_start(ledc_mode_t speed_mode, ledc_channel_t channel, ledc_fade_mode_t fade_mode);
+esp_err_t ledc_fade_stop(ledc_mode_t speed_mode, ledc_channel_t channel);
@@ -0,0 +1,89 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+// UART ports with nothing attached: the driver installs and writes go out, but no byte ever
+// comes back. Enough to build drivers whose protocol parsing is tested on recorded streams.
+
+typedef enum {
+        UART_NUM_0,
+        UART_NUM_1,
+        UART_NUM_2,
+        UART_NUM_MAX,
+} uart_port_t;
+
+typedef enum {
+        UART_DATA_8_BITS = 3,
+} uart_word_length_t;
+
+typedef enum {
+        UART_PARITY_DISABLE,
+} uart_parity_t;
+
+typedef enum {
+        UART_STOP_BITS_1 = 1,
+} uart_stop_bits_t;
+
+typedef enum {
+        UART_HW_FLOWCTRL_DISABLE,
+} uart_hw_flowcontrol_t;
+
+typedef struct {
+        int baud_rate;
+        uart_word_length_t data_bits;
+        uart_parity_t parity;
+        uart_stop_bits_t stop_bits;
+        uart_hw_flowcontrol_t flow_ctrl;
+} uart_config_t;
+
+typedef enum {
+        UART_DATA,
+        UART_BREAK,
+        UART_BUFFER_FULL,
+        UART_FIFO_OVF,
+        UART_FRAME_ERR,
+        UART_PARITY_ERR,
+} uart_event_type_t;
+
+typedef struct {
+        uart_event_type_t type;
+        size_t size;
+} uart_event_t;
+
+#define UART_PIN_NO_CHANGE (-1)
+
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t *config);
+esp_err_t uart_set_pin(uart_port_t port, int tx_gpio, int rx_gpio, int rts_gpio, int cts_gpio);
+esp_err_t uart_driver_install(uart_port_t port, int rx_buffer_size, int tx_buffer_size, int queue_size,
+                              QueueHandle_t *queue, int intr_alloc_flags);
+esp_err_t uart_driver_delete(uart_port_t port);
+int uart_read_bytes(uart_port_t port, void *buffer, uint32_t length, TickType_t ticks_to_wait);
+int uart_write_bytes(uart_port_t port, const void *data, size_t size);
+esp_err_t uart_flush_input(uart_port_t port);
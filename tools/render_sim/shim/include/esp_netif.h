@@ -0,0 +1,61 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <esp_event.h>
+
+typedef struct esp_netif_obj esp_netif_t;
+
+typedef struct {
+        uint32_t addr;
+} esp_ip4_addr_t;
+
+typedef struct {
+        esp_ip4_addr_t ip;
+        esp_ip4_addr_t netmask;
+        esp_ip4_addr_t gw;
+} esp_netif_ip_info_t;
+
+typedef struct {
+        esp_netif_t *esp_netif;
+        esp_netif_ip_info_t ip_info;
+        bool ip_changed;
+} ip_event_got_ip_t;
+
+ESP_EVENT_DECLARE_BASE(IP_EVENT);
+
+typedef enum {
+        IP_EVENT_STA_GOT_IP,
+        IP_EVENT_STA_LOST_IP,
+} ip_event_t;
+
+#define IPSTR "%d.%d.%d.%d"
+#define IP2STR(ipaddr) ((ipaddr)->addr >> 0) & 0xff, ((ipaddr)->addr >> 8) & 0xff, \
+                       ((ipaddr)->addr >> 16) & 0xff, ((ipaddr)->addr >> 24) & 0xff
+
+esp_err_t esp_netif_init(void);
+esp_netif_t *esp_netif_create_default_wifi_sta(void);
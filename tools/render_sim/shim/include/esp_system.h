@@ -0,0 +1,51 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <esp_err.h>
+
+typedef enum {
+        ESP_RST_UNKNOWN,
+        ESP_RST_POWERON,
+        ESP_RST_EXT,
+        ESP_RST_SW,
+        ESP_RST_PANIC,
+        ESP_RST_INT_WDT,
+        ESP_RST_TASK_WDT,
+        ESP_RST_WDT,
+        ESP_RST_DEEPSLEEP,
+        ESP_RST_BROWNOUT,
+        ESP_RST_SDIO,
+} esp_reset_reason_t;
+
+typedef void (*shutdown_handler_t)(void);
+
+// The reason of the current simulated boot; see sim_reboot()
+esp_reset_reason_t esp_reset_reason(void);
+
+// Runs the shutdown handlers, counts the restart and stops the calling task for good. The
+// scenario then boots the firmware again with sim_reboot().
+void esp_restart(void);
+
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handler);
@@ -0,0 +1,149 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <esp_event.h>
+
+// A station and one access point, controlled with sim_wifi_*() in sim.h. Connect attempts,
+// DHCP and beacon loss take virtual time and end in the same events as on the device.
+
+#define ESP_ERR_WIFI_BASE           0x3000
+#define ESP_ERR_WIFI_NOT_INIT       (ESP_ERR_WIFI_BASE + 1)
+#define ESP_ERR_WIFI_NOT_STARTED    (ESP_ERR_WIFI_BASE + 2)
+#define ESP_ERR_WIFI_NOT_STOPPED    (ESP_ERR_WIFI_BASE + 3)
+#define ESP_ERR_WIFI_IF             (ESP_ERR_WIFI_BASE + 4)
+#define ESP_ERR_WIFI_MODE           (ESP_ERR_WIFI_BASE + 5)
+#define ESP_ERR_WIFI_STATE          (ESP_ERR_WIFI_BASE + 6)
+#define ESP_ERR_WIFI_CONN           (ESP_ERR_WIFI_BASE + 7)
+
+typedef struct {
+        int unused;
+} wifi_init_config_t;
+
+#define WIFI_INIT_CONFIG_DEFAULT() { 0 }
+
+typedef enum {
+        WIFI_MODE_NULL,
+        WIFI_MODE_STA,
+        WIFI_MODE_AP,
+        WIFI_MODE_APSTA,
+} wifi_mode_t;
+
+typedef enum {
+        WIFI_IF_STA,
+        WIFI_IF_AP,
+} wifi_interface_t;
+
+typedef enum {
+        WIFI_STORAGE_FLASH,
+        WIFI_STORAGE_RAM,
+} wifi_storage_t;
+
+typedef enum {
+        WIFI_AUTH_OPEN,
+        WIFI_AUTH_WEP,
+        WIFI_AUTH_WPA_PSK,
+        WIFI_AUTH_WPA2_PSK,
+        WIFI_AUTH_WPA_WPA2_PSK,
+} wifi_auth_mode_t;
+
+typedef struct {
+        uint8_t ssid[32];
+        uint8_t password[64];
+        bool bssid_set;
+        uint8_t bssid[6];
+        uint8_t channel;
+        struct {
+                int8_t rssi;
+                wifi_auth_mode_t authmode;
+        } threshold;
+} wifi_sta_config_t;
+
+typedef union {
+        wifi_sta_config_t sta;
+} wifi_config_t;
+
+ESP_EVENT_DECLARE_BASE(WIFI_EVENT);
+
+typedef enum {
+        WIFI_EVENT_WIFI_READY,
+        WIFI_EVENT_SCAN_DONE,
+        WIFI_EVENT_STA_START,
+        WIFI_EVENT_STA_STOP,
+        WIFI_EVENT_STA_CONNECTED,
+        WIFI_EVENT_STA_DISCONNECTED,
+} wifi_event_t;
+
+typedef struct {
+        uint8_t ssid[32];
+        uint8_t ssid_len;
+        uint8_t bssid[6];
+        uint8_t channel;
+        wifi_auth_mode_t authmode;
+        uint16_t aid;
+} wifi_event_sta_connected_t;
+
+typedef struct {
+        uint8_t ssid[32];
+        uint8_t ssid_len;
+        uint8_t bssid[6];
+        uint8_t reason;
+        int8_t rssi;
+} wifi_event_sta_disconnected_t;
+
+typedef enum {
+        WIFI_REASON_UNSPECIFIED                        = 1,
+        WIFI_REASON_AUTH_EXPIRE                        = 2,
+        WIFI_REASON_AUTH_LEAVE                         = 3,
+        WIFI_REASON_ASSOC_EXPIRE                       = 4,
+        WIFI_REASON_ASSOC_TOOMANY                      = 5,
+        WIFI_REASON_NOT_AUTHED                         = 6,
+        WIFI_REASON_NOT_ASSOCED                        = 7,
+        WIFI_REASON_ASSOC_LEAVE                        = 8,
+        WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT             = 15,
+        WIFI_REASON_802_1X_AUTH_FAILED                 = 23,
+        WIFI_REASON_BEACON_TIMEOUT                     = 200,
+        WIFI_REASON_NO_AP_FOUND                        = 201,
+        WIFI_REASON_AUTH_FAIL                          = 202,
+        WIFI_REASON_ASSOC_FAIL                         = 203,
+        WIFI_REASON_HANDSHAKE_TIMEOUT                  = 204,
+        WIFI_REASON_CONNECTION_FAIL                    = 205,
+        WIFI_REASON_AP_TSF_RESET                       = 206,
+        WIFI_REASON_NO_AP_FOUND_W_COMPATIBLE_SECURITY  = 210,
+        WIFI_REASON_NO_AP_FOUND_IN_AUTHMODE_THRESHOLD  = 211,
+        WIFI_REASON_NO_AP_FOUND_IN_RSSI_THRESHOLD      = 212,
+} wifi_err_reason_t;
+
+esp_err_t esp_wifi_init(const wifi_init_config_t *config);
+esp_err_t esp_wifi_deinit(void);
+esp_err_t esp_wifi_set_storage(wifi_storage_t storage);
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode);
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *config);
+esp_err_t esp_wifi_start(void);
+esp_err_t esp_wifi_stop(void);
+esp_err_t esp_wifi_connect(void);
+esp_err_t esp_wifi_disconnect(void);
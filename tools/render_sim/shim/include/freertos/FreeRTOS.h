@@ -0,0 +1,62 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Tasks are cooperative coroutines on the virtual clock: a task runs until it blocks, and the
+// highest priority task that is ready runs next. Code takes no time; only sleeps, timeouts and
+// strip transmits move the clock. Critical sections are free, as nothing preempts.
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef struct sim_task *TaskHandle_t;
+
+typedef struct {
+        int unused;
+} portMUX_TYPE;
+
+#define configTICK_RATE_HZ          100
+#define portTICK_PERIOD_MS          (1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY               ((TickType_t)0xFFFFFFFF)
+#define pdMS_TO_TICKS(ms)           ((TickType_t)((uint64_t)(ms) * configTICK_RATE_HZ / 1000))
+#define pdTRUE                      1
+#define pdFALSE                     0
+#define pdPASS                      pdTRUE
+#define pdFAIL                      pdFALSE
+#define tskIDLE_PRIORITY            0
+#define configMINIMAL_STACK_SIZE    768
+
+#define portMUX_INITIALIZER_UNLOCKED    { 0 }
+#define portMUX_INITIALIZE(mux)         ((void)(mux))
+#define portENTER_CRITICAL(mux)         ((void)(mux))
+#define portEXIT_CRITICAL(mux)          ((void)(mux))
+#define portENTER_CRITICAL_ISR(mux)     ((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux)      ((void)(mux))
+#define portYIELD_FROM_ISR(woken)       ((void)(woken))
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
@@ -0,0 +1,72 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+// The led_strip calls used by esp32-strip-render and the strip examples. A refresh blocks its
+// caller for the time the frame takes on the wire and is written to the capture.
+
+typedef struct led_strip *led_strip_handle_t;
+
+typedef enum {
+        LED_PIXEL_FORMAT_GRB,
+        LED_PIXEL_FORMAT_GRBW,
+} led_pixel_format_t;
+
+typedef enum {
+        LED_MODEL_WS2812,
+        LED_MODEL_SK6812,
+} led_model_t;
+
+typedef struct {
+        int strip_gpio_num;
+        uint32_t max_leds;
+        led_pixel_format_t led_pixel_format;
+        led_model_t led_model;
+        struct {
+                uint32_t invert_out: 1;
+        } flags;
+} led_strip_config_t;
+
+typedef struct {
+        int clk_src;
+        uint32_t resolution_hz;
+        struct {
+                uint32_t with_dma: 1;
+        } flags;
+} led_strip_rmt_config_t;
+
+#define RMT_CLK_SRC_DEFAULT 0
+
+esp_err_t led_strip_new_rmt_device(const led_strip_config_t *config, const led_strip_rmt_config_t *rmt_config,
+                                   led_strip_handle_t *handle);
+esp_err_t led_strip_set_pixel(led_strip_handle_t strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue);
+esp_err_t led_strip_set_pixel_rgbw(led_strip_handle_t strip, uint32_t index, uint32_t red, uint32_t green,
+                                   uint32_t blue, uint32_t white);
+esp_err_t led_strip_refresh(led_strip_handle_t strip);
+esp_err_t led_strip_clear(led_strip_handle_t strip);
+esp_err_t led_strip_del(led_strip_handle_t strip);
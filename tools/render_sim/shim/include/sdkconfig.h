@@ -0,0 +1,95 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+// Host build configuration for render_sim and the host tests. The values follow the defaults in the components'
+// Kconfig files; override one with e.g. cmake -DSIM_DEFINES=CONFIG_LIGHT_FADE_DITHER_HZ=1000
+
+#pragma once
+
+#ifndef CONFIG_STRIP_RENDER_TASK_PRIORITY
+#define CONFIG_STRIP_RENDER_TASK_PRIORITY 5
+#endif
+#ifndef CONFIG_STRIP_RENDER_TASK_STACK_SIZE
+#define CONFIG_STRIP_RENDER_TASK_STACK_SIZE 3072
+#endif
+#ifndef CONFIG_STRIP_RENDER_CHANNEL_MA
+#define CONFIG_STRIP_RENDER_CHANNEL_MA 20
+#endif
+#ifndef CONFIG_STRIP_RENDER_PIXEL_IDLE_MA
+#define CONFIG_STRIP_RENDER_PIXEL_IDLE_MA 1
+#endif
+
+#ifndef CONFIG_LIGHT_FADE_DITHER_HZ
+#define CONFIG_LIGHT_FADE_DITHER_HZ 0
+#endif
+#ifndef CONFIG_LIGHT_FADE_DITHER_BELOW
+#define CONFIG_LIGHT_FADE_DITHER_BELOW 64
+#endif
+
+#ifndef CONFIG_WIFI_CONNECT_FAST_RECONNECT
+#define CONFIG_WIFI_CONNECT_FAST_RECONNECT 1
+#endif
+#ifndef CONFIG_WIFI_CONNECT_BACKOFF_MIN_MS
+#define CONFIG_WIFI_CONNECT_BACKOFF_MIN_MS 500
+#endif
+#ifndef CONFIG_WIFI_CONNECT_BACKOFF_MAX_MS
+#define CONFIG_WIFI_CONNECT_BACKOFF_MAX_MS 60000
+#endif
+#ifndef CONFIG_WIFI_CONNECT_REINIT_AFTER
+#define CONFIG_WIFI_CONNECT_REINIT_AFTER 8
+#endif
+#ifndef CONFIG_WIFI_CONNECT_RESTART_AFTER_MIN
+#define CONFIG_WIFI_CONNECT_RESTART_AFTER_MIN 30
+#endif
+
+#ifndef CONFIG_GPIO_EDGE_RING_SIZE
+#define CONFIG_GPIO_EDGE_RING_SIZE 64
+#endif
+#ifndef CONFIG_GPIO_EDGE_TASK_PRIORITY
+#define CONFIG_GPIO_EDGE_TASK_PRIORITY 10
+#endif
+#ifndef CONFIG_GPIO_EDGE_TASK_STACK_SIZE
+#define CONFIG_GPIO_EDGE_TASK_STACK_SIZE 3072
+#endif
+
+#ifndef CONFIG_BUTTON_GESTURE_DEBOUNCE_MS
+#define CONFIG_BUTTON_GESTURE_DEBOUNCE_MS 20
+#endif
+#ifndef CONFIG_BUTTON_GESTURE_DOUBLE_PRESS_MS
+#define CONFIG_BUTTON_GESTURE_DOUBLE_PRESS_MS 500
+#endif
+#ifndef CONFIG_BUTTON_GESTURE_LONG_PRESS_MS
+#define CONFIG_BUTTON_GESTURE_LONG_PRESS_MS 1000
+#endif
+#ifndef CONFIG_BUTTON_GESTURE_HOLD_REPEAT_MS
+#define CONFIG_BUTTON_GESTURE_HOLD_REPEAT_MS 0
+#endif
+
+// The simulator records at the driver boundary. The components' own traces can be built in
+// as well; their lines then go to stderr with the log.
+#ifndef CONFIG_STRIP_RENDER_TRACE_DEPTH
+#define CONFIG_STRIP_RENDER_TRACE_DEPTH 0
+#endif
+#ifndef CONFIG_LIGHT_FADE_TRACE_DEPTH
+#define CONFIG_LIGHT_FADE_TRACE_DEPTH 0
+#endif
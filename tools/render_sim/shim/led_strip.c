@@ -0,0 +1,206 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <led_strip.h>
+#include <esp_timer.h>
+#include <sdkconfig.h>
+#include "sim.h"
+
+// WS2812 timing: 1.25 us per bit, and a reset low time of 280 us after the frame
+#define WIRE_NS_PER_BIT 1250
+#define WIRE_RESET_US   280
+#define MAX_STRIPS      8
+
+struct led_strip {
+        char name[32];
+        uint32_t length;
+        uint8_t pixel_size;
+        uint8_t *pixels;            // red, green, blue[, white] per pixel, as the last set_pixel left them
+
+        // Pixels set since the last refresh
+        bool dirty;
+        uint32_t first;
+        uint32_t last;
+
+        uint32_t refreshes;
+        uint32_t set_calls;
+        int64_t busy_us;
+        int64_t first_refresh_us;
+        int64_t last_refresh_us;
+};
+
+static struct led_strip *strips[MAX_STRIPS];
+static int strip_count;
+
+// FNV-1a, as esp32-strip-render hashes its frames; the hashes agree while its limiter is idle
+static uint32_t frame_hash(const struct led_strip *strip) {
+        uint32_t hash = 2166136261u;
+
+        for (size_t i = 0; i < (size_t)strip->length * strip->pixel_size; i++) {
+                hash = (hash ^ strip->pixels[i]) * 16777619u;
+        }
+        return hash;
+}
+
+// The current esp32-strip-render estimates for these pixels
+static uint32_t frame_current_ma(const struct led_strip *strip) {
+        uint64_t sum = 0;
+
+        for (size_t i = 0; i < (size_t)strip->length * strip->pixel_size; i++) {
+                sum += strip->pixels[i];
+        }
+        return strip->length * CONFIG_STRIP_RENDER_PIXEL_IDLE_MA + sum * CONFIG_STRIP_RENDER_CHANNEL_MA / 255;
+}
+
+esp_err_t led_strip_new_rmt_device(const led_strip_config_t *config, const led_strip_rmt_config_t *rmt_config,
+                                   led_strip_handle_t *handle) {
+        if (!config || !handle || !config->max_leds || strip_count == MAX_STRIPS) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        struct led_strip *strip = calloc(1, sizeof(*strip));
+        if (!strip) {
+                return ESP_ERR_NO_MEM;
+        }
+        strip->length = config->max_leds;
+        strip->pixel_size = config->led_pixel_format == LED_PIXEL_FORMAT_GRBW ? 4 : 3;
+        strip->pixels = calloc(strip->length, strip->pixel_size);
+        if (!strip->pixels) {
+                free(strip);
+                return ESP_ERR_NO_MEM;
+        }
+        if (strip_count) {
+                snprintf(strip->name, sizeof(strip->name), "strip%d", strip_count);
+        } else {
+                strcpy(strip->name, "strip");
+        }
+        strips[strip_count++] = strip;
+        *handle = strip;
+        return ESP_OK;
+}
+
+void sim_led_strip_set_name(struct led_strip *strip, const char *name) {
+        snprintf(strip->name, sizeof(strip->name), "%s", name);
+}
+
+static esp_err_t set_pixel(led_strip_handle_t strip, uint32_t index, const uint8_t *pixel, int size) {
+        if (!strip || index >= strip->length || size > strip->pixel_size) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        memcpy(strip->pixels + index * strip->pixel_size, pixel, size);
+        if (!strip->dirty || index < strip->first) {
+                strip->first = index;
+        }
+        if (!strip->dirty || index > strip->last) {
+                strip->last = index;
+        }
+        strip->dirty = true;
+        strip->set_calls++;
+        return ESP_OK;
+}
+
+esp_err_t led_strip_set_pixel(led_strip_handle_t strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue) {
+        const uint8_t pixel[3] = { red, green, blue };
+        return set_pixel(strip, index, pixel, 3);
+}
+
+esp_err_t led_strip_set_pixel_rgbw(led_strip_handle_t strip, uint32_t index, uint32_t red, uint32_t green,
+                                   uint32_t blue, uint32_t white) {
+        const uint8_t pixel[4] = { red, green, blue, white };
+        return set_pixel(strip, index, pixel, 4);
+}
+
+// The whole buffer goes out on every refresh; the caller waits until it has, like with the RMT
+// driver. One "STRIP_RENDER: trace,..." line per refresh, with the limiter scale left as "-"
+// because the driver never sees it.
+esp_err_t led_strip_refresh(led_strip_handle_t strip) {
+        if (!strip) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        int64_t start_us = esp_timer_get_time();
+        uint32_t transmit_us = (uint64_t)strip->length * strip->pixel_size * 8 * WIRE_NS_PER_BIT / 1000 +
+                               WIRE_RESET_US;
+        uint32_t first = strip->dirty ? strip->first : 0;
+        uint32_t last = strip->dirty ? strip->last : 0;
+        uint32_t hash = frame_hash(strip);
+        uint32_t current_ma = frame_current_ma(strip);
+
+        strip->dirty = false;
+        sim_sleep(transmit_us);
+
+        if (!strip->refreshes) {
+                strip->first_refresh_us = start_us;
+        }
+        strip->refreshes++;
+        strip->busy_us += transmit_us;
+        strip->last_refresh_us = start_us;
+
+        FILE *capture = sim_capture ? sim_capture : stdout;
+        fprintf(capture, "STRIP_RENDER: trace,%s,%lu,%lu,%lu,%lu,-,%lu,%08lx\n", strip->name,
+                (unsigned long)(uint32_t)start_us, (unsigned long)transmit_us, (unsigned long)first,
+                (unsigned long)last, (unsigned long)current_ma, (unsigned long)hash);
+        if (sim_capture_pixels) {
+                fprintf(capture, "LED_STRIP: pixels,%s,%lu,", strip->name, (unsigned long)(uint32_t)start_us);
+                for (size_t i = 0; i < (size_t)strip->length * strip->pixel_size; i++) {
+                        fprintf(capture, "%02x", strip->pixels[i]);
+                }
+                fputc('\n', capture);
+        }
+        return ESP_OK;
+}
+
+esp_err_t led_strip_clear(led_strip_handle_t strip) {
+        if (!strip) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        memset(strip->pixels, 0, (size_t)strip->length * strip->pixel_size);
+        strip->dirty = true;
+        strip->first = 0;
+        strip->last = strip->length - 1;
+        return led_strip_refresh(strip);
+}
+
+esp_err_t led_strip_del(led_strip_handle_t strip) {
+        for (int i = 0; i < strip_count; i++) {
+                if (strips[i] == strip) {
+                        strips[i] = strips[--strip_count];
+                        free(strip->pixels);
+                        free(strip);
+                        return ESP_OK;
+                }
+        }
+        return ESP_ERR_INVALID_ARG;
+}
+
+void sim_led_strip_print_summary(void) {
+        for (int i = 0; i < strip_count; i++) {
+                const struct led_strip *strip = strips[i];
+                int64_t span_us = strip->last_refresh_us - strip->first_refresh_us;
+                double fps = strip->refreshes > 1 && span_us ? (strip->refreshes - 1) * 1e6 / span_us : 0.0;
+                int64_t now_us = esp_timer_get_time();
+                fprintf(stderr, "  strip %-20s %8u refreshes, %6.1f fps, wire busy %.1f%%, %u pixel writes\n",
+                        strip->name, strip->refreshes, fps, now_us ? 100.0 * strip->busy_us / now_us : 0.0,
+                        strip->set_calls);
+        }
+}
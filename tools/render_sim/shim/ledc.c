@@ -0,0 +1,167 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <stdio.h>
+#include <driver/ledc.h>
+#include <esp_timer.h>
+#include "sim.h"
+
+typedef struct {
+        bool used;
+        uint32_t duty;              // duty at fade_start_us, or the duty while not fading
+        uint32_t pending;           // set by ledc_set_duty, applied by ledc_update_duty
+
+        // Linear hardware fade from `duty` to `fade_target`
+        bool fading;
+        uint32_t fade_target;
+        int64_t fade_start_us;
+        uint32_t fade_ms;
+        uint32_t next_fade_target;
+        uint32_t next_fade_ms;
+
+        uint32_t updates;
+        uint32_t fades;
+} channel_t;
+
+static channel_t channels[LEDC_SPEED_MODE_MAX][LEDC_CHANNEL_MAX];
+
+static channel_t *lookup(ledc_mode_t speed_mode, ledc_channel_t channel) {
+        if (speed_mode >= LEDC_SPEED_MODE_MAX || channel >= LEDC_CHANNEL_MAX) {
+                return NULL;
+        }
+        channels[speed_mode][channel].used = true;
+        return &channels[speed_mode][channel];
+}
+
+// Where the output is now; a fade that has run its time ends on its target
+static uint32_t duty_now(channel_t *state) {
+        if (!state->fading) {
+                return state->duty;
+        }
+        int64_t elapsed_us = esp_timer_get_time() - state->fade_start_us;
+        int64_t fade_us = (int64_t)state->fade_ms * 1000;
+        if (elapsed_us >= fade_us) {
+                state->duty = state->fade_target;
+                state->fading = false;
+                return state->duty;
+        }
+        int64_t delta = (int64_t)state->fade_target - state->duty;
+        return state->duty + delta * elapsed_us / fade_us;
+}
+
+// One "LIGHT_FADE: trace,ledc<mode>.<channel>,time_us,time_ms,from,to" line per update or fade
+static void capture(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t time_ms, uint32_t from, uint32_t to) {
+        FILE *file = sim_capture ? sim_capture : stdout;
+        fprintf(file, "LIGHT_FADE: trace,ledc%d.%d,%lu,%lu,%lu,%lu\n", speed_mode, channel,
+                (unsigned long)(uint32_t)esp_timer_get_time(), (unsigned long)time_ms, (unsigned long)from,
+                (unsigned long)to);
+}
+
+esp_err_t ledc_fade_func_install(int intr_alloc_flags) {
+        return ESP_OK;
+}
+
+esp_err_t ledc_set_duty(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t duty) {
+        channel_t *state = lookup(speed_mode, channel);
+        if (!state) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        state->pending = duty;
+        return ESP_OK;
+}
+
+esp_err_t ledc_update_duty(ledc_mode_t speed_mode, ledc_channel_t channel) {
+        channel_t *state = lookup(speed_mode, channel);
+        if (!state) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        uint32_t from = duty_now(state);
+        state->fading = false;
+        state->duty = state->pending;
+        state->updates++;
+        capture(speed_mode, channel, 0, from, state->duty);
+        return ESP_OK;
+}
+
+uint32_t ledc_get_duty(ledc_mode_t speed_mode, ledc_channel_t channel) {
+        channel_t *state = lookup(speed_mode, channel);
+        return state ? duty_now(state) : 0;
+}
+
+esp_err_t ledc_set_fade_with_time(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t target_duty,
+                                  int max_fade_time_ms) {
+        channel_t *state = lookup(speed_mode, channel);
+        if (!state || max_fade_time_ms < 0) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        state->next_fade_target = target_duty;
+        state->next_fade_ms = max_fade_time_ms;
+        return ESP_OK;
+}
+
+esp_err_t ledc_fade_start(ledc_mode_t speed_mode, ledc_channel_t channel, ledc_fade_mode_t fade_mode) {
+        channel_t *state = lookup(speed_mode, channel);
+        if (!state) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        state->duty = duty_now(state);
+        state->fade_target = state->next_fade_target;
+        state->fade_ms = state->next_fade_ms;
+        state->fade_start_us = esp_timer_get_time();
+        state->fading = state->fade_ms > 0;
+        if (!state->fading) {
+                state->duty = state->fade_target;
+        }
+        state->fades++;
+        capture(speed_mode, channel, state->fade_ms, state->duty, state->fade_target);
+        if (fade_mode == LEDC_FADE_WAIT_DONE && state->fading) {
+                sim_sleep((int64_t)state->fade_ms * 1000);
+        }
+        return ESP_OK;
+}
+
+esp_err_t ledc_fade_stop(ledc_mode_t speed_mode, ledc_channel_t channel) {
+        channel_t *state = lookup(speed_mode, channel);
+        if (!state) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        state->duty = duty_now(state);
+        state->fading = false;
+        return ESP_OK;
+}
+
+void sim_ledc_print_summary(void) {
+        double seconds = esp_timer_get_time() / 1e6;
+
+        for (int mode = 0; mode < LEDC_SPEED_MODE_MAX; mode++) {
+                for (int channel = 0; channel < LEDC_CHANNEL_MAX; channel++) {
+                        channel_t *state = &channels[mode][channel];
+                        if (!state->used) {
+                                continue;
+                        }
+                        fprintf(stderr, "  ledc  %d.%-18d %8u fades, %8u updates, %6.1f updates/s, duty %lu\n", mode,
+                                channel, state->fades, state->updates, seconds > 0 ? state->updates / seconds : 0.0,
+                                (unsigned long)duty_now(state));
+                }
+        }
+}
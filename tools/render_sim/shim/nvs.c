@@ -0,0 +1,209 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <nvs.h>
+#include "sim.h"
+
+#define MAX_ENTRIES 32
+#define MAX_HANDLES 8
+#define NAME_LENGTH 16              // NVS_KEY_NAME_MAX_SIZE
+
+typedef enum {
+        TYPE_U64,
+        TYPE_BLOB,
+} type_t;
+
+typedef struct {
+        char name_space[NAME_LENGTH];
+        char key[NAME_LENGTH];
+        type_t type;
+        size_t length;
+        void *value;
+} entry_t;
+
+typedef struct {
+        char name_space[NAME_LENGTH];
+        nvs_open_mode_t mode;
+        bool open;
+} handle_t;
+
+static entry_t entries[MAX_ENTRIES];
+static handle_t handles[MAX_HANDLES];
+static sim_nvs_stats_t nvs_stats;
+
+static handle_t *get_handle(nvs_handle_t handle) {
+        if (handle == 0 || handle > MAX_HANDLES || !handles[handle - 1].open) {
+                return NULL;
+        }
+        return &handles[handle - 1];
+}
+
+static entry_t *find(const char *name_space, const char *key) {
+        for (int i = 0; i < MAX_ENTRIES; i++) {
+                if (entries[i].value && strcmp(entries[i].name_space, name_space) == 0 &&
+                    (!key || strcmp(entries[i].key, key) == 0)) {
+                        return &entries[i];
+                }
+        }
+        return NULL;
+}
+
+static esp_err_t get(nvs_handle_t handle, const char *key, type_t type, void *value, size_t *length) {
+        handle_t *h = get_handle(handle);
+        if (!h) {
+                return ESP_ERR_NVS_INVALID_HANDLE;
+        }
+        entry_t *entry = find(h->name_space, key);
+        if (!entry || entry->type != type) {
+                return ESP_ERR_NVS_NOT_FOUND;
+        }
+        if (!value) {
+                *length = entry->length;
+                return ESP_OK;
+        }
+        if (*length < entry->length) {
+                *length = entry->length;
+                return ESP_ERR_NVS_INVALID_LENGTH;
+        }
+        memcpy(value, entry->value, entry->length);
+        *length = entry->length;
+        return ESP_OK;
+}
+
+static esp_err_t set(nvs_handle_t handle, const char *key, type_t type, const void *value, size_t length) {
+        handle_t *h = get_handle(handle);
+        if (!h) {
+                return ESP_ERR_NVS_INVALID_HANDLE;
+        }
+        if (h->mode == NVS_READONLY) {
+                return ESP_ERR_NVS_READ_ONLY;
+        }
+        entry_t *entry = find(h->name_space, key);
+        if (entry && entry->type == type && entry->length == length && memcmp(entry->value, value, length) == 0) {
+                // NVS compares before it writes
+                return ESP_OK;
+        }
+        if (!entry) {
+                for (int i = 0; i < MAX_ENTRIES && !entry; i++) {
+                        if (!entries[i].value) {
+                                entry = &entries[i];
+                        }
+                }
+                if (!entry) {
+                        return ESP_ERR_NO_MEM;
+                }
+                strlcpy(entry->name_space, h->name_space, sizeof(entry->name_space));
+                strlcpy(entry->key, key, sizeof(entry->key));
+        }
+        void *copy = malloc(length ? length : 1);
+        if (!copy) {
+                return ESP_ERR_NO_MEM;
+        }
+        memcpy(copy, value, length);
+        free(entry->value);
+        entry->value = copy;
+        entry->type = type;
+        entry->length = length;
+        nvs_stats.writes++;
+        nvs_stats.bytes += length;
+        return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *name_space, nvs_open_mode_t mode, nvs_handle_t *handle) {
+        if (mode == NVS_READONLY && !find(name_space, NULL)) {
+                return ESP_ERR_NVS_NOT_FOUND;
+        }
+        for (int i = 0; i < MAX_HANDLES; i++) {
+                if (!handles[i].open) {
+                        strlcpy(handles[i].name_space, name_space, sizeof(handles[i].name_space));
+                        handles[i].mode = mode;
+                        handles[i].open = true;
+                        *handle = i + 1;
+                        return ESP_OK;
+                }
+        }
+        return ESP_ERR_NO_MEM;
+}
+
+void nvs_close(nvs_handle_t handle) {
+        handle_t *h = get_handle(handle);
+        if (h) {
+                h->open = false;
+        }
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *value, size_t *length) {
+        return get(handle, key, TYPE_BLOB, value, length);
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length) {
+        return set(handle, key, TYPE_BLOB, value, length);
+}
+
+esp_err_t nvs_get_u64(nvs_handle_t handle, const char *key, uint64_t *value) {
+        size_t length = sizeof(*value);
+        return get(handle, key, TYPE_U64, value, &length);
+}
+
+esp_err_t nvs_set_u64(nvs_handle_t handle, const char *key, uint64_t value) {
+        return set(handle, key, TYPE_U64, &value, sizeof(value));
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key) {
+        handle_t *h = get_handle(handle);
+        if (!h) {
+                return ESP_ERR_NVS_INVALID_HANDLE;
+        }
+        if (h->mode == NVS_READONLY) {
+                return ESP_ERR_NVS_READ_ONLY;
+        }
+        entry_t *entry = find(h->name_space, key);
+        if (!entry) {
+                return ESP_ERR_NVS_NOT_FOUND;
+        }
+        free(entry->value);
+        memset(entry, 0, sizeof(*entry));
+        nvs_stats.writes++;
+        return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+        if (!get_handle(handle)) {
+                return ESP_ERR_NVS_INVALID_HANDLE;
+        }
+        nvs_stats.commits++;
+        return ESP_OK;
+}
+
+void sim_nvs_get_stats(sim_nvs_stats_t *stats) {
+        *stats = nvs_stats;
+}
+
+void sim_nvs_erase_all(void) {
+        for (int i = 0; i < MAX_ENTRIES; i++) {
+                free(entries[i].value);
+        }
+        memset(entries, 0, sizeof(entries));
+}
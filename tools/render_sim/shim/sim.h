@@ -0,0 +1,95 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <esp_system.h>
+
+// Simulator controls, for the scenario driver only
+
+// Run tasks and timers until the virtual clock reaches `time_us`
+void sim_run_until(int64_t time_us);
+
+// Block the calling task, or the driver, for `delay_us` of virtual time
+void sim_sleep(int64_t delay_us);
+
+// Where refreshes and duty changes are written, in the trace formats of esp32-strip-render and
+// esp32-light-fade; stdout unless set
+extern FILE *sim_capture;
+
+// Also write the pixel contents of every refresh
+extern bool sim_capture_pixels;
+
+// Minimum level of the log on stderr
+extern int sim_log_level;
+
+// Name a strip in the capture; strips are "strip", "strip1", ... otherwise
+struct led_strip;
+void sim_led_strip_set_name(struct led_strip *strip, const char *name);
+
+// Counted by esp_restart(), which stops every task; sim_run_until() and sim_sleep() then return
+// early and the driver calls sim_reboot()
+extern uint32_t sim_restarts;
+extern int64_t sim_restart_us;
+
+// Drop every task, timer, event handler and the Wi-Fi driver, so the driver can run the firmware's
+// start-up again. NVS and RTC_NOINIT variables keep their contents and the clock keeps running.
+void sim_reboot(esp_reset_reason_t reason);
+
+// The access point the simulated station can join; it starts up, as "sim" / "password"
+void sim_wifi_set_ap(const char *ssid, const char *password, const uint8_t bssid[6], uint8_t channel);
+
+// Switch the access point on or off. A joined station notices after the beacon timeout.
+void sim_wifi_set_ap_up(bool up);
+
+typedef struct {
+        uint32_t inits;             // esp_wifi_init() calls that brought the driver up
+        uint32_t scans;             // connects that scanned every channel
+        uint32_t pinned;            // connects to a given BSSID and channel
+        uint32_t associations;
+} sim_wifi_stats_t;
+
+void sim_wifi_get_stats(sim_wifi_stats_t *stats);
+
+typedef struct {
+        uint32_t writes;            // sets that changed a value, and erases
+        uint32_t commits;
+        uint64_t bytes;             // payload written
+} sim_nvs_stats_t;
+
+void sim_nvs_get_stats(sim_nvs_stats_t *stats);
+
+// Start from blank flash
+void sim_nvs_erase_all(void);
+
+// Drive an input pin from outside, like a button would. When the level changes on an enabled
+// edge the pin's ISR handler runs at once, in the caller's context.
+void sim_gpio_set_input(int gpio, int level);
+
+// Print timer wakeups, task switches and driver counters to stderr
+void sim_print_summary(void);
+void sim_led_strip_print_summary(void);
+void sim_ledc_print_summary(void);
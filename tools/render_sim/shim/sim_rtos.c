@@ -0,0 +1,582 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+#include <esp_err.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <esp_wifi.h>
+#include <nvs.h>
+#include "sim.h"
+#include "sim_internal.h"
+
+#define TASK_STACK_SIZE     (256 * 1024)
+#define TIMER_TASK_PRIORITY 22      // ESP_TASK_TIMER_PRIO
+#define NEVER               INT64_MAX
+
+FILE *sim_capture;
+bool sim_capture_pixels;
+int sim_log_level = ESP_LOG_INFO;
+
+typedef bool (*ready_fn_t)(struct sim_task *task);
+
+struct sim_task {
+        const char *name;
+        UBaseType_t priority;
+        ucontext_t context;
+        void *stack;
+        TaskFunction_t function;
+        void *arg;
+        bool done;
+
+        // Blocked until `wake_us`, or earlier once `ready` returns true
+        int64_t wake_us;
+        ready_fn_t ready;
+        void *waiting_on;
+
+        uint32_t notifications;
+        uint32_t runs;
+        struct sim_task *next;
+};
+
+struct sim_mutex {
+        struct sim_task *holder;
+};
+
+struct sim_queue {
+        uint8_t *items;
+        UBaseType_t length;
+        UBaseType_t item_size;
+        UBaseType_t head;
+        UBaseType_t count;
+};
+
+struct esp_timer {
+        esp_timer_create_args_t args;
+        int64_t alarm_us;           // NEVER while stopped
+        uint64_t period_us;         // 0 for one-shot
+        uint32_t runs;
+        struct esp_timer *next;
+};
+
+static int64_t now_us;
+static ucontext_t scheduler_context;
+
+// The scenario driver runs outside the scheduler, as the "main" task
+static struct sim_task main_task = { .name = "main", .priority = 1, .wake_us = NEVER };
+static struct sim_task *current = &main_task;
+static struct sim_task *tasks;
+static struct esp_timer *timers;
+static struct sim_task *timer_task;
+
+static bool is_ready(struct sim_task *task) {
+        return !task->done && (now_us >= task->wake_us || (task->ready && task->ready(task)));
+}
+
+// The highest priority task that can run now; the one created first wins a tie
+static struct sim_task *pick(void) {
+        struct sim_task *best = NULL;
+
+        for (struct sim_task *task = tasks; task; task = task->next) {
+                if (is_ready(task) && (!best || task->priority > best->priority)) {
+                        best = task;
+                }
+        }
+        return best;
+}
+
+static int64_t next_alarm(struct esp_timer **due);
+static bool alarm_due(struct sim_task *task);
+
+// The next time a blocked task may become ready; the esp_timer task also waits for alarms
+// armed after it went to sleep, but not for those that fall due while a callback blocks it
+static int64_t next_wake(void) {
+        struct esp_timer *due;
+        int64_t wake = timer_task && timer_task->ready == alarm_due ? next_alarm(&due) : NEVER;
+
+        for (struct sim_task *task = tasks; task; task = task->next) {
+                if (!task->done && task->wake_us < wake) {
+                        wake = task->wake_us;
+                }
+        }
+        return wake;
+}
+
+// Run tasks until none is ready at the current time
+static void run_ready(void) {
+        struct sim_task *task;
+
+        while ((task = pick())) {
+                task->ready = NULL;
+                task->waiting_on = NULL;
+                task->wake_us = NEVER;
+                task->runs++;
+                current = task;
+                swapcontext(&scheduler_context, &task->context);
+                current = &main_task;
+        }
+}
+
+// Block the caller until `wake_us` or until `ready` holds. A task switches back to the
+// scheduler; the driver runs the scheduler itself, moving the clock, until it may go on.
+static void block(int64_t wake_us, ready_fn_t ready, void *waiting_on) {
+        struct sim_task *task = current;
+
+        task->wake_us = wake_us;
+        task->ready = ready;
+        task->waiting_on = waiting_on;
+        if (task != &main_task) {
+                swapcontext(&task->context, &scheduler_context);
+                return;
+        }
+        uint32_t restarts = sim_restarts;
+        for (;;) {
+                run_ready();
+                // After esp_restart() nothing runs until the driver reboots the firmware
+                if (now_us >= wake_us || (ready && ready(task)) || sim_restarts != restarts) {
+                        break;
+                }
+                int64_t next = next_wake();
+                if (next > wake_us) {
+                        next = wake_us;
+                }
+                if (next == NEVER) {
+                        sim_log(ESP_LOG_ERROR, "sim", "main blocks with nothing left to run");
+                        exit(1);
+                }
+                now_us = next;
+        }
+        task->wake_us = NEVER;
+        task->ready = NULL;
+        task->waiting_on = NULL;
+}
+
+void sim_run_until(int64_t time_us) {
+        block(time_us, NULL, NULL);
+}
+
+void sim_sleep(int64_t delay_us) {
+        block(now_us + delay_us, NULL, NULL);
+}
+
+void sim_halt(void) {
+        for (struct sim_task *task = tasks; task; task = task->next) {
+                task->done = true;
+        }
+        if (current != &main_task) {
+                swapcontext(&current->context, &scheduler_context);
+        }
+}
+
+void sim_reboot(esp_reset_reason_t reason) {
+        while (tasks) {
+                struct sim_task *next = tasks->next;
+                free(tasks->stack);
+                free(tasks);
+                tasks = next;
+        }
+        while (timers) {
+                struct esp_timer *next = timers->next;
+                free(timers);
+                timers = next;
+        }
+        timer_task = NULL;
+        sim_event_reset();
+        sim_wifi_reset();
+        sim_system_reset(reason);
+}
+
+static int64_t ticks_to_wake(TickType_t ticks) {
+        if (ticks == portMAX_DELAY) {
+                return NEVER;
+        }
+        return now_us + (int64_t)ticks * portTICK_PERIOD_MS * 1000;
+}
+
+// Tasks
+
+static void task_entry(void) {
+        struct sim_task *task = current;
+
+        task->function(task->arg);
+        // Returning from a task function aborts on the device; here it just ends the task
+        task->done = true;
+        swapcontext(&task->context, &scheduler_context);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack_depth, void *arg,
+                       UBaseType_t priority, TaskHandle_t *handle) {
+        struct sim_task *task = calloc(1, sizeof(*task));
+        if (!task || !(task->stack = malloc(TASK_STACK_SIZE))) {
+                free(task);
+                return pdFAIL;
+        }
+        task->name = name;
+        task->priority = priority;
+        task->function = function;
+        task->arg = arg;
+        task->wake_us = now_us;     // ready at once; it starts when the caller next blocks
+        getcontext(&task->context);
+        task->context.uc_stack.ss_sp = task->stack;
+        task->context.uc_stack.ss_size = TASK_STACK_SIZE;
+        makecontext(&task->context, task_entry, 0);
+
+        struct sim_task **tail = &tasks;
+        while (*tail) {
+                tail = &(*tail)->next;
+        }
+        *tail = task;
+        if (handle) {
+                *handle = task;
+        }
+        return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+        if (!task || task == current) {
+                current->done = true;
+                swapcontext(&current->context, &scheduler_context);
+                return;
+        }
+        task->done = true;
+}
+
+void vTaskDelay(TickType_t ticks) {
+        block(ticks_to_wake(ticks), NULL, NULL);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+        return current;
+}
+
+TickType_t xTaskGetTickCount(void) {
+        return now_us / (portTICK_PERIOD_MS * 1000);
+}
+
+static bool notified(struct sim_task *task) {
+        return task->notifications > 0;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait) {
+        struct sim_task *task = current;
+
+        if (!task->notifications && ticks_to_wait) {
+                block(ticks_to_wake(ticks_to_wait), notified, NULL);
+        }
+        uint32_t value = task->notifications;
+        if (value) {
+                task->notifications = clear_on_exit ? 0 : value - 1;
+        }
+        return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+        task->notifications++;
+        return pdPASS;
+}
+
+// The woken task runs once the interrupted code blocks
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_task_woken) {
+        task->notifications++;
+        if (higher_priority_task_woken) {
+                *higher_priority_task_woken = pdTRUE;
+        }
+}
+
+// Mutexes
+
+static bool mutex_free(struct sim_task *task) {
+        return !((struct sim_mutex *)task->waiting_on)->holder;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+        return calloc(1, sizeof(struct sim_mutex));
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks_to_wait) {
+        int64_t wake_us = ticks_to_wake(ticks_to_wait);
+
+        while (mutex->holder) {
+                if (mutex->holder == current) {
+                        sim_log(ESP_LOG_ERROR, "sim", "%s takes a mutex it already holds", current->name);
+                        abort();
+                }
+                if (now_us >= wake_us) {
+                        return pdFALSE;
+                }
+                block(wake_us, mutex_free, mutex);
+        }
+        mutex->holder = current;
+        return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex) {
+        if (mutex->holder != current) {
+                return pdFALSE;
+        }
+        mutex->holder = NULL;
+        return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t mutex) {
+        free(mutex);
+}
+
+// Queues
+
+static bool queue_has_items(struct sim_task *task) {
+        return ((struct sim_queue *)task->waiting_on)->count > 0;
+}
+
+static bool queue_has_room(struct sim_task *task) {
+        struct sim_queue *queue = task->waiting_on;
+        return queue->count < queue->length;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+        struct sim_queue *queue = calloc(1, sizeof(*queue));
+        if (!queue || !(queue->items = calloc(length, item_size))) {
+                free(queue);
+                return NULL;
+        }
+        queue->length = length;
+        queue->item_size = item_size;
+        return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait) {
+        int64_t wake_us = ticks_to_wake(ticks_to_wait);
+
+        while (queue->count == queue->length) {
+                if (now_us >= wake_us) {
+                        return pdFALSE;
+                }
+                block(wake_us, queue_has_room, queue);
+        }
+        UBaseType_t tail = (queue->head + queue->count) % queue->length;
+        memcpy(queue->items + tail * queue->item_size, item, queue->item_size);
+        queue->count++;
+        return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait) {
+        int64_t wake_us = ticks_to_wake(ticks_to_wait);
+
+        while (!queue->count) {
+                if (now_us >= wake_us) {
+                        return pdFALSE;
+                }
+                block(wake_us, queue_has_items, queue);
+        }
+        memcpy(item, queue->items + queue->head * queue->item_size, queue->item_size);
+        queue->head = (queue->head + 1) % queue->length;
+        queue->count--;
+        return pdTRUE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+        queue->head = 0;
+        queue->count = 0;
+        return pdPASS;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+        free(queue->items);
+        free(queue);
+}
+
+// esp_timer: one task runs every callback in alarm order
+
+static int64_t next_alarm(struct esp_timer **due) {
+        int64_t alarm = NEVER;
+
+        for (struct esp_timer *timer = timers; timer; timer = timer->next) {
+                if (timer->alarm_us < alarm) {
+                        alarm = timer->alarm_us;
+                        *due = timer;
+                }
+        }
+        return alarm;
+}
+
+static bool alarm_due(struct sim_task *task) {
+        struct esp_timer *due;
+        return next_alarm(&due) <= now_us;
+}
+
+static void timer_task_fn(void *arg) {
+        for (;;) {
+                struct esp_timer *timer = NULL;
+                int64_t alarm = next_alarm(&timer);
+                if (alarm > now_us) {
+                        // Woken by the alarm, or earlier when a new timer is started before it
+                        block(alarm, alarm_due, NULL);
+                        continue;
+                }
+                if (timer->period_us) {
+                        // A late periodic timer catches up back to back unless told to skip
+                        timer->alarm_us += timer->period_us;
+                        if (timer->args.skip_unhandled_events && timer->alarm_us <= now_us) {
+                                timer->alarm_us = now_us + timer->period_us;
+                        }
+                } else {
+                        timer->alarm_us = NEVER;
+                }
+                timer->runs++;
+                timer->args.callback(timer->args.arg);
+        }
+}
+
+int64_t esp_timer_get_time(void) {
+        return now_us;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *handle) {
+        if (!args || !args->callback || !handle) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        if (!timer_task && xTaskCreate(timer_task_fn, "esp_timer", 4096, NULL, TIMER_TASK_PRIORITY,
+                                       &timer_task) != pdPASS) {
+                return ESP_ERR_NO_MEM;
+        }
+        struct esp_timer *timer = calloc(1, sizeof(*timer));
+        if (!timer) {
+                return ESP_ERR_NO_MEM;
+        }
+        timer->args = *args;
+        timer->alarm_us = NEVER;
+        timer->next = timers;
+        timers = timer;
+        *handle = timer;
+        return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+        if (timer->alarm_us != NEVER) {
+                return ESP_ERR_INVALID_STATE;
+        }
+        timer->period_us = 0;
+        timer->alarm_us = now_us + timeout_us;
+        return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us) {
+        if (timer->alarm_us != NEVER) {
+                return ESP_ERR_INVALID_STATE;
+        }
+        timer->period_us = period_us;
+        timer->alarm_us = now_us + period_us;
+        return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+        if (timer->alarm_us == NEVER) {
+                return ESP_ERR_INVALID_STATE;
+        }
+        timer->alarm_us = NEVER;
+        return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+        if (timer->alarm_us != NEVER) {
+                return ESP_ERR_INVALID_STATE;
+        }
+        for (struct esp_timer **link = &timers; *link; link = &(*link)->next) {
+                if (*link == timer) {
+                        *link = timer->next;
+                        break;
+                }
+        }
+        free(timer);
+        return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer) {
+        return timer->alarm_us != NEVER;
+}
+
+// Log and errors
+
+void sim_log(int level, const char *tag, const char *format, ...) {
+        static const char letters[] = " EWIDV";
+        va_list args;
+
+        if (level > sim_log_level) {
+                return;
+        }
+        fprintf(stderr, "%c (%lld) %s: ", letters[level], (long long)(now_us / 1000), tag);
+        va_start(args, format);
+        vfprintf(stderr, format, args);
+        va_end(args);
+        fputc('\n', stderr);
+}
+
+const char *esp_err_to_name(esp_err_t code) {
+        switch (code) {
+        case ESP_OK: return "ESP_OK";
+        case ESP_FAIL: return "ESP_FAIL";
+        case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_WIFI_NOT_INIT: return "ESP_ERR_WIFI_NOT_INIT";
+        case ESP_ERR_WIFI_NOT_STARTED: return "ESP_ERR_WIFI_NOT_STARTED";
+        case ESP_ERR_WIFI_NOT_STOPPED: return "ESP_ERR_WIFI_NOT_STOPPED";
+        case ESP_ERR_WIFI_IF: return "ESP_ERR_WIFI_IF";
+        case ESP_ERR_WIFI_MODE: return "ESP_ERR_WIFI_MODE";
+        case ESP_ERR_WIFI_STATE: return "ESP_ERR_WIFI_STATE";
+        case ESP_ERR_WIFI_CONN: return "ESP_ERR_WIFI_CONN";
+        case ESP_ERR_NVS_NOT_FOUND: return "ESP_ERR_NVS_NOT_FOUND";
+        case ESP_ERR_NVS_TYPE_MISMATCH: return "ESP_ERR_NVS_TYPE_MISMATCH";
+        case ESP_ERR_NVS_READ_ONLY: return "ESP_ERR_NVS_READ_ONLY";
+        case ESP_ERR_NVS_INVALID_HANDLE: return "ESP_ERR_NVS_INVALID_HANDLE";
+        case ESP_ERR_NVS_INVALID_LENGTH: return "ESP_ERR_NVS_INVALID_LENGTH";
+        default: return "UNKNOWN ERROR";
+        }
+}
+
+void sim_print_summary(void) {
+        double seconds = now_us / 1e6;
+
+        fprintf(stderr, "simulated %.3f s\n", seconds);
+        for (struct esp_timer *timer = timers; timer; timer = timer->next) {
+                fprintf(stderr, "  timer %-20s %8u runs, %8.1f wakeups/s\n", timer->args.name ? timer->args.name : "?",
+                        timer->runs, seconds > 0 ? timer->runs / seconds : 0.0);
+        }
+        for (struct sim_task *task = tasks; task; task = task->next) {
+                fprintf(stderr, "  task  %-20s %8u runs, %8.1f wakeups/s\n", task->name, task->runs,
+                        seconds > 0 ? task->runs / seconds : 0.0);
+        }
+        sim_led_strip_print_summary();
+        sim_ledc_print_summary();
+}
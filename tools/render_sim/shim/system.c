@@ -0,0 +1,91 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <string.h>
+#include <esp_random.h>
+#include <esp_timer.h>
+#include <esp_system.h>
+#include "sim.h"
+#include "sim_internal.h"
+
+#define MAX_SHUTDOWN_HANDLERS 8
+
+uint32_t sim_restarts;
+int64_t sim_restart_us;
+
+static esp_reset_reason_t reset_reason = ESP_RST_POWERON;
+static shutdown_handler_t shutdown_handlers[MAX_SHUTDOWN_HANDLERS];
+static uint32_t random_state = 0x2545F491;
+
+esp_reset_reason_t esp_reset_reason(void) {
+        return reset_reason;
+}
+
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handler) {
+        for (int i = 0; i < MAX_SHUTDOWN_HANDLERS; i++) {
+                if (shutdown_handlers[i] == handler) {
+                        return ESP_ERR_INVALID_STATE;
+                }
+                if (!shutdown_handlers[i]) {
+                        shutdown_handlers[i] = handler;
+                        return ESP_OK;
+                }
+        }
+        return ESP_ERR_NO_MEM;
+}
+
+void esp_restart(void) {
+        for (int i = MAX_SHUTDOWN_HANDLERS - 1; i >= 0; i--) {
+                if (shutdown_handlers[i]) {
+                        shutdown_handlers[i]();
+                }
+        }
+        sim_restarts++;
+        sim_restart_us = esp_timer_get_time();
+        sim_halt();
+}
+
+// xorshift32
+uint32_t esp_random(void) {
+        random_state ^= random_state << 13;
+        random_state ^= random_state >> 17;
+        random_state ^= random_state << 5;
+        return random_state;
+}
+
+void sim_system_reset(esp_reset_reason_t reason) {
+        reset_reason = reason;
+        memset(shutdown_handlers, 0, sizeof(shutdown_handlers));
+}
+
+// newlib's, for a glibc without it
+__attribute__((weak)) size_t strlcpy(char *dst, const char *src, size_t size) {
+        size_t length = strlen(src);
+
+        if (size) {
+                size_t copy = length < size - 1 ? length : size - 1;
+                memcpy(dst, src, copy);
+                dst[copy] = '\0';
+        }
+        return length;
+}
@@ -0,0 +1,95 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <stdbool.h>
+#include <driver/uart.h>
+
+typedef struct {
+        bool installed;
+        QueueHandle_t events;
+} port_t;
+
+static port_t ports[UART_NUM_MAX];
+
+static port_t *lookup(uart_port_t port) {
+        return port >= 0 && port < UART_NUM_MAX ? &ports[port] : NULL;
+}
+
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t *config) {
+        return lookup(port) && config && config->baud_rate > 0 ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t uart_set_pin(uart_port_t port, int tx_gpio, int rx_gpio, int rts_gpio, int cts_gpio) {
+        return lookup(port) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t uart_driver_install(uart_port_t port, int rx_buffer_size, int tx_buffer_size, int queue_size,
+                              QueueHandle_t *queue, int intr_alloc_flags) {
+        port_t *state = lookup(port);
+        if (!state || rx_buffer_size <= 0) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        if (state->installed) {
+                return ESP_FAIL;
+        }
+        if (queue) {
+                state->events = xQueueCreate(queue_size, sizeof(uart_event_t));
+                if (!state->events) {
+                        return ESP_ERR_NO_MEM;
+                }
+                *queue = state->events;
+        }
+        state->installed = true;
+        return ESP_OK;
+}
+
+esp_err_t uart_driver_delete(uart_port_t port) {
+        port_t *state = lookup(port);
+        if (!state || !state->installed) {
+                return ESP_ERR_INVALID_STATE;
+        }
+        if (state->events) {
+                vQueueDelete(state->events);
+        }
+        *state = (port_t) { 0 };
+        return ESP_OK;
+}
+
+int uart_read_bytes(uart_port_t port, void *buffer, uint32_t length, TickType_t ticks_to_wait) {
+        port_t *state = lookup(port);
+        if (!state || !state->installed) {
+                return -1;
+        }
+        // Nothing is attached, so nothing arrives; returns at once instead of waiting for it
+        return 0;
+}
+
+int uart_write_bytes(uart_port_t port, const void *data, size_t size) {
+        port_t *state = lookup(port);
+        return state && state->installed ? (int)size : -1;
+}
+
+esp_err_t uart_flush_input(uart_port_t port) {
+        port_t *state = lookup(port);
+        return state && state->installed ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
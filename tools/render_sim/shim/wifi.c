@@ -0,0 +1,310 @@
+/**
+   Copyright 2025 Achim Pieters | StudioPieters®
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   for more information visit https://www.studiopieters.nl
+ **/
+
+#include <string.h>
+#include <esp_log.h>
+#include <esp_netif.h>
+#include <esp_timer.h>
+#include <esp_wifi.h>
+#include "sim.h"
+#include "sim_internal.h"
+
+ESP_EVENT_DEFINE_BASE(WIFI_EVENT);
+ESP_EVENT_DEFINE_BASE(IP_EVENT);
+
+// Rough figures of an ESP32 station on a quiet 2.4 GHz network
+#define START_US        60000       // esp_wifi_start() to STA_START
+#define SCAN_US         2200000     // active scan of all 13 channels
+#define PINNED_US       120000      // probe of one BSSID on a known channel
+#define DHCP_US         350000      // STA_CONNECTED to GOT_IP
+#define BEACON_LOSS_US  6000000     // beacon timeout after the access point disappears
+
+typedef enum {
+        STEP_NONE,
+        STEP_START,                 // post STA_START
+        STEP_ATTEMPT,               // finish the scan or probe of esp_wifi_connect()
+        STEP_DHCP,                  // lease granted
+        STEP_BEACON_LOSS,           // the joined access point stopped answering
+} step_t;
+
+typedef enum {
+        LINK_IDLE,
+        LINK_CONNECTING,
+        LINK_ASSOCIATED,
+} link_t;
+
+static struct {
+        char ssid[33];
+        char password[65];
+        uint8_t bssid[6];
+        uint8_t channel;
+        bool up;
+} ap = {
+        .ssid = "sim",
+        .password = "password",
+        .bssid = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 },
+        .channel = 6,
+        .up = true,
+};
+
+static struct {
+        bool initialized;
+        bool started;
+        wifi_mode_t mode;
+        wifi_config_t config;
+        link_t link;
+        step_t step;
+        esp_timer_handle_t timer;   // runs the pending step, on the esp_timer task
+} station;
+
+static sim_wifi_stats_t wifi_stats;
+
+static void schedule(step_t step, int64_t delay_us) {
+        esp_timer_stop(station.timer);
+        station.step = step;
+        esp_timer_start_once(station.timer, delay_us);
+}
+
+static void cancel(void) {
+        esp_timer_stop(station.timer);
+        station.step = STEP_NONE;
+}
+
+static void post_disconnected(uint8_t reason) {
+        wifi_event_sta_disconnected_t event = { .reason = reason, .rssi = -60 };
+        size_t length = strlen((const char *)station.config.sta.ssid);
+        memcpy(event.ssid, station.config.sta.ssid, length);
+        event.ssid_len = length;
+        memcpy(event.bssid, ap.bssid, sizeof(event.bssid));
+        station.link = LINK_IDLE;
+        esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &event, sizeof(event), portMAX_DELAY);
+}
+
+static void finish_attempt(void) {
+        const wifi_sta_config_t *sta = &station.config.sta;
+        bool found = ap.up && strcmp((const char *)sta->ssid, ap.ssid) == 0;
+        if (sta->bssid_set) {
+                found = found && memcmp(sta->bssid, ap.bssid, sizeof(ap.bssid)) == 0;
+        }
+        if (sta->channel) {
+                found = found && sta->channel == ap.channel;
+        }
+        if (!found) {
+                post_disconnected(WIFI_REASON_NO_AP_FOUND);
+                return;
+        }
+        if (strcmp((const char *)sta->password, ap.password) != 0) {
+                post_disconnected(WIFI_REASON_AUTH_FAIL);
+                return;
+        }
+
+        wifi_event_sta_connected_t event = { .channel = ap.channel, .authmode = WIFI_AUTH_WPA2_PSK, .aid = 1 };
+        event.ssid_len = strlen(ap.ssid);
+        memcpy(event.ssid, ap.ssid, event.ssid_len);
+        memcpy(event.bssid, ap.bssid, sizeof(event.bssid));
+        station.link = LINK_ASSOCIATED;
+        wifi_stats.associations++;
+        esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, &event, sizeof(event), portMAX_DELAY);
+        schedule(STEP_DHCP, DHCP_US);
+}
+
+static void step_cb(void *arg) {
+        step_t step = station.step;
+        station.step = STEP_NONE;
+
+        switch (step) {
+        case STEP_START:
+                esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_START, NULL, 0, portMAX_DELAY);
+                break;
+        case STEP_ATTEMPT:
+                finish_attempt();
+                break;
+        case STEP_DHCP: {
+                ip_event_got_ip_t event = {
+                        .ip_info = {
+                                .ip = { 0x3201a8c0 },           // 192.168.1.50
+                                .netmask = { 0x00ffffff },
+                                .gw = { 0x0101a8c0 },
+                        },
+                        .ip_changed = true,
+                };
+                esp_event_post(IP_EVENT, IP_EVENT_STA_GOT_IP, &event, sizeof(event), portMAX_DELAY);
+                break;
+        }
+        case STEP_BEACON_LOSS:
+                post_disconnected(WIFI_REASON_BEACON_TIMEOUT);
+                break;
+        case STEP_NONE:
+                break;
+        }
+}
+
+esp_err_t esp_wifi_init(const wifi_init_config_t *config) {
+        if (station.initialized) {
+                return ESP_OK;
+        }
+        const esp_timer_create_args_t timer_args = {
+                .callback = step_cb,
+                .name = "wifi_sim",
+        };
+        esp_err_t err = esp_timer_create(&timer_args, &station.timer);
+        if (err != ESP_OK) {
+                return err;
+        }
+        station.initialized = true;
+        wifi_stats.inits++;
+        return ESP_OK;
+}
+
+esp_err_t esp_wifi_deinit(void) {
+        if (!station.initialized) {
+                return ESP_ERR_WIFI_NOT_INIT;
+        }
+        if (station.started) {
+                return ESP_ERR_WIFI_NOT_STOPPED;
+        }
+        esp_timer_delete(station.timer);
+        memset(&station, 0, sizeof(station));
+        return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_storage(wifi_storage_t storage) {
+        return station.initialized ? ESP_OK : ESP_ERR_WIFI_NOT_INIT;
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode) {
+        if (!station.initialized) {
+                return ESP_ERR_WIFI_NOT_INIT;
+        }
+        station.mode = mode;
+        return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *config) {
+        if (!station.initialized) {
+                return ESP_ERR_WIFI_NOT_INIT;
+        }
+        if (interface != WIFI_IF_STA) {
+                return ESP_ERR_WIFI_IF;
+        }
+        station.config = *config;
+        return ESP_OK;
+}
+
+esp_err_t esp_wifi_start(void) {
+        if (!station.initialized) {
+                return ESP_ERR_WIFI_NOT_INIT;
+        }
+        if (station.mode != WIFI_MODE_STA) {
+                return ESP_ERR_WIFI_MODE;
+        }
+        if (!station.started) {
+                station.started = true;
+                schedule(STEP_START, START_US);
+        }
+        return ESP_OK;
+}
+
+esp_err_t esp_wifi_stop(void) {
+        if (!station.initialized) {
+                return ESP_ERR_WIFI_NOT_INIT;
+        }
+        if (!station.started) {
+                return ESP_OK;
+        }
+        cancel();
+        if (station.link != LINK_IDLE) {
+                post_disconnected(WIFI_REASON_ASSOC_LEAVE);
+        }
+        station.started = false;
+        esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_STOP, NULL, 0, portMAX_DELAY);
+        return ESP_OK;
+}
+
+esp_err_t esp_wifi_connect(void) {
+        if (!station.initialized) {
+                return ESP_ERR_WIFI_NOT_INIT;
+        }
+        if (!station.started) {
+                return ESP_ERR_WIFI_NOT_STARTED;
+        }
+        if (station.link != LINK_IDLE) {
+                return ESP_ERR_WIFI_CONN;
+        }
+        station.link = LINK_CONNECTING;
+        const wifi_sta_config_t *sta = &station.config.sta;
+        if (sta->bssid_set && sta->channel) {
+                wifi_stats.pinned++;
+                schedule(STEP_ATTEMPT, PINNED_US);
+        } else {
+                wifi_stats.scans++;
+                schedule(STEP_ATTEMPT, SCAN_US);
+        }
+        return ESP_OK;
+}
+
+esp_err_t esp_wifi_disconnect(void) {
+        if (!station.initialized) {
+                return ESP_ERR_WIFI_NOT_INIT;
+        }
+        if (!station.started) {
+                return ESP_ERR_WIFI_NOT_STARTED;
+        }
+        if (station.link != LINK_IDLE) {
+                cancel();
+                post_disconnected(WIFI_REASON_ASSOC_LEAVE);
+        }
+        return ESP_OK;
+}
+
+esp_err_t esp_netif_init(void) {
+        return ESP_OK;
+}
+
+esp_netif_t *esp_netif_create_default_wifi_sta(void) {
+        static int netif;
+        return (esp_netif_t *)&netif;
+}
+
+void sim_wifi_set_ap(const char *ssid, const char *password, const uint8_t bssid[6], uint8_t channel) {
+        strlcpy(ap.ssid, ssid, sizeof(ap.ssid));
+        strlcpy(ap.password, password, sizeof(ap.password));
+        memcpy(ap.bssid, bssid, sizeof(ap.bssid));
+        ap.channel = channel;
+}
+
+void sim_wifi_set_ap_up(bool up) {
+        ap.up = up;
+        if (!up && station.link == LINK_ASSOCIATED && station.step != STEP_BEACON_LOSS) {
+                schedule(STEP_BEACON_LOSS, BEACON_LOSS_US);
+        }
+}
+
+void sim_wifi_get_stats(sim_wifi_stats_t *stats) {
+        *stats = wifi_stats;
+}
+
+void sim_wifi_reset(void) {
+        // The timer went with the other timers
+        memset(&station, 0, sizeof(station));
+}
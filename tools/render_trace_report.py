@@ -0,0 +1,218 @@
+#!/usr/bin/env python3
+#
+# Copyright 2025 Achim Pieters | StudioPieters®
+#
+# Summarise refresh and duty traces printed by esp32-strip-render and
+# esp32-light-fade.
+#
+# Enable the traces in menuconfig (Strip Render -> Refresh trace depth and
+# Light Fade -> Duty trace depth), capture the serial output while the light
+# runs a scene, e.g.
+#   idf.py monitor | tee rainbow.log
+# and report on the capture:
+#   tools/render_trace_report.py rainbow.log --min-fps 45
+#
+# Captures of tools/render_sim, which runs the same components on the host,
+# are read the same way.
+#
+# For every strip the report shows the refreshes, the achieved frame rate,
+# frame intervals, transmit times and limiter activity. For every fade group it
+# shows the fades and jumps; --history NAME prints the duty of each channel of
+# that group over time, rebuilt from the linear hardware fades.
+#
+# With --golden the frame hashes of every strip and the targets of every fade
+# group are compared with an earlier capture of the same scene; timing is
+# ignored. The script exits with status 1 on a mismatch or when a strip stays
+# below --min-fps.
+#
+# for more information visit https://www.studiopieters.nl
+
+import argparse
+import re
+import statistics
+import sys
+from collections import OrderedDict
+
+STRIP_LINE = re.compile(r'STRIP_RENDER: trace,([^,\s]+),(\d+),(\d+),(\d+),(\d+),(\d+|-),(\d+),([0-9a-f]+)')
+DROPPED_LINE = re.compile(r'(STRIP_RENDER|LIGHT_FADE): trace_dropped,([^,\s]+),(\d+)')
+FADE_LINE = re.compile(r'LIGHT_FADE: trace,([^,\s]+),(\d+),(\d+)((?:,\d+,\d+)+)')
+
+FULL_SCALE = 256
+
+
+def unwrap(times):
+    """The device prints the low 32 bits of its microsecond clock; undo the wrap every 71 minutes."""
+    offset = 0
+    previous = None
+    result = []
+    for time_us in times:
+        if previous is not None and time_us < previous:
+            offset += 1 << 32
+        previous = time_us
+        result.append(time_us + offset)
+    return result
+
+
+def parse(path):
+    """Return (strips, fades, dropped): {name: [entry dict]} in capture order, {name: entries lost}."""
+    strips = OrderedDict()
+    fades = OrderedDict()
+    dropped = {}
+    with open(path, errors='replace') as capture:
+        for line in capture:
+            match = DROPPED_LINE.search(line)
+            if match:
+                kind, name, count = match.groups()
+                key = ('strip' if kind == 'STRIP_RENDER' else 'fade', name)
+                dropped[key] = dropped.get(key, 0) + int(count)
+                continue
+            match = STRIP_LINE.search(line)
+            if match:
+                name, time_us, transmit_us, first, last, scale, current_ma, frame_hash = match.groups()
+                strips.setdefault(name, []).append({
+                    'time_us': int(time_us),
+                    'transmit_us': int(transmit_us),
+                    'pixels': int(last) - int(first) + 1,
+                    'scale': None if scale == '-' else int(scale),
+                    'current_ma': int(current_ma),
+                    'hash': frame_hash,
+                })
+                continue
+            match = FADE_LINE.search(line)
+            if match:
+                name, time_us, time_ms, duties = match.groups()
+                values = [int(value) for value in duties.strip(',').split(',')]
+                fades.setdefault(name, []).append({
+                    'time_us': int(time_us),
+                    'time_ms': int(time_ms),
+                    'from': values[0::2],
+                    'to': values[1::2],
+                })
+    for entries in list(strips.values()) + list(fades.values()):
+        for entry, time_us in zip(entries, unwrap([entry['time_us'] for entry in entries])):
+            entry['time_us'] = time_us
+    return strips, fades, dropped
+
+
+def report_strip(name, entries, dropped):
+    """Print one strip and return its achieved frame rate."""
+    span_us = entries[-1]['time_us'] - entries[0]['time_us']
+    # Refreshes the device could not record still count towards the frame rate
+    fps = (len(entries) + dropped - 1) * 1e6 / span_us if span_us else 0.0
+    intervals = [(b['time_us'] - a['time_us']) / 1000.0 for a, b in zip(entries, entries[1:])]
+    transmits = [entry['transmit_us'] / 1000.0 for entry in entries]
+    scales = [entry['scale'] for entry in entries if entry['scale'] is not None]
+    limited = sum(1 for scale in scales if scale < FULL_SCALE)
+
+    print('strip %s' % name)
+    print('  refreshes         %d over %.1f s' % (len(entries), span_us / 1e6))
+    if dropped:
+        print('  not recorded      %d, while the trace was printing' % dropped)
+    print('  frame rate        %.1f fps' % fps)
+    if intervals:
+        print('  interval          median %.2f ms, max %.2f ms' % (statistics.median(intervals), max(intervals)))
+    print('  transmit          median %.2f ms, max %.2f ms' % (statistics.median(transmits), max(transmits)))
+    print('  pixels per frame  median %d, max %d' % (statistics.median(entry['pixels'] for entry in entries),
+                                                   max(entry['pixels'] for entry in entries)))
+    peak_ma = max(entry['current_ma'] for entry in entries)
+    if scales:
+        print('  limited frames    %d, peak %d mA' % (limited, peak_ma))
+    else:
+        # Simulator captures are recorded at the driver, which never sees the limiter scale
+        print('  limited frames    unknown, peak %d mA' % peak_ma)
+    return fps
+
+
+def report_fade(name, entries, dropped):
+    fades = [entry for entry in entries if entry['time_ms']]
+    print('fade %s' % name)
+    print('  fades             %d' % len(fades))
+    print('  jumps             %d' % (len(entries) - len(fades)))
+    if dropped:
+        print('  not recorded      %d, while the trace was printing' % dropped)
+    if fades:
+        times = [entry['time_ms'] for entry in fades]
+        print('  fade time         median %d ms, max %d ms' % (statistics.median(times), max(times)))
+
+
+def history(entries, step_ms):
+    """Yield (time_ms, duties) every step_ms, following each fade in a straight line to its target."""
+    start_us = entries[0]['time_us']
+    end_us = max(entry['time_us'] + entry['time_ms'] * 1000 for entry in entries)
+    index = 0
+    time_us = start_us
+    while time_us <= end_us:
+        while index + 1 < len(entries) and entries[index + 1]['time_us'] <= time_us:
+            index += 1
+        entry = entries[index]
+        elapsed_us = time_us - entry['time_us']
+        if not entry['time_ms'] or elapsed_us >= entry['time_ms'] * 1000:
+            duties = entry['to']
+        else:
+            progress = elapsed_us / (entry['time_ms'] * 1000.0)
+            duties = [round(a + (b - a) * progress) for a, b in zip(entry['from'], entry['to'])]
+        yield (time_us - start_us) / 1000.0, duties
+        time_us += step_ms * 1000
+
+
+def compare(kind, name, actual, expected):
+    """Return a mismatch description, or None when both sequences agree."""
+    if expected is None:
+        return '%s %s is missing from the golden capture' % (kind, name)
+    for index, (a, b) in enumerate(zip(actual, expected)):
+        if a != b:
+            return '%s %s differs at entry %d: %s, golden %s' % (kind, name, index, a, b)
+    if len(actual) != len(expected):
+        return '%s %s has %d entries, golden %d' % (kind, name, len(actual), len(expected))
+    return None
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Summarise esp32-strip-render and esp32-light-fade traces.')
+    parser.add_argument('capture', help='serial log containing STRIP_RENDER or LIGHT_FADE trace lines')
+    parser.add_argument('--golden', help='earlier capture of the same scene to compare frames and targets with')
+    parser.add_argument('--min-fps', type=float, help='fail when a strip refreshes slower than this')
+    parser.add_argument('--history', metavar='NAME', help='print the duties of this fade group over time')
+    parser.add_argument('--step-ms', type=float, default=10.0, help='time step of --history (default 10)')
+    args = parser.parse_args()
+
+    strips, fades, dropped = parse(args.capture)
+    if not strips and not fades:
+        sys.exit('No STRIP_RENDER or LIGHT_FADE trace lines found')
+
+    failures = []
+    for name, entries in strips.items():
+        fps = report_strip(name, entries, dropped.get(('strip', name), 0))
+        if args.min_fps is not None and fps < args.min_fps:
+            failures.append('strip %s runs at %.1f fps, below %.1f' % (name, fps, args.min_fps))
+    for name, entries in fades.items():
+        report_fade(name, entries, dropped.get(('fade', name), 0))
+
+    if args.history:
+        if args.history not in fades:
+            sys.exit('Unknown fade group %r, choose from: %s' % (args.history, ', '.join(fades)))
+        print('history %s' % args.history)
+        for time_ms, duties in history(fades[args.history], args.step_ms):
+            print('  %10.1f ms  %s' % (time_ms, ' '.join('%6d' % duty for duty in duties)))
+
+    if args.golden:
+        golden_strips, golden_fades, golden_dropped = parse(args.golden)
+        if dropped or golden_dropped:
+            print('WARNING: entries were dropped while tracing; frames may not line up with the golden capture')
+        for name, entries in strips.items():
+            expected = golden_strips.get(name)
+            failures.append(compare('strip', name, [entry['hash'] for entry in entries],
+                                    expected and [entry['hash'] for entry in expected]))
+        for name, entries in fades.items():
+            expected = golden_fades.get(name)
+            failures.append(compare('fade', name, [entry['to'] for entry in entries],
+                                    expected and [entry['to'] for entry in expected]))
+        failures = [failure for failure in failures if failure]
+
+    for failure in failures:
+        print('FAIL: %s' % failure)
+    return 1 if failures else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())